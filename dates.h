@@ -0,0 +1,514 @@
+/*
+ * Dates and times
+ * ===============
+ * Formatting the current time for request headers and bodies, parsing timestamps from responses,
+ * and simple date arithmetic. All times are handled as milliseconds since 1970-01-01 00:00:00 UTC
+ * (as returned by lrlib_get_unix_time_ms), and are formatted in UTC.
+ *
+ * Formatting the current time is usually done several times per request, but the time only
+ * changes to a new second once per second. Each vuser keeps the formatted text for the current
+ * second, so most calls only write the milliseconds.
+ *
+ * Dates are converted to and from day numbers with Howard Hinnant's days_from_civil and
+ * civil_from_days algorithms (http://howardhinnant.github.io/date_algorithms.html), which are
+ * correct for the proleptic Gregorian calendar and need no tables or loops.
+ */
+
+// The formats that times can be saved in.
+#define LRLIB_DATE_ISO8601 0 // e.g. "2024-02-29T13:45:07.123Z"
+#define LRLIB_DATE_ISO8601_SECONDS 1 // e.g. "2024-02-29T13:45:07Z"
+#define LRLIB_DATE_RFC1123 2 // e.g. "Thu, 29 Feb 2024 13:45:07 GMT" (as used in HTTP headers)
+#define LRLIB_DATE_FORMAT_COUNT 3
+
+#define LRLIB_DATE_BUFFER_LENGTH 32 // long enough for any of the formats, with a terminating null
+
+// The text for the current second, for each format.
+double lrlib_date_cached_second[LRLIB_DATE_FORMAT_COUNT] = {-1, -1, -1};
+char lrlib_date_cached_text[LRLIB_DATE_FORMAT_COUNT][LRLIB_DATE_BUFFER_LENGTH];
+int lrlib_date_cached_length[LRLIB_DATE_FORMAT_COUNT];
+
+/**
+ * @brief Returns the number of days since 1970-01-01 for a date in the Gregorian calendar.
+ *
+ * @param year The year, e.g. 2024.
+ * @param month The month, from 1 to 12.
+ * @param day The day of the month, from 1 to 31.
+ * @return Returns the number of days (negative for dates before 1970).
+ */
+int lrlib_days_from_civil(int year, int month, int day) {
+    int era;
+    int year_of_era;
+    int day_of_year;
+    int day_of_era;
+
+    // Count years from March, so that February 29 is the last day of the year.
+    if (month <= 2) {
+        year--;
+    }
+    if (year >= 0) {
+        era = year / 400;
+    } else {
+        era = (year - 399) / 400;
+    }
+    year_of_era = year - era * 400; // 0 to 399
+    if (month > 2) {
+        day_of_year = (153 * (month - 3) + 2) / 5 + day - 1; // 0 to 365
+    } else {
+        day_of_year = (153 * (month + 9) + 2) / 5 + day - 1;
+    }
+    day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year; // 0 to 146096
+
+    return era * 146097 + day_of_era - 719468;
+}
+
+/**
+ * @brief Converts a number of days since 1970-01-01 to a date in the Gregorian calendar.
+ *
+ * @param days The number of days (negative for dates before 1970).
+ * @param year Set to the year.
+ * @param month Set to the month, from 1 to 12.
+ * @param day Set to the day of the month, from 1 to 31.
+ * @return This function does not return a value.
+ */
+void lrlib_civil_from_days(int days, int* year, int* month, int* day) {
+    int era;
+    int day_of_era;
+    int year_of_era;
+    int day_of_year;
+    int month_from_march;
+
+    days += 719468; // days since 0000-03-01
+    if (days >= 0) {
+        era = days / 146097;
+    } else {
+        era = (days - 146096) / 146097;
+    }
+    day_of_era = days - era * 146097; // 0 to 146096
+    year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365; // 0 to 399
+    day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100); // 0 to 365
+    month_from_march = (5 * day_of_year + 2) / 153; // 0 to 11
+
+    *day = day_of_year - (153 * month_from_march + 2) / 5 + 1;
+    if (month_from_march < 10) {
+        *month = month_from_march + 3;
+    } else {
+        *month = month_from_march - 9;
+    }
+    *year = year_of_era + era * 400;
+    if (*month <= 2) {
+        (*year)++;
+    }
+}
+
+/**
+ * @brief Writes a whole number of seconds since 1970 in one of the LRLIB_DATE_* formats, with a
+ *        terminating null. For LRLIB_DATE_ISO8601, the text stops after the seconds (the
+ *        milliseconds and "Z" are added by lrlib_format_date).
+ *
+ * @return Returns the number of characters written.
+ */
+int lrlib_format_date_seconds(double unix_seconds, int format, char* buffer) {
+    static const char* DAY_NAMES[7] = {"Thu", "Fri", "Sat", "Sun", "Mon", "Tue", "Wed"}; // 1970-01-01 was a Thursday
+    static const char* MONTH_NAMES[12] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+    double floor(double x);
+    const int days = (int)floor(unix_seconds / 86400);
+    const int seconds_of_day = (int)(unix_seconds - days * 86400.0);
+    int day_of_week;
+    int year;
+    int month;
+    int day;
+
+    lrlib_civil_from_days(days, &year, &month, &day);
+
+    if (format == LRLIB_DATE_RFC1123) {
+        day_of_week = days % 7;
+        if (day_of_week < 0) {
+            day_of_week += 7;
+        }
+        return sprintf(buffer, "%s, %02d %s %04d %02d:%02d:%02d GMT", DAY_NAMES[day_of_week], day,
+            MONTH_NAMES[month - 1], year, seconds_of_day / 3600, (seconds_of_day / 60) % 60, seconds_of_day % 60);
+    } else if (format == LRLIB_DATE_ISO8601_SECONDS) {
+        return sprintf(buffer, "%04d-%02d-%02dT%02d:%02d:%02dZ", year, month, day,
+            seconds_of_day / 3600, (seconds_of_day / 60) % 60, seconds_of_day % 60);
+    } else {
+        return sprintf(buffer, "%04d-%02d-%02dT%02d:%02d:%02d", year, month, day,
+            seconds_of_day / 3600, (seconds_of_day / 60) % 60, seconds_of_day % 60);
+    }
+}
+
+/**
+ * @brief Writes a time in one of the LRLIB_DATE_* formats to a buffer of at least
+ *        LRLIB_DATE_BUFFER_LENGTH characters.
+ *
+ * The text for the most recent second is kept for each format, so if the time is in the same
+ * second as the last call, only the milliseconds are written.
+ *
+ * @param unix_ms The time, in milliseconds since 1970 (UTC).
+ * @param format One of the LRLIB_DATE_* formats.
+ * @param buffer The buffer to write the text to.
+ * @return Returns the number of characters written (not including the terminating null).
+ */
+int lrlib_format_date(double unix_ms, int format, char* buffer) {
+    double floor(double x);
+    const double second = floor(unix_ms / 1000);
+    int milliseconds;
+    int length;
+
+    if ( (format < 0) || (format >= LRLIB_DATE_FORMAT_COUNT) ) {
+        lr_error_message("Invalid date format: %d.", format);
+        lr_abort();
+    }
+
+    if (second != lrlib_date_cached_second[format]) {
+        lrlib_date_cached_length[format] = lrlib_format_date_seconds(second, format, lrlib_date_cached_text[format]);
+        lrlib_date_cached_second[format] = second;
+    }
+
+    length = lrlib_date_cached_length[format];
+    memcpy(buffer, lrlib_date_cached_text[format], length);
+    if (format == LRLIB_DATE_ISO8601) {
+        milliseconds = (int)(unix_ms - second * 1000);
+        buffer[length] = '.';
+        buffer[length + 1] = '0' + milliseconds / 100;
+        buffer[length + 2] = '0' + (milliseconds / 10) % 10;
+        buffer[length + 3] = '0' + milliseconds % 10;
+        buffer[length + 4] = 'Z';
+        length += 5;
+    }
+    buffer[length] = '\0';
+
+    return length;
+}
+
+/**
+ * @brief Saves the current time to a parameter.
+ *
+ * @param format One of the LRLIB_DATE_* formats.
+ * @param output_param_name The name of the parameter to save the time to.
+ * @return Returns TRUE (1).
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     lrlib_save_now(LRLIB_DATE_RFC1123, "HttpDate");
+ *     web_add_header("Date", lr_eval_string("{HttpDate}"));
+ *
+ *     lrlib_save_now(LRLIB_DATE_ISO8601, "Now"); // e.g. "2024-02-29T13:45:07.123Z"
+ *     web_custom_request("order", "URL=https://{Host}/orders", "Method=POST",
+ *         "Body={\"created\":\"{Now}\"}", LAST);
+ *     return 0;
+ * }
+ */
+int lrlib_save_now(int format, const char* output_param_name) {
+    char buffer[LRLIB_DATE_BUFFER_LENGTH];
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    if ( (output_param_name == NULL) || (strlen(output_param_name) == 0) ) {
+        lr_error_message("output_param_name cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    lrlib_format_date(lrlib_get_unix_time_ms(), format, buffer);
+    lr_save_string(buffer, output_param_name);
+    LRLIB_PROFILE_END("lrlib_save_now", profile_start_usec, 0);
+    return TRUE;
+}
+
+/**
+ * @brief Reads a fixed number of digits. Each digit is checked with a single unsigned comparison,
+ *        and a character that is not a digit sets *invalid to TRUE.
+ */
+int lrlib_parse_digits(const char* text, int count, int* invalid) {
+    int value = 0;
+    unsigned int digit;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        digit = (unsigned char)text[i] - '0';
+        if (digit > 9) {
+            *invalid = TRUE; // also stops at the end of the string
+            return 0;
+        }
+        value = value * 10 + digit;
+    }
+    return value;
+}
+
+/**
+ * @brief Converts an ISO-8601 (RFC 3339) timestamp to milliseconds since 1970 (UTC).
+ *
+ * Accepted forms are "2024-02-29", "2024-02-29T13:45", "2024-02-29T13:45:07", with an optional
+ * fraction of a second (any number of digits; only milliseconds are kept), followed by an optional
+ * time zone: "Z", "+10:00", "+1000" or "+10". A space can be used instead of the "T". If there is
+ * no time zone, the time is treated as UTC.
+ *
+ * @param text The timestamp.
+ * @param unix_ms Set to the time in milliseconds since 1970, if the timestamp is valid.
+ * @return Returns TRUE if the timestamp is valid, or FALSE if it is not.
+ */
+int lrlib_parse_iso8601(const char* text, double* unix_ms) {
+    int invalid = 0;
+    int year;
+    int month;
+    int day;
+    int hour = 0;
+    int minute = 0;
+    int second = 0;
+    double milliseconds = 0;
+    double scale = 100;
+    int offset_hours = 0;
+    int offset_minutes = 0;
+    int sign = 1;
+    const char* p = text;
+
+    if (text == NULL) {
+        return FALSE;
+    }
+
+    // The date. strlen is not needed: lrlib_parse_digits stops at the first character that is not
+    // a digit (including the null at the end of the string), and the function returns before any
+    // character after that is read. So every character that is read is part of the string.
+    year = lrlib_parse_digits(p, 4, &invalid);
+    if (invalid) {
+        return FALSE;
+    }
+    if (p[4] != '-') {
+        return FALSE;
+    }
+    month = lrlib_parse_digits(p + 5, 2, &invalid);
+    if (invalid) {
+        return FALSE;
+    }
+    if (p[7] != '-') {
+        return FALSE;
+    }
+    day = lrlib_parse_digits(p + 8, 2, &invalid);
+    if (invalid) {
+        return FALSE;
+    }
+    p += 10;
+
+    // The time.
+    if ( (*p == 'T') || (*p == 't') || (*p == ' ') ) {
+        hour = lrlib_parse_digits(p + 1, 2, &invalid);
+        if (invalid) {
+            return FALSE;
+        }
+        if (p[3] != ':') {
+            return FALSE;
+        }
+        minute = lrlib_parse_digits(p + 4, 2, &invalid);
+        if (invalid) {
+            return FALSE;
+        }
+        p += 6;
+        if (*p == ':') {
+            second = lrlib_parse_digits(p + 1, 2, &invalid);
+            if (invalid) {
+                return FALSE;
+            }
+            p += 3;
+            if ( (*p == '.') || (*p == ',') ) {
+                p++;
+                if ( (*p < '0') || (*p > '9') ) {
+                    return FALSE;
+                }
+                while ( (*p >= '0') && (*p <= '9') ) {
+                    milliseconds += (*p - '0') * scale;
+                    scale = scale / 10;
+                    p++;
+                }
+            }
+        }
+
+        // The time zone.
+        if ( (*p == 'Z') || (*p == 'z') ) {
+            p++;
+        } else if ( (*p == '+') || (*p == '-') ) {
+            if (*p == '-') {
+                sign = -1;
+            } else {
+                sign = 1;
+            }
+            offset_hours = lrlib_parse_digits(p + 1, 2, &invalid);
+            if (invalid) {
+                return FALSE;
+            }
+            p += 3;
+            if (*p == ':') {
+                p++;
+            }
+            if ( (*p >= '0') && (*p <= '9') ) {
+                offset_minutes = lrlib_parse_digits(p, 2, &invalid);
+                if (invalid) {
+                    return FALSE;
+                }
+                p += 2;
+            }
+        }
+    }
+
+    // Check the ranges all at once (a leap second of :60 is allowed, as in RFC 3339).
+    invalid |= (*p != '\0');
+    invalid |= (month < 1) | (month > 12) | (day < 1) | (day > 31);
+    invalid |= (hour > 23) | (minute > 59) | (second > 60);
+    invalid |= (offset_hours > 23) | (offset_minutes > 59);
+    if (invalid) {
+        return FALSE;
+    }
+    offset_minutes = (offset_hours * 60 + offset_minutes) * sign;
+    if (day > 28) {
+        // Check the day against the length of the month. An invalid day (e.g. February 30) comes
+        // back as a day in the next month.
+        int next_year;
+        int next_month;
+        int next_day;
+        lrlib_civil_from_days(lrlib_days_from_civil(year, month, day), &next_year, &next_month, &next_day);
+        if (next_month != month) {
+            return FALSE;
+        }
+    }
+
+    *unix_ms = (lrlib_days_from_civil(year, month, day) * 86400.0 + hour * 3600 + minute * 60 + second - offset_minutes * 60) * 1000 + (int)milliseconds;
+    return TRUE;
+}
+
+/**
+ * @brief Parses an ISO-8601 timestamp, and aborts the vuser if it is not valid.
+ */
+double lrlib_parse_iso8601_or_abort(const char* text) {
+    double unix_ms = 0;
+
+    if (lrlib_parse_iso8601(text, &unix_ms) == FALSE) {
+        lr_error_message("\"%s\" is not a valid ISO-8601 timestamp.", text);
+        lr_abort();
+    }
+    return unix_ms;
+}
+
+/**
+ * @brief Adds a number of seconds (which can be negative, or have a fraction) to an ISO-8601
+ *        timestamp, and saves the result to a parameter.
+ *
+ * @param timestamp The timestamp, or NULL to use the current time. See lrlib_parse_iso8601 for the
+ *        forms that are accepted.
+ * @param seconds The number of seconds to add, e.g. 86400 for one day.
+ * @param format One of the LRLIB_DATE_* formats.
+ * @param output_param_name The name of the parameter to save the time to.
+ * @return Returns TRUE (1). The vuser is aborted if the timestamp is not valid.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     // Search for bookings over the next 7 days.
+ *     lrlib_save_now(LRLIB_DATE_ISO8601_SECONDS, "From");
+ *     lrlib_add_to_date(NULL, 7 * 86400, LRLIB_DATE_ISO8601_SECONDS, "To");
+ *     web_url("bookings", "URL=https://{Host}/bookings?from={From}&to={To}", LAST);
+ *     return 0;
+ * }
+ */
+int lrlib_add_to_date(const char* timestamp, double seconds, int format, const char* output_param_name) {
+    char buffer[LRLIB_DATE_BUFFER_LENGTH];
+    double unix_ms;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    if ( (output_param_name == NULL) || (strlen(output_param_name) == 0) ) {
+        lr_error_message("output_param_name cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    if (timestamp == NULL) {
+        unix_ms = lrlib_get_unix_time_ms();
+    } else {
+        unix_ms = lrlib_parse_iso8601_or_abort(timestamp);
+    }
+
+    lrlib_format_date(unix_ms + seconds * 1000, format, buffer);
+    lr_save_string(buffer, output_param_name);
+    LRLIB_PROFILE_END("lrlib_add_to_date", profile_start_usec, 0);
+    return TRUE;
+}
+
+/**
+ * @brief Converts an ISO-8601 timestamp (e.g. from a server response) to another format, and
+ *        saves it to a parameter. The time is converted to UTC.
+ *
+ * @param timestamp The timestamp. See lrlib_parse_iso8601 for the forms that are accepted.
+ * @param format One of the LRLIB_DATE_* formats.
+ * @param output_param_name The name of the parameter to save the time to.
+ * @return Returns TRUE (1). The vuser is aborted if the timestamp is not valid.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     lr_save_string("2024-02-29T23:45:07+10:00", "Created");
+ *     lrlib_convert_date(lr_eval_string("{Created}"), LRLIB_DATE_RFC1123, "CreatedHttp");
+ *     lr_output_message("%s", lr_eval_string("{CreatedHttp}")); // "Thu, 29 Feb 2024 13:45:07 GMT"
+ *     return 0;
+ * }
+ */
+int lrlib_convert_date(const char* timestamp, int format, const char* output_param_name) {
+    return lrlib_add_to_date(timestamp, 0, format, output_param_name);
+}
+
+/**
+ * @brief Calculates the time between two ISO-8601 timestamps, and saves it (in seconds, with 3
+ *        decimal places) to a parameter.
+ *
+ * @param start_timestamp The earlier timestamp, or NULL to use the current time.
+ * @param end_timestamp The later timestamp, or NULL to use the current time.
+ * @param output_param_name The name of the parameter to save the number of seconds to. It is
+ *        negative if end_timestamp is before start_timestamp.
+ * @return Returns the number of seconds. The vuser is aborted if either timestamp is not valid.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     double atof(const char* string);
+ *
+ *     // How long did the server take to process the order?
+ *     web_reg_save_param_ex("ParamName=Submitted", "LB=\"submitted\":\"", "RB=\"", LAST);
+ *     web_reg_save_param_ex("ParamName=Completed", "LB=\"completed\":\"", "RB=\"", LAST);
+ *     web_url("order", "URL=https://{Host}/orders/{OrderId}", LAST);
+ *     lrlib_date_difference(lr_eval_string("{Submitted}"), lr_eval_string("{Completed}"), "ProcessingTime");
+ *     lr_user_data_point("order_processing_time", atof(lr_eval_string("{ProcessingTime}")));
+ *     return 0;
+ * }
+ */
+double lrlib_date_difference(const char* start_timestamp, const char* end_timestamp, const char* output_param_name) {
+    char buffer[32];
+    double start_ms;
+    double end_ms;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    if ( (output_param_name == NULL) || (strlen(output_param_name) == 0) ) {
+        lr_error_message("output_param_name cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    if (start_timestamp == NULL) {
+        start_ms = lrlib_get_unix_time_ms();
+    } else {
+        start_ms = lrlib_parse_iso8601_or_abort(start_timestamp);
+    }
+    if (end_timestamp == NULL) {
+        end_ms = lrlib_get_unix_time_ms();
+    } else {
+        end_ms = lrlib_parse_iso8601_or_abort(end_timestamp);
+    }
+
+    sprintf(buffer, "%.3f", (end_ms - start_ms) / 1000);
+    lr_save_string(buffer, output_param_name);
+    LRLIB_PROFILE_END("lrlib_date_difference", profile_start_usec, 0);
+    return (end_ms - start_ms) / 1000;
+}
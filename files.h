@@ -1,3 +1,12 @@
+// Without lrlib.h, the file functions are not profiled (these macros do nothing).
+#ifndef LRLIB_PROFILE_START
+#define LRLIB_PROFILE_START(start_usec) do { } while (0)
+#endif
+
+#ifndef LRLIB_PROFILE_END
+#define LRLIB_PROFILE_END(function_name, start_usec, bytes) do { } while (0)
+#endif
+
 /**
  * Checks if a file already exists on the filesystem.
  *
@@ -7,7 +16,7 @@
  *            file, otherwise function returns FALSE (0).
  */
 int lrlib_file_exists(char* file_name) {
-    int fp; // filestream pointer
+    long fp; // filestream pointer
 
     // Check input variables
     if ( (file_name == NULL) || (strlen(file_name) == 0) ) {
@@ -45,7 +54,7 @@ int lrlib_file_exists(char* file_name) {
  * @return    Returns the size of the file in bytes.
  */
 int lrlib_get_file_size(char* file_name) {
-    int fp; // filestream pointer
+    long fp; // filestream pointer
     int size; // file size
 
     // Check input variables
@@ -128,8 +137,11 @@ int lrlib_get_file_size(char* file_name) {
  */
 int lrlib_save_file(char* file_name, void* file_content, unsigned int file_size) {
     int rc; // function return code
-    int fp; // filestream pointer
+    long fp; // filestream pointer
     int bytes; // number of bytes written to the file
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
 
     // Check input variables
     if ( (file_name == NULL) || (strlen(file_name) == 0) ) {
@@ -165,6 +177,7 @@ int lrlib_save_file(char* file_name, void* file_content, unsigned int file_size)
     fclose(fp);
 
     // Return the number of blocks written by fwrite
+    LRLIB_PROFILE_END("lrlib_save_file", profile_start_usec, file_size);
     return bytes;
 }
 
@@ -186,8 +199,11 @@ int lrlib_save_file(char* file_name, void* file_content, unsigned int file_size)
  */
 int lrlib_append_to_file(char* file_name, char* string) {
     int rc; // return code
-    int fp; // filestream pointer
+    long fp; // filestream pointer
     int length = strlen(string);
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
 
     // Check input variables
     if ( (file_name == NULL) || (strlen(file_name) == 0) ) {
@@ -215,12 +231,16 @@ int lrlib_append_to_file(char* file_name, char* string) {
     fclose(fp);
 
     // Return the number of characters written by fprintf
+    LRLIB_PROFILE_END("lrlib_append_to_file", profile_start_usec, length);
     return rc;
 }
 
 int lrlib_append_string_to_text_file_safe(const char* const fileName, const char* const stringToAppend)
 {
     const char* const MUTEX_NAME = "Local\\lrlib_append_string_to_text_file_safe.060f5f76bc1045cba66f6d43ae8923ff";
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
 
     if (fileName == NULL)
     {
@@ -280,6 +300,7 @@ int lrlib_append_string_to_text_file_safe(const char* const fileName, const char
         ReleaseMutex(mutexHandle);
         CloseHandle(mutexHandle);
 
+        LRLIB_PROFILE_END("lrlib_append_string_to_text_file_safe", profile_start_usec, strlen(stringToAppend));
         return result;
     }
 }
@@ -317,9 +338,12 @@ int lrlib_append_string_to_text_file_safe(const char* const fileName, const char
  * Note: if the file is large, then memory can be freed by calling lr_free_parameter().
  */
 void lrlib_read_text_file(const char* file_name, const char* output_param_name) {
-    int fp; // filestream pointer
+    long fp; // filestream pointer
     int file_size;
     char* file_contents; // a pointer to a buffer to store the contents of the file
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
 
 
     // Check input variables
@@ -376,12 +400,687 @@ void lrlib_read_text_file(const char* file_name, const char* output_param_name)
     // Free the memory allocated for the file contents.
     free(file_contents);
 
+    LRLIB_PROFILE_END("lrlib_read_text_file", profile_start_usec, file_size);
     return;
 }
 
 
 
 
+/*
+ * PDF checks
+ * ==========
+ * Checks that a downloaded PDF is complete and well-formed, without reading the whole document.
+ * Only the parts of the file that describe its structure are read:
+ *  1. the "%PDF-x.y" header at the start,
+ *  2. the "startxref" offset and "%%EOF" marker at the end (a truncated download fails here),
+ *  3. the cross-reference table(s) that startxref points to, and the trailer dictionary,
+ *  4. the document catalog, and the page tree root (which holds the page count).
+ * Files are memory mapped, so only the pages of the file that are read are loaded from disk.
+ *
+ * PDF 1.5 and later files can store the cross-reference table as a compressed stream. The
+ * structure of these files is still checked, but their page count cannot be found without
+ * decompressing the stream, so it is reported as unknown.
+ */
+
+#define LRLIB_PDF_TAIL_LENGTH 1024 // "%%EOF" must be within the last 1024 bytes
+#define LRLIB_PDF_MAX_XREF_SECTIONS 64 // the most incremental updates to follow through /Prev
+#define LRLIB_PDF_ERROR_LENGTH 128
+
+typedef struct {
+    const unsigned char* data;
+    int length;
+    char version[4]; // e.g. "1.7"
+    int pages; // -1 if unknown
+    int xref_stream; // TRUE if the cross-reference table is a stream
+    int xref_offsets[LRLIB_PDF_MAX_XREF_SECTIONS]; // the offset of each cross-reference table, newest first
+    int xref_count;
+    int root_object; // the object number of the document catalog
+    char error[LRLIB_PDF_ERROR_LENGTH]; // empty if the PDF is valid
+} lrlib_pdf;
+
+/**
+ * Returns TRUE if a character is PDF whitespace.
+ */
+int lrlib_pdf_is_whitespace(unsigned char c) {
+    return (c == ' ') || (c == '\n') || (c == '\r') || (c == '\t') || (c == '\f') || (c == '\0');
+}
+
+/**
+ * Returns TRUE if a character ends a PDF name or number (whitespace or a delimiter).
+ */
+int lrlib_pdf_is_delimiter(unsigned char c) {
+    return lrlib_pdf_is_whitespace(c) || (c == '/') || (c == '<') || (c == '>') || (c == '[') ||
+        (c == ']') || (c == '(') || (c == ')') || (c == '%');
+}
+
+/**
+ * Skips whitespace and comments, and returns the position of the next token.
+ */
+int lrlib_pdf_skip_whitespace(const lrlib_pdf* pdf, int position) {
+    while (position < pdf->length) {
+        if (pdf->data[position] == '%') {
+            while ( (position < pdf->length) && (pdf->data[position] != '\n') && (pdf->data[position] != '\r') ) {
+                position++;
+            }
+        } else if (lrlib_pdf_is_whitespace(pdf->data[position])) {
+            position++;
+        } else {
+            break;
+        }
+    }
+    return position;
+}
+
+/**
+ * Returns TRUE if the text at a position matches a token (which must be followed by a delimiter,
+ * or the end of the data).
+ */
+int lrlib_pdf_token_at(const lrlib_pdf* pdf, int position, const char* token) {
+    const int length = strlen(token);
+
+    if ( (position < 0) || (position + length > pdf->length) || (memcmp(pdf->data + position, token, length) != 0) ) {
+        return FALSE;
+    }
+    return (position + length == pdf->length) || lrlib_pdf_is_delimiter(pdf->data[position + length]);
+}
+
+/**
+ * Reads a non-negative integer at a position (after any whitespace). The position is moved past
+ * the number.
+ *
+ * @return Returns TRUE if there is a number at the position.
+ */
+int lrlib_pdf_read_integer(const lrlib_pdf* pdf, int* position, int* value) {
+    int p = lrlib_pdf_skip_whitespace(pdf, *position);
+    const int start = p;
+
+    *value = 0;
+    while ( (p < pdf->length) && (pdf->data[p] >= '0') && (pdf->data[p] <= '9') && (*value < 100000000) ) {
+        *value = *value * 10 + (pdf->data[p] - '0');
+        p++;
+    }
+    if ( (p == start) || ( (p < pdf->length) && !lrlib_pdf_is_delimiter(pdf->data[p]) ) ) {
+        return FALSE;
+    }
+    *position = p;
+    return TRUE;
+}
+
+/**
+ * Finds the end of the dictionary that starts ("<<") at a position, allowing for nested
+ * dictionaries and for strings (which can contain ">>", or end just before it, as in <4E6F>>>).
+ *
+ * @return Returns the position just after the closing ">>", or -1 if the dictionary does not end.
+ */
+int lrlib_pdf_dictionary_end(const lrlib_pdf* pdf, int position) {
+    int depth = 0;
+    int string_depth;
+
+    while (position + 1 < pdf->length) {
+        const unsigned char c = pdf->data[position];
+
+        if ( (c == '<') && (pdf->data[position + 1] == '<') ) {
+            depth++;
+            position += 2;
+        } else if ( (c == '>') && (pdf->data[position + 1] == '>') ) {
+            depth--;
+            position += 2;
+            if (depth == 0) {
+                return position;
+            }
+        } else if (c == '<') {
+            // A hex string (e.g. <4E6F>) is skipped up to its closing ">", so that the ">" is not
+            // counted as part of a ">>".
+            position++;
+            while ( (position < pdf->length) && (pdf->data[position] != '>') ) {
+                position++;
+            }
+            position++;
+        } else if (c == '(') {
+            // Strings can contain balanced parentheses, and escaped characters.
+            string_depth = 1;
+            position++;
+            while ( (position < pdf->length) && (string_depth > 0) ) {
+                if (pdf->data[position] == '\\') {
+                    position++;
+                } else if (pdf->data[position] == '(') {
+                    string_depth++;
+                } else if (pdf->data[position] == ')') {
+                    string_depth--;
+                }
+                position++;
+            }
+        } else if (c == '%') {
+            position = lrlib_pdf_skip_whitespace(pdf, position);
+        } else {
+            position++;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Finds a key (e.g. "/Root") at the top level of a dictionary, and returns the position just after
+ * it, or -1 if the dictionary does not have the key. The dictionary is from start ("<<") to end.
+ */
+int lrlib_pdf_find_key(const lrlib_pdf* pdf, int start, int end, const char* key) {
+    const int key_length = strlen(key);
+    int depth = 0;
+    int position = start;
+
+    while (position < end - 1) {
+        const unsigned char c = pdf->data[position];
+
+        if ( (c == '<') && (pdf->data[position + 1] == '<') ) {
+            depth++;
+            position += 2;
+        } else if ( (c == '>') && (pdf->data[position + 1] == '>') ) {
+            depth--;
+            position += 2;
+        } else if (c == '<') {
+            // Skip hex strings (e.g. <4E6F>), as their closing ">" is not part of a ">>".
+            position++;
+            while ( (position < end) && (pdf->data[position] != '>') ) {
+                position++;
+            }
+            position++;
+        } else if ( (c == '(') || (c == '[') ) {
+            // Skip strings and arrays, as they can contain names that are not keys.
+            int nested_end = position + 1;
+            int nesting = 1;
+            unsigned char close = ']';
+
+            if (c == '(') {
+                close = ')';
+            }
+            while ( (nested_end < end) && (nesting > 0) ) {
+                if ( (c == '(') && (pdf->data[nested_end] == '\\') ) {
+                    nested_end++;
+                } else if (pdf->data[nested_end] == c) {
+                    nesting++;
+                } else if (pdf->data[nested_end] == close) {
+                    nesting--;
+                }
+                nested_end++;
+            }
+            position = nested_end;
+        } else if ( (depth == 1) && (c == '/') && lrlib_pdf_token_at(pdf, position, key) ) {
+            return position + key_length;
+        } else {
+            position++;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Reads an indirect reference ("12 0 R") at a position, and returns the object number, or -1.
+ */
+int lrlib_pdf_read_reference(const lrlib_pdf* pdf, int position) {
+    int object_number;
+    int generation;
+
+    if ( (position < 0) || !lrlib_pdf_read_integer(pdf, &position, &object_number) || !lrlib_pdf_read_integer(pdf, &position, &generation) ) {
+        return -1;
+    }
+    position = lrlib_pdf_skip_whitespace(pdf, position);
+    if (lrlib_pdf_token_at(pdf, position, "R") == FALSE) {
+        return -1;
+    }
+    return object_number;
+}
+
+/**
+ * Reads the integer value of a dictionary key, or returns -1 if the key is missing or its value is
+ * not an integer.
+ */
+int lrlib_pdf_read_key_integer(const lrlib_pdf* pdf, int start, int end, const char* key) {
+    int position = lrlib_pdf_find_key(pdf, start, end, key);
+    int value;
+
+    if ( (position < 0) || !lrlib_pdf_read_integer(pdf, &position, &value) ) {
+        return -1;
+    }
+    return value;
+}
+
+/**
+ * Checks an indirect object header ("12 0 obj") at an offset, and returns the position of the
+ * object's value (after "obj"), or -1. If object_number is not -1, it must match.
+ */
+int lrlib_pdf_object_start(const lrlib_pdf* pdf, int offset, int object_number) {
+    int number;
+    int generation;
+
+    if ( (offset < 0) || (offset >= pdf->length) || !lrlib_pdf_read_integer(pdf, &offset, &number) ||
+         !lrlib_pdf_read_integer(pdf, &offset, &generation) ) {
+        return -1;
+    }
+    offset = lrlib_pdf_skip_whitespace(pdf, offset);
+    if ( !lrlib_pdf_token_at(pdf, offset, "obj") || ( (object_number != -1) && (number != object_number) ) ) {
+        return -1;
+    }
+    return lrlib_pdf_skip_whitespace(pdf, offset + 3);
+}
+
+/**
+ * Checks a cross-reference table ("xref", then subsections of 20-byte entries, then "trailer")
+ * and returns the position of the trailer dictionary, or -1 (with pdf->error set).
+ */
+int lrlib_pdf_check_xref_table(lrlib_pdf* pdf, int offset) {
+    int position = offset + 4; // after "xref"
+    int first;
+    int count;
+
+    for (;;) {
+        position = lrlib_pdf_skip_whitespace(pdf, position);
+        if (lrlib_pdf_token_at(pdf, position, "trailer")) {
+            return lrlib_pdf_skip_whitespace(pdf, position + 7);
+        }
+        if ( !lrlib_pdf_read_integer(pdf, &position, &first) || !lrlib_pdf_read_integer(pdf, &position, &count) ) {
+            sprintf(pdf->error, "Invalid cross-reference subsection at offset %d.", position);
+            return -1;
+        }
+
+        // Each entry is exactly 20 bytes: "nnnnnnnnnn ggggg n\r\n". Check that they are all there,
+        // and check the format of the first and last ones.
+        position = lrlib_pdf_skip_whitespace(pdf, position);
+        if ( (count < 0) || (position + count * 20.0 > pdf->length) ) {
+            sprintf(pdf->error, "Cross-reference subsection at offset %d is truncated.", position);
+            return -1;
+        }
+        if ( (count > 0) && ( (pdf->data[position + 10] != ' ') || (pdf->data[position + 16] != ' ') ||
+             ( (pdf->data[position + 17] != 'n') && (pdf->data[position + 17] != 'f') ) ||
+             ( (pdf->data[position + (count - 1) * 20 + 17] != 'n') && (pdf->data[position + (count - 1) * 20 + 17] != 'f') ) ) ) {
+            sprintf(pdf->error, "Invalid cross-reference entry at offset %d.", position);
+            return -1;
+        }
+        position += count * 20;
+    }
+}
+
+/**
+ * Finds the offset of an object using the cross-reference tables (newest first), or returns -1.
+ */
+int lrlib_pdf_find_object(const lrlib_pdf* pdf, int object_number) {
+    int section;
+    int position;
+    int first;
+    int count;
+    int offset;
+    int entry;
+
+    for (section = 0; section < pdf->xref_count; section++) {
+        position = pdf->xref_offsets[section] + 4;
+        for (;;) {
+            position = lrlib_pdf_skip_whitespace(pdf, position);
+            if ( !lrlib_pdf_read_integer(pdf, &position, &first) || !lrlib_pdf_read_integer(pdf, &position, &count) ) {
+                break; // "trailer"
+            }
+            position = lrlib_pdf_skip_whitespace(pdf, position);
+            if ( (object_number >= first) && (object_number < first + count) ) {
+                entry = position + (object_number - first) * 20;
+                if (pdf->data[entry + 17] != 'n') {
+                    return -1; // a free (deleted) object
+                }
+                lrlib_pdf_read_integer(pdf, &entry, &offset);
+                return offset;
+            }
+            position += count * 20;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Checks the structure of a PDF in memory, and finds its page count.
+ *
+ * @return Returns TRUE if the PDF is valid, or FALSE (with pdf->error set) if it is not.
+ */
+int lrlib_pdf_check(lrlib_pdf* pdf) {
+    int tail_start;
+    int position;
+    int eof_position = -1;
+    int startxref_position = -1;
+    int xref_offset;
+    int trailer_start;
+    int trailer_end;
+    int object_start;
+    int object_end;
+    int pages_object;
+    int i;
+
+    pdf->pages = -1;
+    pdf->xref_stream = FALSE;
+    pdf->xref_count = 0;
+    pdf->root_object = -1;
+    pdf->version[0] = '\0';
+    pdf->error[0] = '\0';
+
+    // 1. The header, e.g. "%PDF-1.7". It is usually at the very start, but may be preceded by
+    // some junk.
+    for (i = 0; (i + 8 <= pdf->length) && (i < 1024); i++) {
+        if ( (memcmp(pdf->data + i, "%PDF-", 5) == 0) && (pdf->data[i + 5] >= '1') && (pdf->data[i + 5] <= '2') &&
+             (pdf->data[i + 6] == '.') && (pdf->data[i + 7] >= '0') && (pdf->data[i + 7] <= '9') ) {
+            memcpy(pdf->version, pdf->data + i + 5, 3);
+            pdf->version[3] = '\0';
+            break;
+        }
+    }
+    if (pdf->version[0] == '\0') {
+        strcpy(pdf->error, "There is no %PDF header.");
+        return FALSE;
+    }
+
+    // 2. "%%EOF", and the "startxref" before it, near the end of the file.
+    tail_start = pdf->length - LRLIB_PDF_TAIL_LENGTH;
+    if (tail_start < 0) {
+        tail_start = 0;
+    }
+    for (i = pdf->length - 5; i >= tail_start; i--) {
+        if (memcmp(pdf->data + i, "%%EOF", 5) == 0) {
+            eof_position = i;
+            break;
+        }
+    }
+    if (eof_position < 0) {
+        strcpy(pdf->error, "There is no %%EOF marker at the end of the file (it may be truncated).");
+        return FALSE;
+    }
+    for (i = eof_position - 9; i >= tail_start; i--) {
+        if (memcmp(pdf->data + i, "startxref", 9) == 0) {
+            startxref_position = i + 9;
+            break;
+        }
+    }
+    if ( (startxref_position < 0) || !lrlib_pdf_read_integer(pdf, &startxref_position, &xref_offset) ) {
+        strcpy(pdf->error, "There is no startxref offset before %%EOF.");
+        return FALSE;
+    }
+
+    // 3. The cross-reference tables and trailers. Files that have been updated incrementally
+    // have several, linked by /Prev.
+    while (xref_offset != -1) {
+        if ( (xref_offset <= 0) || (xref_offset >= pdf->length) ) {
+            sprintf(pdf->error, "The cross-reference offset %d is outside the file.", xref_offset);
+            return FALSE;
+        }
+        for (i = 0; i < pdf->xref_count; i++) {
+            if (pdf->xref_offsets[i] == xref_offset) {
+                strcpy(pdf->error, "The cross-reference tables form a loop.");
+                return FALSE;
+            }
+        }
+        if (pdf->xref_count == LRLIB_PDF_MAX_XREF_SECTIONS) {
+            strcpy(pdf->error, "There are too many cross-reference tables.");
+            return FALSE;
+        }
+        pdf->xref_offsets[pdf->xref_count] = xref_offset;
+        pdf->xref_count++;
+
+        if (lrlib_pdf_token_at(pdf, xref_offset, "xref")) {
+            trailer_start = lrlib_pdf_check_xref_table(pdf, xref_offset);
+            if (trailer_start < 0) {
+                return FALSE;
+            }
+        } else {
+            // A cross-reference stream: "n 0 obj << /Type /XRef ... >> stream ... endstream".
+            trailer_start = lrlib_pdf_object_start(pdf, xref_offset, -1);
+            if (trailer_start < 0) {
+                sprintf(pdf->error, "There is no cross-reference table or stream at offset %d.", xref_offset);
+                return FALSE;
+            }
+            pdf->xref_stream = TRUE;
+        }
+
+        if ( (trailer_start + 2 > pdf->length) || (memcmp(pdf->data + trailer_start, "<<", 2) != 0) ||
+             ( (trailer_end = lrlib_pdf_dictionary_end(pdf, trailer_start)) < 0 ) ) {
+            sprintf(pdf->error, "Invalid trailer dictionary at offset %d.", trailer_start);
+            return FALSE;
+        }
+
+        if (pdf->xref_stream == TRUE) {
+            int stream_length = lrlib_pdf_read_key_integer(pdf, trailer_start, trailer_end, "/Length");
+            int type_position = lrlib_pdf_find_key(pdf, trailer_start, trailer_end, "/Type");
+
+            // The stream dictionary must have "/Type /XRef".
+            if ( (type_position < 0) || !lrlib_pdf_token_at(pdf, lrlib_pdf_skip_whitespace(pdf, type_position), "/XRef") ) {
+                sprintf(pdf->error, "The object at offset %d is not a cross-reference stream.", xref_offset);
+                return FALSE;
+            }
+            position = lrlib_pdf_skip_whitespace(pdf, trailer_end);
+            if ( !lrlib_pdf_token_at(pdf, position, "stream") || (stream_length < 0) ) {
+                sprintf(pdf->error, "Invalid cross-reference stream at offset %d.", xref_offset);
+                return FALSE;
+            }
+            // The data starts after "stream" and an end of line, and is followed by "endstream".
+            position += 6;
+            if ( (position < pdf->length) && (pdf->data[position] == '\r') ) {
+                position++;
+            }
+            if ( (position < pdf->length) && (pdf->data[position] == '\n') ) {
+                position++;
+            }
+            position = lrlib_pdf_skip_whitespace(pdf, position + stream_length);
+            if (lrlib_pdf_token_at(pdf, position, "endstream") == FALSE) {
+                sprintf(pdf->error, "The cross-reference stream at offset %d is truncated.", xref_offset);
+                return FALSE;
+            }
+        }
+
+        if (pdf->root_object == -1) {
+            pdf->root_object = lrlib_pdf_read_reference(pdf, lrlib_pdf_find_key(pdf, trailer_start, trailer_end, "/Root"));
+            if (lrlib_pdf_read_key_integer(pdf, trailer_start, trailer_end, "/Size") <= 0) {
+                strcpy(pdf->error, "The trailer has no /Size.");
+                return FALSE;
+            }
+        }
+        xref_offset = lrlib_pdf_read_key_integer(pdf, trailer_start, trailer_end, "/Prev");
+    }
+    if (pdf->root_object < 0) {
+        strcpy(pdf->error, "The trailer has no /Root.");
+        return FALSE;
+    }
+
+    // 4. The page count, from the catalog's /Pages object. Objects can only be found this way if
+    // the cross-reference tables are not compressed.
+    if (pdf->xref_stream == TRUE) {
+        return TRUE;
+    }
+    object_start = lrlib_pdf_object_start(pdf, lrlib_pdf_find_object(pdf, pdf->root_object), pdf->root_object);
+    if ( (object_start < 0) || ( (object_end = lrlib_pdf_dictionary_end(pdf, object_start)) < 0 ) ) {
+        sprintf(pdf->error, "The document catalog (object %d) is missing or invalid.", pdf->root_object);
+        return FALSE;
+    }
+    pages_object = lrlib_pdf_read_reference(pdf, lrlib_pdf_find_key(pdf, object_start, object_end, "/Pages"));
+    object_start = lrlib_pdf_object_start(pdf, lrlib_pdf_find_object(pdf, pages_object), pages_object);
+    if ( (pages_object < 0) || (object_start < 0) || ( (object_end = lrlib_pdf_dictionary_end(pdf, object_start)) < 0 ) ) {
+        strcpy(pdf->error, "The page tree is missing or invalid.");
+        return FALSE;
+    }
+    pdf->pages = lrlib_pdf_read_key_integer(pdf, object_start, object_end, "/Count");
+    if (pdf->pages < 0) {
+        strcpy(pdf->error, "The page tree has no /Count.");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Saves the results of a PDF check to parameters.
+ */
+void lrlib_pdf_save_results(const lrlib_pdf* pdf, int valid, const char* output_prefix) {
+    char param_name[LRLIB_PARAM_NAME_BUFFER_LENGTH];
+    char number[16];
+
+    sprintf(param_name, "%s_error", output_prefix);
+    lr_save_string(pdf->error, param_name);
+    sprintf(param_name, "%s_version", output_prefix);
+    lr_save_string(pdf->version, param_name);
+    sprintf(param_name, "%s_size", output_prefix);
+    sprintf(number, "%d", pdf->length);
+    lr_save_string(number, param_name);
+    sprintf(param_name, "%s_pages", output_prefix);
+    if ( (valid == TRUE) && (pdf->pages >= 0) ) {
+        sprintf(number, "%d", pdf->pages);
+    } else {
+        number[0] = '\0';
+    }
+    lr_save_string(number, param_name);
+}
+
+/**
+ * Checks that a PDF (e.g. a downloaded document) is complete and well-formed.
+ *
+ * These parameters are saved:
+ *  - {<prefix>_error}: why the PDF is not valid, or empty if it is valid.
+ *  - {<prefix>_version}: the PDF version from the header, e.g. "1.7".
+ *  - {<prefix>_size}: the size of the PDF in bytes.
+ *  - {<prefix>_pages}: the number of pages, or empty if the PDF is not valid or the page count
+ *    cannot be found (PDFs with compressed cross-reference streams).
+ *
+ * Example code:
+ *     // Check a PDF that has been downloaded, without saving it to a file.
+ *     web_reg_save_param_ex("ParamName=PdfContents", "LB=", "RB=", SEARCH_FILTERS, "Scope=Body", LAST);
+ *     web_url("Download PDF", "URL=https://{Host}/statements/{StatementId}.pdf", "Resource=0", LAST);
+ *     if (lrlib_check_pdf(lr_eval_string("{PdfContents}"), web_get_int_property(HTTP_INFO_DOWNLOAD_SIZE), "Pdf") == FALSE) {
+ *         lr_error_message("Invalid PDF: %s", lr_eval_string("{Pdf_error}"));
+ *     }
+ *     lr_output_message("The PDF has %s pages.", lr_eval_string("{Pdf_pages}"));
+ *
+ * @param[in] The PDF data (which can contain null bytes).
+ * @param[in] The size of the PDF data in bytes.
+ * @param[in] The start of the names of the parameters to save the results to.
+ * @return    Returns TRUE (1) if the PDF is valid, otherwise FALSE (0).
+ */
+int lrlib_check_pdf(const char* pdf_content, int pdf_size, const char* output_prefix) {
+    lrlib_pdf pdf;
+    int valid;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if ( (pdf_content == NULL) || (pdf_size < 0) ) {
+        lr_error_message("pdf_content cannot be NULL, and pdf_size cannot be negative.");
+        lr_abort();
+    } else if ( (output_prefix == NULL) || (strlen(output_prefix) == 0) || (strlen(output_prefix) > LRLIB_MAX_PARAM_NAME_LENGTH - 8) ) {
+        lr_error_message("output_prefix cannot be NULL, empty, or longer than %d characters.", LRLIB_MAX_PARAM_NAME_LENGTH - 8);
+        lr_abort();
+    }
+
+    pdf.data = (const unsigned char*)pdf_content;
+    pdf.length = pdf_size;
+    valid = lrlib_pdf_check(&pdf);
+    lrlib_pdf_save_results(&pdf, valid, output_prefix);
+    LRLIB_PROFILE_END("lrlib_check_pdf", profile_start_usec, pdf_size);
+    return valid;
+}
+
+/**
+ * Checks that a PDF file is complete and well-formed. The file is memory mapped, so only the parts
+ * of it that are checked are read from disk. The parameters that are saved are the same as for
+ * lrlib_check_pdf.
+ *
+ * Example code:
+ *     lrlib_save_file("C:\\TEMP\\test.pdf", lr_eval_string("{PdfContents}"), pdf_size);
+ *     if (lrlib_check_pdf_file("C:\\TEMP\\test.pdf", "Pdf") == FALSE) {
+ *         lr_error_message("Invalid PDF: %s", lr_eval_string("{Pdf_error}"));
+ *     }
+ *
+ * @param[in] The name of the PDF file. Note: Include the full path in the file name.
+ * @param[in] The start of the names of the parameters to save the results to.
+ * @return    Returns TRUE (1) if the PDF is valid, otherwise FALSE (0).
+ */
+int lrlib_check_pdf_file(const char* file_name, const char* output_prefix) {
+    lrlib_pdf pdf;
+    int valid = FALSE;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if ( (file_name == NULL) || (strlen(file_name) == 0) ) {
+        lr_error_message("file_name cannot be NULL or empty.");
+        lr_abort();
+    } else if ( (output_prefix == NULL) || (strlen(output_prefix) == 0) || (strlen(output_prefix) > LRLIB_MAX_PARAM_NAME_LENGTH - 8) ) {
+        lr_error_message("output_prefix cannot be NULL, empty, or longer than %d characters.", LRLIB_MAX_PARAM_NAME_LENGTH - 8);
+        lr_abort();
+    }
+
+    memset(&pdf, 0, sizeof(pdf));
+    sprintf(pdf.error, "Cannot open file \"%.80s\".", file_name);
+
+#ifdef LRLIB_LINUX
+    {
+        void* mmap(void* address, unsigned long length, int protection, int flags, int fd, long offset);
+        long lseek(int fd, long offset, int whence);
+        const int fd = open(file_name, 0); // O_RDONLY
+        void* mapping;
+
+        if (fd >= 0) {
+            pdf.length = (int)lseek(fd, 0, 2); // SEEK_END
+            if (pdf.length == 0) {
+                pdf.data = (const unsigned char*)"";
+                valid = lrlib_pdf_check(&pdf);
+            } else if (pdf.length > 0) {
+                mapping = mmap(NULL, pdf.length, 1, 2, fd, 0); // PROT_READ, MAP_PRIVATE
+                if (mapping != (void*)-1) {
+                    pdf.data = (const unsigned char*)mapping;
+                    valid = lrlib_pdf_check(&pdf);
+                    munmap(mapping, pdf.length);
+                }
+            }
+            close(fd);
+        }
+    }
+#else
+    {
+        void* MapViewOfFile(unsigned int mapping, unsigned long access, unsigned long offset_high, unsigned long offset_low, unsigned long size);
+        const unsigned long GENERIC_READ = 0x80000000;
+        const unsigned long PAGE_READONLY = 0x02;
+        const unsigned long FILE_MAP_READ = 0x04;
+        unsigned int file;
+        unsigned int mapping;
+        void* view;
+
+        lrlib_load_dll("kernel32.dll");
+        file = CreateFileA(file_name, GENERIC_READ, 1, NULL, 3, 0, NULL); // FILE_SHARE_READ, OPEN_EXISTING
+        if (file != 0xFFFFFFFF) { // INVALID_HANDLE_VALUE
+            pdf.length = GetFileSize(file, NULL);
+            if (pdf.length == 0) {
+                pdf.data = (const unsigned char*)""; // an empty file cannot be mapped
+                valid = lrlib_pdf_check(&pdf);
+            } else {
+                mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+                if (mapping != 0) {
+                    view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                    if (view != NULL) {
+                        pdf.data = (const unsigned char*)view;
+                        valid = lrlib_pdf_check(&pdf);
+                        UnmapViewOfFile(view);
+                    }
+                    CloseHandle(mapping);
+                }
+            }
+            CloseHandle(file);
+        }
+    }
+#endif
+
+    if ( (valid == FALSE) && (strncmp(pdf.error, "Cannot open", 11) == 0) ) {
+        lr_error_message("%s", pdf.error);
+    }
+    lrlib_pdf_save_results(&pdf, valid, output_prefix);
+    LRLIB_PROFILE_END("lrlib_check_pdf_file", profile_start_usec, pdf.length);
+    return valid;
+}
+
+
+
+
 // TODO list of functions
 // ======================
 // * append/write to file with locking
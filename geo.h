@@ -0,0 +1,619 @@
+/*
+ * Geographic point sets
+ * =====================
+ * distance_between_two_points (in lrlib.h) is fine for checking one distance, but it converts its
+ * four arguments from strings every time. If a script needs to compare an address with hundreds
+ * of locations (e.g. depots or stores) in every iteration, load the locations once into a point
+ * set, then query the point set.
+ *
+ * A point set keeps the coordinates in separate arrays of doubles (already converted to radians,
+ * with cos(latitude) calculated in advance), so the distance calculation is a short loop with no
+ * string handling. The points are also sorted into a grid of 1 degree by 1 degree cells, so that a
+ * "within radius" or "nearest" query only needs to look at the points in the cells near the query
+ * point.
+ *
+ * Distances are in meters, and are calculated in the same way as distance_between_two_points
+ * (the Haversine formula, with an earth radius of 6373 km).
+ */
+
+#define LRLIB_MAX_GEO_POINT_SETS 4
+#define LRLIB_GEO_EARTH_RADIUS 6373000.0 // meters, as used by distance_between_two_points
+#define LRLIB_GEO_PI 3.14159265358979323846
+#define LRLIB_GEO_GRID_ROWS 180 // 1 degree of latitude per row
+#define LRLIB_GEO_GRID_COLUMNS 360 // 1 degree of longitude per column
+
+typedef struct {
+    int count; // 0 if the point set is not in use
+    // The points, sorted by grid cell. Each array has "count" elements.
+    double* latitudes; // radians
+    double* longitudes; // radians
+    double* cos_latitudes;
+    int* cell_keys; // row * LRLIB_GEO_GRID_COLUMNS + column, in ascending order
+    int* original_positions; // the position of each point in the parameter arrays it was loaded from (0-based)
+    char** ids; // the ID of each point (in the original order)
+    char* id_buffer; // holds the ID strings
+    int row_start[LRLIB_GEO_GRID_ROWS + 1]; // the first point in each row of the grid
+    // Work areas for queries (so that they do not allocate memory each time).
+    int* result_points;
+    double* result_distances;
+} lrlib_geo_point_set;
+
+lrlib_geo_point_set lrlib_geo_point_sets[LRLIB_MAX_GEO_POINT_SETS];
+
+/**
+ * @brief Returns the point set for an ID, or aborts if the ID is not valid.
+ */
+lrlib_geo_point_set* lrlib_geo_get_point_set(int point_set_id) {
+    if ( (point_set_id < 1) || (point_set_id > LRLIB_MAX_GEO_POINT_SETS) || (lrlib_geo_point_sets[point_set_id - 1].count == 0) ) {
+        lr_error_message("Invalid point set ID %d.", point_set_id);
+        lr_abort();
+    }
+
+    return &lrlib_geo_point_sets[point_set_id - 1];
+}
+
+/**
+ * @brief Returns the grid row (0 to 179) for a latitude in degrees.
+ */
+int lrlib_geo_grid_row(double latitude) {
+    int row = (int)(latitude + 90);
+
+    if (row < 0) {
+        row = 0;
+    } else if (row >= LRLIB_GEO_GRID_ROWS) {
+        row = LRLIB_GEO_GRID_ROWS - 1;
+    }
+    return row;
+}
+
+/**
+ * @brief Returns the grid column (0 to 359) for a longitude in degrees.
+ */
+int lrlib_geo_grid_column(double longitude) {
+    int column = (int)(longitude + 180);
+
+    if (column < 0) {
+        column = 0;
+    } else if (column >= LRLIB_GEO_GRID_COLUMNS) {
+        column = LRLIB_GEO_GRID_COLUMNS - 1;
+    }
+    return column;
+}
+
+/**
+ * @brief Frees the memory used by a point set.
+ *
+ * @param point_set_id The ID returned by lrlib_geo_load.
+ * @return This function does not return a value.
+ */
+void lrlib_geo_free(int point_set_id) {
+    lrlib_geo_point_set* set = lrlib_geo_get_point_set(point_set_id);
+
+    free(set->latitudes);
+    free(set->longitudes);
+    free(set->cos_latitudes);
+    free(set->cell_keys);
+    free(set->original_positions);
+    free(set->ids);
+    free(set->id_buffer);
+    free(set->result_points);
+    free(set->result_distances);
+    memset(set, 0, sizeof(lrlib_geo_point_set));
+}
+
+/**
+ * @brief Loads a set of points (e.g. the locations of all the depots) from parameter arrays, so
+ *        that they can be searched quickly with lrlib_geo_distances, lrlib_geo_within_radius and
+ *        lrlib_geo_nearest.
+ *
+ * @param latitude_paramarr The name of a parameter array of latitudes, in degrees.
+ * @param longitude_paramarr The name of a parameter array of longitudes, in degrees. It must have
+ *        the same number of elements as latitude_paramarr.
+ * @param id_paramarr The name of a parameter array of IDs (e.g. depot names) that the queries
+ *        return. It must have the same number of elements as latitude_paramarr. If this is NULL,
+ *        the queries return the position of each point in the parameter arrays (starting at 1).
+ * @return Returns the ID of the point set, which is used by the other lrlib_geo_* functions.
+ *
+ * @example
+ *
+ * vuser_init()
+ * {
+ *     // DepotLat, DepotLong and DepotName are parameter arrays, e.g. saved with
+ *     // web_reg_save_param_ex(..., "Ordinal=ALL", ...) or lrlib_str_split.
+ *     depots = lrlib_geo_load("DepotLat", "DepotLong", "DepotName"); // "int depots;" is a global variable
+ *     return 0;
+ * }
+ *
+ * Action()
+ * {
+ *     double atof(const char* string);
+ *     double latitude = atof(lr_eval_string("{AddressLat}"));
+ *     double longitude = atof(lr_eval_string("{AddressLong}"));
+ *
+ *     // The three nearest depots, closest first.
+ *     lrlib_geo_nearest(depots, latitude, longitude, 3, "NearDepot");
+ *     lr_output_message("Nearest depot: %s (%s m)", lr_paramarr_idx("NearDepot", 1), lr_paramarr_idx("NearDepot_distance", 1));
+ *
+ *     // Every depot within 10 km.
+ *     lrlib_geo_within_radius(depots, latitude, longitude, 10000, "LocalDepot");
+ *     return 0;
+ * }
+ *
+ * @note Each vuser can have up to 4 point sets loaded at the same time.
+ */
+int lrlib_geo_load(const char* latitude_paramarr, const char* longitude_paramarr, const char* id_paramarr) {
+    double cos(double x);
+    lrlib_geo_point_set* set = NULL;
+    int point_set_id;
+    int count;
+    int i;
+    int* row_counts; // used to sort the points by grid cell
+    int* positions; // the sorted position of each point
+    double latitude;
+    double longitude;
+    int id_buffer_length = 0;
+    char* id_position;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if ( (latitude_paramarr == NULL) || (longitude_paramarr == NULL) ) {
+        lr_error_message("latitude_paramarr and longitude_paramarr cannot be NULL.");
+        lr_abort();
+    }
+
+    count = lr_paramarr_len((char*)latitude_paramarr);
+    if (count < 1) {
+        lr_error_message("Parameter array \"%s\" is empty.", latitude_paramarr);
+        lr_abort();
+    } else if (lr_paramarr_len((char*)longitude_paramarr) != count) {
+        lr_error_message("\"%s\" and \"%s\" must have the same number of elements.", latitude_paramarr, longitude_paramarr);
+        lr_abort();
+    } else if ( (id_paramarr != NULL) && (lr_paramarr_len((char*)id_paramarr) != count) ) {
+        lr_error_message("\"%s\" and \"%s\" must have the same number of elements.", latitude_paramarr, id_paramarr);
+        lr_abort();
+    }
+
+    for (point_set_id = 1; point_set_id <= LRLIB_MAX_GEO_POINT_SETS; point_set_id++) {
+        if (lrlib_geo_point_sets[point_set_id - 1].count == 0) {
+            set = &lrlib_geo_point_sets[point_set_id - 1];
+            break;
+        }
+    }
+    if (set == NULL) {
+        lr_error_message("Too many point sets (the maximum is %d). Use lrlib_geo_free to free a point set that is not needed.", LRLIB_MAX_GEO_POINT_SETS);
+        lr_abort();
+    }
+
+    // Find the length of all the IDs, so they can be copied into one buffer.
+    if (id_paramarr != NULL) {
+        for (i = 1; i <= count; i++) {
+            id_buffer_length += strlen(lr_paramarr_idx((char*)id_paramarr, i)) + 1;
+        }
+    } else {
+        id_buffer_length = count * 12; // enough for any position number
+    }
+
+    set->latitudes = (double*)malloc(count * sizeof(double));
+    set->longitudes = (double*)malloc(count * sizeof(double));
+    set->cos_latitudes = (double*)malloc(count * sizeof(double));
+    set->cell_keys = (int*)malloc(count * sizeof(int));
+    set->original_positions = (int*)malloc(count * sizeof(int));
+    set->ids = (char**)malloc(count * sizeof(char*));
+    set->id_buffer = (char*)malloc(id_buffer_length);
+    set->result_points = (int*)malloc(count * sizeof(int));
+    set->result_distances = (double*)malloc(count * sizeof(double));
+    positions = (int*)malloc(count * sizeof(int));
+    row_counts = (int*)calloc(LRLIB_GEO_GRID_ROWS * LRLIB_GEO_GRID_COLUMNS + 1, sizeof(int));
+    if ( (set->latitudes == NULL) || (set->longitudes == NULL) || (set->cos_latitudes == NULL) ||
+         (set->cell_keys == NULL) || (set->original_positions == NULL) || (set->ids == NULL) ||
+         (set->id_buffer == NULL) || (set->result_points == NULL) || (set->result_distances == NULL) ||
+         (positions == NULL) || (row_counts == NULL) ) {
+        lr_error_message("Unable to allocate memory for %d points.", count);
+        lr_abort();
+    }
+
+    // First pass: check the coordinates, and count the points in each grid cell.
+    for (i = 0; i < count; i++) {
+        const char* latitude_text = lr_paramarr_idx((char*)latitude_paramarr, i + 1);
+        const char* longitude_text = lr_paramarr_idx((char*)longitude_paramarr, i + 1);
+
+        if ( (lrlib_parse_double(latitude_text, &latitude) == FALSE) || (latitude < -90) || (latitude > 90) ) {
+            lr_error_message("Element %d of \"%s\" is not a valid latitude: \"%s\".", i + 1, latitude_paramarr, latitude_text);
+            lr_abort();
+        }
+        if ( (lrlib_parse_double(longitude_text, &longitude) == FALSE) || (longitude < -180) || (longitude > 180) ) {
+            lr_error_message("Element %d of \"%s\" is not a valid longitude: \"%s\".", i + 1, longitude_paramarr, longitude_text);
+            lr_abort();
+        }
+
+        set->cell_keys[i] = lrlib_geo_grid_row(latitude) * LRLIB_GEO_GRID_COLUMNS + lrlib_geo_grid_column(longitude);
+        row_counts[set->cell_keys[i] + 1]++;
+    }
+
+    // Turn the counts into the position of the first point in each cell (a counting sort).
+    for (i = 1; i <= LRLIB_GEO_GRID_ROWS * LRLIB_GEO_GRID_COLUMNS; i++) {
+        row_counts[i] += row_counts[i - 1];
+    }
+    for (i = 0; i <= LRLIB_GEO_GRID_ROWS; i++) {
+        set->row_start[i] = row_counts[i * LRLIB_GEO_GRID_COLUMNS];
+    }
+    for (i = 0; i < count; i++) {
+        positions[i] = row_counts[set->cell_keys[i]];
+        row_counts[set->cell_keys[i]]++;
+    }
+
+    // Second pass: store each point at its sorted position. The cell keys are moved to their
+    // sorted positions too (using result_points as a work area).
+    for (i = 0; i < count; i++) {
+        const int position = positions[i];
+
+        lrlib_parse_double(lr_paramarr_idx((char*)latitude_paramarr, i + 1), &latitude);
+        lrlib_parse_double(lr_paramarr_idx((char*)longitude_paramarr, i + 1), &longitude);
+        set->latitudes[position] = latitude * LRLIB_GEO_PI / 180;
+        set->longitudes[position] = longitude * LRLIB_GEO_PI / 180;
+        set->cos_latitudes[position] = cos(set->latitudes[position]);
+        set->original_positions[position] = i;
+        set->result_points[position] = set->cell_keys[i];
+    }
+    memcpy(set->cell_keys, set->result_points, count * sizeof(int));
+
+    // Copy the IDs, as parameter values can change (and lr_paramarr_idx pointers are only valid
+    // until the end of the iteration).
+    id_position = set->id_buffer;
+    for (i = 0; i < count; i++) {
+        set->ids[i] = id_position;
+        if (id_paramarr != NULL) {
+            strcpy(id_position, lr_paramarr_idx((char*)id_paramarr, i + 1));
+        } else {
+            sprintf(id_position, "%d", i + 1);
+        }
+        id_position += strlen(id_position) + 1;
+    }
+
+    free(row_counts);
+    free(positions);
+
+    set->count = count;
+    LRLIB_PROFILE_END("lrlib_geo_load", profile_start_usec, 0);
+    return point_set_id;
+}
+
+/**
+ * @brief Calculates the "a" value of the Haversine formula from a query point to a range of
+ *        points in a set. The distance is 2 * R * asin(sqrt(a)), but as the distance always gets
+ *        bigger when "a" does, "a" can be compared with a limit without calculating the distance.
+ */
+void lrlib_geo_haversine_a(const lrlib_geo_point_set* set, int first, int last, double latitude, double longitude, double cos_latitude, double* a_values) {
+    double sin(double x);
+    int i;
+
+    for (i = first; i < last; i++) {
+        const double sin_half_delta_latitude = sin((set->latitudes[i] - latitude) / 2);
+        const double sin_half_delta_longitude = sin((set->longitudes[i] - longitude) / 2);
+
+        a_values[i - first] = sin_half_delta_latitude * sin_half_delta_latitude +
+            cos_latitude * set->cos_latitudes[i] * sin_half_delta_longitude * sin_half_delta_longitude;
+    }
+}
+
+/**
+ * @brief Converts the "a" value of the Haversine formula to a distance in meters.
+ */
+double lrlib_geo_a_to_distance(double a) {
+    double sqrt(double x);
+    double asin(double x);
+
+    if (a > 1) {
+        a = 1; // rounding errors can give a value slightly more than 1 for opposite points
+    }
+    return 2 * LRLIB_GEO_EARTH_RADIUS * asin(sqrt(a));
+}
+
+/**
+ * @brief Finds the points within a radius of a query point, using the grid. The points are
+ *        written to set->result_points, with their "a" values in set->result_distances.
+ *
+ * @return Returns the number of points found.
+ */
+int lrlib_geo_search(lrlib_geo_point_set* set, double latitude_degrees, double longitude_degrees, double radius) {
+    double sin(double x);
+    double cos(double x);
+    double asin(double x);
+    const double latitude = latitude_degrees * LRLIB_GEO_PI / 180;
+    const double longitude = longitude_degrees * LRLIB_GEO_PI / 180;
+    const double cos_latitude = cos(latitude);
+    const double angle = radius / LRLIB_GEO_EARTH_RADIUS; // the radius, as an angle at the centre of the earth
+    double a_limit; // points with a Haversine "a" value up to this are within the radius
+    double row_margin; // degrees
+    double column_margin; // degrees
+    int first_row;
+    int last_row;
+    int first_column;
+    int last_column;
+    int row;
+    int found = 0;
+
+    if (angle >= LRLIB_GEO_PI) {
+        a_limit = 1; // the radius covers the whole earth
+    } else {
+        a_limit = sin(angle / 2) * sin(angle / 2);
+    }
+
+    // The rows and columns of the grid that could contain points within the radius. One extra
+    // cell is added on each side, to be safe. Near the poles (or for a very large radius), the
+    // circle covers every column.
+    row_margin = angle * 180 / LRLIB_GEO_PI + 1;
+    first_row = lrlib_geo_grid_row(latitude_degrees - row_margin);
+    last_row = lrlib_geo_grid_row(latitude_degrees + row_margin);
+    if ( (angle >= LRLIB_GEO_PI / 2) || (sin(angle) >= cos_latitude * 0.99) || (latitude_degrees + row_margin >= 90) || (latitude_degrees - row_margin <= -90) ) {
+        first_column = 0;
+        last_column = LRLIB_GEO_GRID_COLUMNS - 1;
+    } else {
+        column_margin = asin(sin(angle) / cos_latitude) * 180 / LRLIB_GEO_PI + 1;
+        first_column = (int)(longitude_degrees - column_margin + 180 + LRLIB_GEO_GRID_COLUMNS) - LRLIB_GEO_GRID_COLUMNS;
+        last_column = (int)(longitude_degrees + column_margin + 180);
+        if (last_column - first_column >= LRLIB_GEO_GRID_COLUMNS - 1) {
+            first_column = 0;
+            last_column = LRLIB_GEO_GRID_COLUMNS - 1;
+        }
+    }
+
+    for (row = first_row; row <= last_row; row++) {
+        int range;
+
+        // The column range can cross the 180th meridian, so it is searched as up to two ranges.
+        for (range = 0; range < 2; range++) {
+            int low_column = first_column;
+            int high_column = last_column;
+            int low;
+            int high;
+            int first;
+            int last;
+            int written;
+            int i;
+
+            if (range == 0) {
+                if (low_column < 0) {
+                    low_column = 0;
+                }
+                if (high_column >= LRLIB_GEO_GRID_COLUMNS) {
+                    high_column = LRLIB_GEO_GRID_COLUMNS - 1;
+                }
+            } else if (first_column < 0) {
+                low_column = first_column + LRLIB_GEO_GRID_COLUMNS;
+                high_column = LRLIB_GEO_GRID_COLUMNS - 1;
+            } else if (last_column >= LRLIB_GEO_GRID_COLUMNS) {
+                low_column = 0;
+                high_column = last_column - LRLIB_GEO_GRID_COLUMNS;
+            } else {
+                break;
+            }
+
+            // Binary search for the first point in the row with a column of at least low_column.
+            low = set->row_start[row];
+            high = set->row_start[row + 1];
+            while (low < high) {
+                const int middle = (low + high) / 2;
+                if (set->cell_keys[middle] < row * LRLIB_GEO_GRID_COLUMNS + low_column) {
+                    low = middle + 1;
+                } else {
+                    high = middle;
+                }
+            }
+            first = low;
+            last = first;
+            while ( (last < set->row_start[row + 1]) && (set->cell_keys[last] <= row * LRLIB_GEO_GRID_COLUMNS + high_column) ) {
+                last++;
+            }
+
+            // Calculate the distance to every point in the range, keeping the ones within the
+            // radius. The "a" values are written after the points found so far, then moved down.
+            lrlib_geo_haversine_a(set, first, last, latitude, longitude, cos_latitude, set->result_distances + found);
+            written = found;
+            for (i = 0; i < last - first; i++) {
+                const double a = set->result_distances[found + i];
+                if (a <= a_limit) {
+                    set->result_distances[written] = a;
+                    set->result_points[written] = first + i;
+                    written++;
+                }
+            }
+            found = written;
+        }
+    }
+
+    return found;
+}
+
+/**
+ * @brief Sorts the search results by distance (closest first), using a Shell sort.
+ */
+void lrlib_geo_sort_results(lrlib_geo_point_set* set, int count) {
+    static const int GAPS[] = {701, 301, 132, 57, 23, 10, 4, 1}; // Ciura's gap sequence
+    int gap_index;
+    int i;
+    int j;
+
+    for (gap_index = 0; gap_index < 8; gap_index++) {
+        const int gap = GAPS[gap_index];
+        for (i = gap; i < count; i++) {
+            const double distance = set->result_distances[i];
+            const int point = set->result_points[i];
+            for (j = i; (j >= gap) && (set->result_distances[j - gap] > distance); j -= gap) {
+                set->result_distances[j] = set->result_distances[j - gap];
+                set->result_points[j] = set->result_points[j - gap];
+            }
+            set->result_distances[j] = distance;
+            set->result_points[j] = point;
+        }
+    }
+}
+
+/**
+ * @brief Saves search results to a parameter array of IDs, and a parameter array of distances
+ *        (with "_distance" added to the name).
+ *
+ * @return Returns the number of results saved.
+ */
+int lrlib_geo_save_results(lrlib_geo_point_set* set, int count, const char* output_paramarr) {
+    lrlib_paramarr_emitter ids;
+    lrlib_paramarr_emitter distances;
+    char distances_name[LRLIB_PARAM_NAME_BUFFER_LENGTH];
+    char distance_text[32];
+    int i;
+
+    if ( (output_paramarr == NULL) || (strlen(output_paramarr) == 0) || (strlen(output_paramarr) > LRLIB_MAX_PARAM_NAME_LENGTH - 9) ) {
+        lr_error_message("output_paramarr cannot be NULL, empty, or longer than %d characters.", LRLIB_MAX_PARAM_NAME_LENGTH - 9);
+        lr_abort();
+    }
+    sprintf(distances_name, "%s_distance", output_paramarr);
+
+    lrlib_paramarr_emitter_init(&ids, output_paramarr);
+    lrlib_paramarr_emitter_init(&distances, distances_name);
+    for (i = 0; i < count; i++) {
+        const int point = set->result_points[i];
+
+        lrlib_paramarr_emitter_save(&ids, set->ids[set->original_positions[point]]);
+        sprintf(distance_text, "%.1f", lrlib_geo_a_to_distance(set->result_distances[i]));
+        lrlib_paramarr_emitter_save(&distances, distance_text);
+    }
+    lrlib_paramarr_emitter_finish(&distances);
+
+    return lrlib_paramarr_emitter_finish(&ids);
+}
+
+/**
+ * @brief Calculates the distance from a point to every point in a point set.
+ *
+ * The distances (in meters) are saved to a parameter array, in the same order as the parameter
+ * arrays the point set was loaded from.
+ *
+ * @param point_set_id The ID returned by lrlib_geo_load.
+ * @param latitude The latitude of the query point, in degrees.
+ * @param longitude The longitude of the query point, in degrees.
+ * @param output_paramarr The name of the parameter array to save the distances to.
+ * @return Returns the number of distances saved.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     lrlib_geo_distances(depots, -37.815531, 144.970886, "DepotDistance");
+ *     lr_output_message("Distance to the first depot: %s m", lr_paramarr_idx("DepotDistance", 1));
+ *     return 0;
+ * }
+ */
+int lrlib_geo_distances(int point_set_id, double latitude, double longitude, const char* output_paramarr) {
+    double cos(double x);
+    lrlib_geo_point_set* set = lrlib_geo_get_point_set(point_set_id);
+    lrlib_paramarr_emitter output;
+    char distance_text[32];
+    const double latitude_radians = latitude * LRLIB_GEO_PI / 180;
+    int i;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    if (lrlib_paramarr_emitter_init(&output, output_paramarr) == FALSE) {
+        lr_abort();
+    }
+
+    // Calculate every distance in one pass over the arrays, then put them back in the original
+    // order.
+    lrlib_geo_haversine_a(set, 0, set->count, latitude_radians, longitude * LRLIB_GEO_PI / 180, cos(latitude_radians), set->result_distances);
+    for (i = 0; i < set->count; i++) {
+        set->result_points[set->original_positions[i]] = i;
+    }
+    for (i = 0; i < set->count; i++) {
+        sprintf(distance_text, "%.1f", lrlib_geo_a_to_distance(set->result_distances[set->result_points[i]]));
+        lrlib_paramarr_emitter_save(&output, distance_text);
+    }
+
+    i = lrlib_paramarr_emitter_finish(&output);
+    LRLIB_PROFILE_END("lrlib_geo_distances", profile_start_usec, 0);
+    return i;
+}
+
+/**
+ * @brief Finds the points that are within a distance of a query point, closest first.
+ *
+ * The IDs of the points are saved to a parameter array, and their distances (in meters) are saved
+ * to a second parameter array with "_distance" added to the name.
+ *
+ * @param point_set_id The ID returned by lrlib_geo_load.
+ * @param latitude The latitude of the query point, in degrees.
+ * @param longitude The longitude of the query point, in degrees.
+ * @param radius The distance in meters.
+ * @param output_paramarr The name of the parameter array to save the IDs to.
+ * @return Returns the number of points found.
+ *
+ * @example See lrlib_geo_load.
+ */
+int lrlib_geo_within_radius(int point_set_id, double latitude, double longitude, double radius, const char* output_paramarr) {
+    lrlib_geo_point_set* set = lrlib_geo_get_point_set(point_set_id);
+    int found;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    if (radius < 0) {
+        lr_error_message("radius cannot be negative.");
+        lr_abort();
+    }
+
+    found = lrlib_geo_search(set, latitude, longitude, radius);
+    lrlib_geo_sort_results(set, found);
+    found = lrlib_geo_save_results(set, found, output_paramarr);
+    LRLIB_PROFILE_END("lrlib_geo_within_radius", profile_start_usec, 0);
+    return found;
+}
+
+/**
+ * @brief Finds the points that are closest to a query point, closest first.
+ *
+ * The IDs of the points are saved to a parameter array, and their distances (in meters) are saved
+ * to a second parameter array with "_distance" added to the name.
+ *
+ * @param point_set_id The ID returned by lrlib_geo_load.
+ * @param latitude The latitude of the query point, in degrees.
+ * @param longitude The longitude of the query point, in degrees.
+ * @param k The number of points to find. If the point set has fewer points, all of them are
+ *        returned.
+ * @param output_paramarr The name of the parameter array to save the IDs to.
+ * @return Returns the number of points found.
+ *
+ * @example See lrlib_geo_load.
+ */
+int lrlib_geo_nearest(int point_set_id, double latitude, double longitude, int k, const char* output_paramarr) {
+    lrlib_geo_point_set* set = lrlib_geo_get_point_set(point_set_id);
+    double radius = 50000; // start by looking within 50 km
+    int found;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    if (k < 0) {
+        lr_error_message("k cannot be negative.");
+        lr_abort();
+    }
+    if (k > set->count) {
+        k = set->count;
+    }
+
+    // If there are not enough points within the radius, double it and try again. Every point
+    // within the radius is found, so once there are at least k, the closest k are among them.
+    for (;;) {
+        found = lrlib_geo_search(set, latitude, longitude, radius);
+        if ( (found >= k) || (radius > LRLIB_GEO_PI * LRLIB_GEO_EARTH_RADIUS) ) {
+            break;
+        }
+        radius = radius * 2;
+    }
+
+    lrlib_geo_sort_results(set, found);
+    found = lrlib_geo_save_results(set, k, output_paramarr);
+    LRLIB_PROFILE_END("lrlib_geo_nearest", profile_start_usec, 0);
+    return found;
+}
@@ -118,6 +118,12 @@ typedef struct _PDH_FMT_COUNTERVALUE {
 
 /* LRLIB defines */
 
+// Scripts that run on Linux load generators are compiled with gcc, which defines __linux__. The
+// few functions that have different Windows and Linux versions check LRLIB_LINUX.
+#if defined(__linux__) && !defined(LRLIB_LINUX)
+#define LRLIB_LINUX
+#endif
+
 #define LRLIB_MAX_PARAM_NAME_LENGTH 200
 #define LRLIB_MAX_SUFFIX_LENGTH 20
 #define LRLIB_PARAM_NAME_BUFFER_LENGTH (LRLIB_MAX_PARAM_NAME_LENGTH + LRLIB_MAX_SUFFIX_LENGTH)
@@ -144,6 +150,99 @@ void lrlib_safe_free_and_null(void** ptr)
     }
 }
 
+/*
+ * Loaded library registry
+ * =======================
+ * lr_load_dll is slow (it loads the library and makes its functions available to the script), and
+ * many lr-libc functions need a library. lrlib_load_dll remembers which libraries have been loaded,
+ * so each library is only loaded once per vuser, however often it is called.
+ *
+ * lr_load_dll makes a library's functions available to the vuser that called it, so the registry
+ * is kept per vuser (in global variables, which are private to each vuser). This also means that
+ * no locking is needed when many vusers start at the same time. The operating system only maps
+ * each library into the process once.
+ */
+
+#define LRLIB_MAX_LOADED_DLLS 32
+#define LRLIB_MAX_CACHED_SYMBOLS 64
+
+typedef struct
+{
+    char path[MAX_PATH];
+    void* handle;  // Operating system handle (only set when lrlib_get_symbol needs it)
+} lrlib_loaded_dll;
+
+typedef struct
+{
+    int dllIndex;
+    char name[64];
+    void* address;
+} lrlib_cached_symbol;
+
+lrlib_loaded_dll lrlib_loaded_dlls[LRLIB_MAX_LOADED_DLLS];
+int lrlib_loaded_dll_count = 0;
+lrlib_cached_symbol lrlib_cached_symbols[LRLIB_MAX_CACHED_SYMBOLS];
+int lrlib_cached_symbol_count = 0;
+
+/**
+ * @brief Compares two library paths. On Windows, case is ignored ("Kernel32.dll" and
+ *        "kernel32.dll" are the same library).
+ */
+int lrlib_dll_path_equals(const char* path1, const char* path2)
+{
+#ifdef LRLIB_LINUX
+    return strcmp(path1, path2) == 0;
+#else
+    while (*path1 != '\0' && tolower((unsigned char)*path1) == tolower((unsigned char)*path2))
+    {
+        path1++;
+        path2++;
+    }
+
+    return *path1 == *path2;
+#endif
+}
+
+/**
+ * @brief Finds a library in the registry.
+ *
+ * @return Returns the index of the library, or -1 if it has not been loaded.
+ */
+int lrlib_find_loaded_dll(const char* dllPath)
+{
+    int i;
+
+    for (i = 0; i < lrlib_loaded_dll_count; i++)
+    {
+        if (lrlib_dll_path_equals(lrlib_loaded_dlls[i].path, dllPath))
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Loads a DLL (or a shared library on Linux) so that its functions can be called by the
+ *        script. If the library has already been loaded by this vuser, nothing is done.
+ *
+ * Aborts the vuser if the library cannot be loaded.
+ *
+ * @param dllPath The name or path of the library, e.g. "kernel32.dll".
+ * @return This function does not return a value.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     // This can be called in every iteration; the DLL is only loaded the first time.
+ *     lrlib_load_dll("kernel32.dll");
+ *     Sleep(100);
+ *
+ *     return 0;
+ * }
+ */
 void lrlib_load_dll(const char* dllPath)
 {
     if (dllPath == NULL)
@@ -152,6 +251,11 @@ void lrlib_load_dll(const char* dllPath)
         lr_abort();
     }
 
+    if (lrlib_find_loaded_dll(dllPath) >= 0)
+    {
+        return;
+    }
+
     {
         const int loadResult = lr_load_dll(dllPath);
         if (loadResult != 0)
@@ -160,519 +264,5281 @@ void lrlib_load_dll(const char* dllPath)
             lr_abort();
         }
     }
+
+    // Libraries that don't fit in the registry are still loaded; they are just loaded again
+    // the next time.
+    if (lrlib_loaded_dll_count < LRLIB_MAX_LOADED_DLLS && strlen(dllPath) < MAX_PATH)
+    {
+        strcpy(lrlib_loaded_dlls[lrlib_loaded_dll_count].path, dllPath);
+        lrlib_loaded_dlls[lrlib_loaded_dll_count].handle = NULL;
+        lrlib_loaded_dll_count++;
+    }
 }
 
 /**
- * @brief Creates a new UUID and saves its string representation to a parameter with the specified name.
+ * @brief Gets the address of a function (or variable) in a library, so that it can be called
+ *        through a function pointer. The library is loaded with lrlib_load_dll if necessary, and
+ *        the address is remembered, so only the first call for each symbol is slow.
  *
- * @param output_param_name The name of the parameter to save a created UUID to.
- * @return Returns TRUE (1) if the function succeeded; otherwise, returns FALSE (0).
+ * This uses GetProcAddress on Windows, and dlsym on Linux.
+ *
+ * @param dllPath The name or path of the library, e.g. "kernel32.dll".
+ * @param symbolName The name of the function, e.g. "GetTickCount".
+ * @return Returns the address, or NULL if the symbol was not found.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     typedef unsigned long (*GetTickCountFunction)();
+ *     GetTickCountFunction getTickCount = (GetTickCountFunction)lrlib_get_symbol("kernel32.dll", "GetTickCount");
+ *
+ *     lr_output_message("Uptime: %lu ms", getTickCount());
+ *     return 0;
+ * }
  */
-int lrlib_create_uuid(const char* output_param_name)
+void* lrlib_get_symbol(const char* dllPath, const char* symbolName)
 {
-    const char* LIB_NAME = "Rpcrt4.dll";
-    const int GUID_SIZE = 16;
-    int rpcStatus;
+    int dllIndex;
+    int i;
+    void* address;
+
+    if (symbolName == NULL || strlen(symbolName) >= sizeof(lrlib_cached_symbols[0].name))
+    {
+        lr_error_message("Symbol name cannot be NULL or longer than %d characters.", (int)(sizeof(lrlib_cached_symbols[0].name) - 1));
+        return NULL;
+    }
 
-    char* guid;
-    unsigned char* str;
+    lrlib_load_dll(dllPath);
+    dllIndex = lrlib_find_loaded_dll(dllPath);
 
-    const int loadResult = lr_load_dll(LIB_NAME);
-    if (loadResult != 0)
+    for (i = 0; i < lrlib_cached_symbol_count; i++)
     {
-        lr_error_message("Error loading '%s' (error code %d).", LIB_NAME, loadResult);
-        return FALSE;
+        if (lrlib_cached_symbols[i].dllIndex == dllIndex && strcmp(lrlib_cached_symbols[i].name, symbolName) == 0)
+        {
+            return lrlib_cached_symbols[i].address;
+        }
     }
 
-    guid = (char*)calloc(GUID_SIZE, 1);
-    if (!guid)
     {
-        lr_error_message("Error allocating memory.");
-        return FALSE;
+#ifdef LRLIB_LINUX
+        void* dlopen(const char* fileName, int flags);
+        void* dlsym(void* handle, const char* symbolName);
+        int dlclose(void* handle);
+        void* handle = NULL;
+
+        if (dllIndex >= 0)
+        {
+            handle = lrlib_loaded_dlls[dllIndex].handle;
+        }
+        if (handle == NULL)
+        {
+            // The library is already loaded by lr_load_dll, so this just gets a handle to it.
+            handle = dlopen(dllPath, 1);  // 1 = RTLD_LAZY
+            if (handle == NULL)
+            {
+                lr_error_message("Error opening '%s'.", dllPath);
+                return NULL;
+            }
+        }
+        address = dlsym(handle, symbolName);
+        if (dllIndex < 0)
+        {
+            // The library registry is full, so the handle cannot be kept for next time. Close it
+            // now, so that a new handle is not leaked on every call. The library stays loaded (it
+            // was loaded by lr_load_dll), so the address is still valid.
+            dlclose(handle);
+            handle = NULL;
+        }
+#else
+        void* GetModuleHandleA(const char* moduleName);
+        void* GetProcAddress(void* module, const char* procName);
+        void* handle = NULL;
+
+        if (dllIndex >= 0)
+        {
+            handle = lrlib_loaded_dlls[dllIndex].handle;
+        }
+        if (handle == NULL)
+        {
+            lrlib_load_dll("kernel32.dll");
+
+            // The library is already loaded by lr_load_dll, so it does not need to be loaded again.
+            handle = GetModuleHandleA(dllPath);
+            if (handle == NULL)
+            {
+                lr_error_message("Error getting a handle to '%s'.", dllPath);
+                return NULL;
+            }
+        }
+        address = GetProcAddress(handle, symbolName);
+#endif
+
+        if (dllIndex >= 0)
+        {
+            lrlib_loaded_dlls[dllIndex].handle = handle;
+        }
     }
 
-    rpcStatus = UuidCreate(guid);
-    if (rpcStatus != 0)
+    if (address == NULL)
     {
-        lr_error_message("Error creating UUID (%d).", rpcStatus);
-        free(guid);
-        return FALSE;
+        lr_error_message("Symbol '%s' was not found in '%s'.", symbolName, dllPath);
+        return NULL;
     }
 
-    rpcStatus = UuidToStringA(guid, &str);
-    if (rpcStatus != 0)
+    if (dllIndex >= 0 && lrlib_cached_symbol_count < LRLIB_MAX_CACHED_SYMBOLS)
     {
-        lr_error_message("Error converting UUID to string (%d).", rpcStatus);
-        free(guid);
-        return FALSE;
+        lrlib_cached_symbols[lrlib_cached_symbol_count].dllIndex = dllIndex;
+        strcpy(lrlib_cached_symbols[lrlib_cached_symbol_count].name, symbolName);
+        lrlib_cached_symbols[lrlib_cached_symbol_count].address = address;
+        lrlib_cached_symbol_count++;
     }
 
-    lr_save_string((char*)str, output_param_name);
+    return address;
+}
 
-    RpcStringFreeA(&str);
-    free(guid);
+/*
+ * The lrlib_paramarr_emitter_* functions save values to a new parameter array ({Name_1},
+ * {Name_2}, ... and {Name_count}). They are used by every lr-libc function that creates a
+ * parameter array.
+ *
+ * The parameter name buffer is part of the emitter structure, so no memory needs to be allocated.
+ * The "Name_" part of the parameter name is written once, and only the element number is written
+ * for each element (which is much faster than calling sprintf("%s_%d") every time).
+ */
+typedef struct {
+    char name[LRLIB_PARAM_NAME_BUFFER_LENGTH]; // "Name_" followed by the current element number
+    int prefix_length; // the length of "Name_"
+    int count; // the number of elements saved so far
+} lrlib_paramarr_emitter;
 
-    return TRUE;
+/**
+ * @brief Writes a number as decimal digits (much faster than sprintf("%u")).
+ *
+ * @param value The number to write.
+ * @param buffer The buffer to write the digits to. It must have room for at least 11 characters.
+ *        A null terminator is written after the digits.
+ * @return Returns the number of digits written.
+ */
+int lrlib_format_uint(unsigned int value, char* buffer) {
+    char digits[10]; // 4294967295 is the largest unsigned int, which has 10 digits
+    int num_digits = 0;
+    int i;
+
+    // Get the digits from right to left...
+    do {
+        digits[num_digits] = (char)('0' + (value % 10));
+        num_digits++;
+        value = value / 10;
+    } while (value != 0);
+
+    // ...then write them from left to right.
+    for (i = 0; i < num_digits; i++) {
+        buffer[i] = digits[num_digits - 1 - i];
+    }
+    buffer[num_digits] = '\0';
+
+    return num_digits;
 }
 
 /**
- * Pauses the execution of the vuser for the specified number of seconds. This
- * think time cannot be ignored by the script's runtime settings.
- *
- * Example code:
- *     // This is usually useful when you have a polling loop, and you don't
- *     // want to poll too quickly
- *
- * TODO: should write to the output log when this is called (what message does lr_think_time() write?
- *
- * @param[in] The time (in seconds) to wait.
- * @return    This function does not return a value.
+ * @brief Prepares an emitter to save elements to a new parameter array.
  *
- * Note: This function only works on Windows.
- * Note: This function ignores the runtime settings related to think time.
+ * @param emitter The emitter to initialise.
+ * @param paramarr_name The name of the parameter array to create.
+ * @return Returns TRUE (1) if the emitter is ready to use, or FALSE (0) if the parameter array
+ *         name is NULL, empty or too long (an error message is written to the replay log).
  */
-void lrlib_think_time(double time) {
-    int rc;
-    rc = lr_load_dll("Kernel32.dll"); // needed for sleep() <- use a static value, so lr_load_dll is only called once.
-    if (rc != 0) {
-        lr_error_message("Error loading DLL");
+int lrlib_paramarr_emitter_init(lrlib_paramarr_emitter* emitter, const char* paramarr_name) {
+    int length;
+
+    if ( (paramarr_name == NULL) || (strlen(paramarr_name) == 0) ) {
+        lr_error_message("Parameter array name cannot be NULL or empty.");
+        return FALSE;
+    }
+
+    length = strlen(paramarr_name);
+    if (length > LRLIB_MAX_PARAM_NAME_LENGTH) {
+        lr_error_message("Parameter array name is too long (maximum length is %d).", LRLIB_MAX_PARAM_NAME_LENGTH);
+        return FALSE;
     }
 
-    lr_start_transaction("sleep time");
+    memcpy(emitter->name, paramarr_name, length);
+    emitter->name[length] = '_';
+    emitter->name[length + 1] = '\0';
+    emitter->prefix_length = length + 1;
+    emitter->count = 0;
 
-    sleep(1000); // sleep time in milliseconds
+    return TRUE;
+}
 
-    // Check whether VuGen regards sleep time as "wasted time" <- put this in function reference.
-    lr_output_message("wasted time: %d", lr_get_transaction_wasted_time ("sleep time"));
+/**
+ * @brief Saves a value as the next element of the parameter array.
+ *
+ * @param emitter The emitter (see lrlib_paramarr_emitter_init).
+ * @param value The string to save.
+ * @return Returns the element number of the value that was saved (first element is 1).
+ */
+int lrlib_paramarr_emitter_save(lrlib_paramarr_emitter* emitter, const char* value) {
+    emitter->count++;
+    lrlib_format_uint(emitter->count, emitter->name + emitter->prefix_length);
+    lr_save_string(value, emitter->name);
 
-    lr_end_transaction("sleep time", LR_AUTO);
+    return emitter->count;
 }
 
 /**
- * Gets the process ID of the mmdrv.exe process that is running the VuGen script that called
- * this function.
+ * @brief Saves the {Name_count} parameter, so that the lr_paramarr_* functions can be used with
+ *        the new parameter array.
  *
- * @return    This function returns the process ID of the calling process.
+ * @param emitter The emitter (see lrlib_paramarr_emitter_init).
+ * @return Returns the number of elements in the parameter array.
+ */
+int lrlib_paramarr_emitter_finish(lrlib_paramarr_emitter* emitter) {
+    strcpy(emitter->name + emitter->prefix_length, "count");
+    lr_save_int(emitter->count, emitter->name);
+
+    return emitter->count;
+}
+
+/*
+ * Random number generator state for lrlib_random_*. Global variables in a script are private to
+ * each vuser, so every vuser gets its own generator, and no locking is needed.
+ */
+unsigned int lrlib_random_state[4];
+int lrlib_random_seeded = FALSE;
+
+/**
+ * @brief Seeds the lr-libc random number generator.
  *
- * Example code:
- *     // Print the vuser's process ID
- *     int vuser_pid; vuser_pid = lrlib_get_vuser_pid();
- *     lr_output_message("vuser_pid: %d", vuser_pid);
+ * It is not necessary to call this function; the generator is automatically seeded (differently
+ * for each vuser) the first time a random number is requested. Call it with a fixed value if you
+ * want every run of the script to produce the same sequence of random numbers.
  *
- * Note: This function only works on Windows.
+ * @param seed Any number.
+ * @return This function does not return a value.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     // Always pick the same "random" elements while debugging the script in VuGen.
+ *     lrlib_random_seed(12345);
+ *
+ *     return 0;
+ * }
  */
-int lrlib_get_vuser_pid() {
-    int rc; // return code
-    int pid; // the process id
-    static int dll_loaded = FALSE; // A static variable inside a function keeps its value between
-                                   // invocations. The FALSE value is assigned only on the first
-                                   // invocation.
-    char* dll_name = "MSVCRT.DLL"; // This DLL contains the _getpid() function. It is a standard
-                                   // Windows DLL, usually found in C:\WINDOWS\system32.
-                                   // Note: on Windows platforms, if you do not specify a path,
-                                   // lr_load_dll searches for the DLL using the standard sequence
-                                   // used by the C++ function, LoadLibrary.
-
-    // Only load the DLL the first time this function is called.
-    if (dll_loaded == FALSE) {
-        rc = lr_load_dll(dll_name);
-        if (rc != 0) {
-            lr_error_message("Error loading %s.", dll_name);
-            lr_abort();
-        }
-        dll_loaded = TRUE;
+void lrlib_random_seed(unsigned int seed) {
+    int i;
+
+    // Expand the single seed value into the four state words with the SplitMix32 algorithm. This
+    // makes sure that similar seeds (e.g. 1 and 2) still produce very different sequences.
+    for (i = 0; i < 4; i++) {
+        unsigned int z;
+        seed = seed + 0x9E3779B9u;
+        z = seed;
+        z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+        z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+        z = z ^ (z >> 16);
+        lrlib_random_state[i] = z;
     }
 
-    pid = _getpid();
+    // The generator does not work if all of the state words are zero.
+    if ( (lrlib_random_state[0] | lrlib_random_state[1] | lrlib_random_state[2] | lrlib_random_state[3]) == 0) {
+        lrlib_random_state[0] = 1;
+    }
 
-    return pid;
+    lrlib_random_seeded = TRUE;
 }
 
 /**
- * Prints log options to the replay log.
+ * @brief Returns a random 32-bit number (from 0 to 4294967295).
  *
- * @param[in] The logging settings to print. This should be the value returned by
- *            lr_get_debug_message().
- * @return    This function does not return a value. The logging settings are printed to the
- *            replay log.
+ * This uses the xoshiro128** algorithm, which is much faster than rand() and produces much
+ * better random numbers. It is not suitable for cryptography (e.g. generating passwords or keys).
  *
- * Example code:
- *     // Print the current logging settings to the output log.
- *     unsigned int log_options;
- *     log_options = lr_get_debug_message();
- *     lrlib_print_log_options(log_options);
+ * @return Returns a random number.
  *
- * Note: The standard lr_output_message function will write to the replay log even when logging
- * is disabled. The only case where it will not write to the replay log is when "send messages only
- * when an error occurs" is enabled.
+ * @example
+ *
+ * Action()
+ * {
+ *     lr_output_message("Random number: %u", lrlib_random_uint32());
+ *
+ *     return 0;
+ * }
  */
-void lrlib_print_log_options(unsigned int log_options_to_print) {
-    unsigned int current_log_settings; // the logging settings that were enabled when this
-                                       // function was called.
-    char bit_pattern[(sizeof(int) * 8) + 1]; // this string holds the pattern of bits from the
-                                             // unsigned int containing the logging settings.
-
-    // Save the logging settings that were enabled when this function was called.
-    current_log_settings = lr_get_debug_message();
-
-    // Get the bit pattern for the log options that were passed to this function.
-    itoa(log_options_to_print, bit_pattern, 2); //
+unsigned int lrlib_random_uint32() {
+    unsigned int result;
+    unsigned int t;
 
-    // If "send messages only when an error occurs" is enabled, then turn it off, otherwise nothing
-    // will be written to the output log.
-    // Note use of the bitwise AND operator. "current_log_settings & LR_MSG_CLASS_JIT_LOG_ON_ERROR"
-    // will evaluate to "LR_MSG_CLASS_JIT_LOG_ON_ERROR" if this setting is enabled.
-    if (current_log_settings & LR_MSG_CLASS_JIT_LOG_ON_ERROR) {
-        lr_set_debug_message(LR_MSG_CLASS_JIT_LOG_ON_ERROR, LR_SWITCH_OFF);
+    // Seed the generator the first time it is used. The seed is different for every vuser, as it
+    // combines the current time, the vuser ID and the address of a variable on the vuser's stack.
+    if (lrlib_random_seeded == FALSE) {
+        int vuser_id;
+        int scenario_id;
+        char* vuser_group;
+        lr_whoami(&vuser_id, &vuser_group, &scenario_id);
+        lrlib_random_seed((unsigned int)time(NULL) ^ ((unsigned int)vuser_id * 0x27D4EB2Du) ^ (unsigned int)&vuser_id);
     }
 
-    // Print the bit pattern.
-    // Message formatting specifies a string that is 32 characters wide (padded with 0s to the
-    // left of the printed value)
-    lr_output_message("%032.32s", bit_pattern);
-    lr_output_message("                      |    |||||");
-    lr_output_message("                      |    ||||+-LR_MSG_CLASS_BRIEF_LOG (Standard log)");
-    lr_output_message("                      |    |||+--LR_MSG_CLASS_RESULT_DATA (Data returned by server)");
-    lr_output_message("                      |    ||+---LR_MSG_CLASS_PARAMETERS (Parameter substitution)");
-    lr_output_message("                      |    |+----LR_MSG_CLASS_FULL_TRACE (Advanced trace)");
-    lr_output_message("                      |    +-----LR_MSG_CLASS_EXTENDED_LOG (Extended log)");
-    lr_output_message("                      +----------LR_MSG_CLASS_JIT_LOG_ON_ERROR (Send messages only when an error occurs)");
+    // xoshiro128** (see http://prng.di.unimi.it/xoshiro128starstar.c). Rotations are written as
+    // two shifts, as C does not have a rotate operator.
+    t = lrlib_random_state[1] * 5;
+    result = ((t << 7) | (t >> 25)) * 9;
 
-    // Restore the "send messages only when an error occurs" logging setting if it was
-    // originally enabled.
-    if (current_log_settings & LR_MSG_CLASS_JIT_LOG_ON_ERROR) {
-        lr_set_debug_message(LR_MSG_CLASS_JIT_LOG_ON_ERROR, LR_SWITCH_ON);
-    }
+    t = lrlib_random_state[1] << 9;
+    lrlib_random_state[2] ^= lrlib_random_state[0];
+    lrlib_random_state[3] ^= lrlib_random_state[1];
+    lrlib_random_state[1] ^= lrlib_random_state[2];
+    lrlib_random_state[0] ^= lrlib_random_state[3];
+    lrlib_random_state[2] ^= t;
+    lrlib_random_state[3] = (lrlib_random_state[3] << 11) | (lrlib_random_state[3] >> 21);
 
-    return;
+    return result;
 }
 
 /**
- * Writes a message to the replay log, even if logging is disabled.
+ * @brief Returns a random number that is greater than or equal to 0, and less than the specified
+ *        limit. Every number in the range is equally likely.
  *
- * @param[in] The message to write to the replay log.
- * @return    This function does not return a value.
+ * @param limit The upper limit (this number is never returned). Must be greater than 0.
+ * @return Returns a random number from 0 to (limit - 1).
  *
- * Example code:
- *     // Write the current {UserName} parameter to the replay log, even though "send messages
- *     // only when an error occurs" is enabled.
- *     lrlib_force_output_message(lr_eval_string("logged in user is {UserName}"));
+ * @example
  *
- * Note: The standard lr_output_message function will write to the replay log even when logging is
- * disabled. The only case where it will not write to the replay log is when "send messages only
- * when an error occurs" is enabled.
- * Note: The lr_output_message function supports sprintf-style message formatting. This function
- * only allows a single string argument. A good work-around for this is to include {Parameters}
- * in your message, and call the lr_eval_string function, as has been done in the example code.
+ * Action()
+ * {
+ *     // Roll a 6-sided die.
+ *     lr_output_message("You rolled a %u", lrlib_random_range(6) + 1);
+ *
+ *     return 0;
+ * }
+ *
+ * @note Using "rand() % limit" makes some numbers more likely than others. This function throws
+ *       away the few random numbers that would cause this bias, and tries again.
  */
-void lrlib_force_output_message(char* output_message) {
-    unsigned int current_log_settings; // the logging settings that were enabled when this
-                                       // function was called.
+unsigned int lrlib_random_range(unsigned int limit) {
+    unsigned int threshold; // random numbers below this value would be biased
+    unsigned int value;
 
-    // Check input variables
-    if ( (output_message == NULL) || (strlen(output_message) == 0) ) {
-        lr_error_message("output_message cannot be NULL or empty.");
+    if (limit == 0) {
+        lr_error_message("limit must be greater than 0.");
         lr_abort();
     }
 
-    // Save the logging settings that were enabled when this function was called.
-    current_log_settings = lr_get_debug_message();
+    // (2^32 - limit) % limit is the number of values at the bottom of the range that would make
+    // some results more likely than others. Unsigned arithmetic wraps around, so 0 - limit is the
+    // same as 2^32 - limit.
+    threshold = (0 - limit) % limit;
+    do {
+        value = lrlib_random_uint32();
+    } while (value < threshold);
 
-    // If "send messages only when an error occurs" is enabled, then turn it off, otherwise nothing
-    // will be written to the output log.
-    // Note use of the bitwise AND operator. "current_log_settings & LR_MSG_CLASS_JIT_LOG_ON_ERROR"
-    // will evaluate to "LR_MSG_CLASS_JIT_LOG_ON_ERROR" if this setting is enabled.
-    if (current_log_settings & LR_MSG_CLASS_JIT_LOG_ON_ERROR) {
-        lr_set_debug_message(LR_MSG_CLASS_JIT_LOG_ON_ERROR, LR_SWITCH_OFF);
-    }
-
-    // Write the message to the replay log.
-    lr_output_message(output_message);
-
-    // Restore the "send messages only when an error occurs" logging setting if it was
-    // originally enabled.
-    if (current_log_settings & LR_MSG_CLASS_JIT_LOG_ON_ERROR) {
-        lr_set_debug_message(LR_MSG_CLASS_JIT_LOG_ON_ERROR, LR_SWITCH_ON);
-    }
-
-    return;
-}
+    return value % limit;
+}
 
 /**
- * Sets new logging options to specify what information should be written to the replay log.
+ * @brief Converts a string to a double, and checks that the whole string is a number.
  *
- * @param[in] The new logging settings to use. Use the same C
- *       constants as lr_set_debug_message
- *       (LR_MSG_CLASS_BRIEF_LOG, LR_MSG_CLASS_EXTENDED_LOG
- *       etc.). Invalid combinations (that are not possible to
- *       create through the VuGen user interface) are not
- *       permitted.
- * @return    This function does not return a value.
+ * This is faster than atof (which has to handle locales, hexadecimal numbers, "INF" etc.), and it
+ * tells you whether the string was actually a number. Leading and trailing spaces are allowed.
  *
- * Example code:
- *     // Increase logging levels just for a short section of code (not the entire script).
- *     int original_options;
- *     // Save current logging options.
- *     original_options = lr_get_log lrlib_set_log_level(LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_RESULT_DATA | LR_MSG_CLASS_FULL_TRACE);
+ * @param string The string to convert, e.g. "42", "-3.5", "1.25e6".
+ * @param value Receives the number. If the string is not a number, this is set to 0.
+ * @return Returns TRUE (1) if the string is a number, otherwise returns FALSE (0).
  *
- *     // Put code that you want to get full logging for here (e.g. a step that is failing).
+ * @example
  *
- *     // Restore original logging options
- *     lrlib_set_log_level(original_options);
+ * Action()
+ * {
+ *     double price;
  *
- * Note: It is recommended that you use this function instead of the standard lr_set_debug_message
- * function. VuGen has an unexpected behaviour where if "send messages only when an error occurs"
- * is selected in the user interface (even if logging is disabled), then "send messages only when
- * an error occurs" will be enabled along with the new logging settings, even if it was not
- * specified in the function argument.
+ *     if (lrlib_parse_double(lr_eval_string("{Price}"), &price) == FALSE) {
+ *         lr_error_message("Price is not a number: %s", lr_eval_string("{Price}"));
+ *     }
+ *
+ *     return 0;
+ * }
+ *
+ * @note The result can differ from atof in the last significant digit for numbers with more than
+ *       15 significant digits.
  */
-void lrlib_set_log_level(unsigned int new_log_options) {
-    int i;
-    int is_valid = FALSE; // are the settings defined in new_log_options valid?
-    int valid_log_settings[] = { // all the possible logging settings available through the GUI
-        LR_MSG_CLASS_DISABLE_LOG,
-        LR_MSG_CLASS_BRIEF_LOG,
-        LR_MSG_CLASS_EXTENDED_LOG,
-        LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS,
-        LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_RESULT_DATA,
-        LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_RESULT_DATA,
-        LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_FULL_TRACE,
-        LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_FULL_TRACE,
-        LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_RESULT_DATA | LR_MSG_CLASS_FULL_TRACE,
-        LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_BRIEF_LOG,
-        LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG,
-        LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS,
-        LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_RESULT_DATA,
-        LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_RESULT_DATA,
-        LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_FULL_TRACE,
-        LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_FULL_TRACE,
-        LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_RESULT_DATA | LR_MSG_CLASS_FULL_TRACE
+int lrlib_parse_double(const char* string, double* value) {
+    // Exact powers of 10 that can be stored in a double.
+    static const double POWERS_OF_10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
     };
+    const char* c = string;
+    double mantissa = 0; // the digits of the number, without the decimal point
+    int exponent = 0; // the power of 10 to multiply the mantissa by
+    int exponent_part = 0; // the number after the "e"
+    int negative = FALSE;
+    int negative_exponent = FALSE;
+    int num_digits = 0; // the number of digits in the mantissa (to check there was at least one)
 
-    // Check wheter the new logging options are valid.
-    for (i=0; i<17; i++) {
-        if (new_log_options == valid_log_settings[i]) {
-            is_valid = TRUE;
-            break;
+    *value = 0;
+
+    while (*c == ' ') {
+        c++;
+    }
+
+    if (*c == '-') {
+        negative = TRUE;
+        c++;
+    } else if (*c == '+') {
+        c++;
+    }
+
+    // Digits before the decimal point.
+    while ( (*c >= '0') && (*c <= '9') ) {
+        mantissa = (mantissa * 10) + (*c - '0');
+        num_digits++;
+        c++;
+    }
+
+    // Digits after the decimal point. Each one makes the exponent 1 smaller.
+    if (*c == '.') {
+        c++;
+        while ( (*c >= '0') && (*c <= '9') ) {
+            mantissa = (mantissa * 10) + (*c - '0');
+            exponent--;
+            num_digits++;
+            c++;
         }
     }
 
-    if(is_valid == FALSE) {
-        lr_error_message("Invalid logging setting. You may use one of the following:\n"
-            "    lrlib_set_log_level(LR_MSG_CLASS_DISABLE_LOG);\n"
-            "    lrlib_set_log_level(LR_MSG_CLASS_BRIEF_LOG);\n"
-            "    lrlib_set_log_level(LR_MSG_CLASS_EXTENDED_LOG);\n"
-            "    lrlib_set_log_level(LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS);\n"
-            "    lrlib_set_log_level(LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_RESULT_DATA);\n"
-            "    lrlib_set_log_level(LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_RESULT_DATA);\n"
-            "    lrlib_set_log_level(LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_FULL_TRACE);\n"
-            "    lrlib_set_log_level(LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_FULL_TRACE);\n"
-            "    lrlib_set_log_level(LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_RESULT_DATA | LR_MSG_CLASS_FULL_TRACE);\n"
-            "    lrlib_set_log_level(LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_BRIEF_LOG);\n"
-            "    lrlib_set_log_level(LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG);\n"
-            "    lrlib_set_log_level(LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS);\n"
-            "    lrlib_set_log_level(LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_RESULT_DATA);\n"
-            "    lrlib_set_log_level(LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_RESULT_DATA);\n"
-            "    lrlib_set_log_level(LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_FULL_TRACE);\n"
-            "    lrlib_set_log_level(LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_FULL_TRACE);\n"
-            "    lrlib_set_log_level(LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_RESULT_DATA | LR_MSG_CLASS_FULL_TRACE);"
-        );
-        lr_abort();
+    if (num_digits == 0) {
+        return FALSE;
     }
 
-    // Set the new logging options.
-    lr_set_debug_message(LR_MSG_CLASS_DISABLE_LOG, LR_SWITCH_ON); // reset everything to 0
-    lr_set_debug_message(new_log_options, LR_SWITCH_ON); // set the new option
+    // Optional exponent, e.g. "e6" or "E-3".
+    if ( (*c == 'e') || (*c == 'E') ) {
+        c++;
+        if (*c == '-') {
+            negative_exponent = TRUE;
+            c++;
+        } else if (*c == '+') {
+            c++;
+        }
+        if ( (*c < '0') || (*c > '9') ) {
+            return FALSE;
+        }
+        while ( (*c >= '0') && (*c <= '9') ) {
+            if (exponent_part < 10000) {
+                exponent_part = (exponent_part * 10) + (*c - '0');
+            }
+            c++;
+        }
+        if (negative_exponent == TRUE) {
+            exponent -= exponent_part;
+        } else {
+            exponent += exponent_part;
+        }
+    }
 
-    // If LR_MSG_CLASS_JIT_LOG_ON_ERROR has become set, and it was not specified in
-    // new_log_options, then disable it.
-    if ( (lr_get_debug_message() & LR_MSG_CLASS_JIT_LOG_ON_ERROR) &&
-         !(new_log_options & LR_MSG_CLASS_JIT_LOG_ON_ERROR) ) {
-        lr_set_debug_message(LR_MSG_CLASS_JIT_LOG_ON_ERROR, LR_SWITCH_OFF);
+    while (*c == ' ') {
+        c++;
+    }
+    if (*c != '\0') {
+        return FALSE; // there is something after the number
     }
 
-    return;
+    // Apply the exponent, 22 powers of 10 at a time.
+    while (exponent > 22) {
+        mantissa = mantissa * 1e22;
+        exponent -= 22;
+    }
+    while (exponent < -22) {
+        mantissa = mantissa / 1e22;
+        exponent += 22;
+    }
+    if (exponent >= 0) {
+        mantissa = mantissa * POWERS_OF_10[exponent];
+    } else {
+        mantissa = mantissa / POWERS_OF_10[-exponent];
+    }
+
+    if (negative == TRUE) {
+        mantissa = -mantissa;
+    }
+
+    *value = mantissa;
+    return TRUE;
 }
 
-int lrlib_get_process_file_path(const int processId, char* const filePath, const int maxLength)
-{
-    int result;
+/*
+ * Cryptographically secure random numbers
+ * =======================================
+ * lrlib_random_uint32 is fast, but its output can be predicted. The functions below use the
+ * ChaCha20 stream cipher, keyed once per vuser with random bytes from the operating system
+ * (getrandom on Linux, RtlGenRandom on Windows). After that, no system calls are needed.
+ */
 
-    lrlib_load_dll("kernel32.dll");
-    lrlib_load_dll("psapi.dll");
+unsigned int lrlib_csprng_key[8];
+unsigned int lrlib_csprng_counter[2]; // 64-bit block counter, low word first
+unsigned char lrlib_csprng_buffer[64]; // the current block of output
+int lrlib_csprng_available = 0; // the number of unused bytes at the end of lrlib_csprng_buffer
+int lrlib_csprng_seeded = FALSE;
 
-    {
-        const unsigned int hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, processId);
-        if (hProcess == NULL)
-        {
-            *filePath = '\0';
-            return 0;
-        }
+/**
+ * @brief Fills a buffer with random bytes from the operating system. This is slow, so it is only
+ *        used to seed the ChaCha20 generator.
+ */
+void lrlib_get_os_entropy(unsigned char* buffer, int length) {
+#ifdef LRLIB_LINUX
+    long getrandom(void* buffer, unsigned long length, unsigned int flags);
+    long bytes_read = getrandom(buffer, length, 0);
 
-        result = GetModuleFileNameExA(hProcess, NULL, filePath, maxLength);
-        if (result == 0)
-        {
-            *filePath = '\0';
+    if (bytes_read != length) {
+        // getrandom was added in Linux 3.17 (and glibc 2.25), so fall back to /dev/urandom.
+        const int fd = open("/dev/urandom", 0); // 0 = O_RDONLY
+        bytes_read = -1;
+        if (fd >= 0) {
+            bytes_read = read(fd, buffer, length);
+            close(fd);
         }
+    }
+#else
+    long bytes_read = length;
 
-        CloseHandle(hProcess);
+    // RtlGenRandom is exported by advapi32.dll as SystemFunction036.
+    lrlib_load_dll("advapi32.dll");
+    if (SystemFunction036(buffer, length) == FALSE) {
+        bytes_read = -1;
     }
+#endif
 
-    return result;
+    if (bytes_read != length) {
+        lr_error_message("Could not get random bytes from the operating system.");
+        lr_abort();
+    }
 }
 
-int lrlib_kill_all_mmdrv()
-{
-    #define MAX_PROCESS_ID_COUNT 1024
-
-    unsigned long currentProcessId;
-    unsigned long processIds[MAX_PROCESS_ID_COUNT];
-    const long ELEMENT_SIZE = sizeof(processIds[0]);
-    unsigned long bytesReturned;
-    long enumResult;
-    long processIdCount;
-    long i;
-    char processFilePath[MAX_PATH];
-    char currentProcessFilePath[MAX_PATH];
-    int res;
-    int killCount = 0;
+/**
+ * @brief Generates the next 64-byte block of ChaCha20 output (RFC 8439, with a zero nonce and a
+ *        64-bit block counter).
+ */
+void lrlib_csprng_block() {
+    // The four ChaCha quarter rounds that make up a round, as indexes into the state.
+    static const int QUARTER_ROUNDS[8][4] = {
+        {0, 4, 8, 12}, {1, 5, 9, 13}, {2, 6, 10, 14}, {3, 7, 11, 15}, // columns
+        {0, 5, 10, 15}, {1, 6, 11, 12}, {2, 7, 8, 13}, {3, 4, 9, 14}  // diagonals
+    };
+    unsigned int input[16];
+    unsigned int x[16];
+    int round;
+    int i;
 
-    lrlib_load_dll("kernel32.dll");
-    lrlib_load_dll("psapi.dll");
+    input[0] = 0x61707865; // "expand 32-byte k"
+    input[1] = 0x3320646e;
+    input[2] = 0x79622d32;
+    input[3] = 0x6b206574;
+    for (i = 0; i < 8; i++) {
+        input[4 + i] = lrlib_csprng_key[i];
+    }
+    input[12] = lrlib_csprng_counter[0];
+    input[13] = lrlib_csprng_counter[1];
+    input[14] = 0;
+    input[15] = 0;
+    memcpy(x, input, sizeof(x));
 
-    currentProcessId = GetCurrentProcessId();
-    res = lrlib_get_process_file_path(currentProcessId, currentProcessFilePath, MAX_PATH);
-    if (res <= 0)
-    {
-        lr_error_message("Error querying the current process.");
-        return 0;
+    for (round = 0; round < 20; round++) {
+        const int* q = QUARTER_ROUNDS[(round & 1) * 4];
+        for (i = 0; i < 4; i++, q += 4) {
+            unsigned int a = x[q[0]], b = x[q[1]], c = x[q[2]], d = x[q[3]];
+            a += b; d ^= a; d = (d << 16) | (d >> 16);
+            c += d; b ^= c; b = (b << 12) | (b >> 20);
+            a += b; d ^= a; d = (d << 8) | (d >> 24);
+            c += d; b ^= c; b = (b << 7) | (b >> 25);
+            x[q[0]] = a; x[q[1]] = b; x[q[2]] = c; x[q[3]] = d;
+        }
     }
 
-    enumResult = EnumProcesses(processIds, MAX_PROCESS_ID_COUNT * ELEMENT_SIZE, &bytesReturned);
-    if (!enumResult)
-    {
-        lr_error_message("Error enumerating processes.");
-        return 0;
+    // Write the output little-endian, so that it is the same on every platform.
+    for (i = 0; i < 16; i++) {
+        const unsigned int word = x[i] + input[i];
+        lrlib_csprng_buffer[i * 4] = word & 0xFF;
+        lrlib_csprng_buffer[i * 4 + 1] = (word >> 8) & 0xFF;
+        lrlib_csprng_buffer[i * 4 + 2] = (word >> 16) & 0xFF;
+        lrlib_csprng_buffer[i * 4 + 3] = (word >> 24) & 0xFF;
     }
 
-    processIdCount = bytesReturned / ELEMENT_SIZE;
-    for (i = 0; i < processIdCount; i++)
-    {
-        const unsigned long processId = processIds[i];
-        if (processId == currentProcessId)
-        {
-            continue;
-        }
+    lrlib_csprng_counter[0]++;
+    if (lrlib_csprng_counter[0] == 0) {
+        lrlib_csprng_counter[1]++;
+    }
+    lrlib_csprng_available = 64;
+}
 
-        res = lrlib_get_process_file_path(processId, processFilePath, MAX_PATH);
-        if (res <= 0)
-        {
-            continue;
-        }
+/**
+ * @brief Fills a buffer with cryptographically secure random bytes.
+ *
+ * The generator is seeded from the operating system the first time it is used (separately for
+ * each vuser). It is suitable for generating session IDs, nonces, passwords and keys.
+ *
+ * @param buffer The buffer to fill.
+ * @param length The number of random bytes to write to the buffer.
+ * @return This function does not return a value.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     unsigned char nonce[16];
+ *
+ *     lrlib_secure_random_bytes(nonce, sizeof(nonce));
+ *     lr_save_var((char*)nonce, sizeof(nonce), 0, "Nonce");
+ *
+ *     return 0;
+ * }
+ */
+void lrlib_secure_random_bytes(unsigned char* buffer, int length) {
+    if (lrlib_csprng_seeded == FALSE) {
+        unsigned char seed[32];
+        int i;
 
-        if (stricmp(processFilePath, currentProcessFilePath) != 0)
-        {
-            continue;
+        lrlib_get_os_entropy(seed, sizeof(seed));
+        for (i = 0; i < 8; i++) {
+            lrlib_csprng_key[i] = seed[i * 4] | (seed[i * 4 + 1] << 8) | (seed[i * 4 + 2] << 16) | ((unsigned int)seed[i * 4 + 3] << 24);
         }
+        lrlib_csprng_counter[0] = 0;
+        lrlib_csprng_counter[1] = 0;
+        lrlib_csprng_available = 0;
+        lrlib_csprng_seeded = TRUE;
+    }
 
-        {
-            const unsigned long hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ | PROCESS_TERMINATE, FALSE, processId);
-            if (hProcess == NULL)
-            {
-                continue;
-            }
+    while (length > 0) {
+        int chunk;
 
-            lr_output_message("Killing process %d", processId);
-            if (TerminateProcess(hProcess, 0))
-            {
-                killCount++;
-            }
+        if (lrlib_csprng_available == 0) {
+            lrlib_csprng_block();
+        }
 
-            CloseHandle(hProcess);
+        chunk = lrlib_csprng_available;
+        if (chunk > length) {
+            chunk = length;
         }
-    }
 
-    return killCount;
+        // Take bytes from the end of the block, and wipe them so they can't be read again later.
+        memcpy(buffer, lrlib_csprng_buffer + 64 - lrlib_csprng_available, chunk);
+        memset(lrlib_csprng_buffer + 64 - lrlib_csprng_available, 0, chunk);
+        lrlib_csprng_available -= chunk;
+        buffer += chunk;
+        length -= chunk;
+    }
 }
 
 /**
- * @brief Calculates the distance between two points of latitude/longitude.
+ * @brief Returns the current time as the number of milliseconds since 1 January 1970 UTC.
  *
- * @param latitude_1 degrees of latitude for the first point
- * @param longitude_1 degrees of longitude for the first point
- * @param latitude_2 degrees of latitude for the second point
- * @param longitude_2 degrees of longitude for the second point
- * @return distance between the two points in meters. This number is always positive.
+ * The result is a double, as VuGen does not have a working 64-bit integer type. A double can
+ * hold every millisecond value exactly for the next 280,000 years.
+ *
+ * @return Returns the number of milliseconds since the Unix epoch.
  *
  * @example
  *
  * Action()
  * {
- *     double distance;
+ *     char timestamp[32];
  *
- *     // Is the address within 10km of the freight depot? Save the distance to a parameter.
- *     // {Param_Address_Lat} and {Param_Address_Long} could be saved from a web page, or from a
- *     // parameter file, or from a web service that translates addresses to coordinates.
- *     distance = distance_between_two_points("-37.815531", // freight depot latitude
- *                                            "144.970886", // freight depot longitude
- *                                            lr_eval_string("{Param_Address_Lat}"),
- *                                            lr_eval_string("{Param_Address_Long}"));
- *     if (distance < 10000) {
- *         // Note: when the double is typecast to an int, the value will lose fractions of a meter.
- *         lr_save_int((int)distance, "Param_Distance");
- *     }
+ *     // Many web applications add a timestamp to URLs to stop caching, e.g. "_=1414716000123".
+ *     sprintf(timestamp, "%.0f", lrlib_get_unix_time_ms());
+ *     lr_save_string(timestamp, "Timestamp");
  *
  *     return 0;
  * }
- *
- * @note To convert meters to miles, multiply by 0.000621371. To convert meters to feet, multiply
- *       by 3.28084.
- * @note Different applications may calculate the distance between two points differently. If you
- *       are using this to check the results of a distance calculation in the system under test,
- *       then you should probably re-implement their distance calculation code yourself.
- * @note There are many free online services that will convert addresses to GPS coordinates
- *       (latitude and longitude).
  */
-double distance_between_two_points(char* latitude_1, char* longitude_1, char* latitude_2, char* longitude_2) {
-    const double PI = 3.14159265358979323846; // the mathematical constant pi
-    const double R = 6373000; // the radius of the earth in meters
+double lrlib_get_unix_time_ms() {
+#ifdef LRLIB_LINUX
+    // struct timespec on 64-bit Linux
+    struct {
+        long seconds;
+        long nanoseconds;
+    } now;
 
-    // In LoadRunner, functions that do not return an int must be explicitly declared.
-    // The explicit declaration of the function prototype can be done in the body of another function.
-    // This means that the function definitions only have local scope, and may be re-declared elsewhere in the script.
-    double atof(const char* string);
-    double sin(double x);
-    double cos(double x);
-    double sqrt(double x);
-    double asin(double x); // Note that this function is not included in the LoadRunner documentation, but is available.
+    clock_gettime(0, &now); // 0 = CLOCK_REALTIME
+    return (now.seconds * 1000.0) + (now.nanoseconds / 1000000);
+#else
+    double floor(double x);
 
-    // Convert degrees to radians
-    double lat1rad = atof(latitude_1) * PI/180;
-    double long1rad = atof(longitude_1) * PI/180;
-    double lat2rad = atof(latitude_2) * PI/180;
-    double long2rad = atof(longitude_2) * PI/180;
+    // FILETIME: the number of 100-nanosecond intervals since 1 January 1601.
+    struct {
+        unsigned long low;
+        unsigned long high;
+    } now;
 
-    // TODO: Check input values. If any values are 0.0 after being converted using the atof function, then there is a problem.
+    lrlib_load_dll("kernel32.dll");
+    GetSystemTimeAsFileTime(&now);
+    return floor((now.high * 4294967296.0 + now.low) / 10000) - 11644473600000.0;
+#endif
+}
 
-    // Get the difference between the two points.
-    double delta_lat = lat2rad - lat1rad;
-    double delta_long = long2rad - long1rad;
+/*
+ * High-resolution clock
+ * =====================
+ * Used by the code timers, the self-profiler, pacing and the other functions that measure time.
+ */
 
-    // Use the  Haversine Formula (http://en.wikipedia.org/wiki/Haversine_formula) to calculate the
-    // distance between two points on the Earth.
-    double a = sin(delta_lat/2) * sin(delta_lat/2) + sin(delta_long/2) * sin(delta_long/2) * cos(lat1rad) * cos(lat2rad);
-    double c = 2 * asin(sqrt(a));
+double lrlib_timer_ticks_per_usec = 0; // Windows only
 
-    return R * c; // The distance between the two points in meters
+/**
+ * @brief Returns the time in microseconds from a high-resolution clock that is not affected by
+ *        changes to the system time. Only the difference between two times is meaningful.
+ *
+ * On Windows this uses QueryPerformanceCounter; on Linux it uses clock_gettime(CLOCK_MONOTONIC).
+ * Both take a few tens of nanoseconds.
+ *
+ * @return Returns the current time in microseconds.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     double start = lrlib_timer_now_usec();
+ *     lrlib_str_split(lr_eval_string("{Response}"), ",", "Field");
+ *     lr_output_message("Split took %.1f us", lrlib_timer_now_usec() - start);
+ *     return 0;
+ * }
+ */
+double lrlib_timer_now_usec() {
+#ifdef LRLIB_LINUX
+    // struct timespec on 64-bit Linux
+    struct {
+        long seconds;
+        long nanoseconds;
+    } now;
+
+    clock_gettime(1, &now); // 1 = CLOCK_MONOTONIC
+    return (now.seconds * 1000000.0) + (now.nanoseconds / 1000.0);
+#else
+    // LARGE_INTEGER. VuGen does not have a working 64-bit integer type, so the two halves are
+    // combined into a double (which is exact for over 100 years of ticks).
+    struct {
+        unsigned long low;
+        unsigned long high;
+    } ticks;
+
+    if (lrlib_timer_ticks_per_usec == 0) {
+        lrlib_load_dll("kernel32.dll");
+        QueryPerformanceFrequency(&ticks);
+        lrlib_timer_ticks_per_usec = (ticks.high * 4294967296.0 + ticks.low) / 1000000.0;
+    }
+
+    QueryPerformanceCounter(&ticks);
+    return (ticks.high * 4294967296.0 + ticks.low) / lrlib_timer_ticks_per_usec;
+#endif
+}
+
+/*
+ * Self-profiler
+ * =============
+ * When a load generator runs short of CPU, it is useful to know how much of the time is spent in
+ * lr-libc functions. When profiling is turned on (with lrlib_profiling_enable), the public
+ * functions in every lr-libc header record how many times they were called, the time they took,
+ * and how many bytes they processed (where this is known). The results are kept per vuser, and can
+ * be written out with lrlib_profile_dump.
+ *
+ * Some functions are not profiled:
+ * - functions that only do a few operations or return a single value (e.g. lrlib_timer_start,
+ *   lrlib_histogram_record, lrlib_log_message, lrlib_random_range, lrlib_create_uuid_v4,
+ *   lrlib_parse_iso8601), as timing them would cost more than the work itself. The time that
+ *   lrlib_log_message spends writing to the file is recorded under lrlib_log_flush.
+ * - functions that only wait (lrlib_think_time, lrlib_sleep_until_usec, lrlib_pacing_*).
+ * - the original Windows perfmon functions in monitors.h (lrlib_get_perfmon_*). Nearly all of their
+ *   time is spent in the PDH library, or sleeping between samples.
+ * - the profiler and timer functions themselves.
+ * Calls that fail part-way (and return an error) are not counted.
+ *
+ * When profiling is turned off, the only cost is checking lrlib_profiling_enabled at the start
+ * and end of each function.
+ */
+
+#define LRLIB_MAX_PROFILE_ENTRIES 128
+
+// Used at the start and end of the profiled functions. The do/while makes each macro a single
+// statement, so it is safe to use in an if/else without braces.
+#define LRLIB_PROFILE_START(start_usec) do { if (lrlib_profiling_enabled) { start_usec = lrlib_timer_now_usec(); } } while (0)
+#define LRLIB_PROFILE_END(function_name, start_usec, bytes) do { if (lrlib_profiling_enabled) { lrlib_profile_record(function_name, start_usec, bytes); } } while (0)
+
+typedef struct {
+    const char* function_name;
+    unsigned int calls;
+    double total_usec;
+    double max_usec;
+    double bytes;
+} lrlib_profile_entry;
+
+int lrlib_profiling_enabled = FALSE;
+lrlib_profile_entry lrlib_profile_entries[LRLIB_MAX_PROFILE_ENTRIES];
+int lrlib_profile_entry_count = 0;
+
+/**
+ * @brief Turns the lr-libc self-profiler on or off (for this vuser).
+ *
+ * @param enabled TRUE to start recording, FALSE to stop. The recorded results are kept until
+ *        lrlib_profile_reset is called.
+ * @return This function does not return a value.
+ *
+ * @example
+ *
+ * vuser_init()
+ * {
+ *     lrlib_profiling_enable(TRUE);
+ *     return 0;
+ * }
+ *
+ * vuser_end()
+ * {
+ *     // Write the profile for vuser 1 to a file, and the profile for the other vusers to the log.
+ *     if (atoi(lr_eval_string("{VuserId}")) == 1) {
+ *         lrlib_profile_dump("C:\\Temp\\lrlib_profile.txt");
+ *     } else {
+ *         lrlib_profile_dump(NULL);
+ *     }
+ *     return 0;
+ * }
+ */
+void lrlib_profiling_enable(int enabled) {
+    lrlib_profiling_enabled = enabled;
+}
+
+/**
+ * @brief Records one call to a profiled function. Called by LRLIB_PROFILE_END.
+ *
+ * @param function_name The name of the function. This must be a string literal, as only the
+ *        pointer is stored.
+ * @param start_usec The time the function started (0 if profiling was turned on while it ran).
+ * @param bytes The number of bytes processed, or 0 if this is not known.
+ */
+void lrlib_profile_record(const char* function_name, double start_usec, double bytes) {
+    lrlib_profile_entry* entry = NULL;
+    double elapsed;
+    int i;
+
+    if (start_usec == 0) {
+        return;
+    }
+    elapsed = lrlib_timer_now_usec() - start_usec;
+
+    // There are only a few profiled functions, and each always passes the same string literal, so
+    // comparing pointers is enough.
+    for (i = 0; i < lrlib_profile_entry_count; i++) {
+        if (lrlib_profile_entries[i].function_name == function_name) {
+            entry = &lrlib_profile_entries[i];
+            break;
+        }
+    }
+    if (entry == NULL) {
+        if (lrlib_profile_entry_count >= LRLIB_MAX_PROFILE_ENTRIES) {
+            return;
+        }
+        entry = &lrlib_profile_entries[lrlib_profile_entry_count];
+        memset(entry, 0, sizeof(lrlib_profile_entry));
+        entry->function_name = function_name;
+        lrlib_profile_entry_count++;
+    }
+
+    entry->calls++;
+    entry->total_usec += elapsed;
+    entry->bytes += bytes;
+    if (elapsed > entry->max_usec) {
+        entry->max_usec = elapsed;
+    }
+}
+
+/*
+ * UUIDs
+ * =====
+ * Random (version 4) and time-ordered (version 7) UUIDs, made from lrlib_secure_random_bytes
+ * without calling the operating system for each UUID.
+ */
+
+#define LRLIB_UUID_LENGTH 36 // e.g. "4a1c2f3e-9b7d-4e6f-8a5b-0c1d2e3f4a5b"
+
+// The UUID versions that lrlib_create_uuid_paramarr can generate.
+#define LRLIB_UUID_V4 4 // random
+#define LRLIB_UUID_V7 7 // time-ordered
+
+char lrlib_hex_pairs[512]; // "000102...feff", so each byte can be formatted with one lookup
+double lrlib_uuid_v7_last_time_ms = 0;
+unsigned int lrlib_uuid_v7_counter = 0;
+
+/**
+ * @brief Fills lrlib_hex_pairs, if it has not been done already.
+ */
+void lrlib_init_hex_pairs() {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    int i;
+
+    if (lrlib_hex_pairs[0] == '\0') {
+        for (i = 0; i < 256; i++) {
+            lrlib_hex_pairs[i * 2] = HEX_DIGITS[i >> 4];
+            lrlib_hex_pairs[i * 2 + 1] = HEX_DIGITS[i & 0x0F];
+        }
+    }
+}
+
+/**
+ * @brief Writes a UUID (RFC 9562) and a terminating null to a buffer of at least
+ *        LRLIB_UUID_LENGTH + 1 characters.
+ *
+ * Version 4 UUIDs are 122 random bits. Version 7 UUIDs start with the time in milliseconds, so
+ * they sort in the order they were created (which keeps database indexes compact); the rest is
+ * random, except that UUIDs created by the same vuser in the same millisecond use a 12-bit counter
+ * so that they still sort in order.
+ */
+void lrlib_format_uuid(int version, char* buffer) {
+    unsigned char bytes[16];
+    int i;
+
+    lrlib_init_hex_pairs();
+    lrlib_secure_random_bytes(bytes, sizeof(bytes));
+
+    if (version == LRLIB_UUID_V7) {
+        double time_ms = lrlib_get_unix_time_ms();
+        unsigned int time_high;
+        unsigned int time_low;
+
+        if (time_ms > lrlib_uuid_v7_last_time_ms) {
+            // A new millisecond: start the counter at a random value below 2048, leaving room to
+            // count up.
+            lrlib_uuid_v7_counter = ((bytes[6] << 8) | bytes[7]) & 0x7FF;
+            lrlib_uuid_v7_last_time_ms = time_ms;
+        } else {
+            // The same millisecond (or the clock went backwards): count up from the last UUID. If
+            // the counter runs out, borrow the next millisecond.
+            lrlib_uuid_v7_counter++;
+            if (lrlib_uuid_v7_counter > 0xFFF) {
+                lrlib_uuid_v7_counter = 0;
+                lrlib_uuid_v7_last_time_ms++;
+            }
+            time_ms = lrlib_uuid_v7_last_time_ms;
+        }
+
+        // The 48-bit timestamp, most significant byte first.
+        time_high = (unsigned int)(time_ms / 4294967296.0);
+        time_low = (unsigned int)(time_ms - time_high * 4294967296.0);
+        bytes[0] = (time_high >> 8) & 0xFF;
+        bytes[1] = time_high & 0xFF;
+        bytes[2] = (time_low >> 24) & 0xFF;
+        bytes[3] = (time_low >> 16) & 0xFF;
+        bytes[4] = (time_low >> 8) & 0xFF;
+        bytes[5] = time_low & 0xFF;
+        bytes[6] = 0x70 | ((lrlib_uuid_v7_counter >> 8) & 0x0F);
+        bytes[7] = lrlib_uuid_v7_counter & 0xFF;
+    } else {
+        bytes[6] = 0x40 | (bytes[6] & 0x0F);
+    }
+    bytes[8] = 0x80 | (bytes[8] & 0x3F); // the RFC 9562 variant
+
+    for (i = 0; i < 16; i++) {
+        buffer[0] = lrlib_hex_pairs[bytes[i] * 2];
+        buffer[1] = lrlib_hex_pairs[bytes[i] * 2 + 1];
+        buffer += 2;
+        if (i == 3 || i == 5 || i == 7 || i == 9) {
+            *buffer = '-';
+            buffer++;
+        }
+    }
+    *buffer = '\0';
+}
+
+/**
+ * @brief Creates a random (version 4) UUID and saves it to a parameter.
+ *
+ * @param output_param_name The name of the parameter to save the UUID to.
+ * @return Returns TRUE (1).
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     lrlib_create_uuid_v4("RequestId");
+ *     web_add_header("X-Request-ID", lr_eval_string("{RequestId}"));
+ *
+ *     return 0;
+ * }
+ */
+int lrlib_create_uuid_v4(const char* output_param_name) {
+    char uuid[LRLIB_UUID_LENGTH + 1];
+
+    lrlib_format_uuid(LRLIB_UUID_V4, uuid);
+    lr_save_string(uuid, output_param_name);
+    return TRUE;
+}
+
+/**
+ * @brief Creates a time-ordered (version 7) UUID and saves it to a parameter.
+ *
+ * UUIDs created later sort after UUIDs created earlier (even within the same millisecond, for UUIDs
+ * created by the same vuser).
+ *
+ * @param output_param_name The name of the parameter to save the UUID to.
+ * @return Returns TRUE (1).
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     lrlib_create_uuid_v7("OrderId");
+ *     lr_output_message("Order ID: %s", lr_eval_string("{OrderId}"));
+ *
+ *     return 0;
+ * }
+ */
+int lrlib_create_uuid_v7(const char* output_param_name) {
+    char uuid[LRLIB_UUID_LENGTH + 1];
+
+    lrlib_format_uuid(LRLIB_UUID_V7, uuid);
+    lr_save_string(uuid, output_param_name);
+    return TRUE;
+}
+
+/**
+ * @brief Creates many UUIDs at once, and saves them to a parameter array.
+ *
+ * @param output_paramarr_name The name of the parameter array to save the UUIDs to.
+ * @param count The number of UUIDs to create.
+ * @param version LRLIB_UUID_V4 or LRLIB_UUID_V7.
+ * @return Returns the number of UUIDs created, or -1 if there was an error.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     int i;
+ *
+ *     // One ID for each line of the order.
+ *     lrlib_create_uuid_paramarr("LineId", lr_paramarr_len("ProductId"), LRLIB_UUID_V7);
+ *     for (i = 1; i <= lr_paramarr_len("LineId"); i++) {
+ *         lr_output_message("%s", lr_paramarr_idx("LineId", i));
+ *     }
+ *
+ *     return 0;
+ * }
+ */
+int lrlib_create_uuid_paramarr(const char* output_paramarr_name, int count, int version) {
+    lrlib_paramarr_emitter output;
+    char uuid[LRLIB_UUID_LENGTH + 1];
+    int i;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    if ( (version != LRLIB_UUID_V4) && (version != LRLIB_UUID_V7) ) {
+        lr_error_message("Invalid UUID version %d. Use LRLIB_UUID_V4 or LRLIB_UUID_V7.", version);
+        return -1;
+    }
+    if (count < 0) {
+        lr_error_message("count cannot be negative.");
+        return -1;
+    }
+    if (lrlib_paramarr_emitter_init(&output, output_paramarr_name) == FALSE) {
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        lrlib_format_uuid(version, uuid);
+        lrlib_paramarr_emitter_save(&output, uuid);
+    }
+
+    count = lrlib_paramarr_emitter_finish(&output);
+    LRLIB_PROFILE_END("lrlib_create_uuid_paramarr", profile_start_usec, 0);
+    return count;
+}
+
+/**
+ * @brief Creates a new UUID and saves its string representation to a parameter with the specified name.
+ *
+ * The UUID is a random (version 4) UUID, in lower case, like the UUIDs created by the Windows
+ * UuidCreate function. This function works on Windows and Linux.
+ *
+ * @param output_param_name The name of the parameter to save a created UUID to.
+ * @return Returns TRUE (1) if the function succeeded; otherwise, returns FALSE (0).
+ */
+int lrlib_create_uuid(const char* output_param_name)
+{
+    return lrlib_create_uuid_v4(output_param_name);
+}
+
+/*
+ * SHA-256 and HMAC-SHA256
+ * =======================
+ * SHA-256 (FIPS 180-4) hashes of strings, parameter arrays and files, and HMAC-SHA256 (RFC 2104)
+ * signatures, e.g. for APIs that require each request to be signed. Digests are saved to a
+ * parameter as lower-case hex or as base64.
+ *
+ * Files are hashed in 64 KB chunks, so large files do not need to fit in memory. For HMAC, the
+ * hash state after the key has been processed is kept, so signing many messages with the same key
+ * only costs the hashing of the messages themselves.
+ */
+
+#define LRLIB_SHA256_DIGEST_LENGTH 32 // bytes
+#define LRLIB_SHA256_BLOCK_LENGTH 64 // bytes
+#define LRLIB_SHA256_FILE_CHUNK 65536 // bytes read from a file at a time
+
+// The formats that a digest can be saved in.
+#define LRLIB_DIGEST_HEX 0 // e.g. "ba7816bf8f01cfea..."
+#define LRLIB_DIGEST_BASE64 1 // e.g. "ungWv48Bz+pBQUDeXa4iI7ADYaOWF3qctBD/YfIAFa0="
+
+typedef struct {
+    unsigned int state[8];
+    unsigned char block[LRLIB_SHA256_BLOCK_LENGTH]; // data that does not fill a block yet
+    int block_length;
+    double total_length; // bytes hashed so far (a double, as "long long" cannot be used in VuGen)
+} lrlib_sha256_context;
+
+const unsigned int LRLIB_SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+// The HMAC key that was used last, and the hash states after its inner and outer padded blocks.
+char* lrlib_hmac_cached_key = NULL;
+lrlib_sha256_context lrlib_hmac_inner_context;
+lrlib_sha256_context lrlib_hmac_outer_context;
+
+#define LRLIB_SHA256_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+/**
+ * @brief Processes one 64-byte block of data.
+ */
+void lrlib_sha256_compress(unsigned int* state, const unsigned char* block) {
+    unsigned int w[64];
+    unsigned int a, b, c, d, e, f, g, h;
+    unsigned int t1, t2;
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        w[i] = (block[i * 4] << 24) | (block[i * 4 + 1] << 16) | (block[i * 4 + 2] << 8) | block[i * 4 + 3];
+    }
+    for (i = 16; i < 64; i++) {
+        t1 = LRLIB_SHA256_ROTR(w[i - 2], 17) ^ LRLIB_SHA256_ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        t2 = LRLIB_SHA256_ROTR(w[i - 15], 7) ^ LRLIB_SHA256_ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        w[i] = t1 + w[i - 7] + t2 + w[i - 16];
+    }
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+
+    for (i = 0; i < 64; i++) {
+        t1 = h + (LRLIB_SHA256_ROTR(e, 6) ^ LRLIB_SHA256_ROTR(e, 11) ^ LRLIB_SHA256_ROTR(e, 25)) +
+            ((e & f) ^ (~e & g)) + LRLIB_SHA256_K[i] + w[i];
+        t2 = (LRLIB_SHA256_ROTR(a, 2) ^ LRLIB_SHA256_ROTR(a, 13) ^ LRLIB_SHA256_ROTR(a, 22)) +
+            ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+/**
+ * @brief Starts a new hash.
+ */
+void lrlib_sha256_init(lrlib_sha256_context* context) {
+    context->state[0] = 0x6a09e667;
+    context->state[1] = 0xbb67ae85;
+    context->state[2] = 0x3c6ef372;
+    context->state[3] = 0xa54ff53a;
+    context->state[4] = 0x510e527f;
+    context->state[5] = 0x9b05688c;
+    context->state[6] = 0x1f83d9ab;
+    context->state[7] = 0x5be0cd19;
+    context->block_length = 0;
+    context->total_length = 0;
+}
+
+/**
+ * @brief Adds data to a hash. This can be called any number of times between lrlib_sha256_init
+ *        and lrlib_sha256_final.
+ */
+void lrlib_sha256_update(lrlib_sha256_context* context, const unsigned char* data, int length) {
+    int bytes_to_copy;
+
+    context->total_length += length;
+
+    // Fill up a partly full block first.
+    if (context->block_length > 0) {
+        bytes_to_copy = LRLIB_SHA256_BLOCK_LENGTH - context->block_length;
+        if (bytes_to_copy > length) {
+            bytes_to_copy = length;
+        }
+        memcpy(context->block + context->block_length, data, bytes_to_copy);
+        context->block_length += bytes_to_copy;
+        data += bytes_to_copy;
+        length -= bytes_to_copy;
+        if (context->block_length < LRLIB_SHA256_BLOCK_LENGTH) {
+            return;
+        }
+        lrlib_sha256_compress(context->state, context->block);
+        context->block_length = 0;
+    }
+
+    // Process whole blocks straight from the data, without copying them.
+    while (length >= LRLIB_SHA256_BLOCK_LENGTH) {
+        lrlib_sha256_compress(context->state, data);
+        data += LRLIB_SHA256_BLOCK_LENGTH;
+        length -= LRLIB_SHA256_BLOCK_LENGTH;
+    }
+
+    memcpy(context->block, data, length);
+    context->block_length = length;
+}
+
+/**
+ * @brief Finishes a hash, and writes the 32-byte digest.
+ */
+void lrlib_sha256_final(lrlib_sha256_context* context, unsigned char* digest) {
+    const double total_bits = context->total_length * 8;
+    const unsigned int bits_high = (unsigned int)(total_bits / 4294967296.0);
+    const unsigned int bits_low = (unsigned int)(total_bits - bits_high * 4294967296.0);
+    int i;
+
+    // Padding: a 1 bit, then zeros up to the last 8 bytes of a block, then the length in bits.
+    context->block[context->block_length] = 0x80;
+    context->block_length++;
+    if (context->block_length > LRLIB_SHA256_BLOCK_LENGTH - 8) {
+        memset(context->block + context->block_length, 0, LRLIB_SHA256_BLOCK_LENGTH - context->block_length);
+        lrlib_sha256_compress(context->state, context->block);
+        context->block_length = 0;
+    }
+    memset(context->block + context->block_length, 0, LRLIB_SHA256_BLOCK_LENGTH - 8 - context->block_length);
+    for (i = 0; i < 4; i++) {
+        context->block[56 + i] = (bits_high >> (24 - i * 8)) & 0xFF;
+        context->block[60 + i] = (bits_low >> (24 - i * 8)) & 0xFF;
+    }
+    lrlib_sha256_compress(context->state, context->block);
+
+    for (i = 0; i < 8; i++) {
+        digest[i * 4] = (context->state[i] >> 24) & 0xFF;
+        digest[i * 4 + 1] = (context->state[i] >> 16) & 0xFF;
+        digest[i * 4 + 2] = (context->state[i] >> 8) & 0xFF;
+        digest[i * 4 + 3] = context->state[i] & 0xFF;
+    }
+}
+
+/**
+ * @brief Writes a digest as hex or base64 (see LRLIB_DIGEST_HEX and LRLIB_DIGEST_BASE64), with a
+ *        terminating null. The buffer must have room for 2 * length + 1 characters.
+ */
+void lrlib_format_digest(const unsigned char* digest, int length, int format, char* buffer) {
+    static const char BASE64_DIGITS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    unsigned int group;
+    int i;
+
+    if (format == LRLIB_DIGEST_HEX) {
+        lrlib_init_hex_pairs();
+        for (i = 0; i < length; i++) {
+            *buffer++ = lrlib_hex_pairs[digest[i] * 2];
+            *buffer++ = lrlib_hex_pairs[digest[i] * 2 + 1];
+        }
+    } else if (format == LRLIB_DIGEST_BASE64) {
+        for (i = 0; i < length; i += 3) {
+            group = digest[i] << 16;
+            if (i + 1 < length) {
+                group |= digest[i + 1] << 8;
+            }
+            if (i + 2 < length) {
+                group |= digest[i + 2];
+            }
+            *buffer++ = BASE64_DIGITS[(group >> 18) & 0x3F];
+            *buffer++ = BASE64_DIGITS[(group >> 12) & 0x3F];
+            if (i + 1 < length) {
+                *buffer++ = BASE64_DIGITS[(group >> 6) & 0x3F];
+            } else {
+                *buffer++ = '=';
+            }
+            if (i + 2 < length) {
+                *buffer++ = BASE64_DIGITS[group & 0x3F];
+            } else {
+                *buffer++ = '=';
+            }
+        }
+    } else {
+        lr_error_message("Invalid digest format: %d.", format);
+        lr_abort();
+    }
+    *buffer = '\0';
+}
+
+/**
+ * @brief Adds the contents of a file to a hash.
+ *
+ * @return Returns TRUE if successful, or FALSE if the file could not be read.
+ */
+int lrlib_sha256_update_from_file(lrlib_sha256_context* context, const char* file_name) {
+    long fp;
+    unsigned char* buffer;
+    int bytes_read;
+
+    if ( (file_name == NULL) || (strlen(file_name) == 0) ) {
+        lr_error_message("file_name cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    fp = (long)fopen(file_name, "rb");
+    if (fp == 0) {
+        lr_error_message("Cannot open file \"%s\" for reading.", file_name);
+        return FALSE;
+    }
+
+    buffer = (unsigned char*)malloc(LRLIB_SHA256_FILE_CHUNK);
+    if (buffer == NULL) {
+        lr_error_message("Unable to allocate memory for the file buffer.");
+        lr_abort();
+    }
+
+    while ( (bytes_read = fread(buffer, 1, LRLIB_SHA256_FILE_CHUNK, fp)) > 0 ) {
+        lrlib_sha256_update(context, buffer, bytes_read);
+    }
+
+    free(buffer);
+    fclose(fp);
+    return TRUE;
+}
+
+/**
+ * @brief Calculates the SHA-256 hash of a string, and saves it to a parameter.
+ *
+ * @param data The string to hash.
+ * @param format LRLIB_DIGEST_HEX or LRLIB_DIGEST_BASE64.
+ * @param output_param_name The name of the parameter to save the digest to.
+ * @return Returns TRUE (1).
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     lrlib_sha256(lr_eval_string("{RequestBody}"), LRLIB_DIGEST_HEX, "BodyHash");
+ *     web_add_header("x-content-sha256", lr_eval_string("{BodyHash}"));
+ *     return 0;
+ * }
+ */
+int lrlib_sha256(const char* data, int format, const char* output_param_name) {
+    lrlib_sha256_context context;
+    unsigned char digest[LRLIB_SHA256_DIGEST_LENGTH];
+    char digest_text[LRLIB_SHA256_DIGEST_LENGTH * 2 + 1];
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if (data == NULL) {
+        lr_error_message("data cannot be NULL.");
+        lr_abort();
+    } else if ( (output_param_name == NULL) || (strlen(output_param_name) == 0) ) {
+        lr_error_message("output_param_name cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    lrlib_sha256_init(&context);
+    lrlib_sha256_update(&context, data, strlen(data));
+    lrlib_sha256_final(&context, digest);
+    lrlib_format_digest(digest, LRLIB_SHA256_DIGEST_LENGTH, format, digest_text);
+    lr_save_string(digest_text, output_param_name);
+    LRLIB_PROFILE_END("lrlib_sha256", profile_start_usec, context.total_length);
+    return TRUE;
+}
+
+/**
+ * @brief Calculates the SHA-256 hash of every element of a parameter array, and saves the digests
+ *        to another parameter array (in the same order).
+ *
+ * This is quicker than calling lrlib_sha256 for each element, as the output parameter names are
+ * built by a lrlib_paramarr_emitter instead of with sprintf.
+ *
+ * @param input_paramarr_name The name of the parameter array to hash.
+ * @param format LRLIB_DIGEST_HEX or LRLIB_DIGEST_BASE64.
+ * @param output_paramarr_name The name of the parameter array to save the digests to.
+ * @return Returns the number of digests saved.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     web_reg_save_param_ex("ParamName=Token", "LB=\"token\":\"", "RB=\"", "Ordinal=ALL", LAST);
+ *     web_url("tokens", "URL=https://{Host}/tokens", LAST);
+ *     lrlib_sha256_paramarr("Token", LRLIB_DIGEST_HEX, "TokenHash");
+ *     return 0;
+ * }
+ */
+int lrlib_sha256_paramarr(const char* input_paramarr_name, int format, const char* output_paramarr_name) {
+    lrlib_paramarr_emitter output;
+    lrlib_sha256_context context;
+    unsigned char digest[LRLIB_SHA256_DIGEST_LENGTH];
+    char digest_text[LRLIB_SHA256_DIGEST_LENGTH * 2 + 1];
+    int count;
+    int i;
+    double bytes = 0; // the total length of the elements (for the self-profiler)
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if ( (input_paramarr_name == NULL) || (strlen(input_paramarr_name) == 0) ) {
+        lr_error_message("input_paramarr_name cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    if (lrlib_paramarr_emitter_init(&output, output_paramarr_name) == FALSE) {
+        lr_abort();
+    }
+
+    count = lr_paramarr_len((char*)input_paramarr_name);
+    for (i = 1; i <= count; i++) {
+        const char* element = lr_paramarr_idx((char*)input_paramarr_name, i);
+
+        lrlib_sha256_init(&context);
+        lrlib_sha256_update(&context, element, strlen(element));
+        lrlib_sha256_final(&context, digest);
+        lrlib_format_digest(digest, LRLIB_SHA256_DIGEST_LENGTH, format, digest_text);
+        lrlib_paramarr_emitter_save(&output, digest_text);
+        bytes += context.total_length;
+    }
+
+    count = lrlib_paramarr_emitter_finish(&output);
+    LRLIB_PROFILE_END("lrlib_sha256_paramarr", profile_start_usec, bytes);
+    return count;
+}
+
+/**
+ * @brief Calculates the SHA-256 hash of a file, and saves it to a parameter. The file is read in
+ *        64 KB chunks, so it can be any size.
+ *
+ * @param file_name The file to hash.
+ * @param format LRLIB_DIGEST_HEX or LRLIB_DIGEST_BASE64.
+ * @param output_param_name The name of the parameter to save the digest to.
+ * @return Returns TRUE if successful, or FALSE if the file could not be read.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     lrlib_sha256_file("C:\\TEMP\\upload.pdf", LRLIB_DIGEST_BASE64, "UploadHash");
+ *     web_add_header("Content-Digest", lr_eval_string("sha-256=:{UploadHash}:"));
+ *     return 0;
+ * }
+ */
+int lrlib_sha256_file(const char* file_name, int format, const char* output_param_name) {
+    lrlib_sha256_context context;
+    unsigned char digest[LRLIB_SHA256_DIGEST_LENGTH];
+    char digest_text[LRLIB_SHA256_DIGEST_LENGTH * 2 + 1];
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    if ( (output_param_name == NULL) || (strlen(output_param_name) == 0) ) {
+        lr_error_message("output_param_name cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    lrlib_sha256_init(&context);
+    if (lrlib_sha256_update_from_file(&context, file_name) == FALSE) {
+        return FALSE;
+    }
+    lrlib_sha256_final(&context, digest);
+    lrlib_format_digest(digest, LRLIB_SHA256_DIGEST_LENGTH, format, digest_text);
+    lr_save_string(digest_text, output_param_name);
+    LRLIB_PROFILE_END("lrlib_sha256_file", profile_start_usec, context.total_length);
+    return TRUE;
+}
+
+/**
+ * @brief Prepares the HMAC inner and outer hash states for a key, unless they were already
+ *        prepared for the same key by the last call.
+ */
+void lrlib_hmac_sha256_set_key(const char* key) {
+    unsigned char padded_key[LRLIB_SHA256_BLOCK_LENGTH];
+    int key_length = strlen(key);
+    int i;
+
+    if ( (lrlib_hmac_cached_key != NULL) && (strcmp(lrlib_hmac_cached_key, key) == 0) ) {
+        return;
+    }
+
+    // Keys longer than a block are hashed first. Shorter keys are padded with zeros.
+    memset(padded_key, 0, sizeof(padded_key));
+    if (key_length > LRLIB_SHA256_BLOCK_LENGTH) {
+        lrlib_sha256_init(&lrlib_hmac_inner_context);
+        lrlib_sha256_update(&lrlib_hmac_inner_context, key, key_length);
+        lrlib_sha256_final(&lrlib_hmac_inner_context, padded_key);
+    } else {
+        memcpy(padded_key, key, key_length);
+    }
+
+    for (i = 0; i < LRLIB_SHA256_BLOCK_LENGTH; i++) {
+        padded_key[i] ^= 0x36;
+    }
+    lrlib_sha256_init(&lrlib_hmac_inner_context);
+    lrlib_sha256_update(&lrlib_hmac_inner_context, padded_key, LRLIB_SHA256_BLOCK_LENGTH);
+
+    for (i = 0; i < LRLIB_SHA256_BLOCK_LENGTH; i++) {
+        padded_key[i] ^= 0x36 ^ 0x5c;
+    }
+    lrlib_sha256_init(&lrlib_hmac_outer_context);
+    lrlib_sha256_update(&lrlib_hmac_outer_context, padded_key, LRLIB_SHA256_BLOCK_LENGTH);
+
+    free(lrlib_hmac_cached_key);
+    lrlib_hmac_cached_key = (char*)malloc(key_length + 1);
+    if (lrlib_hmac_cached_key == NULL) {
+        lr_error_message("Unable to allocate memory for the HMAC key.");
+        lr_abort();
+    }
+    strcpy(lrlib_hmac_cached_key, key);
+}
+
+/**
+ * @brief Finishes an HMAC, given the inner hash context (which has had the message added to it),
+ *        and saves it to a parameter.
+ */
+void lrlib_hmac_sha256_finish(lrlib_sha256_context* inner, int format, const char* output_param_name) {
+    lrlib_sha256_context outer;
+    unsigned char digest[LRLIB_SHA256_DIGEST_LENGTH];
+    char digest_text[LRLIB_SHA256_DIGEST_LENGTH * 2 + 1];
+
+    lrlib_sha256_final(inner, digest);
+    outer = lrlib_hmac_outer_context;
+    lrlib_sha256_update(&outer, digest, LRLIB_SHA256_DIGEST_LENGTH);
+    lrlib_sha256_final(&outer, digest);
+    lrlib_format_digest(digest, LRLIB_SHA256_DIGEST_LENGTH, format, digest_text);
+    lr_save_string(digest_text, output_param_name);
+}
+
+/**
+ * @brief Calculates the HMAC-SHA256 of a string, and saves it to a parameter.
+ *
+ * @param key The secret key.
+ * @param data The string to sign.
+ * @param format LRLIB_DIGEST_HEX or LRLIB_DIGEST_BASE64.
+ * @param output_param_name The name of the parameter to save the signature to.
+ * @return Returns TRUE (1).
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     lr_save_timestamp("Timestamp", LAST);
+ *     lrlib_hmac_sha256(lr_eval_string("{ApiSecret}"), lr_eval_string("GET\n/orders\n{Timestamp}"), LRLIB_DIGEST_BASE64, "Signature");
+ *     web_add_header("X-Signature", lr_eval_string("{Signature}"));
+ *     return 0;
+ * }
+ */
+int lrlib_hmac_sha256(const char* key, const char* data, int format, const char* output_param_name) {
+    lrlib_sha256_context inner;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if ( (key == NULL) || (data == NULL) ) {
+        lr_error_message("key and data cannot be NULL.");
+        lr_abort();
+    } else if ( (output_param_name == NULL) || (strlen(output_param_name) == 0) ) {
+        lr_error_message("output_param_name cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    lrlib_hmac_sha256_set_key(key);
+    inner = lrlib_hmac_inner_context;
+    lrlib_sha256_update(&inner, data, strlen(data));
+    lrlib_hmac_sha256_finish(&inner, format, output_param_name);
+    LRLIB_PROFILE_END("lrlib_hmac_sha256", profile_start_usec, strlen(data));
+    return TRUE;
+}
+
+/**
+ * @brief Calculates the HMAC-SHA256 of a file, and saves it to a parameter. The file is read in
+ *        64 KB chunks, so it can be any size.
+ *
+ * @param key The secret key.
+ * @param file_name The file to sign.
+ * @param format LRLIB_DIGEST_HEX or LRLIB_DIGEST_BASE64.
+ * @param output_param_name The name of the parameter to save the signature to.
+ * @return Returns TRUE if successful, or FALSE if the file could not be read.
+ */
+int lrlib_hmac_sha256_file(const char* key, const char* file_name, int format, const char* output_param_name) {
+    lrlib_sha256_context inner;
+    double file_length;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if (key == NULL) {
+        lr_error_message("key cannot be NULL.");
+        lr_abort();
+    } else if ( (output_param_name == NULL) || (strlen(output_param_name) == 0) ) {
+        lr_error_message("output_param_name cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    lrlib_hmac_sha256_set_key(key);
+    inner = lrlib_hmac_inner_context;
+    if (lrlib_sha256_update_from_file(&inner, file_name) == FALSE) {
+        return FALSE;
+    }
+    // The inner hash starts with one block made from the key, which is not part of the file.
+    file_length = inner.total_length - LRLIB_SHA256_BLOCK_LENGTH;
+    lrlib_hmac_sha256_finish(&inner, format, output_param_name);
+    LRLIB_PROFILE_END("lrlib_hmac_sha256_file", profile_start_usec, file_length);
+    return TRUE;
+}
+
+/**
+ * Gets the process ID of the mmdrv.exe process that is running the VuGen script that called
+ * this function.
+ *
+ * @return    This function returns the process ID of the calling process.
+ *
+ * Example code:
+ *     // Print the vuser's process ID
+ *     int vuser_pid; vuser_pid = lrlib_get_vuser_pid();
+ *     lr_output_message("vuser_pid: %d", vuser_pid);
+ *
+ * Note: This function only works on Windows.
+ */
+int lrlib_get_vuser_pid() {
+    int pid; // the process id
+
+    // MSVCRT.DLL contains the _getpid() function. It is a standard Windows DLL, usually found in
+    // C:\WINDOWS\system32. lrlib_load_dll only loads it the first time this function is called.
+    lrlib_load_dll("MSVCRT.DLL");
+
+    pid = _getpid();
+
+    return pid;
+}
+
+/**
+ * Prints log options to the replay log.
+ *
+ * @param[in] The logging settings to print. This should be the value returned by
+ *            lr_get_debug_message().
+ * @return    This function does not return a value. The logging settings are printed to the
+ *            replay log.
+ *
+ * Example code:
+ *     // Print the current logging settings to the output log.
+ *     unsigned int log_options;
+ *     log_options = lr_get_debug_message();
+ *     lrlib_print_log_options(log_options);
+ *
+ * Note: The standard lr_output_message function will write to the replay log even when logging
+ * is disabled. The only case where it will not write to the replay log is when "send messages only
+ * when an error occurs" is enabled.
+ */
+void lrlib_print_log_options(unsigned int log_options_to_print) {
+    unsigned int current_log_settings; // the logging settings that were enabled when this
+                                       // function was called.
+    char bit_pattern[(sizeof(int) * 8) + 1]; // this string holds the pattern of bits from the
+                                             // unsigned int containing the logging settings.
+
+    // Save the logging settings that were enabled when this function was called.
+    current_log_settings = lr_get_debug_message();
+
+    // Get the bit pattern for the log options that were passed to this function.
+    itoa(log_options_to_print, bit_pattern, 2); //
+
+    // If "send messages only when an error occurs" is enabled, then turn it off, otherwise nothing
+    // will be written to the output log.
+    // Note use of the bitwise AND operator. "current_log_settings & LR_MSG_CLASS_JIT_LOG_ON_ERROR"
+    // will evaluate to "LR_MSG_CLASS_JIT_LOG_ON_ERROR" if this setting is enabled.
+    if (current_log_settings & LR_MSG_CLASS_JIT_LOG_ON_ERROR) {
+        lr_set_debug_message(LR_MSG_CLASS_JIT_LOG_ON_ERROR, LR_SWITCH_OFF);
+    }
+
+    // Print the bit pattern.
+    // Message formatting specifies a string that is 32 characters wide (padded with 0s to the
+    // left of the printed value)
+    lr_output_message("%032.32s", bit_pattern);
+    lr_output_message("                      |    |||||");
+    lr_output_message("                      |    ||||+-LR_MSG_CLASS_BRIEF_LOG (Standard log)");
+    lr_output_message("                      |    |||+--LR_MSG_CLASS_RESULT_DATA (Data returned by server)");
+    lr_output_message("                      |    ||+---LR_MSG_CLASS_PARAMETERS (Parameter substitution)");
+    lr_output_message("                      |    |+----LR_MSG_CLASS_FULL_TRACE (Advanced trace)");
+    lr_output_message("                      |    +-----LR_MSG_CLASS_EXTENDED_LOG (Extended log)");
+    lr_output_message("                      +----------LR_MSG_CLASS_JIT_LOG_ON_ERROR (Send messages only when an error occurs)");
+
+    // Restore the "send messages only when an error occurs" logging setting if it was
+    // originally enabled.
+    if (current_log_settings & LR_MSG_CLASS_JIT_LOG_ON_ERROR) {
+        lr_set_debug_message(LR_MSG_CLASS_JIT_LOG_ON_ERROR, LR_SWITCH_ON);
+    }
+
+    return;
+}
+
+/**
+ * Writes a message to the replay log, even if logging is disabled.
+ *
+ * @param[in] The message to write to the replay log.
+ * @return    This function does not return a value.
+ *
+ * Example code:
+ *     // Write the current {UserName} parameter to the replay log, even though "send messages
+ *     // only when an error occurs" is enabled.
+ *     lrlib_force_output_message(lr_eval_string("logged in user is {UserName}"));
+ *
+ * Note: The standard lr_output_message function will write to the replay log even when logging is
+ * disabled. The only case where it will not write to the replay log is when "send messages only
+ * when an error occurs" is enabled.
+ * Note: The lr_output_message function supports sprintf-style message formatting. This function
+ * only allows a single string argument. A good work-around for this is to include {Parameters}
+ * in your message, and call the lr_eval_string function, as has been done in the example code.
+ */
+void lrlib_force_output_message(char* output_message) {
+    unsigned int current_log_settings; // the logging settings that were enabled when this
+                                       // function was called.
+
+    // Check input variables
+    if ( (output_message == NULL) || (strlen(output_message) == 0) ) {
+        lr_error_message("output_message cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    // Save the logging settings that were enabled when this function was called.
+    current_log_settings = lr_get_debug_message();
+
+    // If "send messages only when an error occurs" is enabled, then turn it off, otherwise nothing
+    // will be written to the output log.
+    // Note use of the bitwise AND operator. "current_log_settings & LR_MSG_CLASS_JIT_LOG_ON_ERROR"
+    // will evaluate to "LR_MSG_CLASS_JIT_LOG_ON_ERROR" if this setting is enabled.
+    if (current_log_settings & LR_MSG_CLASS_JIT_LOG_ON_ERROR) {
+        lr_set_debug_message(LR_MSG_CLASS_JIT_LOG_ON_ERROR, LR_SWITCH_OFF);
+    }
+
+    // Write the message to the replay log.
+    lr_output_message(output_message);
+
+    // Restore the "send messages only when an error occurs" logging setting if it was
+    // originally enabled.
+    if (current_log_settings & LR_MSG_CLASS_JIT_LOG_ON_ERROR) {
+        lr_set_debug_message(LR_MSG_CLASS_JIT_LOG_ON_ERROR, LR_SWITCH_ON);
+    }
+
+    return;
+}
+
+/**
+ * Sets new logging options to specify what information should be written to the replay log.
+ *
+ * @param[in] The new logging settings to use. Use the same C
+ *       constants as lr_set_debug_message
+ *       (LR_MSG_CLASS_BRIEF_LOG, LR_MSG_CLASS_EXTENDED_LOG
+ *       etc.). Invalid combinations (that are not possible to
+ *       create through the VuGen user interface) are not
+ *       permitted.
+ * @return    This function does not return a value.
+ *
+ * Example code:
+ *     // Increase logging levels just for a short section of code (not the entire script).
+ *     int original_options;
+ *     // Save current logging options.
+ *     original_options = lr_get_log lrlib_set_log_level(LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_RESULT_DATA | LR_MSG_CLASS_FULL_TRACE);
+ *
+ *     // Put code that you want to get full logging for here (e.g. a step that is failing).
+ *
+ *     // Restore original logging options
+ *     lrlib_set_log_level(original_options);
+ *
+ * Note: It is recommended that you use this function instead of the standard lr_set_debug_message
+ * function. VuGen has an unexpected behaviour where if "send messages only when an error occurs"
+ * is selected in the user interface (even if logging is disabled), then "send messages only when
+ * an error occurs" will be enabled along with the new logging settings, even if it was not
+ * specified in the function argument.
+ */
+void lrlib_set_log_level(unsigned int new_log_options) {
+    int i;
+    int is_valid = FALSE; // are the settings defined in new_log_options valid?
+    int valid_log_settings[] = { // all the possible logging settings available through the GUI
+        LR_MSG_CLASS_DISABLE_LOG,
+        LR_MSG_CLASS_BRIEF_LOG,
+        LR_MSG_CLASS_EXTENDED_LOG,
+        LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS,
+        LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_RESULT_DATA,
+        LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_RESULT_DATA,
+        LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_FULL_TRACE,
+        LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_FULL_TRACE,
+        LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_RESULT_DATA | LR_MSG_CLASS_FULL_TRACE,
+        LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_BRIEF_LOG,
+        LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG,
+        LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS,
+        LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_RESULT_DATA,
+        LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_RESULT_DATA,
+        LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_FULL_TRACE,
+        LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_FULL_TRACE,
+        LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_RESULT_DATA | LR_MSG_CLASS_FULL_TRACE
+    };
+
+    // Check wheter the new logging options are valid.
+    for (i=0; i<17; i++) {
+        if (new_log_options == valid_log_settings[i]) {
+            is_valid = TRUE;
+            break;
+        }
+    }
+
+    if(is_valid == FALSE) {
+        lr_error_message("Invalid logging setting. You may use one of the following:\n"
+            "    lrlib_set_log_level(LR_MSG_CLASS_DISABLE_LOG);\n"
+            "    lrlib_set_log_level(LR_MSG_CLASS_BRIEF_LOG);\n"
+            "    lrlib_set_log_level(LR_MSG_CLASS_EXTENDED_LOG);\n"
+            "    lrlib_set_log_level(LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS);\n"
+            "    lrlib_set_log_level(LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_RESULT_DATA);\n"
+            "    lrlib_set_log_level(LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_RESULT_DATA);\n"
+            "    lrlib_set_log_level(LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_FULL_TRACE);\n"
+            "    lrlib_set_log_level(LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_FULL_TRACE);\n"
+            "    lrlib_set_log_level(LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_RESULT_DATA | LR_MSG_CLASS_FULL_TRACE);\n"
+            "    lrlib_set_log_level(LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_BRIEF_LOG);\n"
+            "    lrlib_set_log_level(LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG);\n"
+            "    lrlib_set_log_level(LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS);\n"
+            "    lrlib_set_log_level(LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_RESULT_DATA);\n"
+            "    lrlib_set_log_level(LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_RESULT_DATA);\n"
+            "    lrlib_set_log_level(LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_FULL_TRACE);\n"
+            "    lrlib_set_log_level(LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_FULL_TRACE);\n"
+            "    lrlib_set_log_level(LR_MSG_CLASS_JIT_LOG_ON_ERROR | LR_MSG_CLASS_EXTENDED_LOG | LR_MSG_CLASS_PARAMETERS | LR_MSG_CLASS_RESULT_DATA | LR_MSG_CLASS_FULL_TRACE);"
+        );
+        lr_abort();
+    }
+
+    // Set the new logging options.
+    lr_set_debug_message(LR_MSG_CLASS_DISABLE_LOG, LR_SWITCH_ON); // reset everything to 0
+    lr_set_debug_message(new_log_options, LR_SWITCH_ON); // set the new option
+
+    // If LR_MSG_CLASS_JIT_LOG_ON_ERROR has become set, and it was not specified in
+    // new_log_options, then disable it.
+    if ( (lr_get_debug_message() & LR_MSG_CLASS_JIT_LOG_ON_ERROR) &&
+         !(new_log_options & LR_MSG_CLASS_JIT_LOG_ON_ERROR) ) {
+        lr_set_debug_message(LR_MSG_CLASS_JIT_LOG_ON_ERROR, LR_SWITCH_OFF);
+    }
+
+    return;
+}
+
+/*
+ * Code timers
+ * ===========
+ * Transactions are too slow to put around small pieces of code that run thousands of times per
+ * iteration. These timers cost a few tens of nanoseconds per start/stop. Totals are kept (per
+ * vuser) for each timer name, and reported all at once by lrlib_timer_report, e.g. at the end of
+ * each iteration.
+ *
+ * Timers can be nested. Each timer records its total time (including any timers started inside
+ * it), and its "self" time (excluding them).
+ */
+
+#define LRLIB_MAX_TIMERS 128 // must be a power of 2
+#define LRLIB_MAX_TIMER_NAME_LENGTH 63
+#define LRLIB_MAX_TIMER_DEPTH 32
+
+// Values for the "destination" argument of lrlib_timer_report.
+#define LRLIB_TIMER_REPORT_LOG 1 // one lr_output_message line per timer
+#define LRLIB_TIMER_REPORT_DATA_POINTS 2 // lr_user_data_point samples for each timer
+
+typedef struct {
+    char name[LRLIB_MAX_TIMER_NAME_LENGTH + 1]; // empty if the slot is not used
+    unsigned int count;
+    double total_usec;
+    double self_usec;
+    double max_usec;
+} lrlib_timer;
+
+typedef struct {
+    lrlib_timer* timer;
+    double start_usec;
+    double child_usec; // time spent in timers started inside this one
+} lrlib_timer_frame;
+
+lrlib_timer lrlib_timers[LRLIB_MAX_TIMERS];
+lrlib_timer_frame lrlib_timer_stack[LRLIB_MAX_TIMER_DEPTH];
+int lrlib_timer_depth = 0;
+
+/**
+ * @brief Finds the timer with this name, adding it if it is new.
+ */
+lrlib_timer* lrlib_timer_find(const char* name) {
+    unsigned int hash = 2166136261u; // FNV-1a
+    const char* c;
+    unsigned int i;
+
+    for (c = name; *c != '\0'; c++) {
+        hash = (hash ^ (unsigned char)*c) * 16777619u;
+    }
+
+    for (i = 0; i < LRLIB_MAX_TIMERS; i++) {
+        lrlib_timer* timer = &lrlib_timers[(hash + i) & (LRLIB_MAX_TIMERS - 1)];
+
+        if (timer->name[0] == '\0') {
+            if (c - name > LRLIB_MAX_TIMER_NAME_LENGTH || c == name) {
+                lr_error_message("Timer name must be between 1 and %d characters long.", LRLIB_MAX_TIMER_NAME_LENGTH);
+                lr_abort();
+            }
+            strcpy(timer->name, name);
+            return timer;
+        }
+        if (strcmp(timer->name, name) == 0) {
+            return timer;
+        }
+    }
+
+    lr_error_message("Too many timers (the maximum is %d).", LRLIB_MAX_TIMERS);
+    lr_abort();
+    return NULL;
+}
+
+/**
+ * @brief Starts a timer. Every lrlib_timer_start must be followed by an lrlib_timer_stop with the
+ *        same name. Timers can be nested (up to 32 deep), but must be stopped in reverse order.
+ *
+ * @param name The name of the timer (up to 63 characters).
+ * @return This function does not return a value.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     int i;
+ *
+ *     for (i = 1; i <= lr_paramarr_len("OrderId"); i++) {
+ *         lrlib_timer_start("build_order");
+ *
+ *         lrlib_timer_start("encode");
+ *         // ...encode a field...
+ *         lrlib_timer_stop("encode");
+ *
+ *         lrlib_timer_stop("build_order");
+ *     }
+ *
+ *     // Log the totals for this iteration, and clear them for the next iteration.
+ *     lrlib_timer_report(LRLIB_TIMER_REPORT_LOG);
+ *     return 0;
+ * }
+ */
+void lrlib_timer_start(const char* name) {
+    lrlib_timer_frame* frame;
+
+    if (lrlib_timer_depth >= LRLIB_MAX_TIMER_DEPTH) {
+        lr_error_message("Timers are nested too deeply (the maximum is %d). Is a call to lrlib_timer_stop missing?", LRLIB_MAX_TIMER_DEPTH);
+        lr_abort();
+    }
+
+    frame = &lrlib_timer_stack[lrlib_timer_depth];
+    frame->timer = lrlib_timer_find(name);
+    frame->child_usec = 0;
+    lrlib_timer_depth++;
+
+    // Read the clock last, so that the time to find the timer is not included.
+    frame->start_usec = lrlib_timer_now_usec();
+}
+
+/**
+ * @brief Stops a timer that was started with lrlib_timer_start, and adds the elapsed time to its
+ *        totals.
+ *
+ * @param name The name of the timer. It must be the most recently started timer that has not been
+ *        stopped yet.
+ * @return Returns the elapsed time in microseconds.
+ *
+ * @example See lrlib_timer_start.
+ */
+double lrlib_timer_stop(const char* name) {
+    const double now = lrlib_timer_now_usec();
+    lrlib_timer_frame* frame;
+    lrlib_timer* timer;
+    double elapsed;
+
+    if (lrlib_timer_depth == 0) {
+        lr_error_message("lrlib_timer_stop(\"%s\") was called, but no timer is running.", name);
+        lr_abort();
+    }
+
+    frame = &lrlib_timer_stack[lrlib_timer_depth - 1];
+    timer = frame->timer;
+    if (strcmp(timer->name, name) != 0) {
+        lr_error_message("lrlib_timer_stop(\"%s\") was called, but the most recently started timer is \"%s\".", name, timer->name);
+        lr_abort();
+    }
+    lrlib_timer_depth--;
+
+    elapsed = now - frame->start_usec;
+    timer->count++;
+    timer->total_usec += elapsed;
+    timer->self_usec += elapsed - frame->child_usec;
+    if (elapsed > timer->max_usec) {
+        timer->max_usec = elapsed;
+    }
+
+    if (lrlib_timer_depth > 0) {
+        lrlib_timer_stack[lrlib_timer_depth - 1].child_usec += elapsed;
+    }
+
+    return elapsed;
+}
+
+/**
+ * @brief Reports the totals of every timer that has been used since the last report, then clears
+ *        the totals.
+ *
+ * With LRLIB_TIMER_REPORT_LOG, one line is written to the log for each timer, with the count,
+ * total, self, average and maximum times (in microseconds). The line is written even if logging is
+ * turned off. With LRLIB_TIMER_REPORT_DATA_POINTS, the data points "<name>_total_ms" and
+ * "<name>_count" are sent for each timer, so they can be graphed in Analysis.
+ *
+ * @param destination LRLIB_TIMER_REPORT_LOG, LRLIB_TIMER_REPORT_DATA_POINTS, or both (added
+ *        together).
+ * @return Returns the number of timers reported.
+ *
+ * @example See lrlib_timer_start.
+ */
+int lrlib_timer_report(int destination) {
+    char line[LRLIB_MAX_TIMER_NAME_LENGTH + 200];
+    char data_point_name[LRLIB_MAX_TIMER_NAME_LENGTH + 16];
+    unsigned int current_log_settings;
+    int reported = 0;
+    int i;
+
+    if (lrlib_timer_depth != 0) {
+        lr_error_message("lrlib_timer_report was called while timer \"%s\" is still running.", lrlib_timer_stack[lrlib_timer_depth - 1].timer->name);
+        lrlib_timer_depth = 0;
+    }
+
+    // Turn off "send messages only when an error occurs" once for the whole report (see
+    // lrlib_force_output_message).
+    current_log_settings = lr_get_debug_message();
+    if ( (destination & LRLIB_TIMER_REPORT_LOG) && (current_log_settings & LR_MSG_CLASS_JIT_LOG_ON_ERROR) ) {
+        lr_set_debug_message(LR_MSG_CLASS_JIT_LOG_ON_ERROR, LR_SWITCH_OFF);
+    }
+
+    for (i = 0; i < LRLIB_MAX_TIMERS; i++) {
+        lrlib_timer* timer = &lrlib_timers[i];
+        if (timer->count == 0) {
+            continue;
+        }
+
+        if (destination & LRLIB_TIMER_REPORT_LOG) {
+            sprintf(line, "Timer %s: count=%u total=%.1fus self=%.1fus avg=%.3fus max=%.1fus",
+                timer->name, timer->count, timer->total_usec, timer->self_usec,
+                timer->total_usec / timer->count, timer->max_usec);
+            // The line contains the timer name, so it must not be used as the format string (a
+            // name like "100%s" would crash the vuser).
+            lr_output_message("%s", line);
+        }
+
+        if (destination & LRLIB_TIMER_REPORT_DATA_POINTS) {
+            sprintf(data_point_name, "%s_total_ms", timer->name);
+            lr_user_data_point(data_point_name, timer->total_usec / 1000);
+            sprintf(data_point_name, "%s_count", timer->name);
+            lr_user_data_point(data_point_name, timer->count);
+        }
+
+        timer->count = 0;
+        timer->total_usec = 0;
+        timer->self_usec = 0;
+        timer->max_usec = 0;
+        reported++;
+    }
+
+    if ( (destination & LRLIB_TIMER_REPORT_LOG) && (current_log_settings & LR_MSG_CLASS_JIT_LOG_ON_ERROR) ) {
+        lr_set_debug_message(LR_MSG_CLASS_JIT_LOG_ON_ERROR, LR_SWITCH_ON);
+    }
+
+    return reported;
+}
+
+/*
+ * Self-profiler results (the self-profiler itself is near the top of this file, before the first
+ * function that it profiles).
+ */
+
+/**
+ * @brief Writes the profile table (one line per function, with the function that used the most
+ *        time first) to the log, or to a file.
+ *
+ * The columns are the number of calls, the total, average and maximum time (in milliseconds and
+ * microseconds), and the number of bytes processed. Log lines are written even if logging is
+ * turned off.
+ *
+ * @param file_name The file to append the table to, or NULL to write it to the log.
+ * @return Returns the number of functions in the table.
+ *
+ * @example See lrlib_profiling_enable.
+ */
+int lrlib_profile_dump(const char* file_name) {
+    int order[LRLIB_MAX_PROFILE_ENTRIES];
+    char line[256];
+    long fp = 0;
+    int i;
+    int j;
+
+    // Sort by total time (insertion sort, as there are only a few entries).
+    for (i = 0; i < lrlib_profile_entry_count; i++) {
+        const double total = lrlib_profile_entries[i].total_usec;
+        for (j = i; j > 0 && lrlib_profile_entries[order[j - 1]].total_usec < total; j--) {
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+    }
+
+    if (file_name != NULL) {
+        fp = (long)fopen(file_name, "a");
+        if (fp == 0) {
+            lr_error_message("Cannot open file \"%s\" for writing.", file_name);
+            return 0;
+        }
+    }
+
+    sprintf(line, "%-40s %10s %12s %12s %12s %14s", "Function", "Calls", "Total (ms)", "Avg (us)", "Max (us)", "Bytes");
+    if (fp == 0) {
+        lrlib_force_output_message(line);
+    } else {
+        fprintf(fp, "%s\n", line);
+    }
+
+    for (i = 0; i < lrlib_profile_entry_count; i++) {
+        const lrlib_profile_entry* entry = &lrlib_profile_entries[order[i]];
+
+        sprintf(line, "%-40s %10u %12.3f %12.3f %12.3f %14.0f", entry->function_name, entry->calls,
+            entry->total_usec / 1000, entry->total_usec / entry->calls, entry->max_usec, entry->bytes);
+        if (fp == 0) {
+            lrlib_force_output_message(line);
+        } else {
+            fprintf(fp, "%s\n", line);
+        }
+    }
+
+    if (fp != 0) {
+        fclose(fp);
+    }
+
+    return lrlib_profile_entry_count;
+}
+
+/**
+ * @brief Clears the profile results (for this vuser).
+ *
+ * @return This function does not return a value.
+ */
+void lrlib_profile_reset() {
+    lrlib_profile_entry_count = 0;
+}
+
+/*
+ * Pacing
+ * ======
+ * Pacing controls how often each vuser starts an iteration, and so sets the throughput of the test.
+ * These functions keep a schedule of absolute start times (deadlines), so an iteration that runs
+ * late does not push back every later iteration; the vuser catches up instead. The gaps between
+ * start times can be fixed, random within a range, exponentially distributed (which models
+ * independent users arriving at random, as in an "open" workload model), or replayed from a list
+ * (e.g. the gaps between requests in a production log).
+ *
+ * The vuser sleeps until the deadline, which is usually accurate to about a millisecond. To get
+ * sub-millisecond accuracy, call lrlib_sleep_set_spin to make the vuser check the clock in a loop
+ * for the last part of the wait instead. This keeps a CPU core busy, so it is off by default.
+ */
+
+#define LRLIB_PACING_FIXED 0 // every gap is param1 seconds
+#define LRLIB_PACING_UNIFORM 1 // gaps are random, between param1 and param2 seconds
+#define LRLIB_PACING_EXPONENTIAL 2 // gaps are exponentially distributed, with a mean of param1 seconds
+#define LRLIB_PACING_REPLAY 3 // gaps are read from a parameter array (see lrlib_pacing_start_replay)
+
+#define LRLIB_MAX_SPIN_USEC 2000 // the longest time that lrlib_sleep_set_spin accepts
+#define LRLIB_MAX_SLEEP_USEC 1000000 // each sleep is at most 1 second (longer waits are split up)
+
+int lrlib_pacing_distribution = -1; // -1 until lrlib_pacing_start is called
+double lrlib_pacing_param1;
+double lrlib_pacing_param2;
+double* lrlib_pacing_replay_intervals = NULL;
+int lrlib_pacing_replay_count = 0;
+int lrlib_pacing_replay_position = 0;
+double lrlib_pacing_deadline_usec; // the start time of the next iteration
+unsigned int lrlib_pacing_iterations;
+unsigned int lrlib_pacing_late_iterations;
+double lrlib_pacing_total_late_usec;
+double lrlib_pacing_max_late_usec;
+int lrlib_sleep_initialised = FALSE;
+double lrlib_sleep_spin_usec = 0; // see lrlib_sleep_set_spin
+
+/**
+ * @brief Makes lrlib_sleep_until_usec (and so lrlib_think_time and lrlib_pacing_wait) check the
+ *        clock in a loop for the last part of each wait, instead of sleeping.
+ *
+ * A sleeping vuser may wake up a millisecond or so late (more on a busy load generator). A vuser
+ * that checks the clock in a loop wakes up within a few microseconds, but uses a whole CPU core
+ * while it waits. Only turn this on for tests that need sub-millisecond timing and have only a
+ * few vusers on each load generator.
+ *
+ * @param spin_usec How long to check the clock in a loop, in microseconds (up to 2000). Use 0 to
+ *        only sleep, which is the default.
+ * @return This function does not return a value.
+ *
+ * @example
+ *
+ * vuser_init()
+ * {
+ *     lrlib_sleep_set_spin(200);
+ *     lrlib_pacing_start(LRLIB_PACING_EXPONENTIAL, 0.01, 0);
+ *     return 0;
+ * }
+ */
+void lrlib_sleep_set_spin(double spin_usec) {
+    if ( (spin_usec < 0) || (spin_usec > LRLIB_MAX_SPIN_USEC) ) {
+        lr_error_message("spin_usec must be between 0 and %d.", LRLIB_MAX_SPIN_USEC);
+        lr_abort();
+    }
+
+    lrlib_sleep_spin_usec = spin_usec;
+}
+
+/**
+ * @brief Pauses the vuser until a time from lrlib_timer_now_usec. The vuser sleeps (in steps of at
+ *        most 1 second) until the time, or until shortly before it if lrlib_sleep_set_spin has
+ *        been called, and then checks the clock in a loop.
+ */
+void lrlib_sleep_until_usec(double deadline_usec) {
+    double remaining = deadline_usec - lrlib_timer_now_usec();
+    double sleep_usec;
+
+#ifndef LRLIB_LINUX
+    // By default, Windows only wakes sleeping threads every 15.6 ms. Ask for 1 ms instead.
+    if (lrlib_sleep_initialised == FALSE) {
+        lrlib_load_dll("kernel32.dll");
+        lrlib_load_dll("winmm.dll");
+        timeBeginPeriod(1);
+        lrlib_sleep_initialised = TRUE;
+    }
+#endif
+
+    // Long waits are split into sleeps of at most 1 second, so the sleep time can never overflow
+    // the argument of the sleep function.
+    while (remaining > lrlib_sleep_spin_usec) {
+        sleep_usec = remaining - lrlib_sleep_spin_usec;
+        if (sleep_usec > LRLIB_MAX_SLEEP_USEC) {
+            sleep_usec = LRLIB_MAX_SLEEP_USEC;
+        }
+#ifdef LRLIB_LINUX
+        {
+            // struct timespec on 64-bit Linux
+            struct {
+                long seconds;
+                long nanoseconds;
+            } duration;
+
+            duration.seconds = (long)(sleep_usec / 1000000);
+            duration.nanoseconds = (long)((sleep_usec - duration.seconds * 1000000.0) * 1000);
+            nanosleep(&duration, NULL);
+        }
+#else
+        // Round up, so that a wait of less than 1 ms sleeps instead of returning straight away.
+        Sleep((unsigned long)((sleep_usec + 999) / 1000));
+#endif
+        remaining = deadline_usec - lrlib_timer_now_usec();
+    }
+
+    while (lrlib_timer_now_usec() < deadline_usec) {
+        // spin (only for the last lrlib_sleep_spin_usec microseconds)
+    }
+}
+
+/**
+ * Pauses the execution of the vuser for the specified number of seconds. This
+ * think time cannot be ignored by the script's runtime settings.
+ *
+ * Example code:
+ *     // This is usually useful when you have a polling loop, and you don't
+ *     // want to poll too quickly
+ *     lrlib_think_time(0.5);
+ *
+ * TODO: should write to the output log when this is called (what message does lr_think_time() write?
+ *
+ * @param[in] The time (in seconds) to wait.
+ * @return    This function does not return a value.
+ *
+ * Note: This function ignores the runtime settings related to think time.
+ */
+void lrlib_think_time(double time) {
+    if (time <= 0) {
+        return;
+    }
+
+    lrlib_sleep_until_usec(lrlib_timer_now_usec() + time * 1000000);
+}
+
+/**
+ * @brief Returns the gap (in microseconds) before the next iteration should start.
+ */
+double lrlib_pacing_next_interval_usec() {
+    double log(double x);
+    double u; // a random number greater than 0 and less than 1
+    double seconds;
+
+    if (lrlib_pacing_distribution == LRLIB_PACING_UNIFORM) {
+        u = (lrlib_random_uint32() + 0.5) / 4294967296.0;
+        seconds = lrlib_pacing_param1 + u * (lrlib_pacing_param2 - lrlib_pacing_param1);
+    } else if (lrlib_pacing_distribution == LRLIB_PACING_EXPONENTIAL) {
+        u = (lrlib_random_uint32() + 0.5) / 4294967296.0;
+        seconds = -lrlib_pacing_param1 * log(u);
+    } else if (lrlib_pacing_distribution == LRLIB_PACING_REPLAY) {
+        seconds = lrlib_pacing_replay_intervals[lrlib_pacing_replay_position];
+        lrlib_pacing_replay_position = (lrlib_pacing_replay_position + 1) % lrlib_pacing_replay_count;
+    } else {
+        seconds = lrlib_pacing_param1;
+    }
+
+    return seconds * 1000000;
+}
+
+/**
+ * @brief Starts pacing (for this vuser). The first iteration starts now; call lrlib_pacing_wait at
+ *        the end of each iteration to wait until the next one is due.
+ *
+ * @param distribution LRLIB_PACING_FIXED, LRLIB_PACING_UNIFORM or LRLIB_PACING_EXPONENTIAL.
+ * @param param1 The gap in seconds (fixed), the shortest gap (uniform), or the mean gap
+ *        (exponential).
+ * @param param2 The longest gap in seconds (uniform). Ignored for the other distributions.
+ * @return This function does not return a value.
+ *
+ * @example
+ *
+ * vuser_init()
+ * {
+ *     // Each vuser starts an iteration every 30 seconds on average, at random (Poisson) times.
+ *     lrlib_pacing_start(LRLIB_PACING_EXPONENTIAL, 30, 0);
+ *     return 0;
+ * }
+ *
+ * Action()
+ * {
+ *     // ...business process...
+ *
+ *     lrlib_pacing_wait();
+ *     return 0;
+ * }
+ *
+ * vuser_end()
+ * {
+ *     lrlib_pacing_save_stats("Pacing");
+ *     lr_output_message("%s of %s iterations started late (by up to %s ms)",
+ *         lr_eval_string("{Pacing_late_count}"), lr_eval_string("{Pacing_count}"),
+ *         lr_eval_string("{Pacing_max_late_ms}"));
+ *     return 0;
+ * }
+ *
+ * Note: Set the runtime settings to start each iteration "As soon as the previous iteration ends",
+ *       so that LoadRunner does not add its own pacing.
+ */
+void lrlib_pacing_start(int distribution, double param1, double param2) {
+    if ( (distribution != LRLIB_PACING_FIXED) && (distribution != LRLIB_PACING_UNIFORM) && (distribution != LRLIB_PACING_EXPONENTIAL) ) {
+        lr_error_message("Invalid distribution %d. Use LRLIB_PACING_FIXED, LRLIB_PACING_UNIFORM or LRLIB_PACING_EXPONENTIAL (or lrlib_pacing_start_replay).", distribution);
+        lr_abort();
+    } else if (param1 < 0) {
+        lr_error_message("param1 cannot be negative.");
+        lr_abort();
+    } else if ( (distribution == LRLIB_PACING_UNIFORM) && (param2 < param1) ) {
+        lr_error_message("param2 (the longest gap) cannot be less than param1 (the shortest gap).");
+        lr_abort();
+    }
+
+    lrlib_pacing_distribution = distribution;
+    lrlib_pacing_param1 = param1;
+    lrlib_pacing_param2 = param2;
+    lrlib_pacing_deadline_usec = lrlib_timer_now_usec();
+    lrlib_pacing_iterations = 0;
+    lrlib_pacing_late_iterations = 0;
+    lrlib_pacing_total_late_usec = 0;
+    lrlib_pacing_max_late_usec = 0;
+}
+
+/**
+ * @brief Starts pacing with gaps that are replayed, in order, from a parameter array of numbers
+ *        (in seconds). When the end of the list is reached, it starts again from the beginning.
+ *
+ * @param paramarr_name The name of a parameter array of gaps in seconds, e.g. {"0.5", "1.25", "3"}.
+ * @return This function does not return a value.
+ *
+ * @example
+ *
+ * vuser_init()
+ * {
+ *     // Replay the gaps between orders from a production log (one per line of a parameter file).
+ *     lrlib_read_text_file("C:\\Temp\\order_gaps.txt", "OrderGaps");
+ *     lrlib_str_split(lr_eval_string("{OrderGaps}"), "\n", "OrderGap");
+ *     lrlib_pacing_start_replay("OrderGap");
+ *     return 0;
+ * }
+ */
+void lrlib_pacing_start_replay(const char* paramarr_name) {
+    int count;
+    int i;
+
+    if ( (paramarr_name == NULL) || (strlen(paramarr_name) == 0) ) {
+        lr_error_message("paramarr_name cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    count = lr_paramarr_len((char*)paramarr_name);
+    if (count < 1) {
+        lr_error_message("Parameter array \"%s\" is empty.", paramarr_name);
+        lr_abort();
+    }
+
+    free(lrlib_pacing_replay_intervals);
+    lrlib_pacing_replay_intervals = (double*)malloc(count * sizeof(double));
+    if (lrlib_pacing_replay_intervals == NULL) {
+        lr_error_message("Unable to allocate memory for the pacing intervals.");
+        lr_abort();
+    }
+
+    for (i = 0; i < count; i++) {
+        const char* element = lr_paramarr_idx((char*)paramarr_name, i + 1);
+        if ( (lrlib_parse_double(element, &lrlib_pacing_replay_intervals[i]) == FALSE) || (lrlib_pacing_replay_intervals[i] < 0) ) {
+            lr_error_message("Element %d of \"%s\" is not a valid number of seconds: \"%s\".", i + 1, paramarr_name, element);
+            lr_abort();
+        }
+    }
+
+    lrlib_pacing_start(LRLIB_PACING_FIXED, 0, 0);
+    lrlib_pacing_distribution = LRLIB_PACING_REPLAY;
+    lrlib_pacing_replay_count = count;
+    lrlib_pacing_replay_position = 0;
+}
+
+/**
+ * @brief Waits until the next iteration is due. Call this at the end of each iteration.
+ *
+ * If the iteration ran past the time the next one was due, this returns immediately and the
+ * lateness is recorded. The schedule is not moved back, so the following iterations start closer
+ * together until the vuser has caught up.
+ *
+ * @return Returns the number of milliseconds that the next iteration is late (0 if it is on time).
+ *
+ * @example See lrlib_pacing_start.
+ */
+double lrlib_pacing_wait() {
+    double now;
+    double late_usec = 0;
+
+    if (lrlib_pacing_distribution == -1) {
+        lr_error_message("lrlib_pacing_wait was called before lrlib_pacing_start.");
+        lr_abort();
+    }
+
+    lrlib_pacing_deadline_usec += lrlib_pacing_next_interval_usec();
+    lrlib_pacing_iterations++;
+
+    now = lrlib_timer_now_usec();
+    if (now < lrlib_pacing_deadline_usec) {
+        lrlib_sleep_until_usec(lrlib_pacing_deadline_usec);
+    } else {
+        late_usec = now - lrlib_pacing_deadline_usec;
+        lrlib_pacing_late_iterations++;
+        lrlib_pacing_total_late_usec += late_usec;
+        if (late_usec > lrlib_pacing_max_late_usec) {
+            lrlib_pacing_max_late_usec = late_usec;
+        }
+    }
+
+    return late_usec / 1000;
+}
+
+/**
+ * @brief Saves pacing statistics (for this vuser) to parameters: {Prefix_count} (iterations
+ *        paced), {Prefix_late_count} (iterations that started late), {Prefix_mean_late_ms} (the
+ *        average lateness of the late iterations) and {Prefix_max_late_ms}.
+ *
+ * @param prefix The start of the parameter names.
+ * @return This function does not return a value.
+ *
+ * @example See lrlib_pacing_start.
+ */
+void lrlib_pacing_save_stats(const char* prefix) {
+    char param_name[LRLIB_PARAM_NAME_BUFFER_LENGTH];
+    char value[32];
+    double mean_late_usec = 0;
+
+    if ( (prefix == NULL) || (strlen(prefix) == 0) || (strlen(prefix) > LRLIB_MAX_PARAM_NAME_LENGTH) ) {
+        lr_error_message("prefix cannot be NULL, empty, or longer than %d characters.", LRLIB_MAX_PARAM_NAME_LENGTH);
+        lr_abort();
+    }
+
+    if (lrlib_pacing_late_iterations > 0) {
+        mean_late_usec = lrlib_pacing_total_late_usec / lrlib_pacing_late_iterations;
+    }
+
+    sprintf(param_name, "%s_count", prefix);
+    sprintf(value, "%u", lrlib_pacing_iterations);
+    lr_save_string(value, param_name);
+    sprintf(param_name, "%s_late_count", prefix);
+    sprintf(value, "%u", lrlib_pacing_late_iterations);
+    lr_save_string(value, param_name);
+    sprintf(param_name, "%s_mean_late_ms", prefix);
+    sprintf(value, "%.3f", mean_late_usec / 1000);
+    lr_save_string(value, param_name);
+    sprintf(param_name, "%s_max_late_ms", prefix);
+    sprintf(value, "%.3f", lrlib_pacing_max_late_usec / 1000);
+    lr_save_string(value, param_name);
+}
+
+/*
+ * Buffered log
+ * ============
+ * lrlib_force_output_message changes the logging settings twice for every message, and every
+ * lr_output_message call is a separate write to the replay log. When a script writes a lot of
+ * diagnostic messages under load, this can use more CPU than the rest of the script.
+ *
+ * lrlib_log_message copies each message into a per-vuser buffer instead. The buffer is written out
+ * as a batch when it is full, when the flush interval has passed, or when lrlib_log_flush is
+ * called. A batch goes to the replay log (with "send messages only when an error occurs" turned
+ * off once per batch, not once per message), or to a separate file (see lrlib_log_open). Each
+ * category of message can also be rate limited, so a flood of the same warning does not fill the
+ * log.
+ *
+ * Messages that are still in the buffer are lost if the vuser aborts, so call lrlib_log_close in
+ * vuser_end.
+ */
+
+#define LRLIB_LOG_BUFFER_SIZE 65536
+#define LRLIB_LOG_MAX_OUTPUT_LENGTH 4000 // the most characters to pass to one lr_output_message call
+#define LRLIB_MAX_LOG_CATEGORIES 32
+#define LRLIB_MAX_LOG_CATEGORY_LENGTH 31
+
+typedef struct {
+    char name[LRLIB_MAX_LOG_CATEGORY_LENGTH + 1];
+    double max_per_second; // 0 if the category is not rate limited
+    double tokens; // the number of messages that can be logged now (a "token bucket")
+    double last_refill_usec;
+    unsigned int dropped; // messages dropped since the last flush
+} lrlib_log_category;
+
+char lrlib_log_buffer[LRLIB_LOG_BUFFER_SIZE];
+int lrlib_log_buffer_length = 0;
+int lrlib_log_buffer_messages = 0;
+int lrlib_log_file = -1; // a file descriptor (Linux) or file handle (Windows), or -1 to write to the replay log
+int lrlib_log_vuser_id = 0; // included in each line written to a file
+double lrlib_log_flush_interval_usec = 1000000;
+double lrlib_log_last_flush_usec = 0;
+lrlib_log_category lrlib_log_categories[LRLIB_MAX_LOG_CATEGORIES];
+int lrlib_log_category_count = 0;
+
+/**
+ * @brief Returns the entry for a log category, adding it if it is new.
+ */
+lrlib_log_category* lrlib_log_find_category(const char* name) {
+    int i;
+    lrlib_log_category* category;
+
+    for (i = 0; i < lrlib_log_category_count; i++) {
+        if (strcmp(lrlib_log_categories[i].name, name) == 0) {
+            return &lrlib_log_categories[i];
+        }
+    }
+
+    if ( (strlen(name) == 0) || (strlen(name) > LRLIB_MAX_LOG_CATEGORY_LENGTH) ) {
+        lr_error_message("Log category \"%s\" must be between 1 and %d characters long.", name, LRLIB_MAX_LOG_CATEGORY_LENGTH);
+        lr_abort();
+    } else if (lrlib_log_category_count == LRLIB_MAX_LOG_CATEGORIES) {
+        lr_error_message("Too many log categories (the maximum is %d).", LRLIB_MAX_LOG_CATEGORIES);
+        lr_abort();
+    }
+
+    category = &lrlib_log_categories[lrlib_log_category_count];
+    lrlib_log_category_count++;
+    memset(category, 0, sizeof(lrlib_log_category));
+    strcpy(category->name, name);
+    return category;
+}
+
+/**
+ * @brief Writes text (one or more complete lines, each ending in '\n') to the log destination.
+ *        The text is modified while it is written, but is restored afterwards.
+ */
+void lrlib_log_write(char* text, int length) {
+    unsigned int current_log_settings;
+    int start = 0;
+    int end;
+    int i;
+#ifndef LRLIB_LINUX
+    unsigned long written;
+#endif
+
+    if (length == 0) {
+        return;
+    } else if (lrlib_log_file != -1) {
+        // The file is opened for appending, so each write goes to the end of the file, even if
+        // another vuser has written to it since. The whole batch is written with one call, so it
+        // is not mixed up with lines from other vusers.
+#ifdef LRLIB_LINUX
+        write(lrlib_log_file, text, length);
+#else
+        WriteFile(lrlib_log_file, text, length, &written, NULL);
+#endif
+        return;
+    }
+
+    // Turn off "send messages only when an error occurs" once for the whole batch (see
+    // lrlib_force_output_message).
+    current_log_settings = lr_get_debug_message();
+    if (current_log_settings & LR_MSG_CLASS_JIT_LOG_ON_ERROR) {
+        lr_set_debug_message(LR_MSG_CLASS_JIT_LOG_ON_ERROR, LR_SWITCH_OFF);
+    }
+
+    // Write as many complete lines as will fit in each lr_output_message call. A line that is
+    // longer than LRLIB_LOG_MAX_OUTPUT_LENGTH is written by itself.
+    while (start < length) {
+        end = start;
+        for (i = start; (i < length) && (i - start < LRLIB_LOG_MAX_OUTPUT_LENGTH); i++) {
+            if (text[i] == '\n') {
+                end = i;
+            }
+        }
+        if (end == start) {
+            while (text[end] != '\n') {
+                end++;
+            }
+        }
+
+        text[end] = '\0';
+        lr_output_message("%s", text + start);
+        text[end] = '\n';
+        start = end + 1;
+    }
+
+    if (current_log_settings & LR_MSG_CLASS_JIT_LOG_ON_ERROR) {
+        lr_set_debug_message(LR_MSG_CLASS_JIT_LOG_ON_ERROR, LR_SWITCH_ON);
+    }
+}
+
+/**
+ * @brief Writes all the buffered log messages.
+ *
+ * Messages are also written automatically when the buffer is full, or when the flush interval
+ * has passed (see lrlib_log_set_flush_interval). If any messages were dropped by a rate limit
+ * since the last flush, a line saying how many is written for each category.
+ *
+ * @return Returns the number of messages written.
+ *
+ * @example See lrlib_log_message.
+ */
+int lrlib_log_flush() {
+    int messages = lrlib_log_buffer_messages;
+    char line[LRLIB_MAX_LOG_CATEGORY_LENGTH + 100];
+    int length;
+    int i;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Add the dropped message counts to the end of the batch, so that the whole batch is written
+    // at once. The buffer is only written early if they do not fit.
+    for (i = 0; i < lrlib_log_category_count; i++) {
+        if (lrlib_log_categories[i].dropped > 0) {
+            length = sprintf(line, "[%s] %u messages were dropped by the rate limit.\n", lrlib_log_categories[i].name, lrlib_log_categories[i].dropped);
+            if (lrlib_log_buffer_length + length > LRLIB_LOG_BUFFER_SIZE) {
+                lrlib_log_write(lrlib_log_buffer, lrlib_log_buffer_length);
+                lrlib_log_buffer_length = 0;
+            }
+            memcpy(lrlib_log_buffer + lrlib_log_buffer_length, line, length);
+            lrlib_log_buffer_length += length;
+            lrlib_log_categories[i].dropped = 0;
+        }
+    }
+
+    lrlib_log_write(lrlib_log_buffer, lrlib_log_buffer_length);
+    lrlib_log_buffer_length = 0;
+    lrlib_log_buffer_messages = 0;
+
+    if (lrlib_log_flush_interval_usec > 0) {
+        lrlib_log_last_flush_usec = lrlib_timer_now_usec();
+    }
+    LRLIB_PROFILE_END("lrlib_log_flush", profile_start_usec, 0);
+    return messages;
+}
+
+/**
+ * @brief Adds a message to the log buffer.
+ *
+ * Each message is written as a line starting with the time the message was logged (milliseconds
+ * since 1970) and its category, e.g. "1760000000123 [login] message text". When the log is written
+ * to a file, the vuser ID is added after the time.
+ *
+ * @param category The category of the message, e.g. "login" or "cache". Messages can be rate
+ *        limited by category (see lrlib_log_set_rate_limit).
+ * @param message The message to log.
+ * @return Returns TRUE if the message was added to the buffer, or FALSE if the rate limit for its
+ *         category was reached and it was dropped.
+ *
+ * @example
+ *
+ * vuser_init()
+ * {
+ *     lrlib_log_open("C:\\Temp\\diagnostics.log"); // or lrlib_log_open(NULL) for the replay log
+ *     lrlib_log_set_rate_limit("cache", 10); // at most 10 "cache" messages per second
+ *     return 0;
+ * }
+ *
+ * Action()
+ * {
+ *     lrlib_log_message("cache", lr_eval_string("Cache miss for {ProductId}"));
+ *     return 0;
+ * }
+ *
+ * vuser_end()
+ * {
+ *     lrlib_log_close(); // writes any messages that are still in the buffer
+ *     return 0;
+ * }
+ *
+ * @note Messages are written in batches, so they can appear in the replay log some time after
+ *       the messages from lr_output_message that were written at the same time.
+ */
+int lrlib_log_message(const char* category, const char* message) {
+    lrlib_log_category* entry;
+    double now_usec = 0;
+    int message_length;
+    char prefix[LRLIB_MAX_LOG_CATEGORY_LENGTH + 48];
+    int prefix_length;
+
+    // Check input variables
+    if ( (category == NULL) || (message == NULL) ) {
+        lr_error_message("category and message cannot be NULL.");
+        lr_abort();
+    }
+
+    entry = lrlib_log_find_category(category);
+    if ( (entry->max_per_second > 0) || (lrlib_log_flush_interval_usec > 0) ) {
+        now_usec = lrlib_timer_now_usec();
+    }
+
+    // The flush interval starts when the first message is logged.
+    if (lrlib_log_last_flush_usec == 0) {
+        lrlib_log_last_flush_usec = now_usec;
+    }
+
+    // Rate limit: the category earns max_per_second tokens per second (up to a burst of one
+    // second's worth), and each message uses one.
+    if (entry->max_per_second > 0) {
+        entry->tokens += (now_usec - entry->last_refill_usec) * entry->max_per_second / 1000000;
+        entry->last_refill_usec = now_usec;
+        if (entry->tokens > entry->max_per_second) {
+            entry->tokens = entry->max_per_second;
+        }
+        if (entry->tokens < 1) {
+            entry->dropped++;
+            return FALSE;
+        }
+        entry->tokens -= 1;
+    }
+
+    if (lrlib_log_file != -1) {
+        prefix_length = sprintf(prefix, "%.0f %d [%s] ", lrlib_get_unix_time_ms(), lrlib_log_vuser_id, entry->name);
+    } else {
+        prefix_length = sprintf(prefix, "%.0f [%s] ", lrlib_get_unix_time_ms(), entry->name);
+    }
+
+    // Make room in the buffer. A message that is too long for an empty buffer is cut short.
+    message_length = strlen(message);
+    if (lrlib_log_buffer_length + prefix_length + message_length + 1 > LRLIB_LOG_BUFFER_SIZE) {
+        lrlib_log_flush();
+        if (prefix_length + message_length + 1 > LRLIB_LOG_BUFFER_SIZE) {
+            message_length = LRLIB_LOG_BUFFER_SIZE - prefix_length - 1;
+        }
+    }
+
+    memcpy(lrlib_log_buffer + lrlib_log_buffer_length, prefix, prefix_length);
+    lrlib_log_buffer_length += prefix_length;
+    memcpy(lrlib_log_buffer + lrlib_log_buffer_length, message, message_length);
+    lrlib_log_buffer_length += message_length;
+    lrlib_log_buffer[lrlib_log_buffer_length] = '\n';
+    lrlib_log_buffer_length++;
+    lrlib_log_buffer_messages++;
+
+    if ( (lrlib_log_flush_interval_usec > 0) && (now_usec - lrlib_log_last_flush_usec >= lrlib_log_flush_interval_usec) ) {
+        lrlib_log_flush();
+    }
+    return TRUE;
+}
+
+/**
+ * @brief Limits the number of messages that can be logged in a category.
+ *
+ * @param category The category of message.
+ * @param max_per_second The average number of messages per second to allow. Short bursts of up to
+ *        one second's worth of messages are allowed. Use 0 to remove the limit.
+ * @return This function does not return a value.
+ *
+ * @example See lrlib_log_message.
+ */
+void lrlib_log_set_rate_limit(const char* category, double max_per_second) {
+    lrlib_log_category* entry;
+
+    if ( (category == NULL) || (max_per_second < 0) ) {
+        lr_error_message("category cannot be NULL, and max_per_second cannot be negative.");
+        lr_abort();
+    }
+
+    entry = lrlib_log_find_category(category);
+    entry->max_per_second = max_per_second;
+    entry->tokens = max_per_second;
+    entry->last_refill_usec = lrlib_timer_now_usec();
+}
+
+/**
+ * @brief Sets how often the log buffer is written out. The check is made each time a message is
+ *        logged, so nothing is written while no messages are being logged.
+ *
+ * @param seconds The longest time to keep messages in the buffer. Use 0 to only write messages
+ *        when the buffer is full, or when lrlib_log_flush is called. The default is 1 second.
+ * @return This function does not return a value.
+ */
+void lrlib_log_set_flush_interval(double seconds) {
+    if (seconds < 0) {
+        lr_error_message("seconds cannot be negative.");
+        lr_abort();
+    }
+
+    lrlib_log_flush_interval_usec = seconds * 1000000;
+    lrlib_log_last_flush_usec = lrlib_timer_now_usec();
+}
+
+/**
+ * @brief Writes any buffered log messages, and closes the log file (if there is one). Call this
+ *        in vuser_end.
+ *
+ * @return This function does not return a value.
+ *
+ * @example See lrlib_log_message.
+ */
+void lrlib_log_close() {
+    lrlib_log_flush();
+    if (lrlib_log_file != -1) {
+#ifdef LRLIB_LINUX
+        close(lrlib_log_file);
+#else
+        CloseHandle(lrlib_log_file);
+#endif
+        lrlib_log_file = -1;
+    }
+}
+
+/**
+ * @brief Sets where buffered log messages are written. Any messages that are already in the
+ *        buffer are written to the old destination first.
+ *
+ * @param file_name The file to append messages to, or NULL to write them to the replay log (the
+ *        default). Several vusers can share a file, as each batch of messages is appended to it
+ *        with a single write.
+ * @return Returns TRUE if successful, or FALSE if the file cannot be opened (messages are then
+ *         written to the replay log).
+ *
+ * @example See lrlib_log_message.
+ */
+int lrlib_log_open(const char* file_name) {
+    char* vuser_group;
+    int scenario_id;
+
+    lrlib_log_close();
+
+    if (file_name == NULL) {
+        return TRUE;
+    }
+
+#ifdef LRLIB_LINUX
+    lrlib_log_file = open(file_name, 01 | 0100 | 02000, 0644); // O_WRONLY | O_CREAT | O_APPEND
+#else
+    lrlib_load_dll("kernel32.dll");
+    // FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL
+    lrlib_log_file = CreateFileA(file_name, 0x0004, 0x0001 | 0x0002, NULL, 4, 0x80, 0); // returns -1 (INVALID_HANDLE_VALUE) on failure
+#endif
+    if (lrlib_log_file == -1) {
+        lr_error_message("Cannot open file \"%s\" for writing.", file_name);
+        return FALSE;
+    }
+    lr_whoami(&lrlib_log_vuser_id, &vuser_group, &scenario_id);
+    return TRUE;
+}
+
+int lrlib_get_process_file_path(const int processId, char* const filePath, const int maxLength)
+{
+    int result;
+
+    lrlib_load_dll("kernel32.dll");
+    lrlib_load_dll("psapi.dll");
+
+    {
+        const unsigned int hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, processId);
+        if (hProcess == NULL)
+        {
+            *filePath = '\0';
+            return 0;
+        }
+
+        result = GetModuleFileNameExA(hProcess, NULL, filePath, maxLength);
+        if (result == 0)
+        {
+            *filePath = '\0';
+        }
+
+        CloseHandle(hProcess);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Finds the other processes that are running the same program as this vuser (e.g. the
+ *        other mmdrv.exe processes on a Windows load generator), saves their process IDs to a
+ *        parameter array, and optionally terminates them.
+ *
+ * On Linux, /proc is read once (with getdents64), and each process's executable is matched by its
+ * device and inode number, so processes are matched even if they were started with a different
+ * path to the same file. On Windows, EnumProcesses is called with a buffer that grows until all
+ * the process IDs fit, and each process is opened once.
+ *
+ * @param outputParamArr The name of the parameter array to save the process IDs to, or NULL.
+ * @param terminate TRUE to terminate the processes that are found, FALSE to only find them.
+ * @return Returns the number of processes found (or, if terminate is TRUE, the number of processes
+ *         that were terminated), or -1 if there was an error.
+ *
+ * @example
+ *
+ * vuser_init()
+ * {
+ *     int count = lrlib_find_vuser_processes("VuserPid", FALSE);
+ *     lr_output_message("%d other vuser processes are running.", count);
+ *     return 0;
+ * }
+ *
+ * Note: On Linux, this function only works on 64-bit (x86-64) load generators.
+ */
+int lrlib_find_vuser_processes(const char* outputParamArr, const int terminate)
+{
+    int matchCount = 0;
+    int killCount = 0;
+    int capacity = 256;
+    int i;
+    unsigned long* matchedIds;
+    lrlib_paramarr_emitter emitter;
+
+    if (outputParamArr != NULL && !lrlib_paramarr_emitter_init(&emitter, outputParamArr))
+    {
+        return -1;
+    }
+
+    matchedIds = (unsigned long*)malloc(capacity * sizeof(unsigned long));
+    if (matchedIds == NULL)
+    {
+        lr_error_message("Error allocating memory.");
+        return -1;
+    }
+
+#ifdef LRLIB_LINUX
+#ifdef __x86_64__
+    {
+        long syscall(long number, ...);
+        const long SYS_stat = 4;          // x86-64 system call numbers
+        const long SYS_getdents64 = 217;
+        const int STAT_ID_SIZE = 16;      // st_dev and st_ino are the first 16 bytes of struct stat
+        unsigned char currentStat[256];   // struct stat is 144 bytes on x86-64
+        unsigned char processStat[256];
+        char buffer[32768];
+        char exePath[64];
+        const unsigned long currentProcessId = getpid();
+        int directory;
+        long bytesRead;
+
+        if (syscall(SYS_stat, "/proc/self/exe", currentStat) != 0)
+        {
+            free(matchedIds);
+            lr_error_message("Error querying the current process.");
+            return -1;
+        }
+
+        directory = open("/proc", 0200000);  // O_RDONLY | O_DIRECTORY
+        if (directory < 0)
+        {
+            free(matchedIds);
+            lr_error_message("Cannot open /proc.");
+            return -1;
+        }
+
+        // Each linux_dirent64 record is: 8-byte inode, 8-byte offset, 2-byte record length,
+        // 1-byte type, then the null-terminated name.
+        while ((bytesRead = syscall(SYS_getdents64, directory, buffer, sizeof(buffer))) > 0)
+        {
+            long position = 0;
+
+            while (position < bytesRead)
+            {
+                const unsigned short recordLength = *(unsigned short*)(buffer + position + 16);
+                const char* name = buffer + position + 19;
+                unsigned long processId = 0;
+                const char* c;
+
+                position += recordLength;
+
+                // Process directories are the ones with numeric names.
+                for (c = name; *c >= '0' && *c <= '9'; c++)
+                {
+                    processId = processId * 10 + (*c - '0');
+                }
+                if (*c != '\0' || c == name || processId == currentProcessId)
+                {
+                    continue;
+                }
+
+                sprintf(exePath, "/proc/%lu/exe", processId);
+                if (syscall(SYS_stat, exePath, processStat) != 0 || memcmp(processStat, currentStat, STAT_ID_SIZE) != 0)
+                {
+                    continue;  // The process has ended, belongs to another user, or is a different program
+                }
+
+                if (matchCount == capacity)
+                {
+                    unsigned long* grown = (unsigned long*)realloc(matchedIds, capacity * 2 * sizeof(unsigned long));
+                    if (grown == NULL)
+                    {
+                        close(directory);
+                        free(matchedIds);
+                        lr_error_message("Error allocating memory.");
+                        return -1;
+                    }
+                    matchedIds = grown;
+                    capacity *= 2;
+                }
+                matchedIds[matchCount] = processId;
+                matchCount++;
+            }
+        }
+
+        close(directory);
+    }
+#else
+    // The system call numbers and the layout of struct stat above are only correct on x86-64. On
+    // other processors, the same numbers are different system calls.
+    free(matchedIds);
+    lr_error_message("lrlib_find_vuser_processes only works on 64-bit (x86-64) Linux load generators.");
+    lr_abort();
+    return -1;
+#endif
+#else
+    {
+        unsigned long currentProcessId;
+        char currentProcessFilePath[MAX_PATH];
+        char processFilePath[MAX_PATH];
+        unsigned long* processIds = NULL;
+        unsigned long bufferSize = 1024 * sizeof(unsigned long);
+        unsigned long bytesReturned;
+        long processIdCount;
+
+        lrlib_load_dll("kernel32.dll");
+        lrlib_load_dll("psapi.dll");
+
+        currentProcessId = GetCurrentProcessId();
+        if (lrlib_get_process_file_path(currentProcessId, currentProcessFilePath, MAX_PATH) <= 0)
+        {
+            free(matchedIds);
+            lr_error_message("Error querying the current process.");
+            return -1;
+        }
+
+        // EnumProcesses does not say how many processes there are. If it fills the whole buffer,
+        // some may be missing, so try again with a bigger buffer.
+        for (;;)
+        {
+            free(processIds);
+            processIds = (unsigned long*)malloc(bufferSize);
+            if (processIds == NULL)
+            {
+                free(matchedIds);
+                lr_error_message("Error allocating memory.");
+                return -1;
+            }
+
+            if (!EnumProcesses(processIds, bufferSize, &bytesReturned))
+            {
+                free(processIds);
+                free(matchedIds);
+                lr_error_message("Error enumerating processes.");
+                return -1;
+            }
+
+            if (bytesReturned < bufferSize)
+            {
+                break;
+            }
+            bufferSize *= 2;
+        }
+
+        processIdCount = bytesReturned / sizeof(unsigned long);
+        for (i = 0; i < processIdCount; i++)
+        {
+            const unsigned long processId = processIds[i];
+            unsigned int hProcess;
+
+            if (processId == currentProcessId || processId == 0)
+            {
+                continue;
+            }
+
+            // Open the process once, with the access needed to both check and terminate it.
+            hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ | PROCESS_TERMINATE, FALSE, processId);
+            if (hProcess == NULL)
+            {
+                continue;
+            }
+
+            if (GetModuleFileNameExA(hProcess, NULL, processFilePath, MAX_PATH) > 0 &&
+                stricmp(processFilePath, currentProcessFilePath) == 0)
+            {
+                if (matchCount == capacity)
+                {
+                    unsigned long* grown = (unsigned long*)realloc(matchedIds, capacity * 2 * sizeof(unsigned long));
+                    if (grown == NULL)
+                    {
+                        CloseHandle(hProcess);
+                        free(processIds);
+                        free(matchedIds);
+                        lr_error_message("Error allocating memory.");
+                        return -1;
+                    }
+                    matchedIds = grown;
+                    capacity *= 2;
+                }
+                matchedIds[matchCount] = processId;
+                matchCount++;
+            }
+
+            CloseHandle(hProcess);
+        }
+
+        free(processIds);
+    }
+#endif
+
+    // Save the process IDs before terminating anything, so that the script can see which
+    // processes were found even if terminating some of them fails.
+    if (outputParamArr != NULL)
+    {
+        char processIdText[16];
+
+        for (i = 0; i < matchCount; i++)
+        {
+            sprintf(processIdText, "%lu", matchedIds[i]);
+            lrlib_paramarr_emitter_save(&emitter, processIdText);
+        }
+        lrlib_paramarr_emitter_finish(&emitter);
+    }
+
+    if (!terminate)
+    {
+        free(matchedIds);
+        return matchCount;
+    }
+
+    for (i = 0; i < matchCount; i++)
+    {
+        lr_output_message("Killing process %lu", matchedIds[i]);
+#ifdef LRLIB_LINUX
+        if (kill(matchedIds[i], 9) == 0)  // 9 = SIGKILL
+        {
+            killCount++;
+        }
+#else
+        {
+            const unsigned int hProcess = OpenProcess(PROCESS_TERMINATE, FALSE, matchedIds[i]);
+            if (hProcess != NULL)
+            {
+                if (TerminateProcess(hProcess, 0))
+                {
+                    killCount++;
+                }
+                CloseHandle(hProcess);
+            }
+        }
+#endif
+    }
+
+    free(matchedIds);
+    return killCount;
+}
+
+/**
+ * @brief Terminates all the other processes that are running the same program as this vuser
+ *        (e.g. mmdrv.exe processes left over from an earlier test).
+ *
+ * @return Returns the number of processes that were terminated.
+ */
+int lrlib_kill_all_mmdrv()
+{
+    const int killCount = lrlib_find_vuser_processes(NULL, TRUE);
+    if (killCount < 0)
+    {
+        return 0;
+    }
+
+    return killCount;
+}
+
+/**
+ * @brief Calculates the distance between two points of latitude/longitude.
+ *
+ * @param latitude_1 degrees of latitude for the first point
+ * @param longitude_1 degrees of longitude for the first point
+ * @param latitude_2 degrees of latitude for the second point
+ * @param longitude_2 degrees of longitude for the second point
+ * @return distance between the two points in meters. This number is always positive.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     double distance;
+ *
+ *     // Is the address within 10km of the freight depot? Save the distance to a parameter.
+ *     // {Param_Address_Lat} and {Param_Address_Long} could be saved from a web page, or from a
+ *     // parameter file, or from a web service that translates addresses to coordinates.
+ *     distance = distance_between_two_points("-37.815531", // freight depot latitude
+ *                                            "144.970886", // freight depot longitude
+ *                                            lr_eval_string("{Param_Address_Lat}"),
+ *                                            lr_eval_string("{Param_Address_Long}"));
+ *     if (distance < 10000) {
+ *         // Note: when the double is typecast to an int, the value will lose fractions of a meter.
+ *         lr_save_int((int)distance, "Param_Distance");
+ *     }
+ *
+ *     return 0;
+ * }
+ *
+ * @note To convert meters to miles, multiply by 0.000621371. To convert meters to feet, multiply
+ *       by 3.28084.
+ * @note Different applications may calculate the distance between two points differently. If you
+ *       are using this to check the results of a distance calculation in the system under test,
+ *       then you should probably re-implement their distance calculation code yourself.
+ * @note There are many free online services that will convert addresses to GPS coordinates
+ *       (latitude and longitude).
+ */
+double distance_between_two_points(char* latitude_1, char* longitude_1, char* latitude_2, char* longitude_2) {
+    const double PI = 3.14159265358979323846; // the mathematical constant pi
+    const double R = 6373000; // the radius of the earth in meters
+
+    // In LoadRunner, functions that do not return an int must be explicitly declared.
+    // The explicit declaration of the function prototype can be done in the body of another function.
+    // This means that the function definitions only have local scope, and may be re-declared elsewhere in the script.
+    double atof(const char* string);
+    double sin(double x);
+    double cos(double x);
+    double sqrt(double x);
+    double asin(double x); // Note that this function is not included in the LoadRunner documentation, but is available.
+
+    // Convert degrees to radians
+    double lat1rad = atof(latitude_1) * PI/180;
+    double long1rad = atof(longitude_1) * PI/180;
+    double lat2rad = atof(latitude_2) * PI/180;
+    double long2rad = atof(longitude_2) * PI/180;
+
+    // TODO: Check input values. If any values are 0.0 after being converted using the atof function, then there is a problem.
+
+    // Get the difference between the two points.
+    double delta_lat = lat2rad - lat1rad;
+    double delta_long = long2rad - long1rad;
+
+    // Use the  Haversine Formula (http://en.wikipedia.org/wiki/Haversine_formula) to calculate the
+    // distance between two points on the Earth.
+    double a = sin(delta_lat/2) * sin(delta_lat/2) + sin(delta_long/2) * sin(delta_long/2) * cos(lat1rad) * cos(lat2rad);
+    double c = 2 * asin(sqrt(a));
+
+    return R * c; // The distance between the two points in meters
+}
+
+/*
+ * Histograms
+ * ==========
+ * LoadRunner transactions only report the average, minimum and maximum (and the percentiles that
+ * Analysis calculates at the end of the test). These functions record values (e.g. the time taken
+ * by a step inside a transaction, in microseconds) in a histogram, so that the real distribution
+ * can be reported.
+ *
+ * The histogram uses log-linear buckets (like HdrHistogram). Values from 0 to 255 have their own
+ * bucket. Larger values are split into 128 buckets for each power of 2, so a reported value is
+ * never more than 0.8% away from the recorded value, and the histogram has a fixed size (3328
+ * buckets) no matter how many values are recorded.
+ *
+ * Each vuser records into its own histogram, so recording is just an array increment with no
+ * locking. lrlib_histogram_merge adds the values recorded since the previous merge to a histogram
+ * that is shared by every vuser in the same process (in shared memory, protected by a named mutex
+ * on Windows, or a file lock on Linux). A histogram can also be saved to a binary snapshot file,
+ * and snapshots can be loaded (and added together) later.
+ *
+ * On Linux, the shared histogram is a small file in /dev/shm
+ * (lrlib_histogram_<pid>_<process start time>_<name>). It is deleted when the last vuser that uses
+ * it calls lrlib_histogram_free. If a vuser is stopped before it can call lrlib_histogram_free, the
+ * file is left behind, but the process start time in its name stops a later process with the same
+ * process ID from using it. On Windows, the shared memory is released by Windows when the last
+ * vuser frees the histogram, or when the process ends.
+ */
+
+#define LRLIB_HISTOGRAM_EXACT_VALUES 256
+#define LRLIB_HISTOGRAM_SUB_BUCKETS 128
+#define LRLIB_HISTOGRAM_BUCKET_COUNT 3328 // 256 + (32 - 8) * 128
+#define LRLIB_MAX_HISTOGRAMS 8
+#define LRLIB_MAX_HISTOGRAM_NAME_LENGTH 63
+
+// Values for the "source" argument of the functions that read a histogram.
+#define LRLIB_HISTOGRAM_VUSER 0 // the values recorded by this vuser
+#define LRLIB_HISTOGRAM_PROCESS 1 // the values merged by every vuser in this process
+
+typedef struct {
+    unsigned int counts[LRLIB_HISTOGRAM_BUCKET_COUNT];
+    double total_count;
+    double sum;
+    unsigned int min;
+    unsigned int max;
+} lrlib_histogram_data;
+
+// The process-wide histogram, in shared memory.
+typedef struct {
+    lrlib_histogram_data data;
+    unsigned int users; // Linux: the number of vusers that have the file open
+    int deleted; // Linux: TRUE once the last user has deleted the file, so it must not be used
+} lrlib_histogram_shared;
+
+typedef struct {
+    char name[LRLIB_MAX_HISTOGRAM_NAME_LENGTH + 1];
+    lrlib_histogram_data data; // everything recorded by this vuser
+    lrlib_histogram_data merged; // what "data" looked like at the last merge
+    lrlib_histogram_shared* shared; // the process-wide histogram (NULL until the first merge)
+    int lock_handle; // Windows mutex handle, or Linux file descriptor
+    unsigned int mapping_handle; // Windows file mapping handle
+} lrlib_histogram;
+
+lrlib_histogram lrlib_histograms[LRLIB_MAX_HISTOGRAMS];
+lrlib_histogram_data lrlib_histogram_scratch; // a copy of a process-wide histogram
+double lrlib_process_start_ticks = 0; // Linux: see lrlib_histogram_file_name
+
+/**
+ * @brief Returns the bucket that a value is counted in.
+ */
+int lrlib_histogram_bucket(unsigned int value) {
+    int msb = 8; // the position of the most significant bit of the value
+
+    if (value < LRLIB_HISTOGRAM_EXACT_VALUES) {
+        return value;
+    }
+
+    while ((value >> msb) > 1) {
+        msb++;
+    }
+
+    // The top 8 bits of the value (128 to 255) select the bucket within the power of 2.
+    return LRLIB_HISTOGRAM_EXACT_VALUES + (msb - 8) * LRLIB_HISTOGRAM_SUB_BUCKETS + (value >> (msb - 7)) - LRLIB_HISTOGRAM_SUB_BUCKETS;
+}
+
+/**
+ * @brief Returns the largest value that is counted in a bucket.
+ */
+unsigned int lrlib_histogram_bucket_max(int bucket) {
+    int shift;
+    unsigned int sub_bucket;
+
+    if (bucket < LRLIB_HISTOGRAM_EXACT_VALUES) {
+        return bucket;
+    }
+
+    shift = (bucket - LRLIB_HISTOGRAM_EXACT_VALUES) / LRLIB_HISTOGRAM_SUB_BUCKETS + 1;
+    sub_bucket = (bucket - LRLIB_HISTOGRAM_EXACT_VALUES) % LRLIB_HISTOGRAM_SUB_BUCKETS;
+    return ((LRLIB_HISTOGRAM_SUB_BUCKETS + sub_bucket) << shift) + ((1u << shift) - 1);
+}
+
+/**
+ * @brief Returns the histogram for an ID, or aborts if the ID is not valid.
+ */
+lrlib_histogram* lrlib_get_histogram(int histogram_id) {
+    if (histogram_id < 1 || histogram_id > LRLIB_MAX_HISTOGRAMS || lrlib_histograms[histogram_id - 1].name[0] == '\0') {
+        lr_error_message("Invalid histogram ID %d.", histogram_id);
+        lr_abort();
+    }
+
+    return &lrlib_histograms[histogram_id - 1];
+}
+
+/**
+ * @brief Adds the values in one histogram to another.
+ */
+void lrlib_histogram_add_data(lrlib_histogram_data* target, const lrlib_histogram_data* source) {
+    int i;
+
+    if (source->total_count == 0) {
+        return;
+    }
+
+    for (i = 0; i < LRLIB_HISTOGRAM_BUCKET_COUNT; i++) {
+        target->counts[i] += source->counts[i];
+    }
+
+    if (target->total_count == 0 || source->min < target->min) {
+        target->min = source->min;
+    }
+    if (source->max > target->max) {
+        target->max = source->max;
+    }
+    target->total_count += source->total_count;
+    target->sum += source->sum;
+}
+
+/**
+ * @brief Creates a histogram. If a histogram with the same name already exists (for this vuser),
+ *        its ID is returned instead.
+ *
+ * @param name The name of the histogram (up to 63 letters, numbers or underscores). Vusers that
+ *        use the same name share the same process-wide histogram.
+ * @return Returns the ID of the histogram, which is used by the other lrlib_histogram_* functions.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     int parse_histogram = lrlib_histogram_create("parse_response");
+ *     merc_timer_handle_t timer;
+ *
+ *     lr_start_transaction("search");
+ *     web_url("search", "URL=http://www.example.com/search?q=test", LAST);
+ *
+ *     timer = lr_start_timer();
+ *     // ...parse the response...
+ *     lrlib_histogram_record(parse_histogram, (unsigned int)(lr_end_timer(timer) * 1000000)); // microseconds
+ *     lr_end_transaction("search", LR_AUTO);
+ *
+ *     lrlib_histogram_merge(parse_histogram);
+ *     lrlib_histogram_save_percentiles(parse_histogram, LRLIB_HISTOGRAM_PROCESS, "Parse");
+ *     lr_output_message("p99 parse time: %s us", lr_eval_string("{Parse_p99}"));
+ *
+ *     return 0;
+ * }
+ *
+ * vuser_end()
+ * {
+ *     // Returns the ID of the existing histogram, so that it can be freed.
+ *     lrlib_histogram_free(lrlib_histogram_create("parse_response"));
+ *     return 0;
+ * }
+ */
+int lrlib_histogram_create(const char* name) {
+    int i;
+    int free_slot = 0;
+    const char* c;
+
+    if (name == NULL || name[0] == '\0' || strlen(name) > LRLIB_MAX_HISTOGRAM_NAME_LENGTH) {
+        lr_error_message("Histogram name must be between 1 and %d characters long.", LRLIB_MAX_HISTOGRAM_NAME_LENGTH);
+        lr_abort();
+    }
+
+    // The name is used in the names of shared memory objects, so keep it simple.
+    for (c = name; *c != '\0'; c++) {
+        if (!isalnum((unsigned char)*c) && *c != '_') {
+            lr_error_message("Histogram name \"%s\" can only contain letters, numbers and underscores.", name);
+            lr_abort();
+        }
+    }
+
+    for (i = LRLIB_MAX_HISTOGRAMS; i >= 1; i--) {
+        if (strcmp(lrlib_histograms[i - 1].name, name) == 0) {
+            return i;
+        }
+        if (lrlib_histograms[i - 1].name[0] == '\0') {
+            free_slot = i;
+        }
+    }
+
+    if (free_slot == 0) {
+        lr_error_message("Too many histograms (the maximum is %d).", LRLIB_MAX_HISTOGRAMS);
+        lr_abort();
+    }
+
+    memset(&lrlib_histograms[free_slot - 1], 0, sizeof(lrlib_histogram));
+    strcpy(lrlib_histograms[free_slot - 1].name, name);
+    return free_slot;
+}
+
+/**
+ * @brief Records a value in a histogram. This is very fast (no locking, no memory allocation), so
+ *        it can be called thousands of times per iteration.
+ *
+ * @param histogram_id The ID returned by lrlib_histogram_create.
+ * @param value The value to record (e.g. a time in microseconds).
+ * @return This function does not return a value.
+ *
+ * @example See lrlib_histogram_create.
+ */
+void lrlib_histogram_record(int histogram_id, unsigned int value) {
+    lrlib_histogram_data* data = &lrlib_get_histogram(histogram_id)->data;
+
+    data->counts[lrlib_histogram_bucket(value)]++;
+    if (data->total_count == 0 || value < data->min) {
+        data->min = value;
+    }
+    if (value > data->max) {
+        data->max = value;
+    }
+    data->total_count++;
+    data->sum += value;
+}
+
+#ifdef LRLIB_LINUX
+/**
+ * @brief Gets the name of the file that holds a process-wide histogram on Linux.
+ *
+ * The name includes the process ID and the time that the process started (field 22 of
+ * /proc/self/stat, in clock ticks since the machine started). Process IDs are reused, so a file
+ * that was left behind by an earlier process could otherwise be picked up by a new one.
+ */
+void lrlib_histogram_file_name(const lrlib_histogram* histogram, char* file_name) {
+    double atof(const char* string);
+    char stat_text[1024];
+    const char* field;
+    long fp;
+    int length;
+    int i;
+
+    if (lrlib_process_start_ticks == 0) {
+        fp = (long)fopen("/proc/self/stat", "r");
+        if (fp != 0) {
+            length = fread(stat_text, 1, sizeof(stat_text) - 1, fp);
+            fclose(fp);
+            stat_text[length] = '\0';
+
+            // The program name (field 2) is in brackets, and can contain spaces, so the fields are
+            // counted from the last bracket. The start time is the 20th field after it.
+            field = (const char*)strrchr(stat_text, ')');
+            for (i = 0; (i < 20) && (field != NULL); i++) {
+                field = (const char*)strchr(field + 1, ' ');
+            }
+            if (field != NULL) {
+                lrlib_process_start_ticks = atof(field + 1);
+            }
+        }
+    }
+
+    sprintf(file_name, "/dev/shm/lrlib_histogram_%d_%.0f_%s", getpid(), lrlib_process_start_ticks, histogram->name);
+}
+#endif
+
+/**
+ * @brief Locks the process-wide histogram, opening (or creating) it the first time.
+ *
+ * @return Returns TRUE (1) if the histogram is locked, otherwise returns FALSE (0).
+ */
+int lrlib_histogram_lock_shared(lrlib_histogram* histogram) {
+    char object_name[LRLIB_MAX_HISTOGRAM_NAME_LENGTH + 64];
+
+#ifdef LRLIB_LINUX
+    // The shared histogram is a file in /dev/shm (which is in memory), mapped into the process
+    // and locked with flock. The file is only created (and filled with zeros) once.
+    void* mmap(void* address, unsigned long length, int protection, int flags, int fd, long offset);
+    long lseek(int fd, long offset, int whence);
+
+    while (histogram->shared == NULL) {
+        void* address;
+
+        lrlib_histogram_file_name(histogram, object_name);
+        histogram->lock_handle = open(object_name, 02 | 0100 | 0200, 0600); // O_RDWR | O_CREAT | O_EXCL
+        if (histogram->lock_handle < 0) {
+            histogram->lock_handle = open(object_name, 02); // O_RDWR
+        }
+        if (histogram->lock_handle < 0) {
+            lr_error_message("Cannot open shared histogram \"%s\".", object_name);
+            return FALSE;
+        }
+
+        flock(histogram->lock_handle, 2); // LOCK_EX
+        // Whichever vuser gets the lock first sets the size of the file. This is checked under
+        // the lock, rather than by the vuser that created the file, because another vuser can
+        // open the file after it is created but before its size is set. Mapping a file that is
+        // too short would crash the vuser (SIGBUS) when it touched the memory.
+        if (lseek(histogram->lock_handle, 0, 2) < (long)sizeof(lrlib_histogram_shared)) { // SEEK_END
+            if (ftruncate(histogram->lock_handle, sizeof(lrlib_histogram_shared)) != 0) {
+                flock(histogram->lock_handle, 8); // LOCK_UN
+                close(histogram->lock_handle);
+                lr_error_message("Cannot set the size of shared histogram \"%s\".", object_name);
+                return FALSE;
+            }
+        }
+        address = mmap(NULL, sizeof(lrlib_histogram_shared), 3, 1, histogram->lock_handle, 0); // PROT_READ | PROT_WRITE, MAP_SHARED
+        if (address == (void*)-1) {
+            flock(histogram->lock_handle, 8); // LOCK_UN
+            close(histogram->lock_handle);
+            lr_error_message("Cannot map shared histogram \"%s\".", object_name);
+            return FALSE;
+        }
+
+        // If the last vuser using the file deleted it after this vuser opened it (but before this
+        // vuser got the lock), go round again to create a new file.
+        if (((lrlib_histogram_shared*)address)->deleted) {
+            munmap(address, sizeof(lrlib_histogram_shared));
+            flock(histogram->lock_handle, 8); // LOCK_UN
+            close(histogram->lock_handle);
+            continue;
+        }
+
+        histogram->shared = (lrlib_histogram_shared*)address;
+        histogram->shared->users++;
+        return TRUE;
+    }
+
+    flock(histogram->lock_handle, 2); // LOCK_EX
+    return TRUE;
+#else
+    // The shared histogram is a named file mapping (backed by the page file, so it starts as
+    // zeros), protected by a named mutex.
+    void* MapViewOfFile(unsigned int mapping, unsigned long access, unsigned long offset_high, unsigned long offset_low, unsigned long size);
+    const unsigned long PAGE_READWRITE = 0x04;
+    const unsigned long FILE_MAP_ALL_ACCESS = 0xF001F;
+
+    if (histogram->shared == NULL) {
+        lrlib_load_dll("kernel32.dll");
+
+        sprintf(object_name, "Local\\lrlib_histogram_mutex_%u_%s", GetCurrentProcessId(), histogram->name);
+        histogram->lock_handle = CreateMutexA(NULL, FALSE, object_name);
+        if (histogram->lock_handle == 0) {
+            lr_error_message("Cannot create mutex \"%s\".", object_name);
+            return FALSE;
+        }
+
+        sprintf(object_name, "Local\\lrlib_histogram_%u_%s", GetCurrentProcessId(), histogram->name);
+        histogram->mapping_handle = CreateFileMappingA(-1, NULL, PAGE_READWRITE, 0, sizeof(lrlib_histogram_shared), object_name); // -1 = INVALID_HANDLE_VALUE
+        if (histogram->mapping_handle == 0) {
+            lr_error_message("Cannot create shared memory \"%s\".", object_name);
+            return FALSE;
+        }
+
+        // The mapping handle is kept open until lrlib_histogram_free, so the shared histogram
+        // lasts until the last vuser frees it (or the process ends).
+        histogram->shared = (lrlib_histogram_shared*)MapViewOfFile(histogram->mapping_handle, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(lrlib_histogram_shared));
+        if (histogram->shared == NULL) {
+            lr_error_message("Cannot map shared memory \"%s\".", object_name);
+            return FALSE;
+        }
+    }
+
+    if (WaitForSingleObject(histogram->lock_handle, INFINITE) == WAIT_ABANDONED) {
+        // Another vuser was stopped while it held the lock. The data may be slightly wrong, but
+        // the lock is now ours.
+        lr_output_message("Warning: shared histogram \"%s\" was not unlocked properly.", histogram->name);
+    }
+    return TRUE;
+#endif
+}
+
+/**
+ * @brief Unlocks the process-wide histogram.
+ */
+void lrlib_histogram_unlock_shared(lrlib_histogram* histogram) {
+#ifdef LRLIB_LINUX
+    flock(histogram->lock_handle, 8); // LOCK_UN
+#else
+    ReleaseMutex(histogram->lock_handle);
+#endif
+}
+
+/**
+ * @brief Adds the values recorded by this vuser (since the previous merge) to the histogram that
+ *        is shared by every vuser in the same process.
+ *
+ * Call this every few iterations, or at the end of each iteration. It takes a lock, so it should
+ * not be called after every recorded value.
+ *
+ * @param histogram_id The ID returned by lrlib_histogram_create.
+ * @return Returns TRUE (1) if the values were merged, otherwise returns FALSE (0).
+ *
+ * @example See lrlib_histogram_create.
+ */
+int lrlib_histogram_merge(int histogram_id) {
+    lrlib_histogram* histogram = lrlib_get_histogram(histogram_id);
+    lrlib_histogram_data* shared;
+    int i;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    if (histogram->data.total_count == histogram->merged.total_count) {
+        return TRUE; // nothing new to merge
+    }
+
+    if (lrlib_histogram_lock_shared(histogram) == FALSE) {
+        return FALSE;
+    }
+
+    shared = &histogram->shared->data;
+    for (i = 0; i < LRLIB_HISTOGRAM_BUCKET_COUNT; i++) {
+        shared->counts[i] += histogram->data.counts[i] - histogram->merged.counts[i];
+    }
+    if (shared->total_count == 0 || histogram->data.min < shared->min) {
+        shared->min = histogram->data.min;
+    }
+    if (histogram->data.max > shared->max) {
+        shared->max = histogram->data.max;
+    }
+    shared->total_count += histogram->data.total_count - histogram->merged.total_count;
+    shared->sum += histogram->data.sum - histogram->merged.sum;
+
+    lrlib_histogram_unlock_shared(histogram);
+
+    memcpy(&histogram->merged, &histogram->data, sizeof(lrlib_histogram_data));
+    LRLIB_PROFILE_END("lrlib_histogram_merge", profile_start_usec, 0);
+    return TRUE;
+}
+
+/**
+ * @brief Gets the data for the vuser or process-wide histogram. The process-wide data is copied
+ *        (while it is locked), so that it does not change while it is being read.
+ *
+ * @return Returns NULL if the process-wide histogram could not be read.
+ */
+const lrlib_histogram_data* lrlib_histogram_get_data(int histogram_id, int source) {
+    lrlib_histogram* histogram = lrlib_get_histogram(histogram_id);
+
+    if (source == LRLIB_HISTOGRAM_VUSER) {
+        return &histogram->data;
+    }
+
+    if (source != LRLIB_HISTOGRAM_PROCESS) {
+        lr_error_message("Invalid histogram source %d. Use LRLIB_HISTOGRAM_VUSER or LRLIB_HISTOGRAM_PROCESS.", source);
+        lr_abort();
+    }
+
+    if (lrlib_histogram_lock_shared(histogram) == FALSE) {
+        return NULL;
+    }
+    memcpy(&lrlib_histogram_scratch, &histogram->shared->data, sizeof(lrlib_histogram_data));
+    lrlib_histogram_unlock_shared(histogram);
+
+    return &lrlib_histogram_scratch;
+}
+
+/**
+ * @brief Returns the value at a percentile (from 0 to 100) of a histogram, using the nearest-rank
+ *        method. The value is the largest value that is counted in the same bucket (but never more
+ *        than the largest recorded value).
+ */
+unsigned int lrlib_histogram_value_at_percentile(const lrlib_histogram_data* data, double percentile) {
+    double ceil(double x);
+    double rank;
+    double count = 0;
+    int i;
+
+    if (data->total_count == 0) {
+        return 0;
+    }
+
+    // The small adjustment stops a rounding error (e.g. 99.9% of 1000 = 999.0000000001) from
+    // moving the rank up by one.
+    rank = ceil(percentile / 100 * data->total_count - 0.000001);
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    for (i = 0; i < LRLIB_HISTOGRAM_BUCKET_COUNT; i++) {
+        count += data->counts[i];
+        if (count >= rank) {
+            if (lrlib_histogram_bucket_max(i) > data->max) {
+                return data->max;
+            }
+            return lrlib_histogram_bucket_max(i);
+        }
+    }
+
+    return data->max;
+}
+
+/**
+ * @brief Saves the summary statistics of a histogram to parameters.
+ *
+ * The parameters are {Prefix_count}, {Prefix_min}, {Prefix_max}, {Prefix_mean}, {Prefix_p50},
+ * {Prefix_p90}, {Prefix_p99} and {Prefix_p99_9}.
+ *
+ * @param histogram_id The ID returned by lrlib_histogram_create.
+ * @param source LRLIB_HISTOGRAM_VUSER for the values recorded by this vuser, or
+ *        LRLIB_HISTOGRAM_PROCESS for the values merged by every vuser in the process.
+ * @param prefix The start of the parameter names.
+ * @return Returns TRUE (1) if the parameters were saved, otherwise returns FALSE (0).
+ *
+ * @example See lrlib_histogram_create.
+ */
+int lrlib_histogram_save_percentiles(int histogram_id, int source, const char* prefix) {
+    const lrlib_histogram_data* data;
+    char param_name[LRLIB_PARAM_NAME_BUFFER_LENGTH];
+    char value[64];
+    double mean = 0;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    if (prefix == NULL || strlen(prefix) > LRLIB_MAX_PARAM_NAME_LENGTH) {
+        lr_error_message("Parameter name prefix cannot be NULL or longer than %d characters.", LRLIB_MAX_PARAM_NAME_LENGTH);
+        return FALSE;
+    }
+
+    data = lrlib_histogram_get_data(histogram_id, source);
+    if (data == NULL) {
+        return FALSE;
+    }
+
+    if (data->total_count > 0) {
+        mean = data->sum / data->total_count;
+    }
+
+    sprintf(param_name, "%s_count", prefix);
+    sprintf(value, "%.0f", data->total_count);
+    lr_save_string(value, param_name);
+    sprintf(param_name, "%s_min", prefix);
+    sprintf(value, "%u", data->min);
+    lr_save_string(value, param_name);
+    sprintf(param_name, "%s_max", prefix);
+    sprintf(value, "%u", data->max);
+    lr_save_string(value, param_name);
+    sprintf(param_name, "%s_mean", prefix);
+    sprintf(value, "%.2f", mean);
+    lr_save_string(value, param_name);
+    sprintf(param_name, "%s_p50", prefix);
+    sprintf(value, "%u", lrlib_histogram_value_at_percentile(data, 50));
+    lr_save_string(value, param_name);
+    sprintf(param_name, "%s_p90", prefix);
+    sprintf(value, "%u", lrlib_histogram_value_at_percentile(data, 90));
+    lr_save_string(value, param_name);
+    sprintf(param_name, "%s_p99", prefix);
+    sprintf(value, "%u", lrlib_histogram_value_at_percentile(data, 99));
+    lr_save_string(value, param_name);
+    sprintf(param_name, "%s_p99_9", prefix);
+    sprintf(value, "%u", lrlib_histogram_value_at_percentile(data, 99.9));
+    lr_save_string(value, param_name);
+
+    LRLIB_PROFILE_END("lrlib_histogram_save_percentiles", profile_start_usec, 0);
+    return TRUE;
+}
+
+/**
+ * @brief Sends the percentiles of a histogram to LoadRunner as data points, so that they can be
+ *        graphed in the Controller and in Analysis.
+ *
+ * The data points are called "<prefix>_p50", "<prefix>_p90", "<prefix>_p99" and
+ * "<prefix>_p99_9". If several vusers report process-wide percentiles, each report is a separate
+ * data point sample, so it is usually best to have only one vuser (e.g. vuser 1) report them.
+ *
+ * @param histogram_id The ID returned by lrlib_histogram_create.
+ * @param source LRLIB_HISTOGRAM_VUSER or LRLIB_HISTOGRAM_PROCESS.
+ * @param prefix The start of the data point names.
+ * @return Returns TRUE (1) if the data points were sent, otherwise returns FALSE (0). Nothing is
+ *         sent if the histogram is empty.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     int histogram = lrlib_histogram_create("encode_time");
+ *     // ...record values...
+ *     lrlib_histogram_merge(histogram);
+ *     if (atoi(lr_eval_string("{VuserId}")) == 1) {
+ *         lrlib_histogram_report_data_points(histogram, LRLIB_HISTOGRAM_PROCESS, "encode_time");
+ *     }
+ *     return 0;
+ * }
+ */
+int lrlib_histogram_report_data_points(int histogram_id, int source, const char* prefix) {
+    const lrlib_histogram_data* data;
+    char data_point_name[LRLIB_MAX_HISTOGRAM_NAME_LENGTH + 256];
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    if (prefix == NULL || strlen(prefix) > 200) {
+        lr_error_message("Data point name prefix cannot be NULL or longer than 200 characters.");
+        return FALSE;
+    }
+
+    data = lrlib_histogram_get_data(histogram_id, source);
+    if (data == NULL) {
+        return FALSE;
+    }
+    if (data->total_count == 0) {
+        return TRUE;
+    }
+
+    sprintf(data_point_name, "%s_p50", prefix);
+    lr_user_data_point(data_point_name, lrlib_histogram_value_at_percentile(data, 50));
+    sprintf(data_point_name, "%s_p90", prefix);
+    lr_user_data_point(data_point_name, lrlib_histogram_value_at_percentile(data, 90));
+    sprintf(data_point_name, "%s_p99", prefix);
+    lr_user_data_point(data_point_name, lrlib_histogram_value_at_percentile(data, 99));
+    sprintf(data_point_name, "%s_p99_9", prefix);
+    lr_user_data_point(data_point_name, lrlib_histogram_value_at_percentile(data, 99.9));
+
+    LRLIB_PROFILE_END("lrlib_histogram_report_data_points", profile_start_usec, 0);
+    return TRUE;
+}
+
+/**
+ * @brief Writes a 32-bit number to a buffer, least significant byte first, so that snapshot files
+ *        are the same on every platform.
+ */
+void lrlib_histogram_put_uint(unsigned char* buffer, unsigned int value) {
+    buffer[0] = value & 0xFF;
+    buffer[1] = (value >> 8) & 0xFF;
+    buffer[2] = (value >> 16) & 0xFF;
+    buffer[3] = (value >> 24) & 0xFF;
+}
+
+unsigned int lrlib_histogram_get_uint(const unsigned char* buffer) {
+    return buffer[0] | (buffer[1] << 8) | (buffer[2] << 16) | ((unsigned int)buffer[3] << 24);
+}
+
+/**
+ * @brief Saves a histogram to a binary snapshot file. Snapshots from different vusers, processes
+ *        or load generators can be added together with lrlib_histogram_load_snapshot.
+ *
+ * The file starts with "LRHIST01", then the bucket count, minimum, maximum, total count (as two
+ * 32-bit halves) and sum (as text, so that the file does not depend on the platform's floating
+ * point format), then one (bucket, count) pair for each bucket that is not empty. All numbers are
+ * 32-bit, least significant byte first.
+ *
+ * @param histogram_id The ID returned by lrlib_histogram_create.
+ * @param source LRLIB_HISTOGRAM_VUSER or LRLIB_HISTOGRAM_PROCESS.
+ * @param file_name The file to write (it is overwritten if it already exists).
+ * @return Returns TRUE (1) if the file was written, otherwise returns FALSE (0).
+ *
+ * @example
+ *
+ * vuser_end()
+ * {
+ *     char file_name[256];
+ *
+ *     sprintf(file_name, "C:\\Temp\\parse_response_%s.hist", lr_eval_string("{VuserId}"));
+ *     lrlib_histogram_save_snapshot(lrlib_histogram_create("parse_response"), LRLIB_HISTOGRAM_VUSER, file_name);
+ *     return 0;
+ * }
+ */
+int lrlib_histogram_save_snapshot(int histogram_id, int source, const char* file_name) {
+    const lrlib_histogram_data* data;
+    unsigned char header[32];
+    unsigned char entry[8];
+    char sum_text[32];
+    long fp;
+    int i;
+    int ok = TRUE;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    data = lrlib_histogram_get_data(histogram_id, source);
+    if (data == NULL) {
+        return FALSE;
+    }
+
+    fp = (long)fopen(file_name, "wb");
+    if (fp == 0) {
+        lr_error_message("Cannot open file \"%s\" for writing.", file_name);
+        return FALSE;
+    }
+
+    memcpy(header, "LRHIST01", 8);
+    lrlib_histogram_put_uint(header + 8, LRLIB_HISTOGRAM_BUCKET_COUNT);
+    lrlib_histogram_put_uint(header + 12, data->min);
+    lrlib_histogram_put_uint(header + 16, data->max);
+    lrlib_histogram_put_uint(header + 20, (unsigned int)(data->total_count / 4294967296.0));
+    lrlib_histogram_put_uint(header + 24, (unsigned int)(data->total_count - (unsigned int)(data->total_count / 4294967296.0) * 4294967296.0));
+    memset(sum_text, 0, sizeof(sum_text));
+    sprintf(sum_text, "%.17g", data->sum);
+    lrlib_histogram_put_uint(header + 28, strlen(sum_text));
+    if (fwrite(header, 1, sizeof(header), fp) != sizeof(header) || fwrite(sum_text, 1, strlen(sum_text), fp) != strlen(sum_text)) {
+        ok = FALSE;
+    }
+
+    for (i = 0; i < LRLIB_HISTOGRAM_BUCKET_COUNT && ok; i++) {
+        if (data->counts[i] != 0) {
+            lrlib_histogram_put_uint(entry, i);
+            lrlib_histogram_put_uint(entry + 4, data->counts[i]);
+            if (fwrite(entry, 1, sizeof(entry), fp) != sizeof(entry)) {
+                ok = FALSE;
+            }
+        }
+    }
+
+    fclose(fp);
+    if (ok == FALSE) {
+        lr_error_message("Error writing to file \"%s\".", file_name);
+    }
+    LRLIB_PROFILE_END("lrlib_histogram_save_snapshot", profile_start_usec, 0);
+    return ok;
+}
+
+/**
+ * @brief Adds the values in a snapshot file (written by lrlib_histogram_save_snapshot) to this
+ *        vuser's histogram.
+ *
+ * @param histogram_id The ID returned by lrlib_histogram_create.
+ * @param file_name The snapshot file to read.
+ * @return Returns TRUE (1) if the snapshot was loaded, otherwise returns FALSE (0).
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     // Combine the snapshots from two load generators, and print the overall percentiles.
+ *     int histogram = lrlib_histogram_create("combined");
+ *     lrlib_histogram_load_snapshot(histogram, "C:\\Results\\lg1.hist");
+ *     lrlib_histogram_load_snapshot(histogram, "C:\\Results\\lg2.hist");
+ *     lrlib_histogram_save_percentiles(histogram, LRLIB_HISTOGRAM_VUSER, "Combined");
+ *     lr_output_message("p99: %s", lr_eval_string("{Combined_p99}"));
+ *     return 0;
+ * }
+ */
+int lrlib_histogram_load_snapshot(int histogram_id, const char* file_name) {
+    double atof(const char* string);
+    lrlib_histogram* histogram = lrlib_get_histogram(histogram_id);
+    unsigned char header[32];
+    unsigned char entry[8];
+    char sum_text[32];
+    unsigned int sum_length;
+    long fp;
+    double profile_start_usec = 0;
+
+    // The snapshot is read into the scratch histogram first, so that a bad file does not change
+    // the vuser's histogram.
+    LRLIB_PROFILE_START(profile_start_usec);
+    memset(&lrlib_histogram_scratch, 0, sizeof(lrlib_histogram_data));
+
+    fp = (long)fopen(file_name, "rb");
+    if (fp == 0) {
+        lr_error_message("Cannot open file \"%s\" for reading.", file_name);
+        return FALSE;
+    }
+
+    if (fread(header, 1, sizeof(header), fp) != sizeof(header) ||
+        memcmp(header, "LRHIST01", 8) != 0 ||
+        lrlib_histogram_get_uint(header + 8) != LRLIB_HISTOGRAM_BUCKET_COUNT) {
+        fclose(fp);
+        lr_error_message("File \"%s\" is not a histogram snapshot.", file_name);
+        return FALSE;
+    }
+
+    sum_length = lrlib_histogram_get_uint(header + 28);
+    if (sum_length >= sizeof(sum_text) || fread(sum_text, 1, sum_length, fp) != sum_length) {
+        fclose(fp);
+        lr_error_message("Histogram snapshot \"%s\" is corrupt.", file_name);
+        return FALSE;
+    }
+    sum_text[sum_length] = '\0';
+
+    lrlib_histogram_scratch.min = lrlib_histogram_get_uint(header + 12);
+    lrlib_histogram_scratch.max = lrlib_histogram_get_uint(header + 16);
+    lrlib_histogram_scratch.total_count = lrlib_histogram_get_uint(header + 20) * 4294967296.0 + lrlib_histogram_get_uint(header + 24);
+    lrlib_histogram_scratch.sum = atof(sum_text);
+
+    while (fread(entry, 1, sizeof(entry), fp) == sizeof(entry)) {
+        const unsigned int bucket = lrlib_histogram_get_uint(entry);
+        if (bucket >= LRLIB_HISTOGRAM_BUCKET_COUNT) {
+            fclose(fp);
+            lr_error_message("Histogram snapshot \"%s\" is corrupt.", file_name);
+            return FALSE;
+        }
+        lrlib_histogram_scratch.counts[bucket] += lrlib_histogram_get_uint(entry + 4);
+    }
+    fclose(fp);
+
+    lrlib_histogram_add_data(&histogram->data, &lrlib_histogram_scratch);
+    LRLIB_PROFILE_END("lrlib_histogram_load_snapshot", profile_start_usec, 0);
+    return TRUE;
+}
+
+/**
+ * @brief Clears the values recorded by this vuser. Values that have already been merged into the
+ *        process-wide histogram are not removed from it.
+ *
+ * @param histogram_id The ID returned by lrlib_histogram_create.
+ * @return This function does not return a value.
+ */
+void lrlib_histogram_reset(int histogram_id) {
+    lrlib_histogram* histogram = lrlib_get_histogram(histogram_id);
+
+    memset(&histogram->data, 0, sizeof(lrlib_histogram_data));
+    memset(&histogram->merged, 0, sizeof(lrlib_histogram_data));
+}
+
+/**
+ * @brief Frees a histogram, so that its ID can be used for another histogram. Call this in
+ *        vuser_end for every histogram that the vuser created.
+ *
+ * The process-wide histogram is deleted when the last vuser that merged into it frees it (on
+ * Linux, this deletes its file in /dev/shm). A vuser that merges into a histogram with the same
+ * name after that starts a new process-wide histogram.
+ *
+ * @param histogram_id The ID returned by lrlib_histogram_create.
+ * @return This function does not return a value.
+ *
+ * @example
+ *
+ * vuser_end()
+ * {
+ *     lrlib_histogram_merge(parse_histogram);
+ *     lrlib_histogram_report_data_points(parse_histogram, LRLIB_HISTOGRAM_VUSER, "parse");
+ *     lrlib_histogram_free(parse_histogram);
+ *     return 0;
+ * }
+ */
+void lrlib_histogram_free(int histogram_id) {
+    lrlib_histogram* histogram = lrlib_get_histogram(histogram_id);
+
+    if (histogram->shared != NULL) {
+#ifdef LRLIB_LINUX
+        char file_name[LRLIB_MAX_HISTOGRAM_NAME_LENGTH + 64];
+
+        flock(histogram->lock_handle, 2); // LOCK_EX
+        histogram->shared->users--;
+        if (histogram->shared->users == 0) {
+            // A vuser that opened the file before it was deleted sees "deleted" when it gets the
+            // lock, and creates a new file instead.
+            histogram->shared->deleted = TRUE;
+            lrlib_histogram_file_name(histogram, file_name);
+            unlink(file_name);
+        }
+        munmap(histogram->shared, sizeof(lrlib_histogram_shared));
+        flock(histogram->lock_handle, 8); // LOCK_UN
+        close(histogram->lock_handle);
+#else
+        UnmapViewOfFile(histogram->shared);
+        CloseHandle(histogram->mapping_handle);
+        CloseHandle(histogram->lock_handle);
+#endif
+    }
+
+    memset(histogram, 0, sizeof(lrlib_histogram));
+}
+
+/*
+ * Port checks
+ * ===========
+ * Checks whether TCP ports are accepting connections, e.g. as a health check of every server
+ * before a test starts. Connections to all the endpoints are started at once without waiting for
+ * each one (non-blocking sockets), and then the vuser waits for all of them together, with one
+ * overall time limit. Checking hundreds of endpoints takes about as long as the slowest one (or
+ * the time limit), instead of the sum of their connection times.
+ *
+ * On Linux, epoll is used to wait for the connections. On Windows, select is used.
+ */
+
+#define LRLIB_PORT_CHECK_MAX_CONCURRENT 256 // the most connections to have in progress at once
+#define LRLIB_MAX_HOST_NAME_LENGTH 255
+
+// The results of a port check.
+#define LRLIB_PORT_PENDING 0 // still being checked
+#define LRLIB_PORT_OPEN 1 // a connection was made
+#define LRLIB_PORT_REFUSED 2 // the host is up, but nothing is listening on the port
+#define LRLIB_PORT_TIMEOUT 3 // no response before the time limit (e.g. a firewall dropped the connection)
+#define LRLIB_PORT_UNREACHABLE 4 // there is no route to the host or network
+#define LRLIB_PORT_ERROR 5 // any other connection error
+#define LRLIB_PORT_INVALID 6 // the endpoint is not "host:port", or the host name could not be resolved
+
+const char* LRLIB_PORT_STATUS_NAMES[7] = {"pending", "open", "refused", "timeout", "unreachable", "error", "invalid"};
+
+typedef struct {
+    int status; // one of the LRLIB_PORT_* values
+    unsigned int address; // IPv4 address, in network byte order
+    unsigned short port;
+    int socket; // -1 when no connection is in progress
+    double start_usec;
+    double latency_usec; // the time taken to connect (or to be refused)
+} lrlib_port_check;
+
+/**
+ * @brief Converts a host name or IPv4 address to an IPv4 address (in network byte order).
+ *
+ * @return Returns TRUE if successful, or FALSE if the host could not be resolved.
+ */
+int lrlib_resolve_ipv4(const char* host, unsigned int* address) {
+    unsigned int inet_addr(const char* cp);
+    int getaddrinfo(const char* node, const char* service, const void* hints, void** result);
+    void freeaddrinfo(void* result);
+    // struct addrinfo has the same fields on Linux and Windows, but in a different order.
+    struct {
+        int ai_flags;
+        int ai_family;
+        int ai_socktype;
+        int ai_protocol;
+#ifdef LRLIB_LINUX
+        unsigned int ai_addrlen;
+        unsigned char* ai_addr;
+        char* ai_canonname;
+#else
+        unsigned int ai_addrlen;
+        char* ai_canonname;
+        unsigned char* ai_addr;
+#endif
+        void* ai_next;
+    } hints, *result;
+
+    // IP addresses do not need to be looked up.
+    *address = inet_addr(host);
+    if ( (*address != 0xFFFFFFFF) || (strcmp(host, "255.255.255.255") == 0) ) {
+        return TRUE;
+    }
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = 2; // AF_INET
+    hints.ai_socktype = 1; // SOCK_STREAM
+    if (getaddrinfo(host, NULL, &hints, (void**)&result) != 0) {
+        return FALSE;
+    }
+    memcpy(address, result->ai_addr + 4, 4); // sin_addr, after sin_family and sin_port
+    freeaddrinfo(result);
+    return TRUE;
+}
+
+/**
+ * @brief Converts a socket error number to one of the LRLIB_PORT_* results.
+ */
+int lrlib_port_status_from_error(int error) {
+#ifdef LRLIB_LINUX
+    if (error == 111) { // ECONNREFUSED
+        return LRLIB_PORT_REFUSED;
+    } else if (error == 110) { // ETIMEDOUT
+        return LRLIB_PORT_TIMEOUT;
+    } else if ( (error == 113) || (error == 101) ) { // EHOSTUNREACH, ENETUNREACH
+        return LRLIB_PORT_UNREACHABLE;
+    }
+#else
+    if (error == 10061) { // WSAECONNREFUSED
+        return LRLIB_PORT_REFUSED;
+    } else if (error == 10060) { // WSAETIMEDOUT
+        return LRLIB_PORT_TIMEOUT;
+    } else if ( (error == 10065) || (error == 10051) ) { // WSAEHOSTUNREACH, WSAENETUNREACH
+        return LRLIB_PORT_UNREACHABLE;
+    }
+#endif
+    return LRLIB_PORT_ERROR;
+}
+
+/**
+ * @brief Starts a non-blocking connection for a port check. If the connection succeeds or fails
+ *        straight away, the result is set and the socket is closed.
+ *
+ * @return Returns TRUE if the connection is in progress.
+ */
+int lrlib_port_check_connect(lrlib_port_check* check) {
+    unsigned char address[16]; // struct sockaddr_in
+    int error;
+
+    memset(address, 0, sizeof(address));
+    address[0] = 2; // sin_family = AF_INET (little-endian)
+    address[2] = check->port >> 8; // sin_port, in network byte order
+    address[3] = check->port & 0xFF;
+    memcpy(address + 4, &check->address, 4);
+
+    check->start_usec = lrlib_timer_now_usec();
+
+#ifdef LRLIB_LINUX
+    {
+        int* __errno_location(void);
+
+        check->socket = socket(2, 1 | 04000, 0); // AF_INET, SOCK_STREAM | SOCK_NONBLOCK
+        if (check->socket < 0) {
+            check->status = LRLIB_PORT_ERROR;
+            return FALSE;
+        }
+        if (connect(check->socket, address, sizeof(address)) == 0) {
+            error = 0;
+        } else {
+            error = *__errno_location();
+            if (error == 115) { // EINPROGRESS
+                return TRUE;
+            }
+        }
+        close(check->socket);
+    }
+#else
+    {
+        unsigned long non_blocking = 1;
+
+        check->socket = socket(2, 1, 0); // AF_INET, SOCK_STREAM
+        if (check->socket == -1) {
+            check->status = LRLIB_PORT_ERROR;
+            return FALSE;
+        }
+        ioctlsocket(check->socket, 0x8004667E, &non_blocking); // FIONBIO
+        if (connect(check->socket, address, sizeof(address)) == 0) {
+            error = 0;
+        } else {
+            error = WSAGetLastError();
+            if (error == 10035) { // WSAEWOULDBLOCK
+                return TRUE;
+            }
+        }
+        closesocket(check->socket);
+    }
+#endif
+
+    check->socket = -1;
+    check->latency_usec = lrlib_timer_now_usec() - check->start_usec;
+    if (error == 0) {
+        check->status = LRLIB_PORT_OPEN;
+    } else {
+        check->status = lrlib_port_status_from_error(error);
+    }
+    return FALSE;
+}
+
+/**
+ * @brief Records the result of a connection that has finished (successfully or not), and closes
+ *        its socket.
+ */
+void lrlib_port_check_finish(lrlib_port_check* check) {
+    int error = 0;
+    int error_length = sizeof(error);
+
+    check->latency_usec = lrlib_timer_now_usec() - check->start_usec;
+#ifdef LRLIB_LINUX
+    getsockopt(check->socket, 1, 4, &error, &error_length); // SOL_SOCKET, SO_ERROR
+    close(check->socket);
+#else
+    getsockopt(check->socket, 0xFFFF, 0x1007, &error, &error_length); // SOL_SOCKET, SO_ERROR
+    closesocket(check->socket);
+#endif
+    check->socket = -1;
+
+    if (error == 0) {
+        check->status = LRLIB_PORT_OPEN;
+    } else {
+        check->status = lrlib_port_status_from_error(error);
+    }
+}
+
+/**
+ * @brief Checks whether many TCP ports are open, all at the same time.
+ *
+ * The result for each endpoint ("open", "refused", "timeout", "unreachable", "error" or "invalid")
+ * is saved to a parameter array, in the same order as the endpoints. The time taken to connect is
+ * saved (in milliseconds) to a second parameter array with "_latency_ms" added to the name; it is
+ * empty for endpoints that timed out or were invalid.
+ *
+ * @param endpoints_paramarr The name of a parameter array of endpoints, each in the form
+ *        "host:port", e.g. "db01.example.com:1521" or "10.0.0.12:443".
+ * @param timeout_seconds The time limit for checking all the endpoints.
+ * @param output_paramarr The name of the parameter array to save the results to.
+ * @return Returns the number of endpoints that are open.
+ *
+ * @example
+ *
+ * vuser_init()
+ * {
+ *     int open_count;
+ *
+ *     lrlib_str_split(lr_eval_string("{Endpoints}"), ",", "Endpoint"); // e.g. "web01:443,web02:443,db01:1521"
+ *     open_count = lrlib_check_ports("Endpoint", 5, "EndpointStatus");
+ *     if (open_count != lr_paramarr_len("Endpoint")) {
+ *         lr_error_message("Only %d of %d endpoints are available.", open_count, lr_paramarr_len("Endpoint"));
+ *         lr_abort();
+ *     }
+ *     return 0;
+ * }
+ *
+ * Note: Host names are resolved one at a time (before any connections are started), and only IPv4
+ * addresses are checked. On Linux, this function only works on 64-bit (x86-64) load generators.
+ */
+int lrlib_check_ports(const char* endpoints_paramarr, double timeout_seconds, const char* output_paramarr) {
+    lrlib_port_check* checks;
+    lrlib_paramarr_emitter statuses;
+    lrlib_paramarr_emitter latencies;
+    char latencies_name[LRLIB_PARAM_NAME_BUFFER_LENGTH];
+    char host[LRLIB_MAX_HOST_NAME_LENGTH + 1];
+    char latency_text[32];
+    double deadline_usec;
+    int count;
+    int next = 0; // the next endpoint to start a connection to
+    int in_progress = 0;
+    int open_count = 0;
+    int i;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if ( (endpoints_paramarr == NULL) || (strlen(endpoints_paramarr) == 0) ) {
+        lr_error_message("endpoints_paramarr cannot be NULL or empty.");
+        lr_abort();
+    } else if (timeout_seconds <= 0) {
+        lr_error_message("timeout_seconds must be greater than 0.");
+        lr_abort();
+    } else if ( (output_paramarr == NULL) || (strlen(output_paramarr) == 0) || (strlen(output_paramarr) > LRLIB_MAX_PARAM_NAME_LENGTH - 11) ) {
+        lr_error_message("output_paramarr cannot be NULL, empty, or longer than %d characters.", LRLIB_MAX_PARAM_NAME_LENGTH - 11);
+        lr_abort();
+    }
+
+    count = lr_paramarr_len((char*)endpoints_paramarr);
+    checks = (lrlib_port_check*)calloc(count + 1, sizeof(lrlib_port_check));
+    if (checks == NULL) {
+        lr_error_message("Unable to allocate memory for %d endpoints.", count);
+        lr_abort();
+    }
+
+    // Parse the endpoints, and resolve the host names.
+    for (i = 0; i < count; i++) {
+        const char* endpoint = lr_paramarr_idx((char*)endpoints_paramarr, i + 1);
+        const char* colon = (const char*)strrchr(endpoint, ':');
+        int port = 0;
+        const char* c;
+
+        checks[i].socket = -1;
+        checks[i].status = LRLIB_PORT_INVALID;
+        if ( (colon == NULL) || (colon == endpoint) || (colon - endpoint > LRLIB_MAX_HOST_NAME_LENGTH) || (colon[1] == '\0') ) {
+            continue;
+        }
+        for (c = colon + 1; (*c >= '0') && (*c <= '9') && (port <= 65535); c++) {
+            port = port * 10 + (*c - '0');
+        }
+        if ( (*c != '\0') || (port < 1) || (port > 65535) ) {
+            continue;
+        }
+        memcpy(host, endpoint, colon - endpoint);
+        host[colon - endpoint] = '\0';
+        if (lrlib_resolve_ipv4(host, &checks[i].address) == FALSE) {
+            continue;
+        }
+        checks[i].port = port;
+        checks[i].status = LRLIB_PORT_PENDING;
+    }
+
+    deadline_usec = lrlib_timer_now_usec() + timeout_seconds * 1000000;
+
+#ifdef LRLIB_LINUX
+    {
+        // struct epoll_event is packed on x86-64: a 4-byte event mask, then 8 bytes of user data
+        // (which holds the index of the port check).
+        struct {
+            unsigned int events;
+            unsigned int index;
+            unsigned int unused;
+        } event, events[64];
+        const int epoll = epoll_create1(0);
+        int ready;
+        int wait_ms;
+
+        if (epoll < 0) {
+            free(checks);
+            lr_error_message("Unable to create an epoll instance.");
+            lr_abort();
+        }
+
+        for (;;) {
+            // Start connections until the limit is reached.
+            while ( (in_progress < LRLIB_PORT_CHECK_MAX_CONCURRENT) && (next < count) ) {
+                if ( (checks[next].status == LRLIB_PORT_PENDING) && (lrlib_port_check_connect(&checks[next]) == TRUE) ) {
+                    event.events = 4 | 8 | 16; // EPOLLOUT | EPOLLERR | EPOLLHUP
+                    event.index = next;
+                    event.unused = 0;
+                    epoll_ctl(epoll, 1, checks[next].socket, &event); // EPOLL_CTL_ADD
+                    in_progress++;
+                }
+                next++;
+            }
+            if (in_progress == 0) {
+                break;
+            }
+
+            wait_ms = (int)((deadline_usec - lrlib_timer_now_usec()) / 1000) + 1;
+            if (wait_ms <= 0) {
+                break;
+            }
+            ready = epoll_wait(epoll, events, 64, wait_ms);
+            for (i = 0; i < ready; i++) {
+                lrlib_port_check_finish(&checks[events[i].index]); // closing the socket removes it from epoll
+                in_progress--;
+            }
+            if (lrlib_timer_now_usec() >= deadline_usec) {
+                break;
+            }
+        }
+        close(epoll);
+    }
+#else
+    {
+        // A Winsock fd_set is a count followed by an array of sockets, so a larger one can be
+        // used than the default FD_SETSIZE (64).
+        struct {
+            unsigned int count;
+            unsigned int sockets[LRLIB_PORT_CHECK_MAX_CONCURRENT];
+        } write_set, error_set;
+        struct {
+            long seconds;
+            long microseconds;
+        } timeout;
+        unsigned char wsa_data[400]; // WSADATA
+        int active[LRLIB_PORT_CHECK_MAX_CONCURRENT]; // the index of each connection in progress
+        double remaining_usec;
+        int j;
+
+        lrlib_load_dll("ws2_32.dll");
+        WSAStartup(0x0202, wsa_data);
+
+        for (;;) {
+            while ( (in_progress < LRLIB_PORT_CHECK_MAX_CONCURRENT) && (next < count) ) {
+                if ( (checks[next].status == LRLIB_PORT_PENDING) && (lrlib_port_check_connect(&checks[next]) == TRUE) ) {
+                    active[in_progress] = next;
+                    in_progress++;
+                }
+                next++;
+            }
+            if (in_progress == 0) {
+                break;
+            }
+
+            remaining_usec = deadline_usec - lrlib_timer_now_usec();
+            if (remaining_usec <= 0) {
+                break;
+            }
+            timeout.seconds = (long)(remaining_usec / 1000000);
+            timeout.microseconds = (long)(remaining_usec - timeout.seconds * 1000000.0);
+
+            // Successful connections are reported as writable, and failed ones as errors.
+            write_set.count = in_progress;
+            error_set.count = in_progress;
+            for (i = 0; i < in_progress; i++) {
+                write_set.sockets[i] = checks[active[i]].socket;
+                error_set.sockets[i] = checks[active[i]].socket;
+            }
+            if (select(0, NULL, &write_set, &error_set, &timeout) <= 0) {
+                break;
+            }
+
+            // select leaves only the ready sockets in each set.
+            for (i = 0; i < in_progress; i++) {
+                const unsigned int socket_handle = checks[active[i]].socket;
+                int ready = FALSE;
+                for (j = 0; j < (int)write_set.count; j++) {
+                    if (write_set.sockets[j] == socket_handle) {
+                        ready = TRUE;
+                    }
+                }
+                for (j = 0; j < (int)error_set.count; j++) {
+                    if (error_set.sockets[j] == socket_handle) {
+                        ready = TRUE;
+                    }
+                }
+                if (ready == TRUE) {
+                    lrlib_port_check_finish(&checks[active[i]]);
+                    in_progress--;
+                    active[i] = active[in_progress];
+                    i--;
+                }
+            }
+        }
+        WSACleanup();
+    }
+#endif
+
+    // Anything that has not finished by the deadline has timed out.
+    for (i = 0; i < count; i++) {
+        if (checks[i].socket != -1) {
+#ifdef LRLIB_LINUX
+            close(checks[i].socket);
+#else
+            closesocket(checks[i].socket);
+#endif
+            checks[i].socket = -1;
+        }
+        if (checks[i].status == LRLIB_PORT_PENDING) {
+            checks[i].status = LRLIB_PORT_TIMEOUT;
+            checks[i].latency_usec = -1;
+        }
+    }
+
+    // Save the results.
+    sprintf(latencies_name, "%s_latency_ms", output_paramarr);
+    lrlib_paramarr_emitter_init(&statuses, output_paramarr);
+    lrlib_paramarr_emitter_init(&latencies, latencies_name);
+    for (i = 0; i < count; i++) {
+        lrlib_paramarr_emitter_save(&statuses, LRLIB_PORT_STATUS_NAMES[checks[i].status]);
+        if ( (checks[i].status == LRLIB_PORT_INVALID) || (checks[i].latency_usec < 0) ) {
+            lrlib_paramarr_emitter_save(&latencies, "");
+        } else {
+            sprintf(latency_text, "%.3f", checks[i].latency_usec / 1000);
+            lrlib_paramarr_emitter_save(&latencies, latency_text);
+        }
+        if (checks[i].status == LRLIB_PORT_OPEN) {
+            open_count++;
+        }
+    }
+    lrlib_paramarr_emitter_finish(&statuses);
+    lrlib_paramarr_emitter_finish(&latencies);
+
+    free(checks);
+    LRLIB_PROFILE_END("lrlib_check_ports", profile_start_usec, 0);
+    return open_count;
+}
+
+/*
+ * Running commands
+ * ================
+ * Runs a program and captures its output, e.g. to call a command-line tool that creates test data
+ * or checks a result. The program is started directly, not through a shell (so the vuser process
+ * is not forked, and shell characters like "|", ">" and "*" in the command have no special
+ * meaning). Its standard output and standard error are read through pipes as it runs, so a
+ * program that writes a lot of output does not block, and a program that runs for too long is
+ * killed.
+ *
+ * On Linux, the program is started with posix_spawnp, and the pipes are read with poll. On
+ * Windows, it is started with CreateProcess.
+ */
+
+#define LRLIB_COMMAND_READ_SIZE 65536 // bytes read from a pipe at a time
+#define LRLIB_MAX_COMMAND_ARGUMENTS 256
+
+typedef struct {
+    char* data;
+    int length;
+    int capacity;
+} lrlib_command_buffer;
+
+// How a command ended, as saved to the <prefix>_status parameter.
+#define LRLIB_COMMAND_EXITED 0 // the program exited; <prefix>_exit_code has its exit code
+#define LRLIB_COMMAND_KILLED 1 // the program was ended by a signal (Linux only); <prefix>_exit_code has the signal number
+#define LRLIB_COMMAND_TIMEOUT 2 // the program was killed because it ran for too long
+#define LRLIB_COMMAND_FAILED 3 // the program could not be started
+
+const char* LRLIB_COMMAND_STATUS_NAMES[4] = {"exited", "killed", "timeout", "failed"};
+
+/**
+ * @brief Adds data to a buffer, making it bigger if needed. The buffer always has room for a
+ *        terminating null after the data.
+ */
+void lrlib_command_buffer_append(lrlib_command_buffer* buffer, const char* data, int length) {
+    char* grown;
+
+    if (buffer->length + length + 1 > buffer->capacity) {
+        if (buffer->capacity == 0) {
+            buffer->capacity = 4096;
+        }
+        while (buffer->length + length + 1 > buffer->capacity) {
+            buffer->capacity = buffer->capacity * 2;
+        }
+        grown = (char*)realloc(buffer->data, buffer->capacity);
+        if (grown == NULL) {
+            lr_error_message("Unable to allocate memory for the command output.");
+            lr_abort();
+        }
+        buffer->data = grown;
+    }
+
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+    buffer->data[buffer->length] = '\0';
+}
+
+/**
+ * @brief Saves each complete line in a buffer to a parameter array, and removes it from the
+ *        buffer. Line endings ("\n" or "\r\n") are not saved. If final is TRUE, any text after the
+ *        last line ending is saved too.
+ */
+void lrlib_command_emit_lines(lrlib_command_buffer* buffer, lrlib_paramarr_emitter* emitter, int final) {
+    int start = 0;
+    int i;
+
+    for (i = 0; i < buffer->length; i++) {
+        if (buffer->data[i] == '\n') {
+            buffer->data[i] = '\0';
+            if ( (i > start) && (buffer->data[i - 1] == '\r') ) {
+                buffer->data[i - 1] = '\0';
+            }
+            lrlib_paramarr_emitter_save(emitter, buffer->data + start);
+            start = i + 1;
+        }
+    }
+    if ( (final == TRUE) && (start < buffer->length) ) {
+        lrlib_paramarr_emitter_save(emitter, buffer->data + start); // the buffer is null terminated
+        start = buffer->length;
+    }
+
+    memmove(buffer->data, buffer->data + start, buffer->length - start);
+    buffer->length -= start;
+    buffer->data[buffer->length] = '\0';
+}
+
+/**
+ * @brief Splits a command into arguments, in place. Arguments are separated by spaces or tabs, and
+ *        can be quoted with double or single quotes to include spaces. Inside double quotes, a
+ *        backslash can be used before a double quote or a backslash.
+ *
+ * @return Returns the number of arguments, or -1 if the command is not valid (an unclosed quote,
+ *         or too many arguments). argv is terminated with a NULL.
+ */
+int lrlib_split_command_line(char* command, char** argv, int max_arguments) {
+    char* input = command;
+    char* output = command;
+    char quote;
+    int count = 0;
+
+    for (;;) {
+        while ( (*input == ' ') || (*input == '\t') ) {
+            input++;
+        }
+        if (*input == '\0') {
+            break;
+        }
+        if (count == max_arguments - 1) {
+            return -1;
+        }
+
+        // Copy the argument towards the start of the string, removing the quotes.
+        argv[count] = output;
+        count++;
+        while ( (*input != '\0') && (*input != ' ') && (*input != '\t') ) {
+            if ( (*input == '"') || (*input == '\'') ) {
+                quote = *input;
+                input++;
+                while (*input != quote) {
+                    if (*input == '\0') {
+                        return -1;
+                    }
+                    if ( (quote == '"') && (*input == '\\') && ( (input[1] == '"') || (input[1] == '\\') ) ) {
+                        input++;
+                    }
+                    *output++ = *input++;
+                }
+                input++;
+            } else {
+                *output++ = *input++;
+            }
+        }
+        if (*input != '\0') {
+            input++;
+        }
+        *output++ = '\0';
+    }
+
+    argv[count] = NULL;
+    return count;
+}
+
+/**
+ * @brief Runs a command, and reads its output until it exits or the time limit is reached.
+ *        Standard output is either kept in stdout_buffer, or (if lines is not NULL) saved to a
+ *        parameter array one line at a time as it is read.
+ *
+ * @return Returns one of the LRLIB_COMMAND_* values. exit_code is set to the program's exit code
+ *         (or the signal that ended it).
+ */
+int lrlib_run_process(const char* command, double timeout_seconds, lrlib_command_buffer* stdout_buffer,
+        lrlib_command_buffer* stderr_buffer, lrlib_paramarr_emitter* lines, int* exit_code) {
+    const double deadline_usec = lrlib_timer_now_usec() + timeout_seconds * 1000000;
+    char* read_buffer;
+    int result = LRLIB_COMMAND_EXITED;
+
+    *exit_code = -1;
+    lrlib_command_buffer_append(stdout_buffer, "", 0); // so the buffers are never NULL
+    lrlib_command_buffer_append(stderr_buffer, "", 0);
+    read_buffer = (char*)malloc(LRLIB_COMMAND_READ_SIZE);
+    if (read_buffer == NULL) {
+        lr_error_message("Unable to allocate memory for the command output.");
+        lr_abort();
+    }
+
+#ifdef LRLIB_LINUX
+    {
+        int pipe2(int* fds, int flags);
+        int posix_spawnp(int* pid, const char* file, const void* file_actions, const void* attributes, char** argv, char** envp);
+        int posix_spawn_file_actions_init(void* file_actions);
+        int posix_spawn_file_actions_adddup2(void* file_actions, int fd, int new_fd);
+        int posix_spawn_file_actions_addopen(void* file_actions, int fd, const char* path, int flags, int mode);
+        int posix_spawn_file_actions_destroy(void* file_actions);
+        extern char** environ;
+        struct {
+            int fd;
+            short events;
+            short revents;
+        } poll_fds[2]; // struct pollfd
+        unsigned char file_actions[256]; // posix_spawn_file_actions_t is 80 bytes with glibc
+        char* argv[LRLIB_MAX_COMMAND_ARGUMENTS];
+        char* arguments;
+        int stdout_pipe[2];
+        int stderr_pipe[2];
+        int pid;
+        int status = 0;
+        int wait_ms;
+        int bytes_read;
+        int i;
+
+        arguments = (char*)malloc(strlen(command) + 1);
+        if (arguments == NULL) {
+            lr_error_message("Unable to allocate memory for the command.");
+            lr_abort();
+        }
+        strcpy(arguments, command);
+        if (lrlib_split_command_line(arguments, argv, LRLIB_MAX_COMMAND_ARGUMENTS) < 1) {
+            lr_error_message("Invalid command: %s", command);
+            free(arguments);
+            free(read_buffer);
+            return LRLIB_COMMAND_FAILED;
+        }
+
+        // The pipes are closed in the child when it starts the program (O_CLOEXEC), except for the
+        // copies made as its standard output and standard error.
+        if (pipe2(stdout_pipe, 02000000) != 0) { // O_CLOEXEC
+            lr_error_message("Unable to create a pipe.");
+            free(arguments);
+            free(read_buffer);
+            return LRLIB_COMMAND_FAILED;
+        }
+        if (pipe2(stderr_pipe, 02000000) != 0) {
+            lr_error_message("Unable to create a pipe.");
+            close(stdout_pipe[0]);
+            close(stdout_pipe[1]);
+            free(arguments);
+            free(read_buffer);
+            return LRLIB_COMMAND_FAILED;
+        }
+        posix_spawn_file_actions_init(file_actions);
+        posix_spawn_file_actions_addopen(file_actions, 0, "/dev/null", 0, 0); // O_RDONLY
+        posix_spawn_file_actions_adddup2(file_actions, stdout_pipe[1], 1);
+        posix_spawn_file_actions_adddup2(file_actions, stderr_pipe[1], 2);
+
+        if (posix_spawnp(&pid, argv[0], file_actions, NULL, argv, environ) != 0) {
+            lr_error_message("Unable to run \"%s\".", argv[0]);
+            result = LRLIB_COMMAND_FAILED;
+            close(stdout_pipe[0]);
+            close(stderr_pipe[0]);
+        }
+        posix_spawn_file_actions_destroy(file_actions);
+        close(stdout_pipe[1]);
+        close(stderr_pipe[1]);
+        free(arguments);
+
+        if (result != LRLIB_COMMAND_FAILED) {
+            // Read from both pipes until the program closes them (usually when it exits).
+            poll_fds[0].fd = stdout_pipe[0];
+            poll_fds[1].fd = stderr_pipe[0];
+            while ( (poll_fds[0].fd >= 0) || (poll_fds[1].fd >= 0) ) {
+                wait_ms = (int)((deadline_usec - lrlib_timer_now_usec()) / 1000) + 1;
+                if (wait_ms <= 0) {
+                    result = LRLIB_COMMAND_TIMEOUT;
+                    break;
+                }
+                for (i = 0; i < 2; i++) {
+                    poll_fds[i].events = 1; // POLLIN
+                    poll_fds[i].revents = 0;
+                }
+                if (poll(poll_fds, 2, wait_ms) <= 0) {
+                    continue; // timed out (checked above) or interrupted
+                }
+
+                for (i = 0; i < 2; i++) {
+                    if (poll_fds[i].revents == 0) {
+                        continue;
+                    }
+                    bytes_read = read(poll_fds[i].fd, read_buffer, LRLIB_COMMAND_READ_SIZE);
+                    if (bytes_read <= 0) {
+                        close(poll_fds[i].fd);
+                        poll_fds[i].fd = -1; // poll ignores negative file descriptors
+                    } else if (i == 0) {
+                        lrlib_command_buffer_append(stdout_buffer, read_buffer, bytes_read);
+                        if (lines != NULL) {
+                            lrlib_command_emit_lines(stdout_buffer, lines, FALSE);
+                        }
+                    } else {
+                        lrlib_command_buffer_append(stderr_buffer, read_buffer, bytes_read);
+                    }
+                }
+            }
+            for (i = 0; i < 2; i++) {
+                if (poll_fds[i].fd >= 0) {
+                    close(poll_fds[i].fd);
+                }
+            }
+
+            // Wait for the program to exit.
+            while ( (result != LRLIB_COMMAND_TIMEOUT) && (waitpid(pid, &status, 1) == 0) ) { // WNOHANG
+                if (lrlib_timer_now_usec() >= deadline_usec) {
+                    result = LRLIB_COMMAND_TIMEOUT;
+                } else {
+                    usleep(100);
+                }
+            }
+            if (result == LRLIB_COMMAND_TIMEOUT) {
+                kill(pid, 9); // SIGKILL
+                waitpid(pid, &status, 0);
+            } else if ((status & 0x7F) == 0) {
+                *exit_code = (status >> 8) & 0xFF;
+            } else {
+                result = LRLIB_COMMAND_KILLED;
+                *exit_code = status & 0x7F;
+            }
+        }
+    }
+#else
+    {
+        struct {
+            unsigned int length;
+            void* security_descriptor;
+            int inherit_handle;
+        } security_attributes;
+        struct {
+            unsigned int cb;
+            char* reserved;
+            char* desktop;
+            char* title;
+            unsigned int x, y, x_size, y_size, x_count_chars, y_count_chars, fill_attribute, flags;
+            unsigned short show_window;
+            unsigned short reserved2_size;
+            void* reserved2;
+            unsigned int std_input;
+            unsigned int std_output;
+            unsigned int std_error;
+            void* attribute_list;
+        } startup_info; // STARTUPINFOEXA (a STARTUPINFOA, followed by the attribute list)
+        struct {
+            unsigned int process;
+            unsigned int thread;
+            unsigned int process_id;
+            unsigned int thread_id;
+        } process_information; // PROCESS_INFORMATION
+        unsigned int pipes[2][2]; // the read and write ends of the stdout and stderr pipes
+        unsigned int inherited_handles[2];
+        unsigned long attribute_list_size = 0;
+        unsigned long available;
+        unsigned long bytes_read;
+        unsigned long process_exit_code;
+        char* command_line;
+        int open_pipes = 2;
+        int wait_ms;
+        int data_read;
+        int i;
+
+        lrlib_load_dll("kernel32.dll");
+
+        // The write ends of the pipes are inherited by the program; the read ends are not.
+        security_attributes.length = sizeof(security_attributes);
+        security_attributes.security_descriptor = NULL;
+        security_attributes.inherit_handle = TRUE;
+        for (i = 0; i < 2; i++) {
+            if (CreatePipe(&pipes[i][0], &pipes[i][1], &security_attributes, 0) == FALSE) {
+                if (i == 1) {
+                    CloseHandle(pipes[0][0]);
+                    CloseHandle(pipes[0][1]);
+                }
+                lr_error_message("Unable to create a pipe.");
+                free(read_buffer);
+                return LRLIB_COMMAND_FAILED;
+            }
+            SetHandleInformation(pipes[i][0], 1, 0); // HANDLE_FLAG_INHERIT
+        }
+
+        // CreateProcess can modify the command line, so it needs a copy.
+        command_line = (char*)malloc(strlen(command) + 1);
+        if (command_line == NULL) {
+            lr_error_message("Unable to allocate memory for the command.");
+            lr_abort();
+        }
+        strcpy(command_line, command);
+
+        // The program only inherits the write ends of its own pipes. Without a handle list, it
+        // would inherit every inheritable handle in the process, including the pipes of commands
+        // that other vusers are running at the same time, and those pipes would then stay open
+        // until this program exited.
+        InitializeProcThreadAttributeList(NULL, 1, 0, &attribute_list_size); // fails, but gets the size
+        memset(&startup_info, 0, sizeof(startup_info));
+        startup_info.attribute_list = malloc(attribute_list_size);
+        if (startup_info.attribute_list == NULL) {
+            lr_error_message("Unable to allocate memory for the process attributes.");
+            lr_abort();
+        }
+        startup_info.cb = sizeof(startup_info);
+        startup_info.flags = 0x100; // STARTF_USESTDHANDLES
+        startup_info.std_output = pipes[0][1];
+        startup_info.std_error = pipes[1][1];
+        inherited_handles[0] = pipes[0][1];
+        inherited_handles[1] = pipes[1][1];
+
+        if (InitializeProcThreadAttributeList(startup_info.attribute_list, 1, 0, &attribute_list_size) == FALSE) {
+            lr_error_message("Unable to create the process attributes for \"%s\" (error %d).", command, GetLastError());
+            result = LRLIB_COMMAND_FAILED;
+        } else {
+            if (UpdateProcThreadAttribute(startup_info.attribute_list, 0, 0x00020002, inherited_handles, sizeof(inherited_handles), NULL, NULL) == FALSE) { // PROC_THREAD_ATTRIBUTE_HANDLE_LIST
+                lr_error_message("Unable to set the handles for \"%s\" to inherit (error %d).", command, GetLastError());
+                result = LRLIB_COMMAND_FAILED;
+            } else if (CreateProcessA(NULL, command_line, NULL, NULL, TRUE, 0x08000000 | 0x00080000, NULL, NULL, &startup_info, &process_information) == FALSE) { // CREATE_NO_WINDOW | EXTENDED_STARTUPINFO_PRESENT
+                lr_error_message("Unable to run \"%s\" (error %d).", command, GetLastError());
+                result = LRLIB_COMMAND_FAILED;
+            }
+            DeleteProcThreadAttributeList(startup_info.attribute_list);
+        }
+        free(startup_info.attribute_list);
+        free(command_line);
+        CloseHandle(pipes[0][1]);
+        CloseHandle(pipes[1][1]);
+
+        if (result != LRLIB_COMMAND_FAILED) {
+            CloseHandle(process_information.thread);
+
+            // Anonymous pipes cannot be waited on, so check both for data, and wait briefly for
+            // the process when neither has any.
+            while (open_pipes > 0) {
+                if (lrlib_timer_now_usec() >= deadline_usec) {
+                    result = LRLIB_COMMAND_TIMEOUT;
+                    break;
+                }
+                data_read = FALSE;
+                for (i = 0; i < 2; i++) {
+                    if (pipes[i][0] == 0) {
+                        continue;
+                    }
+                    if (PeekNamedPipe(pipes[i][0], NULL, 0, NULL, &available, NULL) == FALSE) {
+                        CloseHandle(pipes[i][0]); // the program has closed its end
+                        pipes[i][0] = 0;
+                        open_pipes--;
+                        continue;
+                    }
+                    if (available == 0) {
+                        continue;
+                    }
+                    if (available > LRLIB_COMMAND_READ_SIZE) {
+                        available = LRLIB_COMMAND_READ_SIZE;
+                    }
+                    ReadFile(pipes[i][0], read_buffer, available, &bytes_read, NULL);
+                    data_read = TRUE;
+                    if (i == 0) {
+                        lrlib_command_buffer_append(stdout_buffer, read_buffer, bytes_read);
+                        if (lines != NULL) {
+                            lrlib_command_emit_lines(stdout_buffer, lines, FALSE);
+                        }
+                    } else {
+                        lrlib_command_buffer_append(stderr_buffer, read_buffer, bytes_read);
+                    }
+                }
+                if (data_read == FALSE) {
+                    WaitForSingleObject(process_information.process, 1);
+                }
+            }
+            for (i = 0; i < 2; i++) {
+                if (pipes[i][0] != 0) {
+                    CloseHandle(pipes[i][0]);
+                }
+            }
+
+            if (result != LRLIB_COMMAND_TIMEOUT) {
+                wait_ms = (int)((deadline_usec - lrlib_timer_now_usec()) / 1000) + 1;
+                if (wait_ms < 0) {
+                    wait_ms = 0;
+                }
+                if (WaitForSingleObject(process_information.process, wait_ms) != 0) { // WAIT_OBJECT_0
+                    result = LRLIB_COMMAND_TIMEOUT;
+                }
+            }
+            if (result == LRLIB_COMMAND_TIMEOUT) {
+                TerminateProcess(process_information.process, 1);
+            } else {
+                GetExitCodeProcess(process_information.process, &process_exit_code);
+                *exit_code = process_exit_code;
+            }
+            CloseHandle(process_information.process);
+        } else {
+            CloseHandle(pipes[0][0]);
+            CloseHandle(pipes[1][0]);
+        }
+    }
+#endif
+
+    free(read_buffer);
+    return result;
+}
+
+/**
+ * @brief Saves the status, exit code and standard error of a command to parameters.
+ */
+void lrlib_save_command_result(const char* output_prefix, int result, int exit_code, lrlib_command_buffer* stderr_buffer) {
+    char param_name[LRLIB_PARAM_NAME_BUFFER_LENGTH];
+    char exit_code_text[16];
+
+    sprintf(param_name, "%s_status", output_prefix);
+    lr_save_string(LRLIB_COMMAND_STATUS_NAMES[result], param_name);
+
+    sprintf(param_name, "%s_exit_code", output_prefix);
+    if ( (result == LRLIB_COMMAND_EXITED) || (result == LRLIB_COMMAND_KILLED) ) {
+        sprintf(exit_code_text, "%d", exit_code);
+    } else {
+        exit_code_text[0] = '\0';
+    }
+    lr_save_string(exit_code_text, param_name);
+
+    sprintf(param_name, "%s_stderr", output_prefix);
+    lr_save_var(stderr_buffer->data, stderr_buffer->length, 0, param_name);
+}
+
+/**
+ * @brief Runs a program, waits for it to finish, and saves its output to parameters.
+ *
+ * These parameters are saved:
+ * - {<prefix>_stdout}: everything the program wrote to standard output.
+ * - {<prefix>_stderr}: everything the program wrote to standard error.
+ * - {<prefix>_exit_code}: the program's exit code (empty if it timed out or could not be started).
+ * - {<prefix>_status}: "exited", "killed" (ended by a signal, on Linux), "timeout" or "failed".
+ *
+ * @param command The program and its arguments, e.g. "openssl rand -hex 16". The program is
+ *        found using the PATH. Arguments that contain spaces can be quoted. The command is not run
+ *        by a shell, so pipes, redirection and wildcards cannot be used (run "sh -c '...'" or
+ *        "cmd /c ..." if they are needed).
+ * @param timeout_seconds The program is killed if it is still running after this many seconds.
+ * @param output_prefix The start of the names of the parameters to save the results to.
+ * @return Returns the program's exit code, or -1 if it timed out, was killed, or could not be
+ *         started.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     if (lrlib_run_command("openssl rand -hex 16", 10, "Nonce") != 0) {
+ *         lr_error_message("openssl failed: %s", lr_eval_string("{Nonce_stderr}"));
+ *         lr_abort();
+ *     }
+ *     lr_output_message("Nonce: %s", lr_eval_string("{Nonce_stdout}"));
+ *     return 0;
+ * }
+ *
+ * Note: On Linux, this function only works on 64-bit (x86-64) load generators. On Windows, it needs
+ * Windows Vista or Windows Server 2008 or later.
+ */
+int lrlib_run_command(const char* command, double timeout_seconds, const char* output_prefix) {
+    lrlib_command_buffer stdout_buffer = {NULL, 0, 0};
+    lrlib_command_buffer stderr_buffer = {NULL, 0, 0};
+    char param_name[LRLIB_PARAM_NAME_BUFFER_LENGTH];
+    int exit_code;
+    int result;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if ( (command == NULL) || (strlen(command) == 0) ) {
+        lr_error_message("command cannot be NULL or empty.");
+        lr_abort();
+    } else if (timeout_seconds <= 0) {
+        lr_error_message("timeout_seconds must be greater than 0.");
+        lr_abort();
+    } else if ( (output_prefix == NULL) || (strlen(output_prefix) == 0) || (strlen(output_prefix) > LRLIB_MAX_PARAM_NAME_LENGTH - 10) ) {
+        lr_error_message("output_prefix cannot be NULL, empty, or longer than %d characters.", LRLIB_MAX_PARAM_NAME_LENGTH - 10);
+        lr_abort();
+    }
+
+    result = lrlib_run_process(command, timeout_seconds, &stdout_buffer, &stderr_buffer, NULL, &exit_code);
+
+    sprintf(param_name, "%s_stdout", output_prefix);
+    lr_save_var(stdout_buffer.data, stdout_buffer.length, 0, param_name);
+    lrlib_save_command_result(output_prefix, result, exit_code, &stderr_buffer);
+    free(stdout_buffer.data);
+    free(stderr_buffer.data);
+
+    // A command that timed out or failed to start is still profiled, as the time was spent.
+    LRLIB_PROFILE_END("lrlib_run_command", profile_start_usec, stdout_buffer.length);
+
+    if (result != LRLIB_COMMAND_EXITED) {
+        return -1;
+    }
+    return exit_code;
+}
+
+/**
+ * @brief Runs a program, and saves each line of its standard output to a parameter array as it
+ *        is read. This is useful for programs that write a lot of output, as the output does not
+ *        need to be kept as one large string.
+ *
+ * The lines are saved to {<prefix>_1}, {<prefix>_2}... and {<prefix>_count}, without their line
+ * endings. {<prefix>_stderr}, {<prefix>_exit_code} and {<prefix>_status} are saved as for
+ * lrlib_run_command.
+ *
+ * @param command The program and its arguments (see lrlib_run_command).
+ * @param timeout_seconds The program is killed if it is still running after this many seconds.
+ *        Lines that were read before it was killed are still saved.
+ * @param output_prefix The name of the parameter array to save the lines to.
+ * @return Returns the program's exit code, or -1 if it timed out, was killed, or could not be
+ *         started.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     int i;
+ *
+ *     lrlib_run_command_lines("/opt/tools/list-test-accounts --region emea", 60, "Account");
+ *     for (i = 1; i <= lr_paramarr_len("Account"); i++) {
+ *         lr_output_message("Account: %s", lr_paramarr_idx("Account", i));
+ *     }
+ *     return 0;
+ * }
+ *
+ * Note: On Linux, this function only works on 64-bit (x86-64) load generators. On Windows, it needs
+ * Windows Vista or Windows Server 2008 or later.
+ */
+int lrlib_run_command_lines(const char* command, double timeout_seconds, const char* output_prefix) {
+    lrlib_command_buffer stdout_buffer = {NULL, 0, 0};
+    lrlib_command_buffer stderr_buffer = {NULL, 0, 0};
+    lrlib_paramarr_emitter lines;
+    int exit_code;
+    int result;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if ( (command == NULL) || (strlen(command) == 0) ) {
+        lr_error_message("command cannot be NULL or empty.");
+        lr_abort();
+    } else if (timeout_seconds <= 0) {
+        lr_error_message("timeout_seconds must be greater than 0.");
+        lr_abort();
+    } else if ( (output_prefix == NULL) || (strlen(output_prefix) == 0) || (strlen(output_prefix) > LRLIB_MAX_PARAM_NAME_LENGTH - 10) ) {
+        lr_error_message("output_prefix cannot be NULL, empty, or longer than %d characters.", LRLIB_MAX_PARAM_NAME_LENGTH - 10);
+        lr_abort();
+    }
+
+    lrlib_paramarr_emitter_init(&lines, output_prefix);
+    result = lrlib_run_process(command, timeout_seconds, &stdout_buffer, &stderr_buffer, &lines, &exit_code);
+    lrlib_command_emit_lines(&stdout_buffer, &lines, TRUE);
+    lrlib_paramarr_emitter_finish(&lines);
+
+    lrlib_save_command_result(output_prefix, result, exit_code, &stderr_buffer);
+    free(stdout_buffer.data);
+    free(stderr_buffer.data);
+
+    LRLIB_PROFILE_END("lrlib_run_command_lines", profile_start_usec, 0);
+    if (result != LRLIB_COMMAND_EXITED) {
+        return -1;
+    }
+    return exit_code;
 }
 
 // TODO list of functions
 // ======================
-// * popen wrapper function
-// * check PDF function
-// * SHA256 function
-// * check if a port is open
-// * calendar/date functions
-// * lrlib_kill_all_mmdrv
-//   see: http://msdn.microsoft.com/en-us/library/windows/desktop/ms684847(v=vs.85).aspx (EnumProcesses, GetProcessId, TerminateProcess)
 // * Add debug trace logging to functions with lr_debug_message(LR_MSG_CLASS_FULL_TRACE, "message");
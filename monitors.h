@@ -7,6 +7,26 @@
 // * AWS counters (using the web API)
 
 
+/*
+ * Windows performance counters
+ * ============================
+ * These functions read counters with the Windows Performance Data Helper (PDH) library, and are
+ * only compiled on Windows. The other sections of this file keep their platform-specific code
+ * between "#ifdef LRLIB_LINUX" and "#endif" in the same way, so that a script only needs the
+ * functions of the platform it runs on in order to compile and link.
+ */
+
+#ifndef LRLIB_LINUX
+
+/**
+ * @brief Gets the names of all the performance objects (e.g. "Processor", "Memory") on this
+ *        machine, and saves them to a parameter array.
+ *
+ * Note: This function only works on Windows.
+ *
+ * @param outputParamArr The name of the parameter array to save the object names to.
+ * @return Returns the number of objects, or -1 if there was an error.
+ */
 int lrlib_get_perfmon_counter_list(const char* outputParamArr)
 {
     if (outputParamArr == NULL)
@@ -46,7 +66,7 @@ int lrlib_get_perfmon_counter_list(const char* outputParamArr)
 
             {
                 const char* current;
-                char parameterName[LRLIB_PARAM_NAME_BUFFER_LENGTH];
+                lrlib_paramarr_emitter emitter;
 
                 const PDH_STATUS status = PdhEnumObjectsA(NULL, NULL, buffer, &size, PERF_DETAIL_WIZARD, FALSE);
                 if (status != ERROR_SUCCESS)
@@ -56,22 +76,23 @@ int lrlib_get_perfmon_counter_list(const char* outputParamArr)
                     return -1;
                 }
 
+                if (lrlib_paramarr_emitter_init(&emitter, outputParamArr) == FALSE)
+                {
+                    lr_abort();
+                }
+
                 current = buffer;
-                count = 0;
                 while (*current != '\0')
                 {
                     const unsigned int length = strlen(current);
-                    count++;
 
-                    sprintf(parameterName, "%s_%u", outputParamArr, count);
                     //lr_output_message("%s", current);
-                    lr_save_string(current, parameterName);
+                    lrlib_paramarr_emitter_save(&emitter, current);
 
                     current += length + 1;
                 }
 
-                sprintf(parameterName, "%s_count", outputParamArr);
-                lr_save_int(count, parameterName);
+                count = lrlib_paramarr_emitter_finish(&emitter);
             }
 
             free(buffer);
@@ -80,6 +101,17 @@ int lrlib_get_perfmon_counter_list(const char* outputParamArr)
     }
 }
 
+/**
+ * @brief Gets the counters (e.g. "% Processor Time") and instances (e.g. "_Total", "0") of a
+ *        performance object, and saves them to two parameter arrays.
+ *
+ * Note: This function only works on Windows.
+ *
+ * @param objectName The performance object, e.g. "Processor".
+ * @param itemOutputParamArr The name of the parameter array to save the counter names to.
+ * @param instanceOutputParamArr The name of the parameter array to save the instance names to.
+ * @return Returns TRUE (1) on success, otherwise returns FALSE (0).
+ */
 int lrlib_get_perfmon_counter_item_list(const char* objectName, const char* itemOutputParamArr, const char* instanceOutputParamArr)
 {
     if (itemOutputParamArr == NULL || instanceOutputParamArr == NULL)
@@ -152,41 +184,42 @@ int lrlib_get_perfmon_counter_item_list(const char* objectName, const char* item
 
                 if (counterListLength > 0)
                 {
-                    char parameterName[LRLIB_PARAM_NAME_BUFFER_LENGTH];
-                    int count = 0;
+                    lrlib_paramarr_emitter emitter;
                     const char* current;
+
+                    if (lrlib_paramarr_emitter_init(&emitter, itemOutputParamArr) == FALSE)
+                    {
+                        lr_abort();
+                    }
                     for (current = counterList; *current != '\0'; current += strlen(current) + 1)
                     {
-                        count++;
-
-                        sprintf(parameterName, "%s_%u", itemOutputParamArr, count);
                         //lr_output_message("%s", current);
-                        lr_save_string(current, parameterName);
+                        lrlib_paramarr_emitter_save(&emitter, current);
                     }
 
-                    sprintf(parameterName, "%s_count", itemOutputParamArr);
-                    lr_save_int(count, parameterName);
+                    lrlib_paramarr_emitter_finish(&emitter);
                 }
 
                 if (instanceListLength > 0)
                 {
-                    char parameterName[LRLIB_PARAM_NAME_BUFFER_LENGTH];
+                    lrlib_paramarr_emitter emitter;
                     const char* current = instanceList;
-                    int count = 0;
+
+                    if (lrlib_paramarr_emitter_init(&emitter, instanceOutputParamArr) == FALSE)
+                    {
+                        lr_abort();
+                    }
                     while (*current != '\0')
                     {
                         const unsigned int length = strlen(current);
-                        count++;
 
-                        sprintf(parameterName, "%s_%u", instanceOutputParamArr, count);
                         //lr_output_message("%s", current);
-                        lr_save_string(current, parameterName);
+                        lrlib_paramarr_emitter_save(&emitter, current);
 
                         current += length + 1;
                     }
 
-                    sprintf(parameterName, "%s_count", instanceOutputParamArr);
-                    lr_save_int(count, parameterName);
+                    lrlib_paramarr_emitter_finish(&emitter);
                 }
 
                 lrlib_safe_free_and_null((void**)&counterList);
@@ -198,6 +231,19 @@ int lrlib_get_perfmon_counter_item_list(const char* objectName, const char* item
     return TRUE;
 }
 
+/**
+ * @brief Collects a number of samples of a performance counter, and saves them to a parameter
+ *        array. The vuser waits while the samples are collected.
+ *
+ * Note: This function only works on Windows.
+ *
+ * @param fullCounterPath The counter path, e.g. "\\Processor(_Total)\\% Processor Time".
+ * @param maxSampleCount The number of samples to collect.
+ * @param intervalInMsec The time between samples, in milliseconds.
+ * @param counterFormat PDH_FMT_DOUBLE or PDH_FMT_LONG.
+ * @param outputParamArr The name of the parameter array to save the samples to.
+ * @return Returns TRUE (1) on success, otherwise returns FALSE (0).
+ */
 int lrlib_get_perfmon_counter_value(
     const char* fullCounterPath,
     const DWORD maxSampleCount,
@@ -242,8 +288,7 @@ int lrlib_get_perfmon_counter_value(
             PDH_STATUS addCounterStatus;
             PDH_STATUS initialCollectStatus;
             unsigned long index;
-            int count = 0;
-            char parameterName[LRLIB_PARAM_NAME_BUFFER_LENGTH];
+            lrlib_paramarr_emitter emitter;
 
             openQueryStatus = PdhOpenQueryA(NULL, 0, &queryHandle);
             if (openQueryStatus != ERROR_SUCCESS)
@@ -269,6 +314,11 @@ int lrlib_get_perfmon_counter_value(
                 goto CleanUp;
             }
 
+            if (lrlib_paramarr_emitter_init(&emitter, outputParamArr) == FALSE)
+            {
+                lr_abort();
+            }
+
             for (index = 0; index < maxSampleCount; index++)
             {
                 Sleep(intervalInMsec);
@@ -303,9 +353,6 @@ int lrlib_get_perfmon_counter_value(
                         goto CleanUp;
                     }
 
-                    count++;
-                    sprintf(parameterName, "%s_%u", outputParamArr, count);
-
                     if ((counterFormat & PDH_FMT_DOUBLE) == PDH_FMT_DOUBLE)
                     {
                         sprintf(current, "%.20g", itemBuffer.u.doubleValue);
@@ -325,12 +372,11 @@ int lrlib_get_perfmon_counter_value(
                         goto CleanUp;
                     }
 
-                    lr_save_string(current, parameterName);
+                    lrlib_paramarr_emitter_save(&emitter, current);
                 }
             }
 
-            sprintf(parameterName, "%s_count", outputParamArr);
-            lr_save_int(count, parameterName);
+            lrlib_paramarr_emitter_finish(&emitter);
         }
 
     CleanUp:
@@ -342,3 +388,2419 @@ int lrlib_get_perfmon_counter_value(
         return result;
     }
 }
+
+#endif
+
+/*
+ * Background counter sampler
+ * ==========================
+ * lrlib_get_perfmon_counter_value blocks the vuser while it collects its samples. The
+ * lrlib_counter_sampler_* functions collect samples on a separate thread instead, at a fixed
+ * interval, and store them in a ring buffer. The vuser can read the latest sample (or the last N
+ * samples) at any time without waiting.
+ *
+ * There is one backend for each platform. Only the backend for the platform that the script runs
+ * on is compiled, and starting a sampler with the other backend is an error.
+ * * LRLIB_SAMPLER_BACKEND_PDH reads a Windows performance counter, using the same counter paths
+ *   as lrlib_get_perfmon_counter_value (e.g. "\\Processor(_Total)\\% Processor Time").
+ *   Windows only.
+ * * LRLIB_SAMPLER_BACKEND_PROC reads a number from a file under /proc (or /sys). The counter path
+ *   is the file name and a field number, optionally with the first field of the line to read:
+ *       "/proc/loadavg 1"                  1st field of the first line (1 minute load average)
+ *       "/proc/meminfo MemAvailable: 2"    2nd field of the line starting with "MemAvailable:"
+ *   Linux only.
+ *
+ * The sampler thread must not call any lr_* functions (they are not thread-safe), so errors on
+ * the sampler thread are only recorded in the sampler, and reported by the read functions.
+ */
+
+#define LRLIB_SAMPLER_BACKEND_PDH 0
+#define LRLIB_SAMPLER_BACKEND_PROC 1
+
+#define LRLIB_MAX_SAMPLERS 8
+#define LRLIB_MAX_COUNTER_PATH_LENGTH 512
+#define LRLIB_PROC_BUFFER_SIZE 65536
+
+// Every field is volatile, so that the compiler keeps the reads and writes of the fields in the
+// order they appear in the code (see lrlib_sampler_run and lrlib_sampler_read_slot).
+typedef struct
+{
+    volatile unsigned int sequence;      // Odd while the slot is being written (see lrlib_sampler_read_slot)
+    volatile unsigned int sampleNumber;  // Which sample is in the slot (the slot is reused every "capacity" samples)
+    volatile double timestampMsec;       // Milliseconds since the sampler was started
+    volatile double value;
+} lrlib_sampler_slot;
+
+typedef struct
+{
+    int inUse;
+    char counterPath[LRLIB_MAX_COUNTER_PATH_LENGTH];
+    unsigned int intervalInMsec;
+    double startTimeMsec;
+
+    // Ring buffer. Only the sampler thread writes to it; writeCount is only increased after a
+    // slot has been completely written.
+    lrlib_sampler_slot* slots;
+    unsigned int capacity;
+    volatile unsigned int writeCount;
+    unsigned int publishedCount;     // Samples already sent to lr_user_data_point
+
+    volatile int stopRequested;
+    volatile int errorCode;          // Set by the sampler thread if collection fails
+
+    unsigned long threadHandle;      // Windows thread HANDLE, or Linux pthread_t
+
+#ifdef LRLIB_LINUX
+    // /proc backend
+    int fileDescriptor;
+    char lineKey[64];                // Empty to read the first line
+    int fieldNumber;
+    char* fileBuffer;
+#else
+    // PDH backend
+    PDH_HQUERY queryHandle;
+    PDH_HCOUNTER counterHandle;
+#endif
+} lrlib_sampler;
+
+lrlib_sampler lrlib_samplers[LRLIB_MAX_SAMPLERS];
+
+/**
+ * @brief Finds a number in the text of a /proc file.
+ *
+ * @param text The contents of the file (null-terminated).
+ * @param lineKey The first field of the line to read, or an empty string to read the first line.
+ * @param fieldNumber The field to read (the first field on the line is 1). Fields are separated
+ *        by spaces or tabs.
+ * @param value Receives the number.
+ * @return Returns TRUE (1) if the field was found and is a number, otherwise returns FALSE (0).
+ */
+int lrlib_proc_parse_field(const char* text, const char* lineKey, const int fieldNumber, double* value)
+{
+    const char* line = text;
+    const int keyLength = strlen(lineKey);
+
+    // Find the line that starts with the key (followed by a space or tab). Leading spaces are
+    // ignored, as /proc/net/dev indents its interface names.
+    if (keyLength > 0)
+    {
+        while (*line != '\0')
+        {
+            const char* start = line;
+            while (*start == ' ' || *start == '\t')
+            {
+                start++;
+            }
+            if (strncmp(start, lineKey, keyLength) == 0 && (start[keyLength] == ' ' || start[keyLength] == '\t'))
+            {
+                line = start;
+                break;
+            }
+
+            while (*line != '\0' && *line != '\n')
+            {
+                line++;
+            }
+            if (*line == '\n')
+            {
+                line++;
+            }
+        }
+
+        if (*line == '\0')
+        {
+            return FALSE;
+        }
+    }
+
+    // Skip to the start of the requested field, then copy it so that it can be converted.
+    {
+        const char* current = line;
+        int field = 0;
+        char fieldText[64];
+        int length = 0;
+
+        while (*current != '\0' && *current != '\n')
+        {
+            while (*current == ' ' || *current == '\t')
+            {
+                current++;
+            }
+            if (*current == '\0' || *current == '\n')
+            {
+                break;
+            }
+
+            field++;
+            if (field == fieldNumber)
+            {
+                while (*current != '\0' && *current != '\n' && *current != ' ' && *current != '\t' && length < (int)sizeof(fieldText) - 1)
+                {
+                    fieldText[length] = *current;
+                    length++;
+                    current++;
+                }
+                fieldText[length] = '\0';
+
+                return lrlib_parse_double(fieldText, value);
+            }
+
+            while (*current != '\0' && *current != '\n' && *current != ' ' && *current != '\t')
+            {
+                current++;
+            }
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Gets the current time in milliseconds from a clock that is not affected by changes to
+ *        the system time. Safe to call from the sampler thread.
+ */
+double lrlib_sampler_now_msec()
+{
+#ifdef LRLIB_LINUX
+    // struct timespec on 64-bit Linux
+    struct
+    {
+        long seconds;
+        long nanoseconds;
+    } now;
+
+    clock_gettime(1, &now);  // 1 = CLOCK_MONOTONIC
+    return (now.seconds * 1000.0) + (now.nanoseconds / 1000000.0);
+#else
+    // GetTickCount wraps around after 49.7 days; sampler timestamps are only used for short
+    // differences, so this does not matter.
+    return (double)(unsigned long)GetTickCount();
+#endif
+}
+
+/**
+ * @brief Pauses the calling thread. Safe to call from the sampler thread.
+ */
+void lrlib_sampler_sleep_msec(const double durationInMsec)
+{
+    if (durationInMsec <= 0)
+    {
+        return;
+    }
+
+#ifdef LRLIB_LINUX
+    usleep((unsigned long)(durationInMsec * 1000));
+#else
+    Sleep((unsigned long)durationInMsec);
+#endif
+}
+
+/**
+ * @brief Collects one sample. Safe to call from the sampler thread.
+ *
+ * @return Returns 0 if the sample was collected, otherwise returns an error code (a PDH status, or
+ *         -1 if the /proc file could not be read or parsed).
+ */
+long lrlib_sampler_collect(lrlib_sampler* sampler, double* value)
+{
+#ifdef LRLIB_LINUX
+    // The file stays open; pread reads it again from the start, which makes the kernel generate
+    // fresh contents.
+    const long bytesRead = pread(sampler->fileDescriptor, sampler->fileBuffer, LRLIB_PROC_BUFFER_SIZE - 1, 0);
+    if (bytesRead <= 0)
+    {
+        return -1;
+    }
+    sampler->fileBuffer[bytesRead] = '\0';
+
+    if (!lrlib_proc_parse_field(sampler->fileBuffer, sampler->lineKey, sampler->fieldNumber, value))
+    {
+        return -1;
+    }
+
+    return 0;
+#else
+    PDH_FMT_COUNTERVALUE itemBuffer = { 0 };
+
+    const PDH_STATUS collectStatus = PdhCollectQueryData(sampler->queryHandle);
+    if (collectStatus != ERROR_SUCCESS)
+    {
+        return collectStatus;
+    }
+
+    {
+        const PDH_STATUS getValueStatus = PdhGetFormattedCounterValue(
+            sampler->counterHandle,
+            PDH_FMT_DOUBLE,
+            (LPDWORD)NULL,
+            &itemBuffer);
+        if (getValueStatus != ERROR_SUCCESS)
+        {
+            return getValueStatus;
+        }
+    }
+
+    *value = itemBuffer.u.doubleValue;
+    return 0;
+#endif
+}
+
+/**
+ * @brief The main loop of the sampler thread.
+ *
+ * Each sample is due at a fixed time (start time + n * interval), so time spent collecting a
+ * sample does not make the following samples drift later.
+ */
+void lrlib_sampler_run(lrlib_sampler* sampler)
+{
+    double nextSampleTime = sampler->startTimeMsec + sampler->intervalInMsec;
+
+    while (!sampler->stopRequested)
+    {
+        double value;
+        long error;
+
+        // Sleep in steps of at most 100 ms, so that a stop request is noticed quickly.
+        {
+            double now = lrlib_sampler_now_msec();
+            while (now < nextSampleTime && !sampler->stopRequested)
+            {
+                double remaining = nextSampleTime - now;
+                if (remaining > 100)
+                {
+                    remaining = 100;
+                }
+                lrlib_sampler_sleep_msec(remaining);
+                now = lrlib_sampler_now_msec();
+            }
+        }
+
+        if (sampler->stopRequested)
+        {
+            break;
+        }
+
+        error = lrlib_sampler_collect(sampler, &value);
+        if (error != 0)
+        {
+            sampler->errorCode = error;
+            break;
+        }
+
+        // Write the slot. The sequence number is odd while the slot is being written, so that a
+        // reader can tell if it has read a half-written slot. This only works if the other fields
+        // are written after the first increment and before the second one:
+        // * the fields are all volatile, so the compiler cannot move the writes past each other.
+        // * x86 and x64 processors (which LoadRunner runs on) never make one store visible to
+        //   another thread before an earlier store, or perform one load before an earlier load.
+        {
+            lrlib_sampler_slot* slot = &sampler->slots[sampler->writeCount % sampler->capacity];
+            slot->sequence++;
+            slot->sampleNumber = sampler->writeCount;
+            slot->timestampMsec = lrlib_sampler_now_msec() - sampler->startTimeMsec;
+            slot->value = value;
+            slot->sequence++;
+            sampler->writeCount++;
+        }
+
+        nextSampleTime += sampler->intervalInMsec;
+    }
+}
+
+#ifdef LRLIB_LINUX
+
+/**
+ * @brief Sampler thread entry point on Linux.
+ */
+void* lrlib_sampler_linux_thread(void* parameter)
+{
+    lrlib_sampler_run((lrlib_sampler*)parameter);
+    return NULL;
+}
+
+#else
+
+/**
+ * @brief Sampler thread entry point on Windows.
+ *
+ * Windows thread functions use the __stdcall calling convention, but functions in a script use
+ * __cdecl. To avoid any problem when the function returns, the thread ends by calling ExitThread
+ * instead of returning.
+ */
+unsigned long lrlib_sampler_windows_thread(void* parameter)
+{
+    lrlib_sampler_run((lrlib_sampler*)parameter);
+    ExitThread(0);
+    return 0;
+}
+
+#endif
+
+/**
+ * @brief Releases everything held by a sampler (after its thread has stopped).
+ */
+void lrlib_sampler_release(lrlib_sampler* sampler)
+{
+#ifdef LRLIB_LINUX
+    if (sampler->fileDescriptor >= 0)
+    {
+        close(sampler->fileDescriptor);
+        sampler->fileDescriptor = -1;
+    }
+
+    lrlib_safe_free_and_null((void**)&sampler->fileBuffer);
+#else
+    if (sampler->queryHandle)
+    {
+        PdhCloseQuery(sampler->queryHandle);
+        sampler->queryHandle = 0;
+    }
+#endif
+
+    lrlib_safe_free_and_null((void**)&sampler->slots);
+    sampler->inUse = FALSE;
+}
+
+/**
+ * @brief Gets a running sampler from its ID, or writes an error message if the ID is invalid.
+ */
+lrlib_sampler* lrlib_get_sampler(const int samplerId)
+{
+    if (samplerId < 1 || samplerId > LRLIB_MAX_SAMPLERS || !lrlib_samplers[samplerId - 1].inUse)
+    {
+        lr_error_message("Invalid sampler ID %d.", samplerId);
+        return NULL;
+    }
+
+    return &lrlib_samplers[samplerId - 1];
+}
+
+/**
+ * @brief Starts collecting samples of a counter on a background thread.
+ *
+ * @param backend LRLIB_SAMPLER_BACKEND_PDH (a Windows performance counter, Windows only) or
+ *        LRLIB_SAMPLER_BACKEND_PROC (a number from a /proc file, Linux only).
+ * @param counterPath The counter to sample (see the description of the backends above).
+ * @param intervalInMsec The time between samples, in milliseconds.
+ * @param capacity The number of samples to keep. When the ring buffer is full, the oldest sample
+ *        is overwritten.
+ * @return Returns the ID of the new sampler (1 or more), or 0 if the sampler could not be started.
+ *
+ * @example
+ *
+ * vuser_init()
+ * {
+ *     // Sample CPU utilisation every second in the background, keeping the last 5 minutes.
+ *     cpu_sampler = lrlib_counter_sampler_start(LRLIB_SAMPLER_BACKEND_PDH,
+ *         "\\Processor(_Total)\\% Processor Time", 1000, 300);
+ *     return 0;
+ * }
+ *
+ * Action()
+ * {
+ *     // ... business process ...
+ *
+ *     // Send the samples collected during this iteration to the Analysis graphs.
+ *     lrlib_counter_sampler_publish(cpu_sampler, "cpu_utilisation");
+ *     return 0;
+ * }
+ *
+ * vuser_end()
+ * {
+ *     lrlib_counter_sampler_stop(cpu_sampler);
+ *     return 0;
+ * }
+ *
+ * @note Each vuser can run up to 8 samplers. Always stop a sampler (e.g. in vuser_end) before the
+ *       vuser finishes.
+ */
+int lrlib_counter_sampler_start(const int backend, const char* counterPath, const unsigned int intervalInMsec, const unsigned int capacity)
+{
+    lrlib_sampler* sampler = NULL;
+    int samplerId;
+    double profileStartInUsec = 0;
+
+    LRLIB_PROFILE_START(profileStartInUsec);
+
+#ifdef LRLIB_LINUX
+    if (backend != LRLIB_SAMPLER_BACKEND_PROC)
+    {
+        lr_error_message("Sampler backend %d is not available on Linux. Use LRLIB_SAMPLER_BACKEND_PROC.", backend);
+        return 0;
+    }
+#else
+    if (backend != LRLIB_SAMPLER_BACKEND_PDH)
+    {
+        lr_error_message("Sampler backend %d is not available on Windows. Use LRLIB_SAMPLER_BACKEND_PDH.", backend);
+        return 0;
+    }
+#endif
+
+    if (counterPath == NULL || strlen(counterPath) == 0 || strlen(counterPath) >= LRLIB_MAX_COUNTER_PATH_LENGTH)
+    {
+        lr_error_message("Counter path cannot be NULL, empty or longer than %d characters.", LRLIB_MAX_COUNTER_PATH_LENGTH - 1);
+        return 0;
+    }
+
+    if (intervalInMsec == 0 || capacity == 0)
+    {
+        lr_error_message("Sample interval and capacity must be greater than 0.");
+        return 0;
+    }
+
+    for (samplerId = 1; samplerId <= LRLIB_MAX_SAMPLERS; samplerId++)
+    {
+        if (!lrlib_samplers[samplerId - 1].inUse)
+        {
+            sampler = &lrlib_samplers[samplerId - 1];
+            break;
+        }
+    }
+
+    if (sampler == NULL)
+    {
+        lr_error_message("Too many samplers (the maximum is %d).", LRLIB_MAX_SAMPLERS);
+        return 0;
+    }
+
+    memset(sampler, 0, sizeof(lrlib_sampler));
+    sampler->inUse = TRUE;
+#ifdef LRLIB_LINUX
+    sampler->fileDescriptor = -1;
+#endif
+    sampler->intervalInMsec = intervalInMsec;
+    sampler->capacity = capacity;
+    strcpy(sampler->counterPath, counterPath);
+
+    sampler->slots = (lrlib_sampler_slot*)calloc(capacity, sizeof(lrlib_sampler_slot));
+    if (sampler->slots == NULL)
+    {
+        lr_error_message("Error allocating memory for %u samples.", capacity);
+        lrlib_sampler_release(sampler);
+        return 0;
+    }
+
+    // Open the counter on the vuser thread, so that any problem can be reported straight away.
+#ifdef LRLIB_LINUX
+    {
+        char fileName[LRLIB_MAX_COUNTER_PATH_LENGTH];
+        char secondField[LRLIB_MAX_COUNTER_PATH_LENGTH];
+        char thirdField[LRLIB_MAX_COUNTER_PATH_LENGTH];
+        double value;
+
+        lrlib_load_dll("libpthread.so.0");
+
+        // The counter path is "file field" or "file key field".
+        thirdField[0] = '\0';
+        if (sscanf(counterPath, "%s %s %s", fileName, secondField, thirdField) < 2)
+        {
+            lr_error_message("Invalid /proc counter path '%s'. Use \"file field\" or \"file key field\".", counterPath);
+            lrlib_sampler_release(sampler);
+            return 0;
+        }
+
+        if (thirdField[0] == '\0')
+        {
+            sampler->fieldNumber = atoi(secondField);
+        }
+        else
+        {
+            if (strlen(secondField) >= sizeof(sampler->lineKey))
+            {
+                lr_error_message("Line key '%s' is too long.", secondField);
+                lrlib_sampler_release(sampler);
+                return 0;
+            }
+            strcpy(sampler->lineKey, secondField);
+            sampler->fieldNumber = atoi(thirdField);
+        }
+
+        if (sampler->fieldNumber < 1)
+        {
+            lr_error_message("Invalid field number in counter path '%s' (the first field is 1).", counterPath);
+            lrlib_sampler_release(sampler);
+            return 0;
+        }
+
+        sampler->fileBuffer = (char*)malloc(LRLIB_PROC_BUFFER_SIZE);
+        if (sampler->fileBuffer == NULL)
+        {
+            lr_error_message("Error allocating memory.");
+            lrlib_sampler_release(sampler);
+            return 0;
+        }
+
+        sampler->fileDescriptor = open(fileName, 0);  // 0 = O_RDONLY
+        if (sampler->fileDescriptor < 0)
+        {
+            lr_error_message("Cannot open '%s'.", fileName);
+            lrlib_sampler_release(sampler);
+            return 0;
+        }
+
+        // Check that the counter can be read before starting the thread.
+        if (lrlib_sampler_collect(sampler, &value) != 0)
+        {
+            lr_error_message("Cannot read field %d of '%s'.", sampler->fieldNumber, counterPath);
+            lrlib_sampler_release(sampler);
+            return 0;
+        }
+    }
+#else
+    {
+        PDH_STATUS status;
+
+        lrlib_load_dll("kernel32.dll");
+        lrlib_load_dll("pdh.dll");
+
+        status = PdhOpenQueryA(NULL, 0, &sampler->queryHandle);
+        if (status != ERROR_SUCCESS)
+        {
+            lr_error_message("Cannot open PDH query (error 0x%08X).", status);
+            lrlib_sampler_release(sampler);
+            return 0;
+        }
+
+        status = PdhAddCounterA(sampler->queryHandle, counterPath, 0, &sampler->counterHandle);
+        if (status != ERROR_SUCCESS)
+        {
+            lr_error_message("Cannot add PDH counter '%s' (error 0x%08X).", counterPath, status);
+            lrlib_sampler_release(sampler);
+            return 0;
+        }
+
+        // Rate counters (like % Processor Time) need two collections before they have a value.
+        status = PdhCollectQueryData(sampler->queryHandle);
+        if (status != ERROR_SUCCESS && status != PDH_NO_MORE_DATA)
+        {
+            lr_error_message("Error collecting data (error 0x%08X).", status);
+            lrlib_sampler_release(sampler);
+            return 0;
+        }
+    }
+#endif
+
+    sampler->startTimeMsec = lrlib_sampler_now_msec();
+
+#ifdef LRLIB_LINUX
+    {
+        const int createResult = pthread_create(&sampler->threadHandle, NULL, lrlib_sampler_linux_thread, sampler);
+        if (createResult != 0)
+        {
+            lr_error_message("Error creating sampler thread (error %d).", createResult);
+            lrlib_sampler_release(sampler);
+            return 0;
+        }
+    }
+#else
+    {
+        unsigned long threadId;
+        sampler->threadHandle = CreateThread(NULL, 0, lrlib_sampler_windows_thread, sampler, 0, &threadId);
+        if (sampler->threadHandle == 0)
+        {
+            lr_error_message("Error creating sampler thread.");
+            lrlib_sampler_release(sampler);
+            return 0;
+        }
+    }
+#endif
+
+    LRLIB_PROFILE_END("lrlib_counter_sampler_start", profileStartInUsec, 0);
+    return samplerId;
+}
+
+/**
+ * @brief Stops a sampler, waits for its thread to finish, and releases its resources.
+ *
+ * @param samplerId The ID returned by lrlib_counter_sampler_start.
+ * @return Returns TRUE (1) if the sampler was stopped, otherwise returns FALSE (0).
+ */
+int lrlib_counter_sampler_stop(const int samplerId)
+{
+    lrlib_sampler* sampler = lrlib_get_sampler(samplerId);
+    double profileStartInUsec = 0;
+
+    LRLIB_PROFILE_START(profileStartInUsec);
+
+    if (sampler == NULL)
+    {
+        return FALSE;
+    }
+
+    sampler->stopRequested = TRUE;
+
+#ifdef LRLIB_LINUX
+    pthread_join(sampler->threadHandle, NULL);
+#else
+    WaitForSingleObject(sampler->threadHandle, INFINITE);
+    CloseHandle(sampler->threadHandle);
+#endif
+
+    lrlib_sampler_release(sampler);
+    LRLIB_PROFILE_END("lrlib_counter_sampler_stop", profileStartInUsec, 0);
+    return TRUE;
+}
+
+/**
+ * @brief Reads one slot of the ring buffer, retrying if the sampler thread was writing it at the
+ *        same time.
+ *
+ * @return Returns TRUE (1) if the slot was read, or FALSE (0) if it was overwritten while it was
+ *         being read (i.e. the reader is too far behind).
+ */
+int lrlib_sampler_read_slot(lrlib_sampler* sampler, const unsigned int sampleNumber, lrlib_sampler_slot* result)
+{
+    const lrlib_sampler_slot* slot = &sampler->slots[sampleNumber % sampler->capacity];
+    int attempt;
+
+    // The slot is read between two reads of its sequence number. If the number is odd, or has
+    // changed, the sampler thread was writing the slot, so the values might be a mix of two
+    // samples and are read again.
+    for (attempt = 0; attempt < 100; attempt++)
+    {
+        const unsigned int sequenceBefore = slot->sequence;
+        if ((sequenceBefore & 1) == 0)
+        {
+            result->sampleNumber = slot->sampleNumber;
+            result->timestampMsec = slot->timestampMsec;
+            result->value = slot->value;
+            if (slot->sequence == sequenceBefore)
+            {
+                // The slot might have been reused for a newer sample since sampleNumber was chosen.
+                if (result->sampleNumber != sampleNumber)
+                {
+                    return FALSE;
+                }
+                return TRUE;
+            }
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Reports an error from the sampler thread (once), so that it is not silently ignored.
+ */
+void lrlib_sampler_check_error(lrlib_sampler* sampler)
+{
+    if (sampler->errorCode != 0)
+    {
+        lr_error_message("Sampler for '%s' stopped collecting samples (error 0x%08X).", sampler->counterPath, sampler->errorCode);
+        sampler->errorCode = 0;
+    }
+}
+
+/**
+ * @brief Saves the most recent sample to a parameter. This function does not wait for a new
+ *        sample.
+ *
+ * @param samplerId The ID returned by lrlib_counter_sampler_start.
+ * @param outputParam The name of the parameter to save the value to.
+ * @return Returns TRUE (1) if a sample was saved, or FALSE (0) if no sample has been collected yet.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     if (lrlib_counter_sampler_read_latest(cpu_sampler, "Cpu")) {
+ *         lr_output_message("CPU utilisation: %s%%", lr_eval_string("{Cpu}"));
+ *     }
+ *     return 0;
+ * }
+ */
+int lrlib_counter_sampler_read_latest(const int samplerId, const char* outputParam)
+{
+    lrlib_sampler* sampler = lrlib_get_sampler(samplerId);
+    lrlib_sampler_slot sample;
+    unsigned int writeCount;
+    char current[64];
+    double profileStartInUsec = 0;
+
+    LRLIB_PROFILE_START(profileStartInUsec);
+
+    if (sampler == NULL)
+    {
+        return FALSE;
+    }
+
+    if (outputParam == NULL)
+    {
+        lr_error_message("Output parameter name cannot be NULL.");
+        return FALSE;
+    }
+
+    lrlib_sampler_check_error(sampler);
+
+    writeCount = sampler->writeCount;
+    if (writeCount == 0 || !lrlib_sampler_read_slot(sampler, writeCount - 1, &sample))
+    {
+        return FALSE;
+    }
+
+    sprintf(current, "%.20g", sample.value);
+    lr_save_string(current, outputParam);
+    LRLIB_PROFILE_END("lrlib_counter_sampler_read_latest", profileStartInUsec, 0);
+    return TRUE;
+}
+
+/**
+ * @brief Saves the most recent samples (oldest first) to a parameter array. This function does
+ *        not wait for new samples.
+ *
+ * @param samplerId The ID returned by lrlib_counter_sampler_start.
+ * @param maxSampleCount The maximum number of samples to save.
+ * @param outputParamArr The name of the parameter array to save the values to. The time of each
+ *        sample (milliseconds since the sampler was started) is saved to a second parameter
+ *        array, with "_time" added to the name.
+ * @return Returns the number of samples saved, or -1 if there was an error.
+ */
+int lrlib_counter_sampler_read_window(const int samplerId, const unsigned int maxSampleCount, const char* outputParamArr)
+{
+    lrlib_sampler* sampler = lrlib_get_sampler(samplerId);
+    lrlib_paramarr_emitter valueEmitter;
+    lrlib_paramarr_emitter timeEmitter;
+    char timeParamArr[LRLIB_PARAM_NAME_BUFFER_LENGTH];
+    unsigned int writeCount;
+    unsigned int sampleNumber;
+    unsigned int firstSample;
+    char current[64];
+    int result;
+    double profileStartInUsec = 0;
+
+    LRLIB_PROFILE_START(profileStartInUsec);
+
+    if (sampler == NULL)
+    {
+        return -1;
+    }
+
+    if (outputParamArr == NULL || strlen(outputParamArr) > LRLIB_MAX_PARAM_NAME_LENGTH - 5)
+    {
+        lr_error_message("Output parameter name cannot be NULL or longer than %d characters.", LRLIB_MAX_PARAM_NAME_LENGTH - 5);
+        return -1;
+    }
+
+    lrlib_sampler_check_error(sampler);
+
+    sprintf(timeParamArr, "%s_time", outputParamArr);
+    if (lrlib_paramarr_emitter_init(&valueEmitter, outputParamArr) == FALSE)
+    {
+        lr_abort();
+    }
+    if (lrlib_paramarr_emitter_init(&timeEmitter, timeParamArr) == FALSE)
+    {
+        lr_abort();
+    }
+
+    // Only the last "capacity" samples are still in the ring buffer.
+    writeCount = sampler->writeCount;
+    firstSample = 0;
+    if (writeCount > maxSampleCount)
+    {
+        firstSample = writeCount - maxSampleCount;
+    }
+    if (writeCount - firstSample > sampler->capacity)
+    {
+        firstSample = writeCount - sampler->capacity;
+    }
+
+    for (sampleNumber = firstSample; sampleNumber < writeCount; sampleNumber++)
+    {
+        lrlib_sampler_slot sample;
+        if (!lrlib_sampler_read_slot(sampler, sampleNumber, &sample))
+        {
+            continue;  // Overwritten while reading
+        }
+
+        sprintf(current, "%.20g", sample.value);
+        lrlib_paramarr_emitter_save(&valueEmitter, current);
+        sprintf(current, "%.0f", sample.timestampMsec);
+        lrlib_paramarr_emitter_save(&timeEmitter, current);
+    }
+
+    lrlib_paramarr_emitter_finish(&timeEmitter);
+    result = lrlib_paramarr_emitter_finish(&valueEmitter);
+    LRLIB_PROFILE_END("lrlib_counter_sampler_read_window", profileStartInUsec, 0);
+    return result;
+}
+
+/**
+ * @brief Sends every sample collected since the last call to lr_user_data_point, so that the
+ *        samples appear in LoadRunner Analysis.
+ *
+ * @param samplerId The ID returned by lrlib_counter_sampler_start.
+ * @param dataPointName The name of the data point.
+ * @return Returns the number of samples sent, or -1 if there was an error.
+ *
+ * @note If more samples were collected than the ring buffer can hold, the oldest ones are lost.
+ */
+int lrlib_counter_sampler_publish(const int samplerId, const char* dataPointName)
+{
+    lrlib_sampler* sampler = lrlib_get_sampler(samplerId);
+    unsigned int writeCount;
+    int count = 0;
+    double profileStartInUsec = 0;
+
+    LRLIB_PROFILE_START(profileStartInUsec);
+
+    if (sampler == NULL)
+    {
+        return -1;
+    }
+
+    if (dataPointName == NULL || strlen(dataPointName) == 0)
+    {
+        lr_error_message("Data point name cannot be NULL or empty.");
+        return -1;
+    }
+
+    lrlib_sampler_check_error(sampler);
+
+    writeCount = sampler->writeCount;
+    if (writeCount - sampler->publishedCount > sampler->capacity)
+    {
+        sampler->publishedCount = writeCount - sampler->capacity;
+    }
+
+    for (; sampler->publishedCount < writeCount; sampler->publishedCount++)
+    {
+        lrlib_sampler_slot sample;
+        if (lrlib_sampler_read_slot(sampler, sampler->publishedCount, &sample))
+        {
+            lr_user_data_point(dataPointName, sample.value);
+            count++;
+        }
+    }
+
+    LRLIB_PROFILE_END("lrlib_counter_sampler_publish", profileStartInUsec, 0);
+    return count;
+}
+
+/*
+ * Counter sets
+ * ============
+ * A counter set collects many counters at the same moment. All the counters are registered with
+ * lrlib_counter_set_add, then each call to lrlib_counter_set_collect reads every counter once and
+ * saves the values (with one shared timestamp) to a parameter array.
+ *
+ * The counters are read through a backend, which is a structure of function pointers. Three
+ * backends are included (only two of them on each platform), and you can write your own (e.g. to read counters from a web service) by
+ * filling in an lrlib_counter_backend structure with your own functions.
+ * * lrlib_counter_backend_pdh - Windows performance counters. All the counters are added to a
+ *   single PDH query, so they are collected with one PdhCollectQueryData call. Counter paths can
+ *   contain wildcards, e.g. "\\Processor(*)\\% Processor Time". Windows only.
+ * * lrlib_counter_backend_proc - numbers from Linux /proc and /sys files, using the same counter
+ *   paths as LRLIB_SAMPLER_BACKEND_PROC. Each file is read once per collection, no matter how many
+ *   counters come from it. Use "*" as the line key to add a counter for every line, e.g.
+ *   "/proc/net/dev * 2" for the bytes received by every network interface. Linux only.
+ * * lrlib_counter_backend_mock - each counter path is the name of a LoadRunner parameter, and the
+ *   counter value is the current value of that parameter. Useful for testing scripts that use
+ *   counter sets on any platform.
+ */
+
+#define LRLIB_MAX_COUNTER_SETS 4
+#define LRLIB_MAX_COUNTERS_PER_SET 256
+#define LRLIB_MAX_PROC_FILES_PER_SET 16
+
+typedef struct lrlib_counter_set lrlib_counter_set;
+
+typedef struct
+{
+    // Called once when the set is created. Returns TRUE (1) on success.
+    int (*open)(lrlib_counter_set* counterSet);
+
+    // Adds one counter path (expanding any wildcards) by calling lrlib_counter_set_append for
+    // each counter. Returns the number of counters added, or -1 if there was an error.
+    int (*add)(lrlib_counter_set* counterSet, const char* counterPath);
+
+    // Reads every counter into counterSet->counters[i].value (and .valid). Returns TRUE (1) on
+    // success.
+    int (*collect)(lrlib_counter_set* counterSet);
+
+    // Returns the current time in milliseconds (used to timestamp each collection).
+    double (*now_msec)(lrlib_counter_set* counterSet);
+
+    // Called once when the set is deleted.
+    void (*close)(lrlib_counter_set* counterSet);
+} lrlib_counter_backend;
+
+typedef struct
+{
+    char* name;              // The full counter path (after wildcard expansion)
+    double value;
+    int valid;               // FALSE if the value could not be read on the last collection
+    void* handle;            // PDH counter handle
+    int fileIndex;           // /proc backend: index into lrlib_counter_set.files
+    char lineKey[64];        // /proc backend: first field of the line (empty for the first line)
+    int fieldNumber;         // /proc backend: field to read (the first field is 1)
+} lrlib_counter;
+
+typedef struct
+{
+    char* path;
+    int fileDescriptor;
+    char* buffer;
+} lrlib_counter_file;
+
+struct lrlib_counter_set
+{
+    int inUse;
+    const lrlib_counter_backend* backend;
+    lrlib_counter counters[LRLIB_MAX_COUNTERS_PER_SET];
+    int counterCount;
+    int collectCount;        // The number of times the set has been collected
+
+#ifdef LRLIB_LINUX
+    lrlib_counter_file files[LRLIB_MAX_PROC_FILES_PER_SET];  // /proc backend
+    int fileCount;
+#else
+    PDH_HQUERY queryHandle;  // PDH backend
+#endif
+};
+
+lrlib_counter_set lrlib_counter_sets[LRLIB_MAX_COUNTER_SETS];
+
+/**
+ * @brief Adds a counter to a set. Backends call this from their "add" function.
+ *
+ * @return Returns a pointer to the new counter (so the backend can fill in its own fields), or
+ *         NULL if the set is full.
+ */
+lrlib_counter* lrlib_counter_set_append(lrlib_counter_set* counterSet, const char* name)
+{
+    lrlib_counter* counter;
+
+    if (counterSet->counterCount >= LRLIB_MAX_COUNTERS_PER_SET)
+    {
+        lr_error_message("Too many counters in the set (the maximum is %d).", LRLIB_MAX_COUNTERS_PER_SET);
+        return NULL;
+    }
+
+    counter = &counterSet->counters[counterSet->counterCount];
+    memset(counter, 0, sizeof(lrlib_counter));
+    counter->name = (char*)malloc(strlen(name) + 1);
+    if (counter->name == NULL)
+    {
+        lr_error_message("Error allocating memory.");
+        return NULL;
+    }
+    strcpy(counter->name, name);
+
+    counterSet->counterCount++;
+    return counter;
+}
+
+/* PDH backend (Windows only) */
+
+#ifndef LRLIB_LINUX
+
+int lrlib_counter_pdh_open(lrlib_counter_set* counterSet)
+{
+    PDH_STATUS status;
+
+    lrlib_load_dll("kernel32.dll");
+    lrlib_load_dll("pdh.dll");
+
+    status = PdhOpenQueryA(NULL, 0, &counterSet->queryHandle);
+    if (status != ERROR_SUCCESS)
+    {
+        lr_error_message("Cannot open PDH query (error 0x%08X).", status);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Removes the counters from firstCounter onwards (and their PDH counters) from a set. Used
+ *        to undo a call to lrlib_counter_pdh_add that failed part-way, so that the set is not left
+ *        with counters that have no valid handle.
+ */
+void lrlib_counter_pdh_remove_from(lrlib_counter_set* counterSet, const int firstCounter)
+{
+    while (counterSet->counterCount > firstCounter)
+    {
+        lrlib_counter* counter;
+
+        counterSet->counterCount--;
+        counter = &counterSet->counters[counterSet->counterCount];
+        if (counter->handle != NULL)
+        {
+            PdhRemoveCounter(counter->handle);
+            counter->handle = NULL;
+        }
+        lrlib_safe_free_and_null((void**)&counter->name);
+    }
+}
+
+int lrlib_counter_pdh_add(lrlib_counter_set* counterSet, const char* counterPath)
+{
+    unsigned long size = 0;
+    char* expandedPaths;
+    const char* current;
+    int count = 0;
+    const int firstCounter = counterSet->counterCount;  // where this call starts adding counters
+
+    // Expand any wildcards (e.g. "\\Processor(*)\\% Processor Time" becomes one path per
+    // processor). The result is a list of null-terminated strings, ending with an empty string.
+    PDH_STATUS status = PdhExpandWildCardPathA(NULL, counterPath, NULL, &size, 0);
+    if (status != PDH_MORE_DATA)
+    {
+        lr_error_message("Cannot expand counter path '%s' (error 0x%08X).", counterPath, status);
+        return -1;
+    }
+
+    size++;  // A reserve may be needed on some systems
+    expandedPaths = (char*)malloc(size);
+    if (expandedPaths == NULL)
+    {
+        lr_error_message("Error allocating memory (%u bytes).", size);
+        return -1;
+    }
+
+    status = PdhExpandWildCardPathA(NULL, counterPath, expandedPaths, &size, 0);
+    if (status != ERROR_SUCCESS)
+    {
+        free(expandedPaths);
+        lr_error_message("Cannot expand counter path '%s' (error 0x%08X).", counterPath, status);
+        return -1;
+    }
+
+    for (current = expandedPaths; *current != '\0'; current += strlen(current) + 1)
+    {
+        lrlib_counter* counter = lrlib_counter_set_append(counterSet, current);
+        if (counter == NULL)
+        {
+            free(expandedPaths);
+            lrlib_counter_pdh_remove_from(counterSet, firstCounter);
+            return -1;
+        }
+
+        status = PdhAddCounterA(counterSet->queryHandle, current, 0, &counter->handle);
+        if (status != ERROR_SUCCESS)
+        {
+            lr_error_message("Cannot add PDH counter '%s' (error 0x%08X).", current, status);
+            free(expandedPaths);
+            counter->handle = NULL;  // not a valid handle, so it must not be removed
+            lrlib_counter_pdh_remove_from(counterSet, firstCounter);
+            return -1;
+        }
+
+        count++;
+    }
+
+    free(expandedPaths);
+
+    // Rate counters (like % Processor Time) need two collections before they have a value, so
+    // collect once now.
+    PdhCollectQueryData(counterSet->queryHandle);
+
+    return count;
+}
+
+int lrlib_counter_pdh_collect(lrlib_counter_set* counterSet)
+{
+    int i;
+
+    const PDH_STATUS status = PdhCollectQueryData(counterSet->queryHandle);
+    if (status != ERROR_SUCCESS)
+    {
+        lr_error_message("Error collecting data (error 0x%08X).", status);
+        return FALSE;
+    }
+
+    for (i = 0; i < counterSet->counterCount; i++)
+    {
+        lrlib_counter* counter = &counterSet->counters[i];
+        PDH_FMT_COUNTERVALUE itemBuffer = { 0 };
+
+        const PDH_STATUS getValueStatus = PdhGetFormattedCounterValue(counter->handle, PDH_FMT_DOUBLE, (LPDWORD)NULL, &itemBuffer);
+        counter->valid = (getValueStatus == ERROR_SUCCESS);
+        counter->value = itemBuffer.u.doubleValue;
+    }
+
+    return TRUE;
+}
+
+double lrlib_counter_pdh_now_msec(lrlib_counter_set* counterSet)
+{
+    return lrlib_sampler_now_msec();
+}
+
+void lrlib_counter_pdh_close(lrlib_counter_set* counterSet)
+{
+    if (counterSet->queryHandle)
+    {
+        PdhCloseQuery(counterSet->queryHandle);
+        counterSet->queryHandle = 0;
+    }
+}
+
+const lrlib_counter_backend lrlib_counter_backend_pdh = {
+    lrlib_counter_pdh_open,
+    lrlib_counter_pdh_add,
+    lrlib_counter_pdh_collect,
+    lrlib_counter_pdh_now_msec,
+    lrlib_counter_pdh_close
+};
+
+#endif
+
+/* /proc backend (Linux only) */
+
+#ifdef LRLIB_LINUX
+
+int lrlib_counter_proc_open(lrlib_counter_set* counterSet)
+{
+    counterSet->fileCount = 0;
+    return TRUE;
+}
+
+/**
+ * @brief Reads a file used by the /proc backend (from the start, into its buffer).
+ */
+int lrlib_counter_proc_read_file(lrlib_counter_file* file)
+{
+    const long bytesRead = pread(file->fileDescriptor, file->buffer, LRLIB_PROC_BUFFER_SIZE - 1, 0);
+    if (bytesRead <= 0)
+    {
+        file->buffer[0] = '\0';
+        return FALSE;
+    }
+
+    file->buffer[bytesRead] = '\0';
+    return TRUE;
+}
+
+/**
+ * @brief Finds the open file with this path, or opens it. Each file is only opened once per set.
+ *
+ * @return Returns the index of the file in counterSet->files, or -1 if there was an error.
+ */
+int lrlib_counter_proc_get_file(lrlib_counter_set* counterSet, const char* path)
+{
+    int i;
+    lrlib_counter_file* file;
+
+    for (i = 0; i < counterSet->fileCount; i++)
+    {
+        if (strcmp(counterSet->files[i].path, path) == 0)
+        {
+            return i;
+        }
+    }
+
+    if (counterSet->fileCount >= LRLIB_MAX_PROC_FILES_PER_SET)
+    {
+        lr_error_message("Too many files in the counter set (the maximum is %d).", LRLIB_MAX_PROC_FILES_PER_SET);
+        return -1;
+    }
+
+    file = &counterSet->files[counterSet->fileCount];
+    file->path = (char*)malloc(strlen(path) + 1);
+    file->buffer = (char*)malloc(LRLIB_PROC_BUFFER_SIZE);
+    if (file->path == NULL || file->buffer == NULL)
+    {
+        lrlib_safe_free_and_null((void**)&file->path);
+        lrlib_safe_free_and_null((void**)&file->buffer);
+        lr_error_message("Error allocating memory.");
+        return -1;
+    }
+    strcpy(file->path, path);
+
+    file->fileDescriptor = open(path, 0);  // 0 = O_RDONLY
+    if (file->fileDescriptor < 0)
+    {
+        lrlib_safe_free_and_null((void**)&file->path);
+        lrlib_safe_free_and_null((void**)&file->buffer);
+        lr_error_message("Cannot open '%s'.", path);
+        return -1;
+    }
+
+    counterSet->fileCount++;
+    return counterSet->fileCount - 1;
+}
+
+int lrlib_counter_proc_add(lrlib_counter_set* counterSet, const char* counterPath)
+{
+    char fileName[LRLIB_MAX_COUNTER_PATH_LENGTH];
+    char secondField[LRLIB_MAX_COUNTER_PATH_LENGTH];
+    char thirdField[LRLIB_MAX_COUNTER_PATH_LENGTH];
+    char lineKey[64];
+    int fieldNumber;
+    int fileIndex;
+    double value;
+
+    if (strlen(counterPath) >= LRLIB_MAX_COUNTER_PATH_LENGTH)
+    {
+        lr_error_message("Counter path is too long.");
+        return -1;
+    }
+
+    // The counter path is "file field" or "file key field".
+    thirdField[0] = '\0';
+    if (sscanf(counterPath, "%s %s %s", fileName, secondField, thirdField) < 2)
+    {
+        lr_error_message("Invalid /proc counter path '%s'. Use \"file field\" or \"file key field\".", counterPath);
+        return -1;
+    }
+
+    lineKey[0] = '\0';
+    if (thirdField[0] == '\0')
+    {
+        fieldNumber = atoi(secondField);
+    }
+    else
+    {
+        if (strlen(secondField) >= sizeof(lineKey))
+        {
+            lr_error_message("Line key '%s' is too long.", secondField);
+            return -1;
+        }
+        strcpy(lineKey, secondField);
+        fieldNumber = atoi(thirdField);
+    }
+
+    if (fieldNumber < 1)
+    {
+        lr_error_message("Invalid field number in counter path '%s' (the first field is 1).", counterPath);
+        return -1;
+    }
+
+    fileIndex = lrlib_counter_proc_get_file(counterSet, fileName);
+    if (fileIndex < 0)
+    {
+        return -1;
+    }
+
+    if (!lrlib_counter_proc_read_file(&counterSet->files[fileIndex]))
+    {
+        lr_error_message("Cannot read '%s'.", fileName);
+        return -1;
+    }
+
+    if (strcmp(lineKey, "*") != 0)
+    {
+        lrlib_counter* counter;
+
+        if (!lrlib_proc_parse_field(counterSet->files[fileIndex].buffer, lineKey, fieldNumber, &value))
+        {
+            lr_error_message("Cannot read field %d of '%s'.", fieldNumber, counterPath);
+            return -1;
+        }
+
+        counter = lrlib_counter_set_append(counterSet, counterPath);
+        if (counter == NULL)
+        {
+            return -1;
+        }
+        counter->fileIndex = fileIndex;
+        strcpy(counter->lineKey, lineKey);
+        counter->fieldNumber = fieldNumber;
+        return 1;
+    }
+
+    // Wildcard: add a counter for every line whose requested field is a number. The first field
+    // of each line (e.g. "eth0:") becomes the line key.
+    {
+        const char* line = counterSet->files[fileIndex].buffer;
+        int count = 0;
+
+        while (*line != '\0')
+        {
+            char key[64];
+            int keyLength = 0;
+            const char* current = line;
+
+            while (*current == ' ' || *current == '\t')
+            {
+                current++;
+            }
+            while (*current != '\0' && *current != '\n' && *current != ' ' && *current != '\t' && keyLength < (int)sizeof(key) - 1)
+            {
+                key[keyLength] = *current;
+                keyLength++;
+                current++;
+            }
+            key[keyLength] = '\0';
+
+            if (keyLength > 0 && lrlib_proc_parse_field(counterSet->files[fileIndex].buffer, key, fieldNumber, &value))
+            {
+                char name[LRLIB_MAX_COUNTER_PATH_LENGTH + 64];
+                lrlib_counter* counter;
+
+                sprintf(name, "%s %s %d", fileName, key, fieldNumber);
+                counter = lrlib_counter_set_append(counterSet, name);
+                if (counter == NULL)
+                {
+                    return -1;
+                }
+                counter->fileIndex = fileIndex;
+                strcpy(counter->lineKey, key);
+                counter->fieldNumber = fieldNumber;
+                count++;
+            }
+
+            while (*line != '\0' && *line != '\n')
+            {
+                line++;
+            }
+            if (*line == '\n')
+            {
+                line++;
+            }
+        }
+
+        return count;
+    }
+}
+
+int lrlib_counter_proc_collect(lrlib_counter_set* counterSet)
+{
+    int i;
+
+    // Read each file once, then find every counter in the file contents.
+    for (i = 0; i < counterSet->fileCount; i++)
+    {
+        lrlib_counter_proc_read_file(&counterSet->files[i]);
+    }
+
+    for (i = 0; i < counterSet->counterCount; i++)
+    {
+        lrlib_counter* counter = &counterSet->counters[i];
+        counter->valid = lrlib_proc_parse_field(counterSet->files[counter->fileIndex].buffer, counter->lineKey, counter->fieldNumber, &counter->value);
+    }
+
+    return TRUE;
+}
+
+double lrlib_counter_proc_now_msec(lrlib_counter_set* counterSet)
+{
+    return lrlib_sampler_now_msec();
+}
+
+void lrlib_counter_proc_close(lrlib_counter_set* counterSet)
+{
+    int i;
+
+    for (i = 0; i < counterSet->fileCount; i++)
+    {
+        close(counterSet->files[i].fileDescriptor);
+        lrlib_safe_free_and_null((void**)&counterSet->files[i].path);
+        lrlib_safe_free_and_null((void**)&counterSet->files[i].buffer);
+    }
+    counterSet->fileCount = 0;
+}
+
+const lrlib_counter_backend lrlib_counter_backend_proc = {
+    lrlib_counter_proc_open,
+    lrlib_counter_proc_add,
+    lrlib_counter_proc_collect,
+    lrlib_counter_proc_now_msec,
+    lrlib_counter_proc_close
+};
+
+#endif
+
+/* Mock backend (any platform) */
+
+int lrlib_counter_mock_open(lrlib_counter_set* counterSet)
+{
+    return TRUE;
+}
+
+int lrlib_counter_mock_add(lrlib_counter_set* counterSet, const char* counterPath)
+{
+    if (lrlib_counter_set_append(counterSet, counterPath) == NULL)
+    {
+        return -1;
+    }
+
+    return 1;
+}
+
+int lrlib_counter_mock_collect(lrlib_counter_set* counterSet)
+{
+    int i;
+    char paramReference[LRLIB_MAX_COUNTER_PATH_LENGTH + 3];
+
+    for (i = 0; i < counterSet->counterCount; i++)
+    {
+        lrlib_counter* counter = &counterSet->counters[i];
+        if (strlen(counter->name) > LRLIB_MAX_COUNTER_PATH_LENGTH)
+        {
+            counter->valid = FALSE;
+            continue;
+        }
+
+        sprintf(paramReference, "{%s}", counter->name);
+        counter->valid = lrlib_parse_double(lr_eval_string(paramReference), &counter->value);
+    }
+
+    return TRUE;
+}
+
+double lrlib_counter_mock_now_msec(lrlib_counter_set* counterSet)
+{
+    // A predictable timestamp: one second per collection.
+    return counterSet->collectCount * 1000.0;
+}
+
+void lrlib_counter_mock_close(lrlib_counter_set* counterSet)
+{
+}
+
+const lrlib_counter_backend lrlib_counter_backend_mock = {
+    lrlib_counter_mock_open,
+    lrlib_counter_mock_add,
+    lrlib_counter_mock_collect,
+    lrlib_counter_mock_now_msec,
+    lrlib_counter_mock_close
+};
+
+/**
+ * @brief Gets a counter set from its ID, or writes an error message if the ID is invalid.
+ */
+lrlib_counter_set* lrlib_get_counter_set(const int counterSetId)
+{
+    if (counterSetId < 1 || counterSetId > LRLIB_MAX_COUNTER_SETS || !lrlib_counter_sets[counterSetId - 1].inUse)
+    {
+        lr_error_message("Invalid counter set ID %d.", counterSetId);
+        return NULL;
+    }
+
+    return &lrlib_counter_sets[counterSetId - 1];
+}
+
+/**
+ * @brief Creates an empty counter set.
+ *
+ * @param backend The backend used to read the counters: &lrlib_counter_backend_pdh (Windows only),
+ *        &lrlib_counter_backend_proc (Linux only), &lrlib_counter_backend_mock, or your own backend.
+ * @return Returns the ID of the new counter set (1 or more), or 0 if there was an error.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     int counter_set;
+ *     int i;
+ *
+ *     // Collect the CPU utilisation of every processor, and the available memory, at the same
+ *     // moment.
+ *     counter_set = lrlib_counter_set_create(&lrlib_counter_backend_pdh);
+ *     lrlib_counter_set_add(counter_set, "\\Processor(*)\\% Processor Time");
+ *     lrlib_counter_set_add(counter_set, "\\Memory\\Available MBytes");
+ *     lrlib_counter_set_get_names(counter_set, "CounterNames");
+ *
+ *     for (i = 0; i < 10; i++) {
+ *         lr_think_time(1);
+ *         lrlib_counter_set_collect(counter_set, "CounterValues");
+ *         lr_output_message("%s = %s at %s ms", lr_paramarr_idx("CounterNames", 1),
+ *             lr_paramarr_idx("CounterValues", 1), lr_eval_string("{CounterValues_timestamp}"));
+ *     }
+ *
+ *     lrlib_counter_set_delete(counter_set);
+ *     return 0;
+ * }
+ *
+ * @note Each vuser can have up to 4 counter sets, with up to 256 counters in each set.
+ */
+int lrlib_counter_set_create(const lrlib_counter_backend* backend)
+{
+    int counterSetId;
+    double profileStartInUsec = 0;
+
+    LRLIB_PROFILE_START(profileStartInUsec);
+
+    if (backend == NULL)
+    {
+        lr_error_message("Backend cannot be NULL.");
+        return 0;
+    }
+
+    for (counterSetId = 1; counterSetId <= LRLIB_MAX_COUNTER_SETS; counterSetId++)
+    {
+        lrlib_counter_set* counterSet = &lrlib_counter_sets[counterSetId - 1];
+        if (!counterSet->inUse)
+        {
+            memset(counterSet, 0, sizeof(lrlib_counter_set));
+            counterSet->backend = backend;
+            if (!backend->open(counterSet))
+            {
+                return 0;
+            }
+
+            counterSet->inUse = TRUE;
+            LRLIB_PROFILE_END("lrlib_counter_set_create", profileStartInUsec, 0);
+            return counterSetId;
+        }
+    }
+
+    lr_error_message("Too many counter sets (the maximum is %d).", LRLIB_MAX_COUNTER_SETS);
+    return 0;
+}
+
+/**
+ * @brief Adds a counter (or several counters, if the path contains a wildcard) to a counter set.
+ *
+ * @param counterSetId The ID returned by lrlib_counter_set_create.
+ * @param counterPath The counter path. The format depends on the backend.
+ * @return Returns the number of counters added, or -1 if there was an error.
+ */
+int lrlib_counter_set_add(const int counterSetId, const char* counterPath)
+{
+    lrlib_counter_set* counterSet = lrlib_get_counter_set(counterSetId);
+    int result;
+    double profileStartInUsec = 0;
+
+    LRLIB_PROFILE_START(profileStartInUsec);
+
+    if (counterSet == NULL)
+    {
+        return -1;
+    }
+
+    if (counterPath == NULL || strlen(counterPath) == 0)
+    {
+        lr_error_message("Counter path cannot be NULL or empty.");
+        return -1;
+    }
+
+    result = counterSet->backend->add(counterSet, counterPath);
+    LRLIB_PROFILE_END("lrlib_counter_set_add", profileStartInUsec, 0);
+    return result;
+}
+
+/**
+ * @brief Saves the names of the counters in a set to a parameter array, in the same order as the
+ *        values saved by lrlib_counter_set_collect. This is useful when wildcards were used.
+ *
+ * @param counterSetId The ID returned by lrlib_counter_set_create.
+ * @param outputParamArr The name of the parameter array to save the names to.
+ * @return Returns the number of counters, or -1 if there was an error.
+ */
+int lrlib_counter_set_get_names(const int counterSetId, const char* outputParamArr)
+{
+    lrlib_counter_set* counterSet = lrlib_get_counter_set(counterSetId);
+    lrlib_paramarr_emitter emitter;
+    int i;
+    int result;
+    double profileStartInUsec = 0;
+
+    LRLIB_PROFILE_START(profileStartInUsec);
+
+    if (counterSet == NULL || !lrlib_paramarr_emitter_init(&emitter, outputParamArr))
+    {
+        return -1;
+    }
+
+    for (i = 0; i < counterSet->counterCount; i++)
+    {
+        lrlib_paramarr_emitter_save(&emitter, counterSet->counters[i].name);
+    }
+
+    result = lrlib_paramarr_emitter_finish(&emitter);
+    LRLIB_PROFILE_END("lrlib_counter_set_get_names", profileStartInUsec, 0);
+    return result;
+}
+
+/**
+ * @brief Reads every counter in the set at the same moment, and saves the values to a parameter
+ *        array.
+ *
+ * The time of the collection (in milliseconds, from the backend's clock) is saved to a parameter
+ * with "_timestamp" added to the name of the parameter array. A counter that could not be read is
+ * saved as an empty string.
+ *
+ * @param counterSetId The ID returned by lrlib_counter_set_create.
+ * @param outputParamArr The name of the parameter array to save the values to.
+ * @return Returns the number of values saved, or -1 if there was an error.
+ */
+int lrlib_counter_set_collect(const int counterSetId, const char* outputParamArr)
+{
+    lrlib_counter_set* counterSet = lrlib_get_counter_set(counterSetId);
+    lrlib_paramarr_emitter emitter;
+    char timestampParam[LRLIB_PARAM_NAME_BUFFER_LENGTH];
+    char current[64];
+    double timestamp;
+    int i;
+    int result;
+    double profileStartInUsec = 0;
+
+    LRLIB_PROFILE_START(profileStartInUsec);
+
+    if (counterSet == NULL)
+    {
+        return -1;
+    }
+
+    if (outputParamArr == NULL || strlen(outputParamArr) > LRLIB_MAX_PARAM_NAME_LENGTH)
+    {
+        lr_error_message("Output parameter name cannot be NULL or longer than %d characters.", LRLIB_MAX_PARAM_NAME_LENGTH);
+        return -1;
+    }
+
+    counterSet->collectCount++;
+    timestamp = counterSet->backend->now_msec(counterSet);
+    if (!counterSet->backend->collect(counterSet))
+    {
+        return -1;
+    }
+
+    if (lrlib_paramarr_emitter_init(&emitter, outputParamArr) == FALSE)
+    {
+        lr_abort();
+    }
+    for (i = 0; i < counterSet->counterCount; i++)
+    {
+        if (counterSet->counters[i].valid)
+        {
+            sprintf(current, "%.15g", counterSet->counters[i].value);
+            lrlib_paramarr_emitter_save(&emitter, current);
+        }
+        else
+        {
+            lrlib_paramarr_emitter_save(&emitter, "");
+        }
+    }
+
+    sprintf(timestampParam, "%s_timestamp", outputParamArr);
+    sprintf(current, "%.0f", timestamp);
+    lr_save_string(current, timestampParam);
+
+    result = lrlib_paramarr_emitter_finish(&emitter);
+    LRLIB_PROFILE_END("lrlib_counter_set_collect", profileStartInUsec, 0);
+    return result;
+}
+
+/**
+ * @brief Deletes a counter set, and releases everything it holds.
+ *
+ * @param counterSetId The ID returned by lrlib_counter_set_create.
+ * @return Returns TRUE (1) if the set was deleted, otherwise returns FALSE (0).
+ */
+int lrlib_counter_set_delete(const int counterSetId)
+{
+    lrlib_counter_set* counterSet = lrlib_get_counter_set(counterSetId);
+    int i;
+    double profileStartInUsec = 0;
+
+    LRLIB_PROFILE_START(profileStartInUsec);
+
+    if (counterSet == NULL)
+    {
+        return FALSE;
+    }
+
+    counterSet->backend->close(counterSet);
+
+    for (i = 0; i < counterSet->counterCount; i++)
+    {
+        lrlib_safe_free_and_null((void**)&counterSet->counters[i].name);
+    }
+
+    counterSet->counterCount = 0;
+    counterSet->inUse = FALSE;
+    LRLIB_PROFILE_END("lrlib_counter_set_delete", profileStartInUsec, 0);
+    return TRUE;
+}
+
+/*
+ * Linux host monitors
+ * ===================
+ * Functions that read CPU, memory, network, disk and load average counters from /proc. They save
+ * their results in two parameter arrays (like lrlib_get_perfmon_counter_item_list): one with the
+ * name of each counter, and one with its value, in the same order.
+ *
+ * Each /proc file is opened once (per vuser) and then re-read with pread, which avoids an
+ * open/close for every sample. The file contents are parsed in place, without any memory
+ * allocation.
+ *
+ * CPU utilisation, network and disk rates are calculated from the change since the previous call
+ * to the same function. The first call returns the average since the machine was started.
+ *
+ * Linux only. This section is not compiled on Windows.
+ */
+
+#ifdef LRLIB_LINUX
+
+#define LRLIB_LINUX_FILE_STAT 0
+#define LRLIB_LINUX_FILE_MEMINFO 1
+#define LRLIB_LINUX_FILE_NET_DEV 2
+#define LRLIB_LINUX_FILE_DISKSTATS 3
+#define LRLIB_LINUX_FILE_LOADAVG 4
+#define LRLIB_LINUX_FILE_COUNT 5
+
+#define LRLIB_LINUX_MAX_INSTANCES 64
+#define LRLIB_LINUX_DISK_SECTOR_SIZE 512
+
+const char* lrlib_linux_monitor_paths[LRLIB_LINUX_FILE_COUNT] = {
+    "/proc/stat",
+    "/proc/meminfo",
+    "/proc/net/dev",
+    "/proc/diskstats",
+    "/proc/loadavg"
+};
+
+lrlib_counter_file lrlib_linux_monitor_files[LRLIB_LINUX_FILE_COUNT];
+
+// The counter values from the previous call, for one CPU, network interface or disk.
+typedef struct
+{
+    char name[32];
+    double values[6];
+} lrlib_linux_monitor_previous;
+
+typedef struct
+{
+    lrlib_linux_monitor_previous instances[LRLIB_LINUX_MAX_INSTANCES];
+    int instanceCount;
+    double timeInMsec;  // 0 before the first call, which makes the first rates "since boot"
+} lrlib_linux_monitor_history;
+
+lrlib_linux_monitor_history lrlib_linux_cpu_history;
+lrlib_linux_monitor_history lrlib_linux_network_history;
+lrlib_linux_monitor_history lrlib_linux_disk_history;
+
+/**
+ * @brief Reads one of the /proc files used by the Linux monitors, opening it on first use.
+ *
+ * @return Returns the contents of the file (null-terminated), or NULL if there was an error.
+ */
+const char* lrlib_linux_monitor_read(const int fileId)
+{
+    lrlib_counter_file* file = &lrlib_linux_monitor_files[fileId];
+
+    if (file->buffer == NULL)
+    {
+        file->buffer = (char*)malloc(LRLIB_PROC_BUFFER_SIZE);
+        if (file->buffer == NULL)
+        {
+            lr_error_message("Error allocating memory.");
+            return NULL;
+        }
+
+        file->fileDescriptor = open(lrlib_linux_monitor_paths[fileId], 0);  // 0 = O_RDONLY
+        if (file->fileDescriptor < 0)
+        {
+            lrlib_safe_free_and_null((void**)&file->buffer);
+            lr_error_message("Cannot open '%s'.", lrlib_linux_monitor_paths[fileId]);
+            return NULL;
+        }
+    }
+
+    if (!lrlib_counter_proc_read_file(file))
+    {
+        lr_error_message("Cannot read '%s'.", lrlib_linux_monitor_paths[fileId]);
+        return NULL;
+    }
+
+    return file->buffer;
+}
+
+/**
+ * @brief Skips spaces and tabs (but not newlines).
+ */
+const char* lrlib_linux_skip_spaces(const char* text)
+{
+    while (*text == ' ' || *text == '\t')
+    {
+        text++;
+    }
+
+    return text;
+}
+
+/**
+ * @brief Moves to the start of the next line.
+ */
+const char* lrlib_linux_next_line(const char* text)
+{
+    while (*text != '\0' && *text != '\n')
+    {
+        text++;
+    }
+    if (*text == '\n')
+    {
+        text++;
+    }
+
+    return text;
+}
+
+/**
+ * @brief Parses an unsigned integer (after any spaces). The value is returned as a double, as
+ *        /proc counters can be larger than 32 bits.
+ *
+ * @return Returns a pointer to the character after the number.
+ */
+const char* lrlib_linux_parse_number(const char* text, double* value)
+{
+    double result = 0;
+
+    text = lrlib_linux_skip_spaces(text);
+    while (*text >= '0' && *text <= '9')
+    {
+        result = (result * 10) + (*text - '0');
+        text++;
+    }
+
+    *value = result;
+    return text;
+}
+
+/**
+ * @brief Copies a name (after any spaces) that ends with a space, a newline or the stop character.
+ *        Names that are too long are cut short.
+ *
+ * @return Returns a pointer to the character after the name.
+ */
+const char* lrlib_linux_parse_name(const char* text, const char stopCharacter, char* name, const int nameBufferLength)
+{
+    int length = 0;
+
+    text = lrlib_linux_skip_spaces(text);
+    while (*text != '\0' && *text != '\n' && *text != ' ' && *text != '\t' && *text != stopCharacter)
+    {
+        if (length < nameBufferLength - 1)
+        {
+            name[length] = *text;
+            length++;
+        }
+        text++;
+    }
+    name[length] = '\0';
+
+    return text;
+}
+
+/**
+ * @brief Finds the previous values for an instance, adding the instance if it is new.
+ *
+ * @return Returns NULL if there are too many instances.
+ */
+lrlib_linux_monitor_previous* lrlib_linux_find_previous(lrlib_linux_monitor_history* history, const char* name)
+{
+    lrlib_linux_monitor_previous* previous;
+    int i;
+
+    for (i = 0; i < history->instanceCount; i++)
+    {
+        if (strcmp(history->instances[i].name, name) == 0)
+        {
+            return &history->instances[i];
+        }
+    }
+
+    if (history->instanceCount >= LRLIB_LINUX_MAX_INSTANCES)
+    {
+        return NULL;
+    }
+
+    previous = &history->instances[history->instanceCount];
+    memset(previous, 0, sizeof(lrlib_linux_monitor_previous));
+    strcpy(previous->name, name);
+    history->instanceCount++;
+    return previous;
+}
+
+/**
+ * @brief Saves one name and value to the output parameter arrays. If metric is not NULL, it is
+ *        added to the name (after a space).
+ */
+void lrlib_linux_save_counter(lrlib_paramarr_emitter* nameEmitter, lrlib_paramarr_emitter* valueEmitter, const char* name, const char* metric, const double value, const int decimalPlaces)
+{
+    char text[96];
+
+    if (metric == NULL)
+    {
+        lrlib_paramarr_emitter_save(nameEmitter, name);
+    }
+    else
+    {
+        sprintf(text, "%s %s", name, metric);
+        lrlib_paramarr_emitter_save(nameEmitter, text);
+    }
+
+    sprintf(text, "%.*f", decimalPlaces, value);
+    lrlib_paramarr_emitter_save(valueEmitter, text);
+}
+
+/**
+ * @brief Checks the output parameter names, and starts the two output parameter arrays.
+ */
+int lrlib_linux_start_output(const char* nameOutputParamArr, const char* valueOutputParamArr, lrlib_paramarr_emitter* nameEmitter, lrlib_paramarr_emitter* valueEmitter)
+{
+    if (nameOutputParamArr == NULL || valueOutputParamArr == NULL)
+    {
+        lr_error_message("Output parameter name cannot be NULL.");
+        return FALSE;
+    }
+
+    return lrlib_paramarr_emitter_init(nameEmitter, nameOutputParamArr) && lrlib_paramarr_emitter_init(valueEmitter, valueOutputParamArr);
+}
+
+/**
+ * @brief Gets the CPU utilisation (as a percentage) of the whole machine and of each CPU core.
+ *
+ * The first name is "_Total" (as with the Windows "\Processor(_Total)\% Processor Time" counter),
+ * followed by "cpu0", "cpu1", etc. The utilisation is the average since the previous call to this
+ * function.
+ *
+ * Note: This function only works on Linux.
+ *
+ * @param nameOutputParamArr The name of the parameter array to save the CPU names to.
+ * @param valueOutputParamArr The name of the parameter array to save the utilisation values to.
+ * @return Returns the number of values saved, or -1 if there was an error.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     lrlib_get_linux_cpu_utilisation("CpuName", "CpuUtilisation");
+ *     lr_think_time(10);
+ *     lrlib_get_linux_cpu_utilisation("CpuName", "CpuUtilisation");
+ *     lr_user_data_point("CPU utilisation", atof(lr_paramarr_idx("CpuUtilisation", 1)));
+ *     return 0;
+ * }
+ */
+int lrlib_get_linux_cpu_utilisation(const char* nameOutputParamArr, const char* valueOutputParamArr)
+{
+    lrlib_paramarr_emitter nameEmitter;
+    lrlib_paramarr_emitter valueEmitter;
+    const char* line;
+    int result;
+    double profileStartInUsec = 0;
+
+    LRLIB_PROFILE_START(profileStartInUsec);
+
+    if (!lrlib_linux_start_output(nameOutputParamArr, valueOutputParamArr, &nameEmitter, &valueEmitter))
+    {
+        return -1;
+    }
+
+    line = lrlib_linux_monitor_read(LRLIB_LINUX_FILE_STAT);
+    if (line == NULL)
+    {
+        return -1;
+    }
+
+    // The CPU lines come first: "cpu  user nice system idle iowait irq softirq steal guest
+    // guest_nice", then one line for each core ("cpu0 ..."). Guest time is already included in
+    // user time, so only the first 8 numbers are added up.
+    while (strncmp(line, "cpu", 3) == 0)
+    {
+        char name[32];
+        double total = 0;
+        double idle = 0;
+        double value;
+        int field;
+        lrlib_linux_monitor_previous* previous;
+
+        line = lrlib_linux_parse_name(line, '\0', name, sizeof(name));
+        for (field = 1; field <= 8; field++)
+        {
+            line = lrlib_linux_parse_number(line, &value);
+            total += value;
+            if (field == 4 || field == 5)  // idle and iowait
+            {
+                idle += value;
+            }
+        }
+        line = lrlib_linux_next_line(line);
+
+        if (strcmp(name, "cpu") == 0)
+        {
+            strcpy(name, "_Total");
+        }
+
+        previous = lrlib_linux_find_previous(&lrlib_linux_cpu_history, name);
+        if (previous != NULL)
+        {
+            const double totalDelta = total - previous->values[0];
+            const double busyDelta = (total - idle) - (previous->values[0] - previous->values[1]);
+            double utilisation = 0;
+
+            if (totalDelta > 0)
+            {
+                utilisation = 100.0 * busyDelta / totalDelta;
+            }
+            previous->values[0] = total;
+            previous->values[1] = idle;
+
+            lrlib_linux_save_counter(&nameEmitter, &valueEmitter, name, NULL, utilisation, 2);
+        }
+    }
+
+    lrlib_paramarr_emitter_finish(&nameEmitter);
+    result = lrlib_paramarr_emitter_finish(&valueEmitter);
+    LRLIB_PROFILE_END("lrlib_get_linux_cpu_utilisation", profileStartInUsec, 0);
+    return result;
+}
+
+/**
+ * @brief Gets the memory counters from /proc/meminfo (e.g. "MemTotal", "MemAvailable",
+ *        "SwapFree"). The values are in kB.
+ *
+ * Note: This function only works on Linux.
+ *
+ * @param nameOutputParamArr The name of the parameter array to save the counter names to.
+ * @param valueOutputParamArr The name of the parameter array to save the values to.
+ * @return Returns the number of values saved, or -1 if there was an error.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     int count;
+ *     int i;
+ *
+ *     count = lrlib_get_linux_memory("MemoryCounter", "MemoryValue");
+ *     for (i = 1; i <= count; i++) {
+ *         lr_output_message("%s = %s kB", lr_paramarr_idx("MemoryCounter", i), lr_paramarr_idx("MemoryValue", i));
+ *     }
+ *     return 0;
+ * }
+ */
+int lrlib_get_linux_memory(const char* nameOutputParamArr, const char* valueOutputParamArr)
+{
+    lrlib_paramarr_emitter nameEmitter;
+    lrlib_paramarr_emitter valueEmitter;
+    const char* line;
+    int result;
+    double profileStartInUsec = 0;
+
+    LRLIB_PROFILE_START(profileStartInUsec);
+
+    if (!lrlib_linux_start_output(nameOutputParamArr, valueOutputParamArr, &nameEmitter, &valueEmitter))
+    {
+        return -1;
+    }
+
+    line = lrlib_linux_monitor_read(LRLIB_LINUX_FILE_MEMINFO);
+    if (line == NULL)
+    {
+        return -1;
+    }
+
+    // Each line is "MemTotal:       16318412 kB" (a few lines have no unit).
+    while (*line != '\0')
+    {
+        char name[32];
+        double value;
+
+        line = lrlib_linux_parse_name(line, ':', name, sizeof(name));
+        if (*line == ':')
+        {
+            line = lrlib_linux_parse_number(line + 1, &value);
+            lrlib_linux_save_counter(&nameEmitter, &valueEmitter, name, NULL, value, 0);
+        }
+        line = lrlib_linux_next_line(line);
+    }
+
+    lrlib_paramarr_emitter_finish(&nameEmitter);
+    result = lrlib_paramarr_emitter_finish(&valueEmitter);
+    LRLIB_PROFILE_END("lrlib_get_linux_memory", profileStartInUsec, 0);
+    return result;
+}
+
+/**
+ * @brief Gets the traffic on each network interface, as rates since the previous call.
+ *
+ * There are four counters for each interface, e.g. "eth0 Bytes Received/sec",
+ * "eth0 Bytes Sent/sec", "eth0 Packets Received/sec" and "eth0 Packets Sent/sec".
+ *
+ * Note: This function only works on Linux.
+ *
+ * @param nameOutputParamArr The name of the parameter array to save the counter names to.
+ * @param valueOutputParamArr The name of the parameter array to save the values to.
+ * @return Returns the number of values saved, or -1 if there was an error.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     lrlib_get_linux_network("NetworkCounter", "NetworkValue");
+ *     lr_think_time(10);
+ *     lrlib_get_linux_network("NetworkCounter", "NetworkValue");
+ *     lr_output_message("%s = %s", lr_paramarr_idx("NetworkCounter", 1), lr_paramarr_idx("NetworkValue", 1));
+ *     return 0;
+ * }
+ */
+int lrlib_get_linux_network(const char* nameOutputParamArr, const char* valueOutputParamArr)
+{
+    lrlib_paramarr_emitter nameEmitter;
+    lrlib_paramarr_emitter valueEmitter;
+    const char* line;
+    double now;
+    double elapsedInSeconds;
+    int result;
+    double profileStartInUsec = 0;
+
+    LRLIB_PROFILE_START(profileStartInUsec);
+
+    if (!lrlib_linux_start_output(nameOutputParamArr, valueOutputParamArr, &nameEmitter, &valueEmitter))
+    {
+        return -1;
+    }
+
+    line = lrlib_linux_monitor_read(LRLIB_LINUX_FILE_NET_DEV);
+    if (line == NULL)
+    {
+        return -1;
+    }
+
+    now = lrlib_sampler_now_msec();
+    elapsedInSeconds = (now - lrlib_linux_network_history.timeInMsec) / 1000.0;
+    lrlib_linux_network_history.timeInMsec = now;
+
+    // Skip the two header lines. Each interface line is "  eth0: rx_bytes rx_packets rx_errs
+    // rx_drop rx_fifo rx_frame rx_compressed rx_multicast tx_bytes tx_packets ...". Older kernels
+    // do not put a space after the colon.
+    line = lrlib_linux_next_line(lrlib_linux_next_line(line));
+    while (*line != '\0')
+    {
+        char name[32];
+        double counters[4];
+        double value;
+        int field;
+        lrlib_linux_monitor_previous* previous;
+
+        line = lrlib_linux_parse_name(line, ':', name, sizeof(name));
+        if (*line != ':')
+        {
+            line = lrlib_linux_next_line(line);
+            continue;
+        }
+        line++;
+
+        for (field = 1; field <= 10; field++)
+        {
+            line = lrlib_linux_parse_number(line, &value);
+            if (field == 1)
+            {
+                counters[0] = value;
+            }
+            else if (field == 2)
+            {
+                counters[2] = value;
+            }
+            else if (field == 9)
+            {
+                counters[1] = value;
+            }
+            else if (field == 10)
+            {
+                counters[3] = value;
+            }
+        }
+        line = lrlib_linux_next_line(line);
+
+        previous = lrlib_linux_find_previous(&lrlib_linux_network_history, name);
+        if (previous != NULL && elapsedInSeconds > 0)
+        {
+            lrlib_linux_save_counter(&nameEmitter, &valueEmitter, name, "Bytes Received/sec", (counters[0] - previous->values[0]) / elapsedInSeconds, 2);
+            lrlib_linux_save_counter(&nameEmitter, &valueEmitter, name, "Bytes Sent/sec", (counters[1] - previous->values[1]) / elapsedInSeconds, 2);
+            lrlib_linux_save_counter(&nameEmitter, &valueEmitter, name, "Packets Received/sec", (counters[2] - previous->values[2]) / elapsedInSeconds, 2);
+            lrlib_linux_save_counter(&nameEmitter, &valueEmitter, name, "Packets Sent/sec", (counters[3] - previous->values[3]) / elapsedInSeconds, 2);
+            memcpy(previous->values, counters, sizeof(counters));
+        }
+    }
+
+    lrlib_paramarr_emitter_finish(&nameEmitter);
+    result = lrlib_paramarr_emitter_finish(&valueEmitter);
+    LRLIB_PROFILE_END("lrlib_get_linux_network", profileStartInUsec, 0);
+    return result;
+}
+
+/**
+ * @brief Gets the I/O on each disk, as rates since the previous call.
+ *
+ * There are five counters for each disk, e.g. "sda Disk Reads/sec", "sda Disk Writes/sec",
+ * "sda Disk Read Bytes/sec", "sda Disk Write Bytes/sec" and "sda % Disk Time" (the percentage of
+ * time that the disk was busy). Devices that have never been read or written (e.g. unused loop
+ * devices) are left out.
+ *
+ * Note: This function only works on Linux.
+ *
+ * @param nameOutputParamArr The name of the parameter array to save the counter names to.
+ * @param valueOutputParamArr The name of the parameter array to save the values to.
+ * @return Returns the number of values saved, or -1 if there was an error.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     lrlib_get_linux_disk_io("DiskCounter", "DiskValue");
+ *     lr_think_time(10);
+ *     lrlib_get_linux_disk_io("DiskCounter", "DiskValue");
+ *     lr_output_message("%s = %s", lr_paramarr_idx("DiskCounter", 1), lr_paramarr_idx("DiskValue", 1));
+ *     return 0;
+ * }
+ */
+int lrlib_get_linux_disk_io(const char* nameOutputParamArr, const char* valueOutputParamArr)
+{
+    lrlib_paramarr_emitter nameEmitter;
+    lrlib_paramarr_emitter valueEmitter;
+    const char* line;
+    double now;
+    double elapsedInMsec;
+    int result;
+    double profileStartInUsec = 0;
+
+    LRLIB_PROFILE_START(profileStartInUsec);
+
+    if (!lrlib_linux_start_output(nameOutputParamArr, valueOutputParamArr, &nameEmitter, &valueEmitter))
+    {
+        return -1;
+    }
+
+    line = lrlib_linux_monitor_read(LRLIB_LINUX_FILE_DISKSTATS);
+    if (line == NULL)
+    {
+        return -1;
+    }
+
+    now = lrlib_sampler_now_msec();
+    elapsedInMsec = now - lrlib_linux_disk_history.timeInMsec;
+    lrlib_linux_disk_history.timeInMsec = now;
+
+    // Each line is "major minor name reads reads_merged sectors_read ms_reading writes
+    // writes_merged sectors_written ms_writing in_progress ms_doing_io ...". Sectors are always
+    // 512 bytes here, whatever the real sector size of the disk.
+    while (*line != '\0')
+    {
+        char name[32];
+        double counters[5];
+        double value;
+        int field;
+        lrlib_linux_monitor_previous* previous;
+
+        line = lrlib_linux_parse_number(line, &value);
+        line = lrlib_linux_parse_number(line, &value);
+        line = lrlib_linux_parse_name(line, '\0', name, sizeof(name));
+
+        for (field = 1; field <= 10; field++)
+        {
+            line = lrlib_linux_parse_number(line, &value);
+            if (field == 1)
+            {
+                counters[0] = value;
+            }
+            else if (field == 3)
+            {
+                counters[2] = value * LRLIB_LINUX_DISK_SECTOR_SIZE;
+            }
+            else if (field == 5)
+            {
+                counters[1] = value;
+            }
+            else if (field == 7)
+            {
+                counters[3] = value * LRLIB_LINUX_DISK_SECTOR_SIZE;
+            }
+            else if (field == 10)
+            {
+                counters[4] = value;
+            }
+        }
+        line = lrlib_linux_next_line(line);
+
+        if (name[0] == '\0' || (counters[0] == 0 && counters[1] == 0))
+        {
+            continue;
+        }
+
+        previous = lrlib_linux_find_previous(&lrlib_linux_disk_history, name);
+        if (previous != NULL && elapsedInMsec > 0)
+        {
+            const double elapsedInSeconds = elapsedInMsec / 1000.0;
+
+            lrlib_linux_save_counter(&nameEmitter, &valueEmitter, name, "Disk Reads/sec", (counters[0] - previous->values[0]) / elapsedInSeconds, 2);
+            lrlib_linux_save_counter(&nameEmitter, &valueEmitter, name, "Disk Writes/sec", (counters[1] - previous->values[1]) / elapsedInSeconds, 2);
+            lrlib_linux_save_counter(&nameEmitter, &valueEmitter, name, "Disk Read Bytes/sec", (counters[2] - previous->values[2]) / elapsedInSeconds, 2);
+            lrlib_linux_save_counter(&nameEmitter, &valueEmitter, name, "Disk Write Bytes/sec", (counters[3] - previous->values[3]) / elapsedInSeconds, 2);
+            lrlib_linux_save_counter(&nameEmitter, &valueEmitter, name, "% Disk Time", 100.0 * (counters[4] - previous->values[4]) / elapsedInMsec, 2);
+            memcpy(previous->values, counters, sizeof(counters));
+        }
+    }
+
+    lrlib_paramarr_emitter_finish(&nameEmitter);
+    result = lrlib_paramarr_emitter_finish(&valueEmitter);
+    LRLIB_PROFILE_END("lrlib_get_linux_disk_io", profileStartInUsec, 0);
+    return result;
+}
+
+/**
+ * @brief Gets the load average: the number of processes that are running or waiting, averaged
+ *        over 1, 5 and 15 minutes. The names are "Load Average 1 min", "Load Average 5 min" and
+ *        "Load Average 15 min".
+ *
+ * Note: This function only works on Linux.
+ *
+ * @param nameOutputParamArr The name of the parameter array to save the counter names to.
+ * @param valueOutputParamArr The name of the parameter array to save the values to.
+ * @return Returns the number of values saved, or -1 if there was an error.
+ *
+ * @example
+ *
+ * Action()
+ * {
+ *     lrlib_get_linux_load_average("LoadName", "LoadValue");
+ *     lr_user_data_point("Load average", atof(lr_paramarr_idx("LoadValue", 1)));
+ *     return 0;
+ * }
+ */
+int lrlib_get_linux_load_average(const char* nameOutputParamArr, const char* valueOutputParamArr)
+{
+    lrlib_paramarr_emitter nameEmitter;
+    lrlib_paramarr_emitter valueEmitter;
+    const char* names[3] = { "Load Average 1 min", "Load Average 5 min", "Load Average 15 min" };
+    const char* line;
+    int i;
+    int result;
+    double profileStartInUsec = 0;
+
+    LRLIB_PROFILE_START(profileStartInUsec);
+
+    if (!lrlib_linux_start_output(nameOutputParamArr, valueOutputParamArr, &nameEmitter, &valueEmitter))
+    {
+        return -1;
+    }
+
+    line = lrlib_linux_monitor_read(LRLIB_LINUX_FILE_LOADAVG);
+    if (line == NULL)
+    {
+        return -1;
+    }
+
+    // The file is "0.15 0.10 0.05 1/123 4567". The values always have two decimal places.
+    for (i = 0; i < 3; i++)
+    {
+        double whole;
+        double fraction = 0;
+        const char* fractionStart;
+
+        line = lrlib_linux_parse_number(line, &whole);
+        if (*line == '.')
+        {
+            fractionStart = line + 1;
+            line = lrlib_linux_parse_number(fractionStart, &fraction);
+            for (; fractionStart < line; fractionStart++)
+            {
+                fraction /= 10;
+            }
+        }
+
+        lrlib_linux_save_counter(&nameEmitter, &valueEmitter, names[i], NULL, whole + fraction, 2);
+    }
+
+    lrlib_paramarr_emitter_finish(&nameEmitter);
+    result = lrlib_paramarr_emitter_finish(&valueEmitter);
+    LRLIB_PROFILE_END("lrlib_get_linux_load_average", profileStartInUsec, 0);
+    return result;
+}
+
+#endif
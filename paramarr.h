@@ -14,6 +14,15 @@ typedef unsigned char* va_list; // Type to hold information about variable argum
 #define va_end(ap)      (ap = (va_list)0)
 #endif
 
+// Without lrlib.h (which has the self-profiler), the profiling macros do nothing.
+#ifndef LRLIB_PROFILE_START
+#define LRLIB_PROFILE_START(start_usec) do { } while (0)
+#endif
+
+#ifndef LRLIB_PROFILE_END
+#define LRLIB_PROFILE_END(function_name, start_usec, bytes) do { } while (0)
+#endif
+
 /**
   @brief Creates a new LoadRunner parameter array from a list of strings.
  
@@ -49,24 +58,68 @@ int lrlib_paramarr_create(const char* paramarrName, ...)
     {
         int count = 0;
         const char* param;
-        char* parameterName = (char*)malloc(strlen(paramarrName) + 32);
-        
-        va_list args;
-        va_start(args, paramarrName);
-        for (param = va_arg(args, char*); param != LAST; param = va_arg(args, char*))
+        char shortParameterName[256];  // used as parameterName, unless the name is too long to fit
+        char* parameterName = shortParameterName;
+        char* number;  // the part of parameterName after "MyParamArray_", where the element number goes
+        char digits[10];  // the digits of the element number, from right to left
+        const int nameLength = strlen(paramarrName);
+        int digitCount;
+        unsigned int value;
+        int i;
+
+        // Memory is only allocated for names that are too long for the buffer on the stack.
+        if (nameLength + 32 > sizeof(shortParameterName))
+        {
+            parameterName = (char*)malloc(nameLength + 32);
+            if (parameterName == NULL)
+            {
+                lr_error_message("Error allocating memory.");
+                return -1;
+            }
+        }
+
+        // "MyParamArray_" is written once, and only the element number changes for each element
+        // (which is much faster than calling sprintf("%s_%d") for every element).
+        memcpy(parameterName, paramarrName, nameLength);
+        parameterName[nameLength] = '_';
+        number = parameterName + nameLength + 1;
+
         {
-            count++;
-            sprintf(parameterName, "%s_%d", paramarrName, count);
-            lr_save_string(param, parameterName);
-        }
-    
-        va_end(args);
-        
-        sprintf(parameterName, "%s_count", paramarrName);
+            va_list args;
+            va_start(args, paramarrName);
+            for (param = va_arg(args, char*); param != LAST; param = va_arg(args, char*))
+            {
+                count++;
+
+                // Write the digits from right to left, then copy them in the right order.
+                value = count;
+                digitCount = 0;
+                do
+                {
+                    digits[digitCount] = (char)('0' + (value % 10));
+                    digitCount++;
+                    value = value / 10;
+                } while (value != 0);
+                for (i = 0; i < digitCount; i++)
+                {
+                    number[i] = digits[digitCount - 1 - i];
+                }
+                number[digitCount] = '\0';
+
+                lr_save_string(param, parameterName);
+            }
+
+            va_end(args);
+        }
+
+        strcpy(number, "count");
         lr_save_int(count, parameterName);
-    
-        free(parameterName);
-    
+
+        if (parameterName != shortParameterName)
+        {
+            free(parameterName);
+        }
+
         return count;
     }
 }
@@ -152,6 +205,9 @@ int lrlib_paramarr_contains(char* paramarr_name, char* element_to_find) {
     int i;
     int num_elements;
     int element_found = FALSE;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
 
     // TODO: Check that the parameter array exists
 
@@ -163,6 +219,7 @@ int lrlib_paramarr_contains(char* paramarr_name, char* element_to_find) {
         }
     }
 
+    LRLIB_PROFILE_END("lrlib_paramarr_contains", profile_start_usec, 0);
     return element_found;
 }
 
@@ -204,6 +261,9 @@ int lrlib_paramarr_search(char* paramarr_name, char* element_to_find) {
     int i;
     int num_elements;
     int element_found = FALSE;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
 
     // TODO: Check that the parameter array exists
 
@@ -215,6 +275,7 @@ int lrlib_paramarr_search(char* paramarr_name, char* element_to_find) {
         }
     }
 
+    LRLIB_PROFILE_END("lrlib_paramarr_search", profile_start_usec, 0);
     return element_found;
 }
 
@@ -320,21 +381,1704 @@ int lrlib_paramarr_pop(char* paramarr_name, char* output_param_name) {
     return num_elements; // TODO: not sure what the best return value for this function is.
 }
 
-// Note existing LoadRunner functions:
-// * lr_paramarr_idx
-// * lr_paramarr_len
-// * lr_paramarr_random
-// * lr_param_increment
-// * lr_free_parameter
+/*
+ * The lrlib_strset_* functions are a small hash set of strings. They are used by the parameter
+ * array functions that need to answer "have I seen this value before?" for every element of an
+ * array. Checking each element against every other element with strcmp is fine for 10 elements,
+ * but a parameter array saved with "ORD=All" can easily contain 100,000 elements, and 100,000 x
+ * 100,000 string comparisons would take minutes. With a hash set, each check takes (roughly) the
+ * same amount of time no matter how many elements there are.
+ *
+ * Note: the hash set does not copy the strings that are added to it; it only keeps a pointer to
+ * them. The strings returned by lr_paramarr_idx are not freed until the end of the iteration, so
+ * they can safely be added to the set.
+ */
+typedef struct {
+    const char** values; // the strings in the set. An empty slot holds NULL.
+    unsigned int* hashes; // the hash value of the string in each slot (to avoid most strcmp calls)
+    unsigned int mask; // the number of slots minus 1. The number of slots is always a power of 2,
+                       // so (hash & mask) gives a slot number without a slow division.
+} lrlib_strset;
 
-// Note that there are already some functions in the strings.h library.
+/**
+ * @brief Calculates a hash value for a string (using the 32-bit FNV-1a algorithm).
+ *
+ * @param string The string to calculate the hash value for.
+ * @return Returns the hash value.
+ */
+unsigned int lrlib_strset_hash(const char* string) {
+    unsigned int hash = 2166136261u; // FNV offset basis
+
+    // For each character, XOR it into the hash, then multiply by the FNV prime.
+    while (*string != '\0') {
+        hash = hash ^ (unsigned char)*string;
+        hash = hash * 16777619u; // FNV prime
+        string++;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Prepares an empty hash set that can hold at least the specified number of strings.
+ *
+ * @param set The hash set to initialise.
+ * @param expected_count The maximum number of strings that will be added to the set.
+ * @return This function does not return a value. If memory cannot be allocated, the script is
+ *         aborted.
+ */
+void lrlib_strset_init(lrlib_strset* set, int expected_count) {
+    unsigned int slot_count = 16;
+
+    // Keep the table at most half full, so that the search for a free slot is always short.
+    while (slot_count < (unsigned int)expected_count * 2) {
+        slot_count = slot_count * 2;
+    }
+
+    set->mask = slot_count - 1;
+    set->values = (const char**)calloc(slot_count, sizeof(char*));
+    set->hashes = (unsigned int*)calloc(slot_count, sizeof(unsigned int));
+    if ( (set->values == NULL) || (set->hashes == NULL) ) {
+        lr_error_message("Unable to allocate memory for a hash set of %u slots.", slot_count);
+        lr_abort();
+    }
+}
+
+/**
+ * @brief Finds the slot that holds a string, or the empty slot where it should be added.
+ *
+ * @param set The hash set to search.
+ * @param string The string to find.
+ * @param hash The hash value of the string (from lrlib_strset_hash).
+ * @return Returns the slot number.
+ */
+unsigned int lrlib_strset_find_slot(lrlib_strset* set, const char* string, unsigned int hash) {
+    unsigned int slot = hash & set->mask;
+
+    // If the slot is used by a different string, then try the next slot (this is called "linear
+    // probing"). There is always an empty slot, because the table is never more than half full.
+    while (set->values[slot] != NULL) {
+        if ( (set->hashes[slot] == hash) && (strcmp(set->values[slot], string) == 0) ) {
+            break;
+        }
+        slot = (slot + 1) & set->mask;
+    }
+
+    return slot;
+}
+
+/**
+ * @brief Adds a string to a hash set.
+ *
+ * @param set The hash set to add the string to.
+ * @param string The string to add. The string is not copied, so it must not be freed while the
+ *        set is still being used.
+ * @return Returns TRUE (1) if the string was added, or FALSE (0) if it was already in the set.
+ */
+int lrlib_strset_add(lrlib_strset* set, const char* string) {
+    unsigned int hash = lrlib_strset_hash(string);
+    unsigned int slot = lrlib_strset_find_slot(set, string, hash);
+
+    if (set->values[slot] != NULL) {
+        return FALSE; // already in the set
+    }
+
+    set->values[slot] = string;
+    set->hashes[slot] = hash;
+    return TRUE;
+}
+
+/**
+ * @brief Checks whether a string is in a hash set.
+ *
+ * @param set The hash set to search.
+ * @param string The string to find.
+ * @return Returns TRUE (1) if the string is in the set, otherwise returns FALSE (0).
+ */
+int lrlib_strset_contains(lrlib_strset* set, const char* string) {
+    unsigned int slot = lrlib_strset_find_slot(set, string, lrlib_strset_hash(string));
+
+    if (set->values[slot] != NULL) {
+        return TRUE;
+    } else {
+        return FALSE;
+    }
+}
+
+/**
+ * @brief Releases the memory used by a hash set. The strings in the set are not freed.
+ *
+ * @param set The hash set to free.
+ */
+void lrlib_strset_free(lrlib_strset* set) {
+    free(set->values);
+    free(set->hashes);
+    set->values = NULL;
+    set->hashes = NULL;
+}
+
+/**
+ * @brief Creates a new parameter array containing only the unique elements of a parameter array.
+ *
+ * Elements keep the same order as the original parameter array. If an element appears more than
+ * once, only the first occurrence is kept.
+ *
+ * @param paramarr_name The name of the parameter array to remove duplicates from.
+ * @param output_paramarr_name The name of the new parameter array. This must be different from
+ *        paramarr_name.
+ * @return Returns the number of elements in the new parameter array.
+ *
+ * @example:
+ *
+ * Action()
+ * {
+ *     int i;
+ *
+ *     // Simulate the creation of a parameter array.
+ *     // Note: Parameter array are usually created with with web_reg_save_param using ORD=All".
+ *     lr_save_string("red", "Colours_1");
+ *     lr_save_string("green", "Colours_2");
+ *     lr_save_string("red", "Colours_3");
+ *     lr_save_string("blue", "Colours_4");
+ *     lr_save_string("4", "Colours_count");
+ *
+ *     // Remove the duplicate "red" element. UniqueColours will contain red, green, blue.
+ *     lrlib_paramarr_unique("Colours", "UniqueColours");
+ *     for (i = 1; i <= lr_paramarr_len("UniqueColours"); i++) {
+ *         lr_output_message("element %d: %s", i, lr_paramarr_idx("UniqueColours", i));
+ *     }
+ *
+ *     return 0;
+ * }
+ *
+ * @note This function uses a hash set, so the time taken grows in proportion to the number of
+ *       elements (rather than the number of elements squared). Arrays of 100,000 elements are
+ *       fine.
+ */
+int lrlib_paramarr_unique(const char* paramarr_name, const char* output_paramarr_name) {
+    int i;
+    int num_elements; // number of elements in the input parameter array
+    char* element; // the current element of the input parameter array
+    lrlib_paramarr_emitter output; // saves the elements of the output parameter array
+    lrlib_strset seen; // all the element values that have been seen so far
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if ( (paramarr_name == NULL) || (strlen(paramarr_name) == 0) ) {
+        lr_error_message("paramarr_name cannot be NULL or empty.");
+        lr_abort();
+    } else if ( (output_paramarr_name == NULL) || (strlen(output_paramarr_name) == 0) ) {
+        lr_error_message("output_paramarr_name cannot be NULL or empty.");
+        lr_abort();
+    } else if (strcmp(paramarr_name, output_paramarr_name) == 0) {
+        lr_error_message("output_paramarr_name must be different from paramarr_name.");
+        lr_abort();
+    }
+
+    if (lrlib_paramarr_emitter_init(&output, output_paramarr_name) == FALSE) {
+        lr_abort();
+    }
+
+    num_elements = lr_paramarr_len(paramarr_name);
+    lrlib_strset_init(&seen, num_elements);
+
+    // Save each element to the output array the first time it is seen.
+    for (i = 1; i <= num_elements; i++) {
+        element = lr_paramarr_idx(paramarr_name, i);
+        if (lrlib_strset_add(&seen, element) == TRUE) {
+            lrlib_paramarr_emitter_save(&output, element);
+        }
+    }
+
+    lrlib_paramarr_emitter_finish(&output);
+
+    lrlib_strset_free(&seen);
+
+    LRLIB_PROFILE_END("lrlib_paramarr_unique", profile_start_usec, 0);
+    return output.count;
+}
+
+/**
+ * @brief Creates a new parameter array containing the elements of one parameter array that are
+ *        not present in a second parameter array.
+ *
+ * Elements keep the same order as the first parameter array. Duplicate elements in the first
+ * array are kept (use lrlib_paramarr_unique if you do not want them).
+ *
+ * @param paramarr_name The name of the parameter array to take elements from.
+ * @param exclude_paramarr_name The name of the parameter array containing the elements to leave
+ *        out.
+ * @param output_paramarr_name The name of the new parameter array. This must be different from
+ *        both of the other parameter array names.
+ * @return Returns the number of elements in the new parameter array.
+ *
+ * @example:
+ *
+ * Action()
+ * {
+ *     // Which products in the catalogue are not already in the shopping cart?
+ *     lrlib_paramarr_create("Catalogue", "P100", "P200", "P300", "P400", LAST);
+ *     lrlib_paramarr_create("Cart", "P300", "P100", LAST);
+ *
+ *     // NotInCart will contain P200, P400.
+ *     lrlib_paramarr_diff("Catalogue", "Cart", "NotInCart");
+ *     lr_output_message("Random product to add: %s", lr_paramarr_random("NotInCart"));
+ *
+ *     return 0;
+ * }
+ *
+ * @note This function uses a hash set, so the time taken grows in proportion to the total number
+ *       of elements in both arrays. Arrays of 100,000 elements are fine.
+ */
+int lrlib_paramarr_diff(const char* paramarr_name, const char* exclude_paramarr_name, const char* output_paramarr_name) {
+    int i;
+    int num_elements; // number of elements in the first parameter array
+    int num_exclude; // number of elements in the second parameter array
+    char* element; // the current element of the first parameter array
+    lrlib_paramarr_emitter output; // saves the elements of the output parameter array
+    lrlib_strset exclude; // all the element values of the second parameter array
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if ( (paramarr_name == NULL) || (strlen(paramarr_name) == 0) ) {
+        lr_error_message("paramarr_name cannot be NULL or empty.");
+        lr_abort();
+    } else if ( (exclude_paramarr_name == NULL) || (strlen(exclude_paramarr_name) == 0) ) {
+        lr_error_message("exclude_paramarr_name cannot be NULL or empty.");
+        lr_abort();
+    } else if ( (output_paramarr_name == NULL) || (strlen(output_paramarr_name) == 0) ) {
+        lr_error_message("output_paramarr_name cannot be NULL or empty.");
+        lr_abort();
+    } else if ( (strcmp(paramarr_name, output_paramarr_name) == 0) ||
+                (strcmp(exclude_paramarr_name, output_paramarr_name) == 0) ) {
+        lr_error_message("output_paramarr_name must be different from the input parameter arrays.");
+        lr_abort();
+    }
 
-// lrlib_paramarr_unique(param_arr_name, new_param_arr_name). Takes a parameter array, and creates a new parameter array containing only unique values. Note: can implement this the inefficient way, as parameter arrays are generally not large.
-// lrlib_paramarr_join(paramarr_name, delimiter)
-// lrlib_paramarr_next() -- can use for loop iterator. static variable keeps track of place in loop. returns true while there is still elements.
-// lrlib_paramarr_shuffle() - could use shuffle then next, to make sure you don't get repeats (which you would get with random)
-// lrlib_paramarr_diff
-// lrlib_paramarr_intersect
+    if (lrlib_paramarr_emitter_init(&output, output_paramarr_name) == FALSE) {
+        lr_abort();
+    }
+
+    // Add every element of the second array to the hash set.
+    num_exclude = lr_paramarr_len(exclude_paramarr_name);
+    lrlib_strset_init(&exclude, num_exclude);
+    for (i = 1; i <= num_exclude; i++) {
+        lrlib_strset_add(&exclude, lr_paramarr_idx(exclude_paramarr_name, i));
+    }
+
+    // Save each element of the first array that is not in the hash set.
+    num_elements = lr_paramarr_len(paramarr_name);
+    for (i = 1; i <= num_elements; i++) {
+        element = lr_paramarr_idx(paramarr_name, i);
+        if (lrlib_strset_contains(&exclude, element) == FALSE) {
+            lrlib_paramarr_emitter_save(&output, element);
+        }
+    }
+
+    lrlib_paramarr_emitter_finish(&output);
+
+    lrlib_strset_free(&exclude);
+
+    LRLIB_PROFILE_END("lrlib_paramarr_diff", profile_start_usec, 0);
+    return output.count;
+}
+
+/**
+ * @brief Creates a new parameter array containing the elements of one parameter array that are
+ *        also present in a second parameter array.
+ *
+ * Elements keep the same order as the first parameter array. Duplicate elements in the first
+ * array are kept (use lrlib_paramarr_unique if you do not want them).
+ *
+ * @param paramarr_name The name of the parameter array to take elements from.
+ * @param match_paramarr_name The name of the parameter array containing the elements to keep.
+ * @param output_paramarr_name The name of the new parameter array. This must be different from
+ *        both of the other parameter array names.
+ * @return Returns the number of elements in the new parameter array.
+ *
+ * @example:
+ *
+ * Action()
+ * {
+ *     // Which of the products on the search results page are on special?
+ *     lrlib_paramarr_create("SearchResults", "P100", "P200", "P300", "P400", LAST);
+ *     lrlib_paramarr_create("Specials", "P400", "P900", "P200", LAST);
+ *
+ *     // SearchResultsOnSpecial will contain P200, P400.
+ *     if (lrlib_paramarr_intersect("SearchResults", "Specials", "SearchResultsOnSpecial") > 0) {
+ *         lr_output_message("First special: %s", lr_paramarr_idx("SearchResultsOnSpecial", 1));
+ *     }
+ *
+ *     return 0;
+ * }
+ *
+ * @note This function uses a hash set, so the time taken grows in proportion to the total number
+ *       of elements in both arrays. Arrays of 100,000 elements are fine.
+ */
+int lrlib_paramarr_intersect(const char* paramarr_name, const char* match_paramarr_name, const char* output_paramarr_name) {
+    int i;
+    int num_elements; // number of elements in the first parameter array
+    int num_match; // number of elements in the second parameter array
+    char* element; // the current element of the first parameter array
+    lrlib_paramarr_emitter output; // saves the elements of the output parameter array
+    lrlib_strset match; // all the element values of the second parameter array
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if ( (paramarr_name == NULL) || (strlen(paramarr_name) == 0) ) {
+        lr_error_message("paramarr_name cannot be NULL or empty.");
+        lr_abort();
+    } else if ( (match_paramarr_name == NULL) || (strlen(match_paramarr_name) == 0) ) {
+        lr_error_message("match_paramarr_name cannot be NULL or empty.");
+        lr_abort();
+    } else if ( (output_paramarr_name == NULL) || (strlen(output_paramarr_name) == 0) ) {
+        lr_error_message("output_paramarr_name cannot be NULL or empty.");
+        lr_abort();
+    } else if ( (strcmp(paramarr_name, output_paramarr_name) == 0) ||
+                (strcmp(match_paramarr_name, output_paramarr_name) == 0) ) {
+        lr_error_message("output_paramarr_name must be different from the input parameter arrays.");
+        lr_abort();
+    }
+
+    if (lrlib_paramarr_emitter_init(&output, output_paramarr_name) == FALSE) {
+        lr_abort();
+    }
+
+    // Add every element of the second array to the hash set.
+    num_match = lr_paramarr_len(match_paramarr_name);
+    lrlib_strset_init(&match, num_match);
+    for (i = 1; i <= num_match; i++) {
+        lrlib_strset_add(&match, lr_paramarr_idx(match_paramarr_name, i));
+    }
+
+    // Save each element of the first array that is also in the hash set.
+    num_elements = lr_paramarr_len(paramarr_name);
+    for (i = 1; i <= num_elements; i++) {
+        element = lr_paramarr_idx(paramarr_name, i);
+        if (lrlib_strset_contains(&match, element) == TRUE) {
+            lrlib_paramarr_emitter_save(&output, element);
+        }
+    }
+
+    lrlib_paramarr_emitter_finish(&output);
+
+    lrlib_strset_free(&match);
+
+    LRLIB_PROFILE_END("lrlib_paramarr_intersect", profile_start_usec, 0);
+    return output.count;
+}
+
+/*
+ * State for lrlib_paramarr_shuffle, lrlib_paramarr_next and lrlib_paramarr_reset. Each vuser has
+ * its own copy of these global variables, so vusers do not interfere with each other.
+ *
+ * The random order is worked out one element at a time (as lrlib_paramarr_next is called), using
+ * the Fisher-Yates shuffle algorithm. This means that shuffling a 1,000,000 element array does not
+ * take any time until the elements are actually used.
+ */
+#define LRLIB_MAX_PARAMARR_ITERATORS 16
+
+typedef struct {
+    char paramarr_name[LRLIB_PARAM_NAME_BUFFER_LENGTH]; // an empty string means the slot is free
+    int length; // the number of elements in the parameter array when it was shuffled
+    unsigned int* order; // order[i] is the element number at position i. A value of 0 means that
+                         // the element has not been moved, so it is element number i + 1. calloc
+                         // sets every value to 0, so no time is spent filling in the array.
+    int position; // the number of elements returned by lrlib_paramarr_next so far
+    int fixed; // the number of positions (at the start of order) that have been shuffled
+} lrlib_paramarr_iterator;
+
+lrlib_paramarr_iterator lrlib_paramarr_iterators[LRLIB_MAX_PARAMARR_ITERATORS];
+
+/**
+ * @brief Finds the iterator for a parameter array (used by the shuffle/next/reset functions).
+ *
+ * @param paramarr_name The name of the parameter array.
+ * @return Returns a pointer to the iterator, or NULL if the parameter array has not been shuffled.
+ */
+lrlib_paramarr_iterator* lrlib_paramarr_find_iterator(const char* paramarr_name) {
+    int i;
+
+    for (i = 0; i < LRLIB_MAX_PARAMARR_ITERATORS; i++) {
+        if (strcmp(lrlib_paramarr_iterators[i].paramarr_name, paramarr_name) == 0) {
+            return &lrlib_paramarr_iterators[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Shuffles a parameter array, so that lrlib_paramarr_next returns its elements in a random
+ *        order with no repeats.
+ *
+ * The elements of the parameter array are not moved or copied; only the order in which
+ * lrlib_paramarr_next returns them is changed. Calling this function again starts a new random
+ * order (a "reshuffle").
+ *
+ * @param paramarr_name The name of the parameter array to shuffle.
+ * @return Returns the number of elements in the parameter array.
+ *
+ * @example:
+ *
+ * Action()
+ * {
+ *     // Simulate the creation of a parameter array.
+ *     // Note: Parameter array are usually created with with web_reg_save_param using ORD=All".
+ *     lrlib_paramarr_create("ProductIds", "P100", "P200", "P300", "P400", LAST);
+ *
+ *     // View every product exactly once, in a random order. Using lr_paramarr_random would
+ *     // visit some products twice, and miss others.
+ *     lrlib_paramarr_shuffle("ProductIds");
+ *     while (lrlib_paramarr_next("ProductIds", "ProductId") > 0) {
+ *         web_url("View Product",
+ *             "URL=http://www.example.com/product?id={ProductId}",
+ *             LAST);
+ *     }
+ *
+ *     return 0;
+ * }
+ *
+ * @note If the parameter array is saved again (e.g. on the next iteration) and its length
+ *       changes, call this function again before calling lrlib_paramarr_next.
+ * @note Up to 16 parameter arrays can be shuffled at the same time (per vuser).
+ */
+int lrlib_paramarr_shuffle(const char* paramarr_name) {
+    int num_elements;
+    lrlib_paramarr_iterator* iterator;
+
+    // Check input variables
+    if ( (paramarr_name == NULL) || (strlen(paramarr_name) == 0) ) {
+        lr_error_message("paramarr_name cannot be NULL or empty.");
+        lr_abort();
+    } else if (strlen(paramarr_name) > LRLIB_MAX_PARAM_NAME_LENGTH) {
+        lr_error_message("paramarr_name is too long.");
+        lr_abort();
+    }
+
+    num_elements = lr_paramarr_len(paramarr_name);
+
+    // Find the iterator for this parameter array. If there isn't one, use a free slot.
+    iterator = lrlib_paramarr_find_iterator(paramarr_name);
+    if (iterator == NULL) {
+        iterator = lrlib_paramarr_find_iterator("");
+        if (iterator == NULL) {
+            lr_error_message("Too many shuffled parameter arrays (the maximum is %d).", LRLIB_MAX_PARAMARR_ITERATORS);
+            lr_abort();
+        }
+        strcpy(iterator->paramarr_name, paramarr_name);
+        iterator->order = NULL;
+        iterator->length = -1;
+    }
+
+    // If the number of elements has changed, then the old order cannot be reused.
+    if (iterator->length != num_elements) {
+        free(iterator->order);
+        iterator->order = (unsigned int*)calloc(num_elements + 1, sizeof(unsigned int));
+        if (iterator->order == NULL) {
+            lr_error_message("Unable to allocate memory to shuffle %d elements.", num_elements);
+            lr_abort();
+        }
+        iterator->length = num_elements;
+    }
+
+    // Start a new random order. Shuffling an order that has already been shuffled still gives a
+    // completely random result, so there is no need to put the elements back in order first.
+    iterator->position = 0;
+    iterator->fixed = 0;
+
+    return num_elements;
+}
+
+/**
+ * @brief Gets the next element of a shuffled parameter array.
+ *
+ * Every element is returned exactly once (in a random order) before the function returns 0. Call
+ * lrlib_paramarr_reset to go through the same order again, or lrlib_paramarr_shuffle to go
+ * through the elements in a new random order.
+ *
+ * @param paramarr_name The name of the parameter array. If lrlib_paramarr_shuffle has not been
+ *        called for this parameter array, it is called automatically.
+ * @param output_param_name The name of the parameter to save the element to. If this is NULL, the
+ *        element is not saved (use the returned element number with lr_paramarr_idx instead).
+ * @return Returns the element number (first element is 1) of the next element, or 0 if every
+ *         element has already been returned.
+ *
+ * @example:
+ *
+ * Action()
+ * {
+ *     int element_number;
+ *
+ *     lrlib_paramarr_create("Cities", "Melbourne", "Sydney", "Perth", "Adelaide", LAST);
+ *
+ *     // Pick two different cities for a flight search.
+ *     lrlib_paramarr_shuffle("Cities");
+ *     lrlib_paramarr_next("Cities", "DepartureCity");
+ *     element_number = lrlib_paramarr_next("Cities", NULL);
+ *     lr_save_string(lr_paramarr_idx("Cities", element_number), "ArrivalCity");
+ *
+ *     return 0;
+ * }
+ */
+int lrlib_paramarr_next(const char* paramarr_name, const char* output_param_name) {
+    lrlib_paramarr_iterator* iterator;
+    unsigned int element_number; // the element number at the current position
+    unsigned int swap_position; // the randomly chosen position to swap with the current position
+    unsigned int swap_element_number; // the element number at swap_position
+
+    // Check input variables
+    if ( (paramarr_name == NULL) || (strlen(paramarr_name) == 0) ) {
+        lr_error_message("paramarr_name cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    iterator = lrlib_paramarr_find_iterator(paramarr_name);
+    if (iterator == NULL) {
+        lrlib_paramarr_shuffle(paramarr_name);
+        iterator = lrlib_paramarr_find_iterator(paramarr_name);
+    }
+
+    // Stop when every element has been returned.
+    if (iterator->position >= iterator->length) {
+        return 0;
+    }
+
+    // If the element at this position has not been chosen yet, then do one step of the
+    // Fisher-Yates shuffle: swap the current position with a random position from the part of the
+    // array that has not been shuffled yet (which includes the current position itself).
+    if (iterator->position == iterator->fixed) {
+        swap_position = iterator->position + lrlib_random_range(iterator->length - iterator->position);
+
+        element_number = iterator->order[iterator->position];
+        if (element_number == 0) {
+            element_number = iterator->position + 1;
+        }
+        swap_element_number = iterator->order[swap_position];
+        if (swap_element_number == 0) {
+            swap_element_number = swap_position + 1;
+        }
+
+        iterator->order[iterator->position] = swap_element_number;
+        iterator->order[swap_position] = element_number;
+        iterator->fixed++;
+    }
+
+    element_number = iterator->order[iterator->position];
+    iterator->position++;
+
+    if (output_param_name != NULL) {
+        lr_save_string(lr_paramarr_idx(paramarr_name, element_number), output_param_name);
+    }
+
+    return element_number;
+}
+
+/**
+ * @brief Restarts lrlib_paramarr_next from the first element, using the same random order as
+ *        before.
+ *
+ * @param paramarr_name The name of the parameter array.
+ * @return This function does not return a value.
+ *
+ * @example:
+ *
+ * Action()
+ * {
+ *     lrlib_paramarr_create("Accounts", "1001", "1002", "1003", LAST);
+ *     lrlib_paramarr_shuffle("Accounts");
+ *
+ *     // Check the balance of each account...
+ *     while (lrlib_paramarr_next("Accounts", "AccountId") > 0) {
+ *         lr_output_message("Checking balance of %s", lr_eval_string("{AccountId}"));
+ *     }
+ *
+ *     // ...then transfer money out of each account, in the same order.
+ *     lrlib_paramarr_reset("Accounts");
+ *     while (lrlib_paramarr_next("Accounts", "AccountId") > 0) {
+ *         lr_output_message("Transferring from %s", lr_eval_string("{AccountId}"));
+ *     }
+ *
+ *     return 0;
+ * }
+ */
+void lrlib_paramarr_reset(const char* paramarr_name) {
+    lrlib_paramarr_iterator* iterator;
+
+    // Check input variables
+    if ( (paramarr_name == NULL) || (strlen(paramarr_name) == 0) ) {
+        lr_error_message("paramarr_name cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    iterator = lrlib_paramarr_find_iterator(paramarr_name);
+    if (iterator == NULL) {
+        lr_error_message("Parameter array %s has not been shuffled.", paramarr_name);
+        lr_abort();
+    }
+
+    // The positions before "fixed" keep the order that has already been chosen.
+    iterator->position = 0;
+
+    return;
+}
+
+/**
+ * @brief Gets pointers to all the elements of a parameter array.
+ *
+ * This is used by functions that need to look at every element more than once. Calling
+ * lr_paramarr_idx for each element once, and keeping the pointers, is much faster than calling it
+ * again for every pass.
+ *
+ * @param paramarr_name The name of the parameter array.
+ * @param num_elements Receives the number of elements in the parameter array.
+ * @return Returns an array of pointers to the elements (the first element is at index 0). Free
+ *         the returned array with free() (but do not free the elements themselves; LoadRunner
+ *         frees them at the end of the iteration).
+ */
+char** lrlib_paramarr_get_elements(const char* paramarr_name, int* num_elements) {
+    int i;
+    char** elements;
+
+    *num_elements = lr_paramarr_len(paramarr_name);
+
+    // Allocate one extra pointer, so that malloc is never asked for 0 bytes.
+    elements = (char**)malloc((*num_elements + 1) * sizeof(char*));
+    if (elements == NULL) {
+        lr_error_message("Unable to allocate memory for %d elements.", *num_elements);
+        lr_abort();
+    }
+
+    for (i = 0; i < *num_elements; i++) {
+        elements[i] = lr_paramarr_idx(paramarr_name, i + 1);
+    }
+
+    return elements;
+}
+
+/**
+ * @brief Joins the elements of a parameter array into a single string, with a delimiter between
+ *        each element.
+ *
+ * @param paramarr_name The name of the parameter array to join.
+ * @param delimiter The string to put between each element (e.g. "," or "&id="). It can be empty.
+ * @param output_param_name The name of the parameter to save the joined string to.
+ * @return Returns the length of the joined string.
+ *
+ * @example:
+ *
+ * Action()
+ * {
+ *     lrlib_paramarr_create("ItemIds", "1001", "1002", "1003", LAST);
+ *
+ *     // Build a request body like "items=1001|1002|1003".
+ *     lrlib_paramarr_join("ItemIds", "|", "ItemList");
+ *     lr_output_message("items=%s", lr_eval_string("{ItemList}"));
+ *
+ *     return 0;
+ * }
+ *
+ * @note Joining a large array with a loop of strcat calls gets slower and slower, as strcat has
+ *       to find the end of the string every time. This function works out the exact length of
+ *       the joined string first, then copies each element into place once.
+ */
+int lrlib_paramarr_join(const char* paramarr_name, const char* delimiter, const char* output_param_name) {
+    int i;
+    int num_elements;
+    char** elements; // pointers to each element of the parameter array
+    int delimiter_length;
+    int total_length = 0; // the length of the joined string
+    char* joined; // a buffer to hold the joined string
+    char* position; // the place in the buffer where the next piece will be copied
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if ( (paramarr_name == NULL) || (strlen(paramarr_name) == 0) ) {
+        lr_error_message("paramarr_name cannot be NULL or empty.");
+        lr_abort();
+    } else if (delimiter == NULL) {
+        lr_error_message("delimiter cannot be NULL.");
+        lr_abort();
+    } else if ( (output_param_name == NULL) || (strlen(output_param_name) == 0) ) {
+        lr_error_message("output_param_name cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    elements = lrlib_paramarr_get_elements(paramarr_name, &num_elements);
+    delimiter_length = strlen(delimiter);
+
+    // First pass: add up the length of every element, plus a delimiter between each one.
+    for (i = 0; i < num_elements; i++) {
+        total_length += strlen(elements[i]);
+        if (i > 0) {
+            total_length += delimiter_length;
+        }
+    }
+
+    joined = (char*)malloc(total_length + 1);
+    if (joined == NULL) {
+        lr_error_message("Unable to allocate memory for the joined string (%d bytes).", total_length + 1);
+        lr_abort();
+    }
+
+    // Second pass: copy the delimiters and elements into place.
+    position = joined;
+    for (i = 0; i < num_elements; i++) {
+        int element_length = strlen(elements[i]);
+        if (i > 0) {
+            memcpy(position, delimiter, delimiter_length);
+            position += delimiter_length;
+        }
+        memcpy(position, elements[i], element_length);
+        position += element_length;
+    }
+    *position = '\0';
+
+    lr_save_string(joined, output_param_name);
+
+    free(joined);
+    free(elements);
+
+    LRLIB_PROFILE_END("lrlib_paramarr_join", profile_start_usec, total_length);
+    return total_length;
+}
+
+/**
+ * @brief Converts a parameter array to a single line of CSV (comma-separated values).
+ *
+ * Elements that contain a comma, a double quote or a line break are enclosed in double quotes,
+ * and any double quotes inside them are doubled (as described in RFC 4180). Other elements are
+ * written as they are.
+ *
+ * @param paramarr_name The name of the parameter array to convert.
+ * @param output_param_name The name of the parameter to save the CSV line to.
+ * @return Returns the length of the CSV line.
+ *
+ * @example:
+ *
+ * Action()
+ * {
+ *     lrlib_paramarr_create("Row", "Smith, John", "42", "says \"hi\"", LAST);
+ *
+ *     // CsvRow will contain: "Smith, John",42,"says ""hi"""
+ *     lrlib_paramarr_to_csv("Row", "CsvRow");
+ *     lrlib_append_to_file("C:\\TEMP\\output.csv", lr_eval_string("{CsvRow}\n"));
+ *
+ *     return 0;
+ * }
+ */
+int lrlib_paramarr_to_csv(const char* paramarr_name, const char* output_param_name) {
+    int i;
+    int num_elements;
+    char** elements; // pointers to each element of the parameter array
+    char* needs_quotes; // needs_quotes[i] is TRUE if elements[i] must be enclosed in quotes
+    int total_length = 0; // the length of the CSV line
+    char* csv; // a buffer to hold the CSV line
+    char* position; // the place in the buffer where the next character will be written
+    const char* c; // the current character of the current element
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if ( (paramarr_name == NULL) || (strlen(paramarr_name) == 0) ) {
+        lr_error_message("paramarr_name cannot be NULL or empty.");
+        lr_abort();
+    } else if ( (output_param_name == NULL) || (strlen(output_param_name) == 0) ) {
+        lr_error_message("output_param_name cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    elements = lrlib_paramarr_get_elements(paramarr_name, &num_elements);
+    needs_quotes = (char*)malloc(num_elements + 1);
+    if (needs_quotes == NULL) {
+        lr_error_message("Unable to allocate memory for needs_quotes.");
+        lr_abort();
+    }
+
+    // First pass: work out which elements need quotes, and the exact length of the CSV line.
+    for (i = 0; i < num_elements; i++) {
+        needs_quotes[i] = FALSE;
+        for (c = elements[i]; *c != '\0'; c++) {
+            total_length++;
+            if (*c == '"') {
+                total_length++; // the quote will be doubled
+                needs_quotes[i] = TRUE;
+            } else if ( (*c == ',') || (*c == '\r') || (*c == '\n') ) {
+                needs_quotes[i] = TRUE;
+            }
+        }
+        if (needs_quotes[i] == TRUE) {
+            total_length += 2; // opening and closing quotes
+        }
+        if (i > 0) {
+            total_length++; // comma
+        }
+    }
+
+    csv = (char*)malloc(total_length + 1);
+    if (csv == NULL) {
+        lr_error_message("Unable to allocate memory for the CSV line (%d bytes).", total_length + 1);
+        lr_abort();
+    }
+
+    // Second pass: write the CSV line.
+    position = csv;
+    for (i = 0; i < num_elements; i++) {
+        if (i > 0) {
+            *position++ = ',';
+        }
+        if (needs_quotes[i] == TRUE) {
+            *position++ = '"';
+            for (c = elements[i]; *c != '\0'; c++) {
+                if (*c == '"') {
+                    *position++ = '"';
+                }
+                *position++ = *c;
+            }
+            *position++ = '"';
+        } else {
+            int element_length = strlen(elements[i]);
+            memcpy(position, elements[i], element_length);
+            position += element_length;
+        }
+    }
+    *position = '\0';
+
+    lr_save_string(csv, output_param_name);
+
+    free(csv);
+    free(needs_quotes);
+    free(elements);
+
+    LRLIB_PROFILE_END("lrlib_paramarr_to_csv", profile_start_usec, total_length);
+    return total_length;
+}
+
+/**
+ * @brief Converts a parameter array to a JSON array of strings.
+ *
+ * Double quotes, backslashes and control characters in the elements are escaped, so the result
+ * is always valid JSON (as long as the elements are valid UTF-8).
+ *
+ * @param paramarr_name The name of the parameter array to convert.
+ * @param output_param_name The name of the parameter to save the JSON array to.
+ * @return Returns the length of the JSON array.
+ *
+ * @example:
+ *
+ * Action()
+ * {
+ *     lrlib_paramarr_create("Tags", "red", "say \"hi\"", "C:\\TEMP", LAST);
+ *
+ *     // TagsJson will contain: ["red","say \"hi\"","C:\\TEMP"]
+ *     lrlib_paramarr_to_json("Tags", "TagsJson");
+ *
+ *     web_custom_request("Save Tags",
+ *         "URL=http://www.example.com/api/tags",
+ *         "Method=POST",
+ *         "EncType=application/json",
+ *         "Body={TagsJson}",
+ *         LAST);
+ *
+ *     return 0;
+ * }
+ */
+int lrlib_paramarr_to_json(const char* paramarr_name, const char* output_param_name) {
+    const char* HEX_DIGITS = "0123456789abcdef";
+    int i;
+    int num_elements;
+    char** elements; // pointers to each element of the parameter array
+    int total_length = 2; // the length of the JSON array, starting with the [ and ] characters
+    char* json; // a buffer to hold the JSON array
+    char* position; // the place in the buffer where the next character will be written
+    const unsigned char* c; // the current character of the current element
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if ( (paramarr_name == NULL) || (strlen(paramarr_name) == 0) ) {
+        lr_error_message("paramarr_name cannot be NULL or empty.");
+        lr_abort();
+    } else if ( (output_param_name == NULL) || (strlen(output_param_name) == 0) ) {
+        lr_error_message("output_param_name cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    elements = lrlib_paramarr_get_elements(paramarr_name, &num_elements);
+
+    // First pass: work out the exact length of the JSON array.
+    for (i = 0; i < num_elements; i++) {
+        total_length += 2; // opening and closing quotes
+        if (i > 0) {
+            total_length++; // comma
+        }
+        for (c = (const unsigned char*)elements[i]; *c != '\0'; c++) {
+            if ( (*c == '"') || (*c == '\\') || (*c == '\b') || (*c == '\f') ||
+                 (*c == '\n') || (*c == '\r') || (*c == '\t') ) {
+                total_length += 2; // e.g. \" or \n
+            } else if (*c < 0x20) {
+                total_length += 6; // other control characters are written as \u00XX
+            } else {
+                total_length++;
+            }
+        }
+    }
+
+    json = (char*)malloc(total_length + 1);
+    if (json == NULL) {
+        lr_error_message("Unable to allocate memory for the JSON array (%d bytes).", total_length + 1);
+        lr_abort();
+    }
+
+    // Second pass: write the JSON array.
+    position = json;
+    *position++ = '[';
+    for (i = 0; i < num_elements; i++) {
+        if (i > 0) {
+            *position++ = ',';
+        }
+        *position++ = '"';
+        for (c = (const unsigned char*)elements[i]; *c != '\0'; c++) {
+            if ( (*c == '"') || (*c == '\\') ) {
+                *position++ = '\\';
+                *position++ = *c;
+            } else if (*c == '\b') {
+                *position++ = '\\';
+                *position++ = 'b';
+            } else if (*c == '\f') {
+                *position++ = '\\';
+                *position++ = 'f';
+            } else if (*c == '\n') {
+                *position++ = '\\';
+                *position++ = 'n';
+            } else if (*c == '\r') {
+                *position++ = '\\';
+                *position++ = 'r';
+            } else if (*c == '\t') {
+                *position++ = '\\';
+                *position++ = 't';
+            } else if (*c < 0x20) {
+                *position++ = '\\';
+                *position++ = 'u';
+                *position++ = '0';
+                *position++ = '0';
+                *position++ = HEX_DIGITS[*c >> 4];
+                *position++ = HEX_DIGITS[*c & 0x0F];
+            } else {
+                *position++ = *c;
+            }
+        }
+        *position++ = '"';
+    }
+    *position++ = ']';
+    *position = '\0';
+
+    lr_save_string(json, output_param_name);
+
+    free(json);
+    free(elements);
+
+    LRLIB_PROFILE_END("lrlib_paramarr_to_json", profile_start_usec, total_length);
+    return total_length;
+}
+
+/* Sort modes for lrlib_paramarr_sort */
+#define LRLIB_SORT_LEXICOGRAPHIC 0 // compare strings character by character (like strcmp)
+#define LRLIB_SORT_NUMERIC 1 // compare the numeric value of each element (like atof)
+#define LRLIB_SORT_NATURAL 2 // compare text as text and digits as numbers ("item2" < "item10")
+
+/* Sort orders for lrlib_paramarr_sort */
+#define LRLIB_SORT_ASCENDING 0
+#define LRLIB_SORT_DESCENDING 1
+
+/**
+ * @brief Sorts part of an index array with insertion sort, comparing the strings from a given
+ *        character position onwards. Used by lrlib_paramarr_radix_sort_strings for small groups.
+ */
+void lrlib_paramarr_insertion_sort_strings(char** elements, int* order, int count, int depth) {
+    int i;
+    int j;
+    int current;
+
+    for (i = 1; i < count; i++) {
+        current = order[i];
+        j = i - 1;
+        while ( (j >= 0) && (strcmp(elements[order[j]] + depth, elements[current] + depth) > 0) ) {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = current;
+    }
+}
+
+/**
+ * @brief Sorts an index array so that the strings it points to are in lexicographic order, using
+ *        a most-significant-digit (MSD) radix sort.
+ *
+ * The strings are put into 256 groups according to the character at position "depth". Each group
+ * is then sorted by the next character, and so on. Strings are never compared with each other
+ * (except in small groups, where insertion sort is faster).
+ *
+ * Each call uses about 2 KB of stack (for counts and starts), so the number of nested calls is
+ * kept small: the smaller groups are sorted by calling this function again, but the largest group
+ * is sorted by going around the loop again. A nested call always has at most half as many strings
+ * as its caller, so there are never more than about 20 nested calls (for a million strings), even
+ * if every string starts with the same long prefix.
+ *
+ * @param elements The strings to sort. These are not moved.
+ * @param order The part of the index array to sort (indexes into elements).
+ * @param temp A buffer that is at least as large as order.
+ * @param count The number of indexes to sort.
+ * @param depth The character position to sort on (all strings in this group share the characters
+ *        before this position).
+ */
+void lrlib_paramarr_radix_sort_strings(char** elements, int* order, int* temp, int count, int depth) {
+    int i;
+    int bucket;
+    int counts[256];
+    int starts[256];
+    int next_start;
+    int largest_bucket;
+    int largest_start = 0;
+
+    for (;;) {
+        if (count < 32) {
+            lrlib_paramarr_insertion_sort_strings(elements, order, count, depth);
+            return;
+        }
+
+        // Count how many strings have each character at this position. A string that has already
+        // ended is counted in bucket 0 (the null terminator), which sorts before every other
+        // character.
+        memset(counts, 0, sizeof(counts));
+        for (i = 0; i < count; i++) {
+            counts[(unsigned char)elements[order[i]][depth]]++;
+        }
+
+        // Work out where each bucket starts, then copy the indexes into place (this keeps equal
+        // strings in their original order).
+        next_start = 0;
+        for (bucket = 0; bucket < 256; bucket++) {
+            starts[bucket] = next_start;
+            next_start += counts[bucket];
+        }
+        for (i = 0; i < count; i++) {
+            bucket = (unsigned char)elements[order[i]][depth];
+            temp[starts[bucket]] = order[i];
+            starts[bucket]++;
+        }
+        memcpy(order, temp, count * sizeof(int));
+
+        // Sort each bucket by the next character. Bucket 0 holds strings that have ended, which are
+        // all equal, so it does not need to be sorted. The largest bucket is left until last.
+        largest_bucket = 1;
+        for (bucket = 2; bucket < 256; bucket++) {
+            if (counts[bucket] > counts[largest_bucket]) {
+                largest_bucket = bucket;
+            }
+        }
+        next_start = counts[0];
+        for (bucket = 1; bucket < 256; bucket++) {
+            if (bucket == largest_bucket) {
+                largest_start = next_start;
+            } else if (counts[bucket] > 1) {
+                lrlib_paramarr_radix_sort_strings(elements, order + next_start, temp, counts[bucket], depth + 1);
+            }
+            next_start += counts[bucket];
+        }
+
+        // Sort the largest bucket by the next character, without another nested call.
+        order = order + largest_start;
+        count = counts[largest_bucket];
+        depth++;
+    }
+}
+
+/**
+ * @brief Sorts an index array by numeric value, using a least-significant-digit (LSD) radix sort
+ *        on the bytes of each number.
+ *
+ * Each double is converted to 8 bytes that sort in the same order as the numbers themselves, then
+ * the indexes are sorted by each byte in turn (starting with the least significant byte).
+ *
+ * @param elements The strings to sort. These are not moved.
+ * @param order The index array to sort (indexes into elements).
+ * @param count The number of elements.
+ */
+void lrlib_paramarr_radix_sort_numbers(char** elements, int* order, int count) {
+    double atof(const char* string); // explicit declaration, as atof does not return an int
+    int i;
+    int byte_number;
+    int bucket;
+    int counts[256];
+    int starts[256];
+    int next_start;
+    double value;
+    unsigned char* keys; // 8 bytes for each element, least significant byte first
+    unsigned char* key;
+    int* temp;
+
+    keys = (unsigned char*)malloc(count * 8 + 1);
+    temp = (int*)malloc(count * sizeof(int) + 1);
+    if ( (keys == NULL) || (temp == NULL) ) {
+        lr_error_message("Unable to allocate memory to sort %d elements.", count);
+        lr_abort();
+    }
+
+    // Convert each element to a sort key. On Windows (and Linux), the bytes of a double are
+    // stored least significant byte first. The highest bit of the last byte is the sign bit.
+    // * For positive numbers, setting the sign bit makes them sort after the negative numbers.
+    // * For negative numbers, flipping every bit makes "more negative" numbers sort first.
+    for (i = 0; i < count; i++) {
+        value = atof(elements[i]);
+        key = keys + (i * 8);
+        memcpy(key, &value, 8);
+        if (key[7] & 0x80) {
+            for (byte_number = 0; byte_number < 8; byte_number++) {
+                key[byte_number] = ~key[byte_number];
+            }
+        } else {
+            key[7] = key[7] | 0x80;
+        }
+    }
+
+    // Sort by each byte, starting with the least significant byte. Each pass keeps the order from
+    // the previous pass for equal bytes, so after the last pass the keys are fully sorted.
+    for (byte_number = 0; byte_number < 8; byte_number++) {
+        memset(counts, 0, sizeof(counts));
+        for (i = 0; i < count; i++) {
+            counts[keys[(order[i] * 8) + byte_number]]++;
+        }
+
+        // If every key has the same value for this byte, then this pass would not change anything.
+        if (counts[keys[(order[0] * 8) + byte_number]] == count) {
+            continue;
+        }
+
+        next_start = 0;
+        for (bucket = 0; bucket < 256; bucket++) {
+            starts[bucket] = next_start;
+            next_start += counts[bucket];
+        }
+        for (i = 0; i < count; i++) {
+            bucket = keys[(order[i] * 8) + byte_number];
+            temp[starts[bucket]] = order[i];
+            starts[bucket]++;
+        }
+        memcpy(order, temp, count * sizeof(int));
+    }
+
+    free(temp);
+    free(keys);
+}
+
+/**
+ * @brief Compares two strings in "natural" order, where runs of digits are compared by their
+ *        numeric value. For example, "item2" comes before "item10".
+ *
+ * @return Returns a negative number if a comes first, a positive number if b comes first, or 0 if
+ *         they are equal.
+ */
+int lrlib_natural_compare(const char* a, const char* b) {
+    const char* a_digits; // the start of a run of digits in a (after any leading zeros)
+    const char* b_digits; // the start of a run of digits in b (after any leading zeros)
+    int a_length; // the number of digits in the run
+    int b_length;
+    int i;
+
+    while ( (*a != '\0') && (*b != '\0') ) {
+        if ( (isdigit((unsigned char)*a)) && (isdigit((unsigned char)*b)) ) {
+            // Skip leading zeros, then find the end of each run of digits.
+            while (*a == '0') {
+                a++;
+            }
+            while (*b == '0') {
+                b++;
+            }
+            a_digits = a;
+            b_digits = b;
+            while (isdigit((unsigned char)*a)) {
+                a++;
+            }
+            while (isdigit((unsigned char)*b)) {
+                b++;
+            }
+            a_length = a - a_digits;
+            b_length = b - b_digits;
+
+            // A number with more digits is larger. If they have the same number of digits, then
+            // the first digit that is different decides which number is larger.
+            if (a_length != b_length) {
+                return a_length - b_length;
+            }
+            for (i = 0; i < a_length; i++) {
+                if (a_digits[i] != b_digits[i]) {
+                    return a_digits[i] - b_digits[i];
+                }
+            }
+        } else {
+            if (*a != *b) {
+                return (unsigned char)*a - (unsigned char)*b;
+            }
+            a++;
+            b++;
+        }
+    }
+
+    return (unsigned char)*a - (unsigned char)*b;
+}
+
+/**
+ * @brief Sorts an index array in natural order, using a merge sort (which keeps equal elements in
+ *        their original order).
+ *
+ * @param elements The strings to sort. These are not moved.
+ * @param order The part of the index array to sort (indexes into elements).
+ * @param temp A buffer that is at least as large as order.
+ * @param count The number of indexes to sort.
+ */
+void lrlib_paramarr_merge_sort_natural(char** elements, int* order, int* temp, int count) {
+    int middle;
+    int left; // the next position in the left half
+    int right; // the next position in the right half
+    int i;
+
+    if (count < 2) {
+        return;
+    }
+
+    // Sort each half, then merge the two sorted halves together.
+    middle = count / 2;
+    lrlib_paramarr_merge_sort_natural(elements, order, temp, middle);
+    lrlib_paramarr_merge_sort_natural(elements, order + middle, temp, count - middle);
+
+    left = 0;
+    right = middle;
+    for (i = 0; i < count; i++) {
+        if ( (right >= count) ||
+             ( (left < middle) && (lrlib_natural_compare(elements[order[left]], elements[order[right]]) <= 0) ) ) {
+            temp[i] = order[left];
+            left++;
+        } else {
+            temp[i] = order[right];
+            right++;
+        }
+    }
+    memcpy(order, temp, count * sizeof(int));
+}
+
+/**
+ * @brief Sorts the elements of a parameter array.
+ *
+ * @param paramarr_name The name of the parameter array to sort. The sorted elements are saved back
+ *        to the same parameter array.
+ * @param sort_mode How to compare elements:
+ *        * LRLIB_SORT_LEXICOGRAPHIC - character by character, like strcmp ("10" < "9").
+ *        * LRLIB_SORT_NUMERIC - by numeric value, like atof ("9" < "10"). Elements that are not
+ *          numbers are treated as 0.
+ *        * LRLIB_SORT_NATURAL - text is compared as text, and runs of digits are compared as
+ *          numbers ("item9" < "item10").
+ * @param sort_order LRLIB_SORT_ASCENDING or LRLIB_SORT_DESCENDING.
+ * @return Returns the number of elements in the parameter array.
+ *
+ * @example:
+ *
+ * Action()
+ * {
+ *     // Simulate the creation of a parameter array.
+ *     // Note: Parameter array are usually created with with web_reg_save_param using ORD=All".
+ *     lrlib_paramarr_create("Prices", "19.99", "5.00", "120.50", "7.25", LAST);
+ *
+ *     // Find the most expensive item.
+ *     lrlib_paramarr_sort("Prices", LRLIB_SORT_NUMERIC, LRLIB_SORT_DESCENDING);
+ *     lr_output_message("Highest price: %s", lr_paramarr_idx("Prices", 1));
+ *
+ *     return 0;
+ * }
+ *
+ * @note Lexicographic and numeric sorts use radix sorts, which do not compare elements with each
+ *       other, so 100,000 elements can be sorted in a few milliseconds. Natural sorts use a merge
+ *       sort.
+ * @note For an ascending sort, elements that are equal keep their original order.
+ */
+int lrlib_paramarr_sort(const char* paramarr_name, int sort_mode, int sort_order) {
+    int i;
+    int num_elements;
+    char** elements; // pointers to each element of the parameter array
+    int* order; // the element indexes, in sorted order
+    int* temp; // a work area for the sort functions
+    lrlib_paramarr_emitter output; // saves the sorted elements back to the parameter array
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if ( (paramarr_name == NULL) || (strlen(paramarr_name) == 0) ) {
+        lr_error_message("paramarr_name cannot be NULL or empty.");
+        lr_abort();
+    } else if ( (sort_mode != LRLIB_SORT_LEXICOGRAPHIC) && (sort_mode != LRLIB_SORT_NUMERIC) && (sort_mode != LRLIB_SORT_NATURAL) ) {
+        lr_error_message("Invalid sort_mode: %d. Use LRLIB_SORT_LEXICOGRAPHIC, LRLIB_SORT_NUMERIC or LRLIB_SORT_NATURAL.", sort_mode);
+        lr_abort();
+    } else if ( (sort_order != LRLIB_SORT_ASCENDING) && (sort_order != LRLIB_SORT_DESCENDING) ) {
+        lr_error_message("Invalid sort_order: %d. Use LRLIB_SORT_ASCENDING or LRLIB_SORT_DESCENDING.", sort_order);
+        lr_abort();
+    }
+
+    if (lrlib_paramarr_emitter_init(&output, paramarr_name) == FALSE) {
+        lr_abort();
+    }
+
+    elements = lrlib_paramarr_get_elements(paramarr_name, &num_elements);
+    order = (int*)malloc(num_elements * sizeof(int) + 1);
+    temp = (int*)malloc(num_elements * sizeof(int) + 1);
+    if ( (order == NULL) || (temp == NULL) ) {
+        lr_error_message("Unable to allocate memory to sort %d elements.", num_elements);
+        lr_abort();
+    }
+
+    // Sort the element indexes (rather than moving the strings around).
+    for (i = 0; i < num_elements; i++) {
+        order[i] = i;
+    }
+    if (num_elements > 1) {
+        if (sort_mode == LRLIB_SORT_LEXICOGRAPHIC) {
+            lrlib_paramarr_radix_sort_strings(elements, order, temp, num_elements, 0);
+        } else if (sort_mode == LRLIB_SORT_NUMERIC) {
+            lrlib_paramarr_radix_sort_numbers(elements, order, num_elements);
+        } else {
+            lrlib_paramarr_merge_sort_natural(elements, order, temp, num_elements);
+        }
+    }
+
+    // Save the elements back to the parameter array in one pass. The element pointers point to
+    // copies of the old values, so overwriting the parameters does not change them.
+    for (i = 0; i < num_elements; i++) {
+        if (sort_order == LRLIB_SORT_ASCENDING) {
+            lrlib_paramarr_emitter_save(&output, elements[order[i]]);
+        } else {
+            lrlib_paramarr_emitter_save(&output, elements[order[num_elements - 1 - i]]);
+        }
+    }
+    lrlib_paramarr_emitter_finish(&output);
+
+    free(temp);
+    free(order);
+    free(elements);
+
+    LRLIB_PROFILE_END("lrlib_paramarr_sort", profile_start_usec, 0);
+    return num_elements;
+}
+
+/**
+ * @brief Finds the k-th smallest number in an array (the first element is k = 0), using the
+ *        quickselect algorithm. The array is partly reordered.
+ *
+ * @param values The numbers to search.
+ * @param count The number of values.
+ * @param k The position (in sorted order) of the value to find.
+ * @return Returns the k-th smallest value.
+ */
+double lrlib_quickselect(double* values, int count, int k) {
+    int left = 0;
+    int right = count - 1;
+    int middle;
+    int i;
+    int j;
+    double pivot;
+    double temp;
+
+    while (left < right) {
+        // Use the median of the first, middle and last values as the pivot. This avoids slow
+        // behaviour when the values are already sorted.
+        middle = left + ((right - left) / 2);
+        if (values[middle] < values[left]) {
+            temp = values[middle]; values[middle] = values[left]; values[left] = temp;
+        }
+        if (values[right] < values[left]) {
+            temp = values[right]; values[right] = values[left]; values[left] = temp;
+        }
+        if (values[right] < values[middle]) {
+            temp = values[right]; values[right] = values[middle]; values[middle] = temp;
+        }
+        pivot = values[middle];
+
+        // Move values smaller than the pivot to the left, and larger values to the right.
+        i = left;
+        j = right;
+        while (i <= j) {
+            while (values[i] < pivot) {
+                i++;
+            }
+            while (values[j] > pivot) {
+                j--;
+            }
+            if (i <= j) {
+                temp = values[i]; values[i] = values[j]; values[j] = temp;
+                i++;
+                j--;
+            }
+        }
+
+        // Keep searching only the part that contains position k.
+        if (k <= j) {
+            right = j;
+        } else if (k >= i) {
+            left = i;
+        } else {
+            break; // values between j and i are all equal to the pivot
+        }
+    }
+
+    return values[k];
+}
+
+/**
+ * @brief Calculates statistics for a parameter array of numbers.
+ *
+ * The following parameters are created (where "Stats" is the output prefix):
+ *     {Stats_count}, {Stats_sum}, {Stats_min}, {Stats_max}, {Stats_mean}, {Stats_stddev}
+ * and one parameter for each requested percentile, e.g. {Stats_p90}. A decimal point in the
+ * percentile is replaced with an underscore, so the 99.9th percentile is saved to {Stats_p99_9}.
+ *
+ * @param paramarr_name The name of the parameter array. Every element must be a number.
+ * @param percentiles A comma-separated list of percentiles to calculate (e.g. "50,90,99,99.9"),
+ *        or an empty string if no percentiles are needed. Spaces around each percentile are
+ *        ignored, so "50, 90" is the same as "50,90".
+ * @param output_prefix The prefix for the names of the output parameters.
+ * @return Returns the number of elements in the parameter array.
+ *
+ * @example:
+ *
+ * Action()
+ * {
+ *     // Save the response times from a report page, then work out the 90th percentile.
+ *     web_reg_save_param_ex("ParamName=ResponseTimes", "LB=<td class=\"time\">", "RB=</td>",
+ *         "Ordinal=All", LAST);
+ *     web_url("Report", "URL=http://www.example.com/report", LAST);
+ *
+ *     lrlib_paramarr_stats("ResponseTimes", "50,90", "ResponseTimeStats");
+ *     lr_output_message("min=%s, mean=%s, 90th percentile=%s",
+ *         lr_eval_string("{ResponseTimeStats_min}"),
+ *         lr_eval_string("{ResponseTimeStats_mean}"),
+ *         lr_eval_string("{ResponseTimeStats_p90}"));
+ *
+ *     return 0;
+ * }
+ *
+ * @note Percentiles use the "nearest rank" method: the p-th percentile is the smallest value that
+ *       is greater than or equal to p percent of the values.
+ * @note The standard deviation is the population standard deviation (the same as LoadRunner
+ *       Analysis uses).
+ */
+int lrlib_paramarr_stats(const char* paramarr_name, const char* percentiles, const char* output_prefix) {
+    double sqrt(double x); // explicit declaration, as sqrt does not return an int
+    double ceil(double x);
+    int i;
+    int num_elements;
+    double* values; // the numbers, in one contiguous buffer
+    double sums[4]; // four separate running totals (see below)
+    double mins[4];
+    double maxs[4];
+    double sum;
+    double min;
+    double max;
+    double mean;
+    double squares; // the sum of the squared differences from the mean
+    double difference;
+    double percentile;
+    int rank;
+    const char* c; // the current position in the percentiles string
+    char* end; // the end of the current percentile in the percentiles string
+    const char* next; // the start of the next percentile in the percentiles string
+    char percentile_text[32]; // the current percentile, e.g. "99.9"
+    char param_name[LRLIB_PARAM_NAME_BUFFER_LENGTH];
+    char value_text[64];
+    int length;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if ( (paramarr_name == NULL) || (strlen(paramarr_name) == 0) ) {
+        lr_error_message("paramarr_name cannot be NULL or empty.");
+        lr_abort();
+    } else if (percentiles == NULL) {
+        lr_error_message("percentiles cannot be NULL (use \"\" for no percentiles).");
+        lr_abort();
+    } else if ( (output_prefix == NULL) || (strlen(output_prefix) == 0) ) {
+        lr_error_message("output_prefix cannot be NULL or empty.");
+        lr_abort();
+    } else if (strlen(output_prefix) > LRLIB_MAX_PARAM_NAME_LENGTH) {
+        lr_error_message("output_prefix is too long.");
+        lr_abort();
+    }
+
+    num_elements = lr_paramarr_len(paramarr_name);
+    if (num_elements < 1) {
+        lr_error_message("Parameter array %s has no elements.", paramarr_name);
+        lr_abort();
+    }
+
+    // Convert every element to a double, and store them all in one buffer.
+    values = (double*)malloc(num_elements * sizeof(double));
+    if (values == NULL) {
+        lr_error_message("Unable to allocate memory for %d values.", num_elements);
+        lr_abort();
+    }
+    for (i = 0; i < num_elements; i++) {
+        if (lrlib_parse_double(lr_paramarr_idx(paramarr_name, i + 1), &values[i]) == FALSE) {
+            lr_error_message("Element %d of %s is not a number: \"%s\"", i + 1, paramarr_name,
+                lr_paramarr_idx(paramarr_name, i + 1));
+            lr_abort();
+        }
+    }
+
+    // Add up the values and find the smallest and largest. Keeping four separate totals (one for
+    // every 4th value) lets the processor work on four values at the same time, rather than
+    // waiting for each addition to finish before starting the next one.
+    for (i = 0; i < 4; i++) {
+        sums[i] = 0;
+        mins[i] = values[0];
+        maxs[i] = values[0];
+    }
+    for (i = 0; i + 3 < num_elements; i += 4) {
+        sums[0] += values[i];
+        sums[1] += values[i + 1];
+        sums[2] += values[i + 2];
+        sums[3] += values[i + 3];
+        if (values[i] < mins[0]) { mins[0] = values[i]; }
+        if (values[i + 1] < mins[1]) { mins[1] = values[i + 1]; }
+        if (values[i + 2] < mins[2]) { mins[2] = values[i + 2]; }
+        if (values[i + 3] < mins[3]) { mins[3] = values[i + 3]; }
+        if (values[i] > maxs[0]) { maxs[0] = values[i]; }
+        if (values[i + 1] > maxs[1]) { maxs[1] = values[i + 1]; }
+        if (values[i + 2] > maxs[2]) { maxs[2] = values[i + 2]; }
+        if (values[i + 3] > maxs[3]) { maxs[3] = values[i + 3]; }
+    }
+    for (; i < num_elements; i++) { // the last few values (if the count is not a multiple of 4)
+        sums[0] += values[i];
+        if (values[i] < mins[0]) { mins[0] = values[i]; }
+        if (values[i] > maxs[0]) { maxs[0] = values[i]; }
+    }
+    sum = sums[0] + sums[1] + sums[2] + sums[3];
+    min = mins[0];
+    max = maxs[0];
+    for (i = 1; i < 4; i++) {
+        if (mins[i] < min) { min = mins[i]; }
+        if (maxs[i] > max) { max = maxs[i]; }
+    }
+    mean = sum / num_elements;
+
+    // The standard deviation is calculated in a second pass, which is more accurate than keeping
+    // a running total of the squares.
+    squares = 0;
+    for (i = 0; i < num_elements; i++) {
+        difference = values[i] - mean;
+        squares += difference * difference;
+    }
+
+    // Save the results.
+    sprintf(param_name, "%s_count", output_prefix);
+    lr_save_int(num_elements, param_name);
+    sprintf(param_name, "%s_sum", output_prefix);
+    sprintf(value_text, "%.15g", sum);
+    lr_save_string(value_text, param_name);
+    sprintf(param_name, "%s_min", output_prefix);
+    sprintf(value_text, "%.15g", min);
+    lr_save_string(value_text, param_name);
+    sprintf(param_name, "%s_max", output_prefix);
+    sprintf(value_text, "%.15g", max);
+    lr_save_string(value_text, param_name);
+    sprintf(param_name, "%s_mean", output_prefix);
+    sprintf(value_text, "%.15g", mean);
+    lr_save_string(value_text, param_name);
+    sprintf(param_name, "%s_stddev", output_prefix);
+    sprintf(value_text, "%.15g", sqrt(squares / num_elements));
+    lr_save_string(value_text, param_name);
+
+    // Calculate each percentile in the comma-separated list.
+    c = percentiles;
+    while (*c != '\0') {
+        // Skip any spaces before the percentile.
+        while ( (*c == ' ') || (*c == '\t') ) {
+            c++;
+        }
+        if (*c == '\0') {
+            break; // only spaces after the last comma
+        }
+
+        end = strchr(c, ',');
+        if (end == NULL) {
+            length = strlen(c);
+        } else {
+            length = end - c;
+        }
+        next = c + length;
+
+        // Leave out any spaces after the percentile, so they do not end up in the parameter name.
+        while ( (length > 0) && ((c[length - 1] == ' ') || (c[length - 1] == '\t')) ) {
+            length--;
+        }
+        if ( (length == 0) || (length >= sizeof(percentile_text)) ) {
+            lr_error_message("Invalid percentiles list: \"%s\"", percentiles);
+            lr_abort();
+        }
+        memcpy(percentile_text, c, length);
+        percentile_text[length] = '\0';
+
+        if ( (lrlib_parse_double(percentile_text, &percentile) == FALSE) || (percentile <= 0) || (percentile > 100) ) {
+            lr_error_message("Invalid percentile: \"%s\" (must be greater than 0 and not more than 100).", percentile_text);
+            lr_abort();
+        }
+
+        // Nearest rank: the smallest value that is >= p percent of the values. A tiny amount is
+        // subtracted before rounding up, as numbers like 99.9 cannot be stored exactly in a
+        // double (99.9% of 1000 would otherwise be calculated as 999.0000000000001, rank 1000).
+        rank = (int)ceil(((percentile / 100) * num_elements) - 0.000001);
+        if (rank < 1) {
+            rank = 1;
+        }
+        sprintf(value_text, "%.15g", lrlib_quickselect(values, num_elements, rank - 1));
+
+        // The parameter name is the prefix, then "_p", then the percentile with "." replaced by "_".
+        for (i = 0; i < length; i++) {
+            if (percentile_text[i] == '.') {
+                percentile_text[i] = '_';
+            }
+        }
+        sprintf(param_name, "%s_p%s", output_prefix, percentile_text);
+        lr_save_string(value_text, param_name);
+
+        c = next;
+        if (*c == ',') {
+            c++;
+        }
+    }
+
+    free(values);
+
+    LRLIB_PROFILE_END("lrlib_paramarr_stats", profile_start_usec, 0);
+    return num_elements;
+}
+
+// Note existing LoadRunner functions:
+// * lr_paramarr_idx
+// * lr_paramarr_len
+// * lr_paramarr_random
+// * lr_param_increment
+// * lr_free_parameter
+
+// Note that there are already some functions in the strings.h library.
 
 
 //TODO: how to save a binary blob (containing nulls) to a paramater. lr_save_var?
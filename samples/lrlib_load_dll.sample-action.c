@@ -0,0 +1,35 @@
+// Measures how long it takes to load a DLL with lr_load_dll, and with lrlib_load_dll (which only
+// loads each DLL once per vuser). Run this in VuGen, or with a few vusers in the Controller to see
+// the effect of many vusers starting at the same time.
+
+Action()
+{
+    const int CALLS = 1000;
+    merc_timer_handle_t timer;
+    double lr_load_dll_time;
+    double lrlib_load_dll_time;
+    double first_call_time;
+    int i;
+
+    timer = lr_start_timer();
+    for (i = 0; i < CALLS; i++) {
+        lr_load_dll("kernel32.dll");
+    }
+    lr_load_dll_time = lr_end_timer(timer);
+
+    timer = lr_start_timer();
+    lrlib_load_dll("psapi.dll");
+    first_call_time = lr_end_timer(timer);
+
+    timer = lr_start_timer();
+    for (i = 0; i < CALLS; i++) {
+        lrlib_load_dll("psapi.dll");
+    }
+    lrlib_load_dll_time = lr_end_timer(timer);
+
+    lr_output_message("lr_load_dll:    %.3f ms per call", lr_load_dll_time * 1000 / CALLS);
+    lr_output_message("lrlib_load_dll: %.3f ms for the first call, %.6f ms per call after that",
+        first_call_time * 1000, lrlib_load_dll_time * 1000 / CALLS);
+
+    return 0;
+}
@@ -0,0 +1,34 @@
+Action()
+{
+    // Benchmark: how many parameter array elements per second can be saved with the emitter,
+    // compared with the sprintf("%s_%d") + lr_save_string pattern it replaces.
+    const int ELEMENT_COUNT = 100000;
+    char element_name[LRLIB_PARAM_NAME_BUFFER_LENGTH];
+    lrlib_paramarr_emitter emitter;
+    int i;
+    merc_timer_handle_t timer;
+    double elapsed;
+
+    timer = lr_start_timer();
+    for (i = 1; i <= ELEMENT_COUNT; i++)
+    {
+        sprintf(element_name, "%s_%d", "SprintfArray", i);
+        lr_save_string("value", element_name);
+    }
+    sprintf(element_name, "%s_count", "SprintfArray");
+    lr_save_int(ELEMENT_COUNT, element_name);
+    elapsed = lr_end_timer(timer);
+    lr_output_message("sprintf: %.0f elements per second.", ELEMENT_COUNT / elapsed);
+
+    timer = lr_start_timer();
+    lrlib_paramarr_emitter_init(&emitter, "EmitterArray");
+    for (i = 1; i <= ELEMENT_COUNT; i++)
+    {
+        lrlib_paramarr_emitter_save(&emitter, "value");
+    }
+    lrlib_paramarr_emitter_finish(&emitter);
+    elapsed = lr_end_timer(timer);
+    lr_output_message("emitter: %.0f elements per second.", ELEMENT_COUNT / elapsed);
+
+    return 0;
+}
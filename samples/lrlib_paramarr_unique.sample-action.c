@@ -0,0 +1,27 @@
+Action()
+{
+    // Benchmark: remove duplicates from a 100,000 element parameter array (50,000 unique values).
+    const int ELEMENT_COUNT = 100000;
+    char element_name[32];
+    char element_value[32];
+    int i;
+    int res;
+    merc_timer_handle_t timer;
+    double elapsed;
+
+    for (i = 1; i <= ELEMENT_COUNT; i++)
+    {
+        sprintf(element_name, "Products_%d", i);
+        sprintf(element_value, "P%d", i % (ELEMENT_COUNT / 2));
+        lr_save_string(element_value, element_name);
+    }
+    lr_save_int(ELEMENT_COUNT, "Products_count");
+
+    timer = lr_start_timer();
+    res = lrlib_paramarr_unique("Products", "UniqueProducts");
+    elapsed = lr_end_timer(timer);
+
+    lr_output_message("res = %d, elapsed = %.3f seconds.", res, elapsed);
+
+    return 0;
+}
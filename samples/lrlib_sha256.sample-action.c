@@ -0,0 +1,34 @@
+Action()
+{
+    const int size = 1024 * 1024; // hash 1 MB at a time
+    const int repeats = 64;
+    char* data;
+    double start_usec;
+    double elapsed_usec;
+    int i;
+
+    // Throughput of SHA-256 over a large buffer.
+    data = (char*)malloc(size + 1);
+    memset(data, 'a', size);
+    data[size] = '\0';
+
+    start_usec = lrlib_timer_now_usec();
+    for (i = 0; i < repeats; i++) {
+        lrlib_sha256(data, LRLIB_DIGEST_HEX, "Hash");
+    }
+    elapsed_usec = lrlib_timer_now_usec() - start_usec;
+    lr_output_message("SHA-256: %.3f GB/s (%.1f MB/s).", (double)size * repeats / elapsed_usec / 1000,
+        (double)size * repeats / elapsed_usec);
+    free(data);
+
+    // Cost of signing a typical API request. The key is only processed on the first call.
+    lr_save_string("GET\n/api/orders\nhost:example.com\nx-date:20240101T000000Z", "StringToSign");
+    start_usec = lrlib_timer_now_usec();
+    for (i = 0; i < 100000; i++) {
+        lrlib_hmac_sha256("my-secret-key", lr_eval_string("{StringToSign}"), LRLIB_DIGEST_BASE64, "Signature");
+    }
+    elapsed_usec = lrlib_timer_now_usec() - start_usec;
+    lr_output_message("HMAC-SHA256: %.2f us per signature (%s).", elapsed_usec / 100000, lr_eval_string("{Signature}"));
+
+    return 0;
+}
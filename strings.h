@@ -1,3 +1,14 @@
+// The self-profiler is in lrlib.h. If lrlib.h has not been included, the functions in this file
+// are not profiled. (To copy one of these functions into a script without lrlib.h, either copy
+// these two macros as well, or delete the LRLIB_PROFILE_START and LRLIB_PROFILE_END lines.)
+#ifndef LRLIB_PROFILE_START
+#define LRLIB_PROFILE_START(start_usec) do { } while (0)
+#endif
+
+#ifndef LRLIB_PROFILE_END
+#define LRLIB_PROFILE_END(function_name, start_usec, bytes) do { } while (0)
+#endif
+
 /**
  * Splits a delimited string and saves the elements to a parameter array
  *
@@ -23,9 +34,20 @@
  */
 int lrlib_str_split(char* string_to_split, char* delimiter, const char* output_paramarr_name) {
     char* token; // a pointer to the current position in the tokenized string.
-    int num_pieces; // number of pieces that the string has been split into. This is always at
-                    // least 1, as long as the string is not null or zero characters long.
+    int num_pieces = 0; // number of pieces that the string has been split into. This is always at
+                        // least 1, as long as the string is not null or zero characters long.
     char* param_name; // holds the parameter names for each element of the parameter array.
+    char short_param_name[256]; // used as param_name, unless the name is too long to fit.
+    char* number; // the part of param_name after "ParameterName_", where the element number goes.
+    char digits[10]; // the digits of the element number, from right to left.
+    int num_digits;
+    unsigned int value;
+    int i;
+    int length; // length of string_to_split (measured before strtok changes it)
+    int name_length; // length of output_paramarr_name
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
 
     // Check input variables
     if ( (string_to_split == NULL) || (strlen(string_to_split) == 0) ) {
@@ -39,42 +61,72 @@ int lrlib_str_split(char* string_to_split, char* delimiter, const char* output_p
         lr_abort();
     }
 
-    // Allocate memory for the buffer. It must be be large enough to contain the
-    // {ParameterName_count} parameter name (plus a NULL terminator character).
-    param_name = (char*)malloc(strlen(output_paramarr_name) + strlen("_count") + 1);
-    if (param_name == NULL) {
-        lr_error_message("Unable to allocate memory for param_name.");
-        lr_abort();
+    length = strlen(string_to_split);
+    name_length = strlen(output_paramarr_name);
+
+    // The buffer must be be large enough to contain the {ParameterName_count} parameter name, or
+    // the name with the largest element number (plus a NULL terminator character). Memory is only
+    // allocated for names that are too long for the buffer on the stack.
+    param_name = short_param_name;
+    if (name_length + 16 > sizeof(short_param_name)) {
+        param_name = (char*)malloc(name_length + 16);
+        if (param_name == NULL) {
+            lr_error_message("Unable to allocate memory for param_name.");
+            lr_abort();
+        }
     }
 
-    // Note regarding implicit declarations: we do not need to explicitly declare strtok  or strcat
-    // (even though they don't return an int), as we are typecasting its return value, and
+    // "ParameterName_" is written once. Only the element number after it changes for each element,
+    // which is much faster than calling sprintf("%s_%d") for every element.
+    memcpy(param_name, output_paramarr_name, name_length);
+    param_name[name_length] = '_';
+    number = param_name + name_length + 1;
+
+    // Note regarding implicit declarations: we do not need to explicitly declare strtok (even
+    // though it doesn't return an int), as we are typecasting its return value, and
     // sizeof(char*) is the same as sizeof(int).
     token = (char*)strtok(string_to_split, delimiter); // Get the first token
     if (token == NULL) {
-        // The delimiter was not found in string_to_split, so the entire string is saved to the
-        // output parameter. The output parameter should be called {ParameterName_1}
-        strcpy(param_name, output_paramarr_name);
-        lr_save_string(string_to_split, (char*)strcat(param_name, "_1"));
+        // The string only contains delimiters, so the entire string is saved to the output
+        // parameter. The output parameter should be called {ParameterName_1}. The next call to
+        // strtok will return NULL, so this is the only element.
+        token = string_to_split;
     }
 
     while (token != NULL) { // While valid tokens are returned.
         num_pieces++;
+
+        // Write the element number after "ParameterName_". The digits are worked out from right to
+        // left, then copied in the right order.
+        value = num_pieces;
+        num_digits = 0;
+        do {
+            digits[num_digits] = (char)('0' + (value % 10));
+            num_digits++;
+            value = value / 10;
+        } while (value != 0);
+        for (i = 0; i < num_digits; i++) {
+            number[i] = digits[num_digits - 1 - i];
+        }
+        number[num_digits] = '\0';
+
         // Create the {ParameterName_x} parameter for each element of the parameter array.
-        sprintf(param_name, "%s_%d", output_paramarr_name, num_pieces);
         lr_save_string(token, param_name);
         token = (char*)strtok(NULL, delimiter); // Get the next token.
     }
 
     // Create a {ParameterName_count} parameter, so that the lr_paramarr_* functions may be used.
-    strcpy(param_name, output_paramarr_name);
-    lr_save_int(num_pieces, (char*)strcat(param_name, "_count"));
+    strcpy(number, "count");
+    lr_save_int(num_pieces, param_name);
 
-    // Free the small amount of memory allocated for the parameter name.
-    free(param_name);
+    // Free the memory allocated for the parameter name (if it was too long for the stack buffer).
+    if (param_name != short_param_name) {
+        free(param_name);
+    }
 
     // Return the numer of pieces that the string was split into. If the delimiter was not found,
     // then this will be 1.
+    LRLIB_PROFILE_END("lrlib_str_split", profile_start_usec, length);
     return num_pieces;
 }
 
@@ -154,7 +206,7 @@ char* lrlib_sapeventqueue_decode(char* enc_string, char* buf) {
             // Get the hex value from the input string
             code[0] = enc_string[i+3];
             code[1] = enc_string[i+4];
-            code[3] = NULL;
+            code[2] = NULL;
             // Convert the hex value to the appropriate character, and add it to buf
             rc = sscanf(code, "%2x", &hex);
             if (rc != 1) {
@@ -187,6 +239,9 @@ void lrlib_str_reverse(const char* string_to_reverse, const char* output_param_n
     int j; // loop counter for string_to_reverse
     int length; // length of string_to_reverse (reversed_string will have the same length)
     char* reversed_string;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
 
     // Check input variables
     if ( (string_to_reverse == NULL) || (strlen(string_to_reverse) == 0) ) {
@@ -219,10 +274,461 @@ void lrlib_str_reverse(const char* string_to_reverse, const char* output_param_n
     // Release the heap memory that was allocated to hold the reversed string.
     free(reversed_string);
 
+    LRLIB_PROFILE_END("lrlib_str_reverse", profile_start_usec, length);
     return;
 }
 
 
+/*
+ * Base64
+ * ======
+ * Base64 (RFC 4648) and base64url (the URL-safe alphabet used by JWTs, with no "=" padding)
+ * encoding and decoding. The data to encode is given with its length, so it can contain null
+ * bytes, and decoded data is saved with lr_save_var, so binary data is kept intact. Encoded and
+ * decoded output is sized exactly, and allocated once.
+ *
+ * Encoding looks up two output characters (12 bits) at a time, and decoding uses a 256-entry
+ * table, so no characters need to be compared in the main loops.
+ */
+
+#define LRLIB_BASE64 0 // "+" and "/", padded with "="
+#define LRLIB_BASE64URL 1 // "-" and "_", not padded
+#define LRLIB_BASE64_FILE_CHUNK 49152 // bytes read at a time by lrlib_base64_encode_file (a multiple of 3)
+#define LRLIB_BASE64_INVALID 0xFF // marks characters that are not part of either alphabet
+
+char lrlib_base64_pairs[2][4096 * 2]; // every pair of output characters, for each alphabet
+unsigned char lrlib_base64_values[256]; // the 6-bit value of each character (either alphabet)
+
+/**
+ * Fills the base64 lookup tables, if it has not been done already.
+ */
+void lrlib_base64_init() {
+    static const char* ALPHABETS[2] = {
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/",
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
+    };
+    int alphabet;
+    int i;
+
+    if (lrlib_base64_pairs[0][0] != '\0') {
+        return;
+    }
+
+    for (alphabet = 0; alphabet < 2; alphabet++) {
+        for (i = 0; i < 4096; i++) {
+            lrlib_base64_pairs[alphabet][i * 2] = ALPHABETS[alphabet][i >> 6];
+            lrlib_base64_pairs[alphabet][i * 2 + 1] = ALPHABETS[alphabet][i & 0x3F];
+        }
+    }
+
+    memset(lrlib_base64_values, LRLIB_BASE64_INVALID, sizeof(lrlib_base64_values));
+    for (i = 0; i < 64; i++) {
+        lrlib_base64_values[(unsigned char)ALPHABETS[0][i]] = i;
+        lrlib_base64_values[(unsigned char)ALPHABETS[1][i]] = i;
+    }
+}
+
+/**
+ * Returns the number of characters needed to base64 encode data of a given length (not including
+ * a terminating null).
+ */
+int lrlib_base64_encoded_length(int length, int alphabet) {
+    if (alphabet == LRLIB_BASE64URL) {
+        return (length / 3) * 4 + ((length % 3) * 4 + 2) / 3; // no padding
+    }
+    return ((length + 2) / 3) * 4;
+}
+
+/**
+ * Base64 encodes data into a buffer (which must have room for lrlib_base64_encoded_length
+ * characters), and returns the number of characters written. A terminating null is not written.
+ */
+int lrlib_base64_encode_buffer(const unsigned char* data, int length, int alphabet, char* buffer) {
+    const char* pairs = lrlib_base64_pairs[alphabet];
+    char* output = buffer;
+    unsigned int group;
+    int i = 0;
+
+    lrlib_base64_init();
+
+    // Each 3 bytes of input becomes two 12-bit halves, and each half is two output characters.
+    for (i = 0; i + 3 <= length; i += 3) {
+        group = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+        memcpy(output, pairs + (group >> 12) * 2, 2);
+        memcpy(output + 2, pairs + (group & 0xFFF) * 2, 2);
+        output += 4;
+    }
+
+    // The last 1 or 2 bytes.
+    if (i < length) {
+        group = data[i] << 16;
+        if (i + 1 < length) {
+            group |= data[i + 1] << 8;
+        }
+        memcpy(output, pairs + (group >> 12) * 2, 2);
+        output += 2;
+        if (i + 1 < length) {
+            *output++ = pairs[(group & 0xFFF) * 2];
+        } else if (alphabet == LRLIB_BASE64) {
+            *output++ = '=';
+        }
+        if (alphabet == LRLIB_BASE64) {
+            *output++ = '=';
+        }
+    }
+
+    return output - buffer;
+}
+
+/**
+ * Decodes base64 text (in either alphabet, with or without padding) into a buffer, which must have
+ * room for (length / 4) * 3 + 2 bytes. Whitespace (e.g. the line breaks that MIME adds every 76
+ * characters) is ignored.
+ *
+ * @return Returns the number of bytes written, or -1 if the text is not valid base64.
+ */
+int lrlib_base64_decode_buffer(const char* encoded, int length, unsigned char* buffer) {
+    const unsigned char* input = (const unsigned char*)encoded;
+    unsigned char* output = buffer;
+    unsigned int group = 0;
+    int group_length = 0; // the number of characters in group
+    int padding = 0;
+    unsigned char value;
+    int i = 0;
+
+    lrlib_base64_init();
+
+    // Fast path: whole groups of 4 valid characters.
+    while (i + 4 <= length) {
+        const unsigned char a = lrlib_base64_values[input[i]];
+        const unsigned char b = lrlib_base64_values[input[i + 1]];
+        const unsigned char c = lrlib_base64_values[input[i + 2]];
+        const unsigned char d = lrlib_base64_values[input[i + 3]];
+        if ( (a | b | c | d) == LRLIB_BASE64_INVALID ) {
+            break; // padding, whitespace or an invalid character
+        }
+        group = (a << 18) | (b << 12) | (c << 6) | d;
+        output[0] = (group >> 16) & 0xFF;
+        output[1] = (group >> 8) & 0xFF;
+        output[2] = group & 0xFF;
+        output += 3;
+        i += 4;
+    }
+
+    // The rest of the text, one character at a time.
+    group = 0;
+    for (; i < length; i++) {
+        if ( (input[i] == ' ') || (input[i] == '\r') || (input[i] == '\n') || (input[i] == '\t') ) {
+            continue;
+        } else if (input[i] == '=') {
+            padding++;
+            continue;
+        }
+
+        value = lrlib_base64_values[input[i]];
+        if ( (value == LRLIB_BASE64_INVALID) || (padding > 0) ) {
+            return -1;
+        }
+        group = (group << 6) | value;
+        group_length++;
+        if (group_length == 4) {
+            output[0] = (group >> 16) & 0xFF;
+            output[1] = (group >> 8) & 0xFF;
+            output[2] = group & 0xFF;
+            output += 3;
+            group = 0;
+            group_length = 0;
+        }
+    }
+
+    // A final partial group of 2 or 3 characters holds 1 or 2 bytes.
+    if (group_length == 1) {
+        return -1;
+    } else if (group_length == 2) {
+        *output++ = (group >> 4) & 0xFF;
+    } else if (group_length == 3) {
+        *output++ = (group >> 10) & 0xFF;
+        *output++ = (group >> 2) & 0xFF;
+    }
+    if ( (padding > 2) || ( (padding > 0) && (group_length + padding != 4) ) ) {
+        return -1;
+    }
+
+    return output - buffer;
+}
+
+/**
+ * Base64 encodes data, and saves it to a parameter.
+ *
+ * @param[in] The data to encode. This can contain null bytes.
+ * @param[in] The number of bytes to encode. For a string, use strlen.
+ * @param[in] The alphabet to use: LRLIB_BASE64 or LRLIB_BASE64URL.
+ * @param[in] The name of the parameter to save the encoded text to.
+ * @return    Returns the length of the encoded text.
+ *
+ * Example code:
+ *     // HTTP Basic authentication.
+ *     char* credentials = lr_eval_string("{UserName}:{Password}");
+ *     lrlib_base64_encode(credentials, strlen(credentials), LRLIB_BASE64, "Credentials");
+ *     web_add_header("Authorization", lr_eval_string("Basic {Credentials}"));
+ */
+int lrlib_base64_encode(const char* data, int length, int alphabet, const char* output_param_name) {
+    char* encoded;
+    int encoded_length;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if ( (data == NULL) || (length < 0) ) {
+        lr_error_message("data cannot be NULL, and length cannot be negative.");
+        lr_abort();
+    } else if ( (alphabet != LRLIB_BASE64) && (alphabet != LRLIB_BASE64URL) ) {
+        lr_error_message("Invalid alphabet: %d.", alphabet);
+        lr_abort();
+    } else if ( (output_param_name == NULL) || (strlen(output_param_name) == 0) ) {
+        lr_error_message("output_param_name cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    encoded = (char*)malloc(lrlib_base64_encoded_length(length, alphabet) + 1);
+    if (encoded == NULL) {
+        lr_error_message("Unable to allocate memory for the encoded text.");
+        lr_abort();
+    }
+
+    encoded_length = lrlib_base64_encode_buffer(data, length, alphabet, encoded);
+    encoded[encoded_length] = '\0';
+    lr_save_string(encoded, output_param_name);
+    free(encoded);
+
+    LRLIB_PROFILE_END("lrlib_base64_encode", profile_start_usec, length);
+    return encoded_length;
+}
+
+/**
+ * Decodes base64 or base64url text, and saves the data to a parameter. The data can be binary, as
+ * it is saved with lr_save_var.
+ *
+ * @param[in] The text to decode. Either alphabet can be used, padding is optional, and whitespace
+ *            is ignored.
+ * @param[in] The name of the parameter to save the decoded data to.
+ * @return    Returns the number of bytes decoded, or -1 if the text is not valid base64.
+ *
+ * Example code:
+ *     // Read the payload of a JWT (the part between the two dots).
+ *     lrlib_str_split(lr_eval_string("{AccessToken}"), ".", "JwtPart");
+ *     lrlib_base64_decode(lr_paramarr_idx("JwtPart", 2), "JwtPayload");
+ *     lr_output_message("JWT payload: %s", lr_eval_string("{JwtPayload}"));
+ */
+int lrlib_base64_decode(const char* encoded, const char* output_param_name) {
+    unsigned char* decoded;
+    int length;
+    int decoded_length;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if (encoded == NULL) {
+        lr_error_message("encoded cannot be NULL.");
+        lr_abort();
+    } else if ( (output_param_name == NULL) || (strlen(output_param_name) == 0) ) {
+        lr_error_message("output_param_name cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    length = strlen(encoded);
+    decoded = (unsigned char*)malloc((length / 4) * 3 + 3);
+    if (decoded == NULL) {
+        lr_error_message("Unable to allocate memory for the decoded data.");
+        lr_abort();
+    }
+
+    decoded_length = lrlib_base64_decode_buffer(encoded, length, decoded);
+    if (decoded_length < 0) {
+        lr_error_message("The text to decode is not valid base64.");
+    } else {
+        lr_save_var(decoded, decoded_length, 0, output_param_name);
+    }
+    free(decoded);
+
+    LRLIB_PROFILE_END("lrlib_base64_decode", profile_start_usec, length);
+    return decoded_length;
+}
+
+/**
+ * Base64 encodes the contents of a file, and saves it to a parameter. The file is read in chunks,
+ * straight into its place in the output, so only the output needs to fit in memory.
+ *
+ * @param[in] The file to encode.
+ * @param[in] The alphabet to use: LRLIB_BASE64 or LRLIB_BASE64URL.
+ * @param[in] The name of the parameter to save the encoded text to.
+ * @return    Returns the length of the encoded text, or -1 if the file could not be read.
+ *
+ * Example code:
+ *     // Upload a file as part of a JSON body.
+ *     lrlib_base64_encode_file("C:\\TEMP\\invoice.pdf", LRLIB_BASE64, "InvoiceBase64");
+ *     web_custom_request("upload", "URL=https://{Host}/invoices", "Method=POST",
+ *         "Body={\"content\":\"{InvoiceBase64}\"}", LAST);
+ */
+int lrlib_base64_encode_file(const char* file_name, int alphabet, const char* output_param_name) {
+    long fp;
+    int file_size;
+    unsigned char* chunk;
+    char* encoded;
+    int encoded_length = 0;
+    int bytes_to_read;
+    int bytes_read;
+    int total_read = 0;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if ( (file_name == NULL) || (strlen(file_name) == 0) ) {
+        lr_error_message("file_name cannot be NULL or empty.");
+        lr_abort();
+    } else if ( (alphabet != LRLIB_BASE64) && (alphabet != LRLIB_BASE64URL) ) {
+        lr_error_message("Invalid alphabet: %d.", alphabet);
+        lr_abort();
+    } else if ( (output_param_name == NULL) || (strlen(output_param_name) == 0) ) {
+        lr_error_message("output_param_name cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    fp = (long)fopen(file_name, "rb");
+    if (fp == 0) {
+        lr_error_message("Cannot open file \"%s\" for reading.", file_name);
+        return -1;
+    }
+    fseek(fp, 0, 2); // SEEK_END
+    file_size = ftell(fp);
+    fseek(fp, 0, 0); // SEEK_SET
+
+    encoded = (char*)malloc(lrlib_base64_encoded_length(file_size, alphabet) + 1);
+    chunk = (unsigned char*)malloc(LRLIB_BASE64_FILE_CHUNK);
+    if ( (encoded == NULL) || (chunk == NULL) ) {
+        lr_error_message("Unable to allocate memory to encode \"%s\".", file_name);
+        lr_abort();
+    }
+
+    // Every chunk except the last is a multiple of 3 bytes, so there is no padding between chunks.
+    // Never read more than file_size bytes, in case the file grows while it is being read.
+    while (total_read < file_size) {
+        bytes_to_read = file_size - total_read;
+        if (bytes_to_read > LRLIB_BASE64_FILE_CHUNK) {
+            bytes_to_read = LRLIB_BASE64_FILE_CHUNK;
+        }
+        bytes_read = fread(chunk, 1, bytes_to_read, fp);
+        if (bytes_read <= 0) {
+            break;
+        }
+        encoded_length += lrlib_base64_encode_buffer(chunk, bytes_read, alphabet, encoded + encoded_length);
+        total_read += bytes_read;
+    }
+    encoded[encoded_length] = '\0';
+    fclose(fp);
+
+    lr_save_string(encoded, output_param_name);
+    free(chunk);
+    free(encoded);
+    LRLIB_PROFILE_END("lrlib_base64_encode_file", profile_start_usec, total_read);
+    return encoded_length;
+}
+
+/**
+ * Decodes base64 or base64url text, and writes the data to a file. The text is decoded in chunks,
+ * so the decoded data never needs to be held in memory all at once.
+ *
+ * @param[in] The text to decode. Either alphabet can be used, padding is optional, and whitespace
+ *            is ignored.
+ * @param[in] The file to write the decoded data to. It is replaced if it already exists.
+ * @return    Returns the number of bytes written, or -1 if the text is not valid base64 or the file
+ *            could not be written.
+ *
+ * Example code:
+ *     // Save a PDF that the server returned as base64 in a JSON response.
+ *     web_reg_save_param_ex("ParamName=PdfBase64", "LB=\"pdf\":\"", "RB=\"", LAST);
+ *     web_url("statement", "URL=https://{Host}/statement", LAST);
+ *     lrlib_base64_decode_to_file(lr_eval_string("{PdfBase64}"), "C:\\TEMP\\statement.pdf");
+ */
+int lrlib_base64_decode_to_file(const char* encoded, const char* file_name) {
+    long fp;
+    unsigned char* chunk;
+    int length;
+    int position = 0;
+    int chunk_length;
+    int decoded_length;
+    int total_length = 0;
+    double profile_start_usec = 0;
+
+    LRLIB_PROFILE_START(profile_start_usec);
+
+    // Check input variables
+    if (encoded == NULL) {
+        lr_error_message("encoded cannot be NULL.");
+        lr_abort();
+    } else if ( (file_name == NULL) || (strlen(file_name) == 0) ) {
+        lr_error_message("file_name cannot be NULL or empty.");
+        lr_abort();
+    }
+
+    fp = (long)fopen(file_name, "wb");
+    if (fp == 0) {
+        lr_error_message("Cannot open file \"%s\" for writing.", file_name);
+        return -1;
+    }
+
+    chunk = (unsigned char*)malloc(LRLIB_BASE64_FILE_CHUNK + 3);
+    if (chunk == NULL) {
+        lr_error_message("Unable to allocate memory for the decoded data.");
+        lr_abort();
+    }
+
+    lrlib_base64_init();
+
+    // Decode 65536 characters (a multiple of 4) at a time. If the text contains whitespace, a
+    // chunk can end part way through a group of 4, so the chunk is extended until it has a
+    // multiple of 4 base64 characters.
+    length = strlen(encoded);
+    while (position < length) {
+        int characters = 0;
+        int i;
+
+        chunk_length = LRLIB_BASE64_FILE_CHUNK / 3 * 4;
+        if (position + chunk_length > length) {
+            chunk_length = length - position;
+        }
+        for (i = position; i < position + chunk_length; i++) {
+            if (lrlib_base64_values[(unsigned char)encoded[i]] != LRLIB_BASE64_INVALID) {
+                characters++;
+            }
+        }
+        while ( (characters % 4 != 0) && (position + chunk_length < length) ) {
+            if (lrlib_base64_values[(unsigned char)encoded[position + chunk_length]] != LRLIB_BASE64_INVALID) {
+                characters++;
+            }
+            chunk_length++;
+        }
+
+        decoded_length = lrlib_base64_decode_buffer(encoded + position, chunk_length, chunk);
+        if (decoded_length < 0) {
+            lr_error_message("The text to decode is not valid base64.");
+            total_length = -1;
+            break;
+        }
+        fwrite(chunk, 1, decoded_length, fp);
+        total_length += decoded_length;
+        position += chunk_length;
+    }
+
+    fclose(fp);
+    free(chunk);
+    LRLIB_PROFILE_END("lrlib_base64_decode_to_file", profile_start_usec, length);
+    return total_length;
+}
+
 // TODO list of functions
 // ======================
 // * replace all occurrances of substring with new string (str_replace). Dont use this instead of web_convert_param to convert to/from URLEncoded or HTML entities.
@@ -0,0 +1,1061 @@
+/**
+ * @file
+ *
+ * @section DESCRIPTION
+ *
+ * Benchmarks for the lr-libc functions, run on Linux against the LoadRunner stub in lr_stub.c.
+ * Build and run them with run_benchmarks.sh.
+ *
+ * Each benchmark has a setup function, which creates its input (parameters, files, buffers), and
+ * a run function, which makes one call (an "op") to the function being measured. The run function
+ * is called repeatedly, with lr_stub_end_iteration after each call, until enough time has passed
+ * for a stable result. The measurement is repeated several times, and the fastest and median
+ * times are reported.
+ *
+ * The results are written to stdout as JSON, one benchmark per line:
+ *     {"benchmark": "strings.h/lrlib_base64_encode", "input": "1 MB", "iterations": 1216,
+ *      "ns_per_op": 411235.2, "ns_per_op_median": 415020.9, "mb_per_s": 2549.8,
+ *      "allocs_per_op": 1.00, "bytes_allocated_per_op": 1398102, "errors": 0}
+ * mb_per_s is only reported for benchmarks that process a known number of bytes. errors is the
+ * number of lr_error_message calls made during the benchmark, which should always be 0.
+ *
+ * Usage: benchmarks [filter]
+ * Only the benchmarks whose names contain the filter text are run. The BENCH_MIN_TIME_MS
+ * environment variable sets the time spent measuring each benchmark (default 500 ms), and
+ * BENCH_TMPDIR sets the directory used for temporary files (default /tmp).
+ */
+
+#include "lr_stub.h"
+#include "../../lrlib.h"
+#include "../../paramarr.h"
+#include "../../strings.h"
+#include "../../files.h"
+#include "../../dates.h"
+#include "../../geo.h"
+#include "../../monitors.h"
+
+#define BENCH_REPEATS 5
+#define BENCH_MAX_FILE_NAME_LENGTH 512
+#define BENCH_KB 1024
+#define BENCH_MB (1024 * 1024)
+
+typedef struct {
+    const char* name; // "<header>/<function>"
+    const char* input; // a short description of the input, e.g. "1 MB" or "100000 elements"
+    void (*setup)(void);
+    void (*run)(void);
+} bench_case;
+
+/* State shared by the setup and run functions */
+
+double bench_bytes_per_op; // set by a setup function if the op processes a known number of bytes
+char* bench_data; // a buffer of test data
+int bench_data_length;
+char* bench_text; // a second buffer (e.g. the input that bench_data is copied from)
+int bench_id; // a histogram or point set ID
+int bench_counter_set_id; // kept separately, as a vuser can only have a few counter sets
+int bench_sampler_id;
+int bench_listener = -1; // a socket listening on 127.0.0.1, for lrlib_check_ports
+double bench_timestamp_ms;
+char bench_tmpdir[BENCH_MAX_FILE_NAME_LENGTH];
+char bench_file_name[BENCH_MAX_FILE_NAME_LENGTH];
+char bench_output_file_name[BENCH_MAX_FILE_NAME_LENGTH];
+
+/* Helpers */
+
+/**
+ * Replaces bench_data with a buffer of pseudo-random printable text (so that functions that treat
+ * their input as a string see a realistic mix of characters).
+ */
+void bench_make_text(int length) {
+    unsigned int x = 12345;
+    int i;
+
+    free(bench_data);
+    bench_data = (char*)malloc(length + 1);
+    for (i = 0; i < length; i++) {
+        x = x * 1103515245 + 12345;
+        bench_data[i] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 .,-_/:*~"[(x >> 16) % 71];
+    }
+    bench_data[length] = '\0';
+    bench_data_length = length;
+}
+
+/**
+ * Saves a parameter array of count elements, made by formatting each element number with format,
+ * (e.g. "item%d"). If modulo is not 0, element numbers are reduced modulo it, to make duplicates.
+ */
+void bench_make_paramarr(const char* paramarr_name, int count, const char* format, int modulo) {
+    char param_name[LRLIB_PARAM_NAME_BUFFER_LENGTH];
+    char value[64];
+    unsigned int x = 54321;
+    int i;
+    int number;
+
+    for (i = 1; i <= count; i++) {
+        x = x * 1103515245 + 12345;
+        number = (x >> 8) % 1000000;
+        if (modulo != 0) {
+            number = number % modulo;
+        }
+        sprintf(value, format, number);
+        sprintf(param_name, "%s_%d", paramarr_name, i);
+        lr_save_string(value, param_name);
+    }
+    sprintf(param_name, "%s_count", paramarr_name);
+    lr_save_int(count, param_name);
+}
+
+/**
+ * Writes bench_data to a file in the temporary directory.
+ */
+void bench_write_file(const char* file_name) {
+    long fp = (long)fopen(file_name, "wb");
+
+    if (fp == 0) {
+        lr_error_message("Cannot create \"%s\".", file_name);
+        lr_abort();
+    }
+    fwrite(bench_data, 1, bench_data_length, fp);
+    fclose(fp);
+}
+
+/**
+ * Builds a minimal, valid PDF with page_count pages of padding content, into bench_data.
+ */
+void bench_make_pdf(int page_count, int page_length) {
+    int* offsets = (int*)malloc((page_count + 3) * sizeof(int));
+    int capacity = 1024 + page_count * (page_length + 128);
+    int length = 0;
+    int xref_offset;
+    int i;
+
+    free(bench_data);
+    bench_data = (char*)malloc(capacity);
+    length += sprintf(bench_data + length, "%%PDF-1.4\n");
+    offsets[1] = length;
+    length += sprintf(bench_data + length, "1 0 obj\n<< /Type /Catalog /Pages 2 0 R >>\nendobj\n");
+    offsets[2] = length;
+    length += sprintf(bench_data + length, "2 0 obj\n<< /Type /Pages /Kids [] /Count %d >>\nendobj\n", page_count);
+    for (i = 3; i < page_count + 3; i++) {
+        offsets[i] = length;
+        length += sprintf(bench_data + length, "%d 0 obj\n<< /Type /Page /Parent 2 0 R >>\nstream\n", i);
+        memset(bench_data + length, 'x', page_length);
+        length += page_length;
+        length += sprintf(bench_data + length, "\nendstream\nendobj\n");
+    }
+    xref_offset = length;
+    length += sprintf(bench_data + length, "xref\n0 %d\n0000000000 65535 f\r\n", page_count + 3);
+    for (i = 1; i < page_count + 3; i++) {
+        length += sprintf(bench_data + length, "%010d 00000 n\r\n", offsets[i]);
+    }
+    length += sprintf(bench_data + length, "trailer\n<< /Size %d /Root 1 0 R >>\nstartxref\n%d\n%%%%EOF\n",
+        page_count + 3, xref_offset);
+    bench_data_length = length;
+    free(offsets);
+}
+
+/* strings.h */
+
+void setup_str_split(void) {
+    int i;
+    int length = 0;
+
+    // 100 comma-separated fields, like a row of CSV data. lrlib_str_split modifies its input, so
+    // each op copies it from bench_text first.
+    free(bench_text);
+    bench_text = (char*)malloc(100 * 16);
+    for (i = 0; i < 100; i++) {
+        length += sprintf(bench_text + length, "field%04d,", i);
+    }
+    bench_text[length - 1] = '\0';
+    bench_data = (char*)realloc(bench_data, length);
+    bench_data_length = length;
+    bench_bytes_per_op = length;
+}
+
+void run_str_split(void) {
+    memcpy(bench_data, bench_text, bench_data_length);
+    lrlib_str_split(bench_data, ",", "Split");
+}
+
+void setup_sapeventqueue(void) {
+    bench_make_text(BENCH_KB);
+    free(bench_text);
+    bench_text = (char*)malloc(BENCH_KB * 6); // every character could become "~XXXX"
+    lrlib_sapeventqueue_encode(bench_data, bench_text);
+    bench_bytes_per_op = BENCH_KB;
+}
+
+void run_sapeventqueue_encode(void) {
+    lrlib_sapeventqueue_encode(bench_data, bench_text);
+}
+
+// Decodes the text encoded by setup_sapeventqueue back into bench_data.
+void run_sapeventqueue_decode(void) {
+    lrlib_sapeventqueue_decode(bench_text, bench_data);
+}
+
+void setup_str_reverse(void) {
+    bench_make_text(4 * BENCH_KB);
+    bench_bytes_per_op = bench_data_length;
+}
+
+void run_str_reverse(void) {
+    lrlib_str_reverse(bench_data, "Reversed");
+}
+
+void setup_base64_small(void) {
+    bench_make_text(64);
+    bench_bytes_per_op = bench_data_length;
+}
+
+void setup_base64_large(void) {
+    bench_make_text(BENCH_MB);
+    bench_bytes_per_op = bench_data_length;
+}
+
+void run_base64_encode(void) {
+    lrlib_base64_encode(bench_data, bench_data_length, LRLIB_BASE64, "Encoded");
+}
+
+void setup_base64_decode(void) {
+    setup_base64_large();
+    lrlib_base64_encode(bench_data, bench_data_length, LRLIB_BASE64, "Encoded");
+    free(bench_text);
+    bench_text = (char*)malloc(strlen(lr_eval_string("{Encoded}")) + 1);
+    strcpy(bench_text, lr_eval_string("{Encoded}"));
+}
+
+void run_base64_decode(void) {
+    lrlib_base64_decode(bench_text, "Decoded");
+}
+
+void setup_base64_encode_file(void) {
+    setup_base64_large();
+    bench_write_file(bench_file_name);
+}
+
+void run_base64_encode_file(void) {
+    lrlib_base64_encode_file(bench_file_name, LRLIB_BASE64, "Encoded");
+}
+
+void run_base64_decode_to_file(void) {
+    lrlib_base64_decode_to_file(bench_text, bench_output_file_name);
+}
+
+/* paramarr.h */
+
+void setup_nothing(void) {
+}
+
+void run_paramarr_create(void) {
+    lrlib_paramarr_create("Cities", "Melbourne", "Sydney", "Perth", "Adelaide", "Brisbane", LAST);
+}
+
+void run_paramarr_create_delete(void) {
+    lrlib_paramarr_create("Cities", "Melbourne", "Sydney", "Perth", "Adelaide", "Brisbane", LAST);
+    lrlib_paramarr_delete("Cities");
+}
+
+void setup_paramarr_1000(void) {
+    bench_make_paramarr("Items", 1000, "item%06d", 0);
+    free(bench_text);
+    bench_text = (char*)malloc(64);
+    strcpy(bench_text, lr_paramarr_idx("Items", 1000)); // the worst case for a linear search
+}
+
+void run_paramarr_push_pop(void) {
+    lrlib_paramarr_push("Items", "new-item");
+    lrlib_paramarr_pop("Items", "Popped");
+}
+
+void run_paramarr_contains(void) {
+    lrlib_paramarr_contains("Items", bench_text);
+}
+
+void run_paramarr_search(void) {
+    lrlib_paramarr_search("Items", bench_text);
+}
+
+void setup_paramarr_100000(void) {
+    bench_make_paramarr("Items", 100000, "item%d", 50000); // about 43000 distinct values
+    bench_make_paramarr("Other", 50000, "item%d", 100000);
+}
+
+void run_paramarr_unique(void) {
+    lrlib_paramarr_unique("Items", "Unique");
+}
+
+void run_paramarr_diff(void) {
+    lrlib_paramarr_diff("Items", "Other", "Diff");
+}
+
+void run_paramarr_intersect(void) {
+    lrlib_paramarr_intersect("Items", "Other", "Intersect");
+}
+
+void run_paramarr_shuffle(void) {
+    lrlib_paramarr_shuffle("Items");
+}
+
+void run_paramarr_next(void) {
+    lrlib_paramarr_next("Items", "Next");
+}
+
+void run_paramarr_get_elements(void) {
+    int count;
+
+    free(lrlib_paramarr_get_elements("Items", &count));
+}
+
+void run_paramarr_join(void) {
+    lrlib_paramarr_join("Items", ",", "Joined");
+}
+
+void run_paramarr_to_csv(void) {
+    lrlib_paramarr_to_csv("Items", "Csv");
+}
+
+void run_paramarr_to_json(void) {
+    lrlib_paramarr_to_json("Items", "Json");
+}
+
+void setup_paramarr_numbers(void) {
+    bench_make_paramarr("Items", 100000, "%d", 0);
+}
+
+void setup_paramarr_natural(void) {
+    bench_make_paramarr("Items", 100000, "file%d.txt", 0);
+}
+
+// Sorting an array that is already sorted is a special case, so each op sorts the array into the
+// opposite order to the previous op.
+int bench_sort_order = LRLIB_SORT_ASCENDING;
+
+void run_paramarr_sort(int sort_mode) {
+    if (bench_sort_order == LRLIB_SORT_ASCENDING) {
+        bench_sort_order = LRLIB_SORT_DESCENDING;
+    } else {
+        bench_sort_order = LRLIB_SORT_ASCENDING;
+    }
+    lrlib_paramarr_sort("Items", sort_mode, bench_sort_order);
+}
+
+void run_paramarr_sort_lexicographic(void) {
+    run_paramarr_sort(LRLIB_SORT_LEXICOGRAPHIC);
+}
+
+void run_paramarr_sort_numeric(void) {
+    run_paramarr_sort(LRLIB_SORT_NUMERIC);
+}
+
+void run_paramarr_sort_natural(void) {
+    run_paramarr_sort(LRLIB_SORT_NATURAL);
+}
+
+void run_paramarr_stats(void) {
+    lrlib_paramarr_stats("Items", "50,90,95,99", "Stats");
+}
+
+void run_natural_compare(void) {
+    lrlib_natural_compare("invoice-2024-00123.pdf", "invoice-2024-01123.pdf");
+}
+
+/* files.h */
+
+void setup_file_64k(void) {
+    bench_make_text(64 * BENCH_KB);
+    bench_write_file(bench_file_name);
+    bench_bytes_per_op = bench_data_length;
+}
+
+void setup_file(void) {
+    setup_file_64k();
+    bench_bytes_per_op = 0; // the size of the file does not matter
+}
+
+void run_file_exists(void) {
+    lrlib_file_exists(bench_file_name);
+}
+
+void run_get_file_size(void) {
+    lrlib_get_file_size(bench_file_name);
+}
+
+void run_save_file(void) {
+    lrlib_save_file(bench_output_file_name, bench_data, bench_data_length);
+}
+
+void run_read_text_file(void) {
+    lrlib_read_text_file(bench_file_name, "FileContents");
+}
+
+void setup_append(void) {
+    bench_make_text(100);
+    bench_data[99] = '\n';
+    remove(bench_output_file_name);
+    bench_bytes_per_op = bench_data_length;
+}
+
+void run_append_to_file(void) {
+    lrlib_append_to_file(bench_output_file_name, bench_data);
+}
+
+// No MB/s is reported for the PDF checks, as they only read the parts of the PDF that describe its
+// structure.
+void setup_pdf(void) {
+    bench_make_pdf(2000, 500);
+    bench_write_file(bench_file_name);
+}
+
+void run_check_pdf(void) {
+    lrlib_check_pdf(bench_data, bench_data_length, "Pdf");
+}
+
+void run_check_pdf_file(void) {
+    lrlib_check_pdf_file(bench_file_name, "Pdf");
+}
+
+void setup_pdf_truncated(void) {
+    // A download that stopped half way through.
+    setup_pdf();
+    bench_data_length /= 2;
+}
+
+/* lrlib.h */
+
+void run_format_uint(void) {
+    char buffer[16];
+
+    lrlib_format_uint(4294967295u, buffer);
+}
+
+void run_parse_double(void) {
+    double value;
+
+    lrlib_parse_double("12345.678", &value);
+}
+
+void run_random_uint32(void) {
+    lrlib_random_uint32();
+}
+
+void run_random_range(void) {
+    lrlib_random_range(1000);
+}
+
+void run_secure_random_bytes(void) {
+    unsigned char buffer[32];
+
+    lrlib_secure_random_bytes(buffer, sizeof(buffer));
+}
+
+void run_create_uuid_v4(void) {
+    lrlib_create_uuid_v4("Uuid");
+}
+
+void run_create_uuid_v7(void) {
+    lrlib_create_uuid_v7("Uuid");
+}
+
+void run_create_uuid_paramarr(void) {
+    lrlib_create_uuid_paramarr("Uuids", 1000, LRLIB_UUID_V4);
+}
+
+void run_sha256(void) {
+    lrlib_sha256(bench_data, LRLIB_DIGEST_HEX, "Hash");
+}
+
+void setup_sha256_paramarr(void) {
+    int i;
+    char param_name[LRLIB_PARAM_NAME_BUFFER_LENGTH];
+
+    bench_make_text(64);
+    for (i = 1; i <= 1000; i++) {
+        bench_data[0] = 'a' + i % 26;
+        sprintf(param_name, "Values_%d", i);
+        lr_save_string(bench_data, param_name);
+    }
+    lr_save_int(1000, "Values_count");
+    bench_bytes_per_op = 1000 * 64;
+}
+
+void run_sha256_paramarr(void) {
+    lrlib_sha256_paramarr("Values", LRLIB_DIGEST_HEX, "Hashes");
+}
+
+void setup_file_1m(void) {
+    setup_base64_large();
+    bench_write_file(bench_file_name);
+}
+
+void run_sha256_file(void) {
+    lrlib_sha256_file(bench_file_name, LRLIB_DIGEST_HEX, "Hash");
+}
+
+void setup_hmac(void) {
+    bench_make_text(256);
+    bench_bytes_per_op = bench_data_length;
+}
+
+void run_hmac_sha256(void) {
+    lrlib_hmac_sha256("my-secret-key", bench_data, LRLIB_DIGEST_BASE64, "Signature");
+}
+
+void run_hmac_sha256_file(void) {
+    lrlib_hmac_sha256_file("my-secret-key", bench_file_name, LRLIB_DIGEST_HEX, "Signature");
+}
+
+void run_timer_now_usec(void) {
+    lrlib_timer_now_usec();
+}
+
+void run_get_unix_time_ms(void) {
+    lrlib_get_unix_time_ms();
+}
+
+void run_timer_start_stop(void) {
+    lrlib_timer_start("Checkout");
+    lrlib_timer_stop("Checkout");
+}
+
+void setup_log_message(void) {
+    bench_make_text(100);
+    bench_bytes_per_op = bench_data_length;
+}
+
+void run_log_message(void) {
+    lrlib_log_message("orders", bench_data);
+}
+
+void setup_pacing(void) {
+    lrlib_pacing_start(LRLIB_PACING_EXPONENTIAL, 10, 0);
+}
+
+void run_pacing_next_interval_usec(void) {
+    lrlib_pacing_next_interval_usec();
+}
+
+void setup_histogram(void) {
+    int i;
+
+    bench_id = lrlib_histogram_create("ResponseTime");
+    for (i = 0; i < 100000; i++) {
+        lrlib_histogram_record(bench_id, lrlib_random_range(5000000));
+    }
+}
+
+void run_histogram_record(void) {
+    lrlib_histogram_record(bench_id, 123456);
+}
+
+void run_histogram_save_percentiles(void) {
+    lrlib_histogram_save_percentiles(bench_id, LRLIB_HISTOGRAM_VUSER, "ResponseTime");
+}
+
+void setup_split_command_line(void) {
+    free(bench_text);
+    bench_text = (char*)malloc(256);
+    strcpy(bench_text, "curl -s -H \"Accept: application/json\" --max-time 5 'https://example.com/api?q=1'");
+    bench_data = (char*)realloc(bench_data, 256);
+}
+
+void run_split_command_line(void) {
+    char* argv[LRLIB_MAX_COMMAND_ARGUMENTS + 1];
+
+    strcpy(bench_data, bench_text);
+    lrlib_split_command_line(bench_data, argv, LRLIB_MAX_COMMAND_ARGUMENTS);
+}
+
+void run_run_command(void) {
+    lrlib_run_command("true", 10, "Command");
+}
+
+void run_run_command_lines(void) {
+    lrlib_run_command_lines("seq 1 1000", 10, "Lines");
+}
+
+void setup_check_ports(void) {
+    char param_name[LRLIB_PARAM_NAME_BUFFER_LENGTH];
+    int i;
+
+    // Ports on localhost that nothing listens on, so every check is refused straight away.
+    for (i = 1; i <= 16; i++) {
+        sprintf(param_name, "Endpoints_%d", i);
+        lr_save_string("127.0.0.1:1", param_name);
+    }
+    lr_save_int(16, "Endpoints_count");
+}
+
+void run_check_ports(void) {
+    lrlib_check_ports("Endpoints", 1, "Ports");
+}
+
+void setup_check_ports_open(void) {
+    int socket(int domain, int type, int protocol);
+    int bind(int fd, const void* address, unsigned int length);
+    int listen(int fd, int backlog);
+    int getsockname(int fd, void* address, unsigned int* length);
+    int fcntl(int fd, int command, ...);
+    int close(int fd);
+    struct {
+        unsigned short family;
+        unsigned char port[2]; // network byte order
+        unsigned char address[4];
+        unsigned char zero[8];
+    } address;
+    unsigned int length = sizeof(address);
+    char endpoint[32];
+
+    // A listener on a port chosen by the system, which accepts connections without blocking.
+    if (bench_listener >= 0) {
+        close(bench_listener);
+    }
+    memset(&address, 0, sizeof(address));
+    address.family = 2; // AF_INET
+    address.address[0] = 127;
+    address.address[3] = 1;
+    bench_listener = socket(2, 1, 0); // AF_INET, SOCK_STREAM
+    if ( (bench_listener < 0) ||
+         (bind(bench_listener, &address, sizeof(address)) != 0) ||
+         (listen(bench_listener, 128) != 0) ||
+         (getsockname(bench_listener, &address, &length) != 0) ) {
+        lr_error_message("Unable to listen on 127.0.0.1.");
+        return;
+    }
+    fcntl(bench_listener, 4, 04000); // F_SETFL, O_NONBLOCK
+
+    sprintf(endpoint, "127.0.0.1:%d", address.port[0] * 256 + address.port[1]);
+    lr_save_string(endpoint, "Endpoints_1");
+    lr_save_int(1, "Endpoints_count");
+
+    // Check the result once. Any mistake is reported as an error in the benchmark results.
+    if (lrlib_check_ports("Endpoints", 1, "Ports") != 1 || strcmp(lr_paramarr_idx("Ports", 1), "open") != 0) {
+        lr_error_message("lrlib_check_ports did not report %s as open.", endpoint);
+    }
+}
+
+void run_check_ports_open(void) {
+    int accept(int fd, void* address, unsigned int* length);
+    int close(int fd);
+    int connection;
+
+    lrlib_check_ports("Endpoints", 1, "Ports");
+
+    // Accept the connection, so that the listen queue never fills up.
+    while ((connection = accept(bench_listener, NULL, NULL)) >= 0) {
+        close(connection);
+    }
+}
+
+/* dates.h */
+
+void setup_dates(void) {
+    bench_timestamp_ms = 1709214307123.0; // 2024-02-29T13:45:07.123Z
+    lr_save_string("2024-02-29T13:45:07.123Z", "Start");
+    lr_save_string("2024-03-01T09:00:00+10:00", "End");
+}
+
+void run_format_date_iso8601(void) {
+    char buffer[LRLIB_DATE_BUFFER_LENGTH];
+
+    // Timestamps 1 ms apart, as when formatting the current time in a busy loop.
+    bench_timestamp_ms += 1;
+    lrlib_format_date(bench_timestamp_ms, LRLIB_DATE_ISO8601, buffer);
+}
+
+void run_format_date_rfc1123(void) {
+    char buffer[LRLIB_DATE_BUFFER_LENGTH];
+
+    bench_timestamp_ms += 1;
+    lrlib_format_date(bench_timestamp_ms, LRLIB_DATE_RFC1123, buffer);
+}
+
+void run_save_now(void) {
+    lrlib_save_now(LRLIB_DATE_ISO8601, "Now");
+}
+
+void run_parse_iso8601(void) {
+    double ms;
+
+    lrlib_parse_iso8601("2024-03-01T09:00:00.250+10:00", &ms);
+}
+
+void run_add_to_date(void) {
+    lrlib_add_to_date(lr_eval_string("{Start}"), 86400, LRLIB_DATE_ISO8601, "Tomorrow");
+}
+
+void run_convert_date(void) {
+    lrlib_convert_date(lr_eval_string("{End}"), LRLIB_DATE_RFC1123, "Converted");
+}
+
+void run_date_difference(void) {
+    lrlib_date_difference(lr_eval_string("{Start}"), lr_eval_string("{End}"), "Difference");
+}
+
+/* geo.h */
+
+void bench_make_points(int count) {
+    char param_name[LRLIB_PARAM_NAME_BUFFER_LENGTH];
+    char value[32];
+    unsigned int x = 99991;
+    int i;
+
+    // Points spread over south-eastern Australia.
+    for (i = 1; i <= count; i++) {
+        x = x * 1103515245 + 12345;
+        sprintf(value, "%.5f", -44.0 + (x >> 8) % 1600000 / 100000.0);
+        sprintf(param_name, "Latitudes_%d", i);
+        lr_save_string(value, param_name);
+        x = x * 1103515245 + 12345;
+        sprintf(value, "%.5f", 138.0 + (x >> 8) % 1600000 / 100000.0);
+        sprintf(param_name, "Longitudes_%d", i);
+        lr_save_string(value, param_name);
+    }
+    lr_save_int(count, "Latitudes_count");
+    lr_save_int(count, "Longitudes_count");
+}
+
+void setup_geo_load(void) {
+    bench_make_points(100000);
+}
+
+void run_geo_load(void) {
+    lrlib_geo_free(lrlib_geo_load("Latitudes", "Longitudes", NULL));
+}
+
+void setup_geo_1000(void) {
+    bench_make_points(1000);
+    bench_id = lrlib_geo_load("Latitudes", "Longitudes", NULL);
+}
+
+void setup_geo_100000(void) {
+    bench_make_points(100000);
+    bench_id = lrlib_geo_load("Latitudes", "Longitudes", NULL);
+}
+
+void run_geo_distances(void) {
+    lrlib_geo_distances(bench_id, -37.8136, 144.9631, "Distances");
+}
+
+void run_geo_within_radius(void) {
+    lrlib_geo_within_radius(bench_id, -37.8136, 144.9631, 50000, "Nearby");
+}
+
+void run_geo_nearest(void) {
+    lrlib_geo_nearest(bench_id, -37.8136, 144.9631, 10, "Nearest");
+}
+
+/* monitors.h */
+
+/**
+ * Deletes the counter set made by the previous monitors.h benchmark (if any), and creates a new
+ * one.
+ */
+void bench_make_counter_set(const lrlib_counter_backend* backend) {
+    if (bench_counter_set_id > 0) {
+        lrlib_counter_set_delete(bench_counter_set_id);
+    }
+    bench_counter_set_id = lrlib_counter_set_create(backend);
+}
+
+void setup_counter_set_mock(void) {
+    char param_name[LRLIB_PARAM_NAME_BUFFER_LENGTH];
+    char value[32];
+    int i;
+
+    // 64 counters, each read from a parameter (e.g. {Counter_7} = "7.5").
+    bench_make_counter_set(&lrlib_counter_backend_mock);
+    for (i = 1; i <= 64; i++) {
+        sprintf(param_name, "Counter_%d", i);
+        sprintf(value, "%d.5", i);
+        lr_save_string(value, param_name);
+        lrlib_counter_set_add(bench_counter_set_id, param_name);
+    }
+    lr_save_string("not a number", "Counter_64");
+
+    // Check the results once. Any mistake is reported as an error in the benchmark results.
+    if (lrlib_counter_set_collect(bench_counter_set_id, "CounterValues") != 64) {
+        lr_error_message("lrlib_counter_set_collect did not save 64 values.");
+    }
+    if (strcmp(lr_paramarr_idx("CounterValues", 1), "1.5") != 0 ||
+        strcmp(lr_paramarr_idx("CounterValues", 63), "63.5") != 0 ||
+        strcmp(lr_paramarr_idx("CounterValues", 64), "") != 0 ||
+        strcmp(lr_eval_string("{CounterValues_timestamp}"), "1000") != 0) {
+        lr_error_message("lrlib_counter_set_collect saved the wrong values with the mock backend.");
+    }
+    if (lrlib_counter_set_get_names(bench_counter_set_id, "CounterNames") != 64 ||
+        strcmp(lr_paramarr_idx("CounterNames", 64), "Counter_64") != 0) {
+        lr_error_message("lrlib_counter_set_get_names saved the wrong names.");
+    }
+}
+
+void run_counter_set_collect(void) {
+    lrlib_counter_set_collect(bench_counter_set_id, "CounterValues");
+}
+
+void setup_counter_set_proc(void) {
+    // Counters from two files: every network interface (a wildcard), and two memory counters.
+    bench_make_counter_set(&lrlib_counter_backend_proc);
+    lrlib_counter_set_add(bench_counter_set_id, "/proc/net/dev * 2");
+    lrlib_counter_set_add(bench_counter_set_id, "/proc/meminfo MemAvailable: 2");
+    lrlib_counter_set_add(bench_counter_set_id, "/proc/meminfo SwapFree: 2");
+}
+
+void run_get_linux_cpu_utilisation(void) {
+    lrlib_get_linux_cpu_utilisation("CpuName", "CpuValue");
+}
+
+void run_get_linux_memory(void) {
+    lrlib_get_linux_memory("MemoryName", "MemoryValue");
+}
+
+void run_get_linux_network(void) {
+    lrlib_get_linux_network("NetworkName", "NetworkValue");
+}
+
+void run_get_linux_disk_io(void) {
+    lrlib_get_linux_disk_io("DiskName", "DiskValue");
+}
+
+void run_get_linux_load_average(void) {
+    lrlib_get_linux_load_average("LoadName", "LoadValue");
+}
+
+/**
+ * Starts a sampler that reads the 1 minute load average every millisecond, and waits until its
+ * ring buffer is full. The sampler keeps running while the read functions are measured.
+ */
+void setup_sampler(void) {
+    if (bench_sampler_id > 0) {
+        lrlib_counter_sampler_stop(bench_sampler_id);
+    }
+    bench_sampler_id = lrlib_counter_sampler_start(LRLIB_SAMPLER_BACKEND_PROC, "/proc/loadavg 1", 1, 1000);
+    while (bench_sampler_id > 0 && lrlib_counter_sampler_read_window(bench_sampler_id, 1000, "Samples") < 1000) {
+        lrlib_sampler_sleep_msec(100);
+    }
+}
+
+void run_counter_sampler_read_latest(void) {
+    lrlib_counter_sampler_read_latest(bench_sampler_id, "Sample");
+}
+
+void run_counter_sampler_read_window(void) {
+    lrlib_counter_sampler_read_window(bench_sampler_id, 100, "Samples");
+}
+
+void run_counter_sampler_start_stop(void) {
+    lrlib_counter_sampler_stop(lrlib_counter_sampler_start(LRLIB_SAMPLER_BACKEND_PROC, "/proc/loadavg 1", 1000, 10));
+}
+
+/* The benchmarks */
+
+// The functions that only work on Windows (e.g. lrlib_append_string_to_text_file_safe, the
+// mmdrv.exe process functions, and the perfmon functions and PDH backends in monitors.h) are not
+// included.
+
+bench_case bench_cases[] = {
+    {"strings.h/lrlib_str_split", "100 fields", setup_str_split, run_str_split},
+    {"strings.h/lrlib_sapeventqueue_encode", "1 KB", setup_sapeventqueue, run_sapeventqueue_encode},
+    {"strings.h/lrlib_sapeventqueue_decode", "1 KB", setup_sapeventqueue, run_sapeventqueue_decode},
+    {"strings.h/lrlib_str_reverse", "4 KB", setup_str_reverse, run_str_reverse},
+    {"strings.h/lrlib_base64_encode", "64 bytes", setup_base64_small, run_base64_encode},
+    {"strings.h/lrlib_base64_encode", "1 MB", setup_base64_large, run_base64_encode},
+    {"strings.h/lrlib_base64_decode", "1 MB", setup_base64_decode, run_base64_decode},
+    {"strings.h/lrlib_base64_encode_file", "1 MB", setup_base64_encode_file, run_base64_encode_file},
+    {"strings.h/lrlib_base64_decode_to_file", "1 MB", setup_base64_decode, run_base64_decode_to_file},
+
+    {"paramarr.h/lrlib_paramarr_create", "5 elements", setup_nothing, run_paramarr_create},
+    {"paramarr.h/lrlib_paramarr_delete", "5 elements (with create)", setup_nothing, run_paramarr_create_delete},
+    {"paramarr.h/lrlib_paramarr_push", "1000 elements (with pop)", setup_paramarr_1000, run_paramarr_push_pop},
+    {"paramarr.h/lrlib_paramarr_contains", "1000 elements, last matches", setup_paramarr_1000, run_paramarr_contains},
+    {"paramarr.h/lrlib_paramarr_search", "1000 elements, last matches", setup_paramarr_1000, run_paramarr_search},
+    {"paramarr.h/lrlib_paramarr_unique", "100000 elements", setup_paramarr_100000, run_paramarr_unique},
+    {"paramarr.h/lrlib_paramarr_diff", "100000 - 50000 elements", setup_paramarr_100000, run_paramarr_diff},
+    {"paramarr.h/lrlib_paramarr_intersect", "100000 and 50000 elements", setup_paramarr_100000, run_paramarr_intersect},
+    {"paramarr.h/lrlib_paramarr_shuffle", "100000 elements", setup_paramarr_100000, run_paramarr_shuffle},
+    {"paramarr.h/lrlib_paramarr_next", "100000 elements", setup_paramarr_100000, run_paramarr_next},
+    {"paramarr.h/lrlib_paramarr_get_elements", "100000 elements", setup_paramarr_100000, run_paramarr_get_elements},
+    {"paramarr.h/lrlib_paramarr_join", "100000 elements", setup_paramarr_100000, run_paramarr_join},
+    {"paramarr.h/lrlib_paramarr_to_csv", "100000 elements", setup_paramarr_100000, run_paramarr_to_csv},
+    {"paramarr.h/lrlib_paramarr_to_json", "100000 elements", setup_paramarr_100000, run_paramarr_to_json},
+    {"paramarr.h/lrlib_paramarr_sort", "100000 elements, lexicographic", setup_paramarr_100000, run_paramarr_sort_lexicographic},
+    {"paramarr.h/lrlib_paramarr_sort", "100000 elements, numeric", setup_paramarr_numbers, run_paramarr_sort_numeric},
+    {"paramarr.h/lrlib_paramarr_sort", "100000 elements, natural", setup_paramarr_natural, run_paramarr_sort_natural},
+    {"paramarr.h/lrlib_paramarr_stats", "100000 elements", setup_paramarr_numbers, run_paramarr_stats},
+    {"paramarr.h/lrlib_natural_compare", "22 characters", setup_nothing, run_natural_compare},
+
+    {"files.h/lrlib_file_exists", "", setup_file, run_file_exists},
+    {"files.h/lrlib_get_file_size", "", setup_file, run_get_file_size},
+    {"files.h/lrlib_save_file", "64 KB", setup_file_64k, run_save_file},
+    {"files.h/lrlib_read_text_file", "64 KB", setup_file_64k, run_read_text_file},
+    {"files.h/lrlib_append_to_file", "100 bytes", setup_append, run_append_to_file},
+    {"files.h/lrlib_check_pdf", "2000 pages", setup_pdf, run_check_pdf},
+    {"files.h/lrlib_check_pdf", "truncated", setup_pdf_truncated, run_check_pdf},
+    {"files.h/lrlib_check_pdf_file", "2000 pages", setup_pdf, run_check_pdf_file},
+
+    {"lrlib.h/lrlib_format_uint", "", setup_nothing, run_format_uint},
+    {"lrlib.h/lrlib_parse_double", "", setup_nothing, run_parse_double},
+    {"lrlib.h/lrlib_random_uint32", "", setup_nothing, run_random_uint32},
+    {"lrlib.h/lrlib_random_range", "", setup_nothing, run_random_range},
+    {"lrlib.h/lrlib_secure_random_bytes", "32 bytes", setup_nothing, run_secure_random_bytes},
+    {"lrlib.h/lrlib_create_uuid_v4", "", setup_nothing, run_create_uuid_v4},
+    {"lrlib.h/lrlib_create_uuid_v7", "", setup_nothing, run_create_uuid_v7},
+    {"lrlib.h/lrlib_create_uuid_paramarr", "1000 UUIDs", setup_nothing, run_create_uuid_paramarr},
+    {"lrlib.h/lrlib_sha256", "64 bytes", setup_base64_small, run_sha256},
+    {"lrlib.h/lrlib_sha256", "1 MB", setup_base64_large, run_sha256},
+    {"lrlib.h/lrlib_sha256_paramarr", "1000 x 64 bytes", setup_sha256_paramarr, run_sha256_paramarr},
+    {"lrlib.h/lrlib_sha256_file", "1 MB", setup_file_1m, run_sha256_file},
+    {"lrlib.h/lrlib_hmac_sha256", "256 bytes", setup_hmac, run_hmac_sha256},
+    {"lrlib.h/lrlib_hmac_sha256_file", "1 MB", setup_file_1m, run_hmac_sha256_file},
+    {"lrlib.h/lrlib_timer_now_usec", "", setup_nothing, run_timer_now_usec},
+    {"lrlib.h/lrlib_get_unix_time_ms", "", setup_nothing, run_get_unix_time_ms},
+    {"lrlib.h/lrlib_timer_start", "with lrlib_timer_stop", setup_nothing, run_timer_start_stop},
+    {"lrlib.h/lrlib_log_message", "100 bytes", setup_log_message, run_log_message},
+    {"lrlib.h/lrlib_pacing_next_interval_usec", "exponential", setup_pacing, run_pacing_next_interval_usec},
+    {"lrlib.h/lrlib_histogram_record", "", setup_histogram, run_histogram_record},
+    {"lrlib.h/lrlib_histogram_save_percentiles", "100000 values", setup_histogram, run_histogram_save_percentiles},
+    {"lrlib.h/lrlib_split_command_line", "8 arguments", setup_split_command_line, run_split_command_line},
+    {"lrlib.h/lrlib_run_command", "true", setup_nothing, run_run_command},
+    {"lrlib.h/lrlib_run_command_lines", "1000 lines", setup_nothing, run_run_command_lines},
+    {"lrlib.h/lrlib_check_ports", "16 refused ports", setup_check_ports, run_check_ports},
+    {"lrlib.h/lrlib_check_ports", "1 open port", setup_check_ports_open, run_check_ports_open},
+
+    {"dates.h/lrlib_format_date", "ISO 8601", setup_dates, run_format_date_iso8601},
+    {"dates.h/lrlib_format_date", "RFC 1123", setup_dates, run_format_date_rfc1123},
+    {"dates.h/lrlib_save_now", "ISO 8601", setup_dates, run_save_now},
+    {"dates.h/lrlib_parse_iso8601", "with offset", setup_dates, run_parse_iso8601},
+    {"dates.h/lrlib_add_to_date", "", setup_dates, run_add_to_date},
+    {"dates.h/lrlib_convert_date", "", setup_dates, run_convert_date},
+    {"dates.h/lrlib_date_difference", "", setup_dates, run_date_difference},
+
+    {"geo.h/lrlib_geo_load", "100000 points (with free)", setup_geo_load, run_geo_load},
+    {"geo.h/lrlib_geo_distances", "1000 points", setup_geo_1000, run_geo_distances},
+    {"geo.h/lrlib_geo_within_radius", "100000 points, 50 km", setup_geo_100000, run_geo_within_radius},
+    {"geo.h/lrlib_geo_nearest", "100000 points, k=10", setup_geo_100000, run_geo_nearest},
+
+    {"monitors.h/lrlib_counter_set_collect", "64 counters, mock backend", setup_counter_set_mock, run_counter_set_collect},
+    {"monitors.h/lrlib_counter_set_collect", "/proc/net/dev and /proc/meminfo", setup_counter_set_proc, run_counter_set_collect},
+    {"monitors.h/lrlib_get_linux_cpu_utilisation", "", setup_nothing, run_get_linux_cpu_utilisation},
+    {"monitors.h/lrlib_get_linux_memory", "", setup_nothing, run_get_linux_memory},
+    {"monitors.h/lrlib_get_linux_network", "", setup_nothing, run_get_linux_network},
+    {"monitors.h/lrlib_get_linux_disk_io", "", setup_nothing, run_get_linux_disk_io},
+    {"monitors.h/lrlib_get_linux_load_average", "", setup_nothing, run_get_linux_load_average},
+    {"monitors.h/lrlib_counter_sampler_start", "with lrlib_counter_sampler_stop", setup_nothing, run_counter_sampler_start_stop},
+    {"monitors.h/lrlib_counter_sampler_read_latest", "sampling every 1 ms", setup_sampler, run_counter_sampler_read_latest},
+    {"monitors.h/lrlib_counter_sampler_read_window", "100 of 1000 samples, sampling every 1 ms", setup_sampler, run_counter_sampler_read_window},
+
+    {NULL, NULL, NULL, NULL}
+};
+
+/* Measuring */
+
+/**
+ * Runs a benchmark for a number of iterations, and returns the elapsed time in microseconds.
+ */
+double bench_time(const bench_case* benchmark, int iterations) {
+    double start_usec;
+    int i;
+
+    start_usec = lr_stub_now_usec();
+    for (i = 0; i < iterations; i++) {
+        benchmark->run();
+        lr_stub_end_iteration();
+    }
+    return lr_stub_now_usec() - start_usec;
+}
+
+/**
+ * Measures a benchmark, and writes its result as a line of JSON.
+ */
+void bench_measure(const bench_case* benchmark, double min_time_usec) {
+    double samples[BENCH_REPEATS];
+    double elapsed_usec;
+    double sample;
+    double mb_per_s;
+    lr_stub_allocation_counts before;
+    lr_stub_allocation_counts after;
+    int errors;
+    int iterations = 1;
+    int i;
+    int j;
+
+    bench_bytes_per_op = 0;
+    errors = lr_stub_error_count();
+    benchmark->setup();
+
+    // Find how many iterations take about a tenth of the measuring time (after one warm-up call,
+    // which fills any caches), then split the measuring time into BENCH_REPEATS runs.
+    bench_time(benchmark, 1);
+    for (;;) {
+        elapsed_usec = bench_time(benchmark, iterations);
+        if ( (elapsed_usec >= min_time_usec / 10) || (iterations >= 1 << 28) ) {
+            break;
+        }
+        iterations *= 2;
+    }
+    iterations = (int)(iterations * (min_time_usec / BENCH_REPEATS) / (elapsed_usec + 1));
+    if (iterations < 1) {
+        iterations = 1;
+    }
+
+    for (i = 0; i < BENCH_REPEATS; i++) {
+        lr_stub_get_allocation_counts(&before);
+        sample = bench_time(benchmark, iterations) * 1000 / iterations;
+        lr_stub_get_allocation_counts(&after);
+
+        // Keep the samples sorted (insertion sort).
+        for (j = i; (j > 0) && (samples[j - 1] > sample); j--) {
+            samples[j] = samples[j - 1];
+        }
+        samples[j] = sample;
+    }
+    errors = lr_stub_error_count() - errors;
+
+    printf("{\"benchmark\": \"%s\", \"input\": \"%s\", \"iterations\": %d, \"ns_per_op\": %.1f, \"ns_per_op_median\": %.1f, ",
+        benchmark->name, benchmark->input, iterations, samples[0], samples[BENCH_REPEATS / 2]);
+    if (bench_bytes_per_op > 0) {
+        mb_per_s = bench_bytes_per_op / samples[0] * 1000000000.0 / BENCH_MB;
+        printf("\"mb_per_s\": %.1f, ", mb_per_s);
+    }
+    printf("\"allocs_per_op\": %.2f, \"bytes_allocated_per_op\": %.0f, \"errors\": %d}\n",
+        (after.mallocs - before.mallocs) / iterations, (after.bytes - before.bytes) / iterations, errors);
+    fflush(NULL);
+}
+
+int main(int argc, char** argv) {
+    const char* filter = NULL;
+    const char* setting;
+    double min_time_usec = 500000;
+    int i;
+
+    if (argc > 1) {
+        filter = argv[1];
+    }
+    setting = getenv("BENCH_MIN_TIME_MS");
+    if (setting != NULL) {
+        min_time_usec = atof(setting) * 1000;
+    }
+    setting = getenv("BENCH_TMPDIR");
+    if (setting == NULL) {
+        setting = "/tmp";
+    }
+    strncpy(bench_tmpdir, setting, BENCH_MAX_FILE_NAME_LENGTH - 64);
+    sprintf(bench_file_name, "%s/lrlib_bench_input.tmp", bench_tmpdir);
+    sprintf(bench_output_file_name, "%s/lrlib_bench_output.tmp", bench_tmpdir);
+
+    // Only errors are logged, so that the log does not affect the timings.
+    lr_set_debug_message(LR_MSG_CLASS_BRIEF_LOG | LR_MSG_CLASS_EXTENDED_LOG, LR_SWITCH_OFF);
+    lrlib_random_seed(12345);
+
+    for (i = 0; bench_cases[i].name != NULL; i++) {
+        if ( (filter == NULL) || (strstr(bench_cases[i].name, filter) != NULL) ) {
+            bench_measure(&bench_cases[i], min_time_usec);
+        }
+    }
+
+    remove(bench_file_name);
+    remove(bench_output_file_name);
+    return 0;
+}
@@ -0,0 +1,476 @@
+/**
+ * @file
+ *
+ * @section DESCRIPTION
+ *
+ * The implementation of the LoadRunner stand-in declared in lr_stub.h. Unlike the code that it
+ * supports, this file is ordinary host C: it uses the system headers, and it does not include
+ * lr_stub.h (whose declarations would clash with them).
+ *
+ * Parameters are kept in a hash table. Strings returned by lr_eval_string and lr_paramarr_idx are
+ * copied into an arena that is emptied by lr_stub_end_iteration, as LoadRunner frees them at the
+ * end of each iteration. Messages are discarded unless LR_STUB_VERBOSE is set in the environment,
+ * except for errors, which always go to stderr.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LR_STUB_PARAM_BUCKETS 65536 // a power of 2
+#define LR_STUB_ARENA_CHUNK_SIZE (1024 * 1024)
+#define LR_STUB_MAX_PARAM_NAME_LENGTH 1024
+
+// Must match lr_stub_allocation_counts in lr_stub.h.
+typedef struct {
+    double mallocs;
+    double frees;
+    double bytes;
+} lr_stub_allocation_counts;
+
+typedef struct lr_stub_param {
+    char* name;
+    char* value;
+    size_t length;
+    size_t capacity;
+    struct lr_stub_param* next;
+} lr_stub_param;
+
+typedef struct lr_stub_arena_chunk {
+    size_t size;
+    size_t used;
+    struct lr_stub_arena_chunk* next;
+    char data[1];
+} lr_stub_arena_chunk;
+
+static lr_stub_param* lr_stub_params[LR_STUB_PARAM_BUCKETS];
+static lr_stub_arena_chunk* lr_stub_arena;
+static lr_stub_allocation_counts lr_stub_counts;
+static int lr_stub_errors;
+static unsigned int lr_stub_debug_message = 1; // LR_MSG_CLASS_BRIEF_LOG
+static int lr_stub_verbose = -1; // -1 until LR_STUB_VERBOSE has been checked
+
+/* Allocation counting */
+
+void* lr_stub_malloc(size_t size) {
+    lr_stub_counts.mallocs++;
+    lr_stub_counts.bytes += size;
+    return malloc(size);
+}
+
+void* lr_stub_calloc(size_t count, size_t size) {
+    lr_stub_counts.mallocs++;
+    lr_stub_counts.bytes += (double)count * size;
+    return calloc(count, size);
+}
+
+void* lr_stub_realloc(void* pointer, size_t size) {
+    lr_stub_counts.mallocs++;
+    lr_stub_counts.bytes += size;
+    return realloc(pointer, size);
+}
+
+void lr_stub_free(void* pointer) {
+    if (pointer != NULL) {
+        lr_stub_counts.frees++;
+    }
+    free(pointer);
+}
+
+void lr_stub_get_allocation_counts(lr_stub_allocation_counts* counts) {
+    *counts = lr_stub_counts;
+}
+
+double lr_stub_now_usec(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000.0 + now.tv_nsec / 1000.0;
+}
+
+int lr_stub_error_count(void) {
+    return lr_stub_errors;
+}
+
+/* The evaluated string arena */
+
+static char* lr_stub_arena_copy(const char* value, size_t length) {
+    lr_stub_arena_chunk* chunk = lr_stub_arena;
+    char* copy;
+
+    if ( (chunk == NULL) || (chunk->used + length + 1 > chunk->size) ) {
+        size_t size = LR_STUB_ARENA_CHUNK_SIZE;
+
+        if (length + 1 > size) {
+            size = length + 1;
+        }
+        chunk = (lr_stub_arena_chunk*)malloc(sizeof(lr_stub_arena_chunk) + size);
+        if (chunk == NULL) {
+            fprintf(stderr, "lr_stub: out of memory\n");
+            exit(2);
+        }
+        chunk->size = size;
+        chunk->used = 0;
+        chunk->next = lr_stub_arena;
+        lr_stub_arena = chunk;
+    }
+
+    copy = chunk->data + chunk->used;
+    memcpy(copy, value, length);
+    copy[length] = '\0';
+    chunk->used += length + 1;
+    return copy;
+}
+
+void lr_stub_end_iteration(void) {
+    lr_stub_arena_chunk* chunk;
+
+    // Keep the newest chunk, so that the next iteration does not have to allocate one.
+    if (lr_stub_arena == NULL) {
+        return;
+    }
+    while (lr_stub_arena->next != NULL) {
+        chunk = lr_stub_arena->next;
+        lr_stub_arena->next = chunk->next;
+        free(chunk);
+    }
+    if (lr_stub_arena->size > LR_STUB_ARENA_CHUNK_SIZE) {
+        free(lr_stub_arena);
+        lr_stub_arena = NULL;
+        return;
+    }
+    lr_stub_arena->used = 0;
+}
+
+/* Parameters */
+
+static unsigned int lr_stub_hash(const char* name, size_t length) {
+    unsigned int hash = 2166136261u; // FNV-1a
+    size_t i;
+
+    for (i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return hash & (LR_STUB_PARAM_BUCKETS - 1);
+}
+
+static lr_stub_param* lr_stub_find_param(const char* name, size_t length) {
+    lr_stub_param* param;
+
+    for (param = lr_stub_params[lr_stub_hash(name, length)]; param != NULL; param = param->next) {
+        if ( (strncmp(param->name, name, length) == 0) && (param->name[length] == '\0') ) {
+            return param;
+        }
+    }
+    return NULL;
+}
+
+int lr_save_var(const char* value, unsigned long length, unsigned long options, const char* param_name) {
+    const size_t name_length = strlen(param_name);
+    lr_stub_param* param = lr_stub_find_param(param_name, name_length);
+    unsigned int bucket;
+
+    if (param == NULL) {
+        bucket = lr_stub_hash(param_name, name_length);
+        param = (lr_stub_param*)calloc(1, sizeof(lr_stub_param));
+        param->name = strdup(param_name);
+        param->next = lr_stub_params[bucket];
+        lr_stub_params[bucket] = param;
+    }
+    if (length + 1 > param->capacity) {
+        free(param->value);
+        param->capacity = length + 1;
+        param->value = (char*)malloc(param->capacity);
+    }
+    memmove(param->value, value, length);
+    param->value[length] = '\0';
+    param->length = length;
+    return 0;
+}
+
+int lr_save_string(const char* value, const char* param_name) {
+    return lr_save_var(value, strlen(value), 0, param_name);
+}
+
+int lr_save_int(int value, const char* param_name) {
+    char buffer[16];
+
+    sprintf(buffer, "%d", value);
+    return lr_save_string(buffer, param_name);
+}
+
+int lr_free_parameter(const char* param_name) {
+    lr_stub_param** link = &lr_stub_params[lr_stub_hash(param_name, strlen(param_name))];
+    lr_stub_param* param;
+
+    while (*link != NULL) {
+        param = *link;
+        if (strcmp(param->name, param_name) == 0) {
+            *link = param->next;
+            free(param->value);
+            free(param->name);
+            free(param);
+            return 0;
+        }
+        link = &param->next;
+    }
+    return -1;
+}
+
+char* lr_eval_string(const char* string) {
+    const char* close;
+    lr_stub_param* param;
+    char* result;
+    size_t length = 0;
+    size_t capacity = 256;
+    char* buffer = (char*)malloc(capacity);
+
+    // Replace each {ParamName} with the parameter's value. Text in braces that is not the name of
+    // a parameter is left as it is, as LoadRunner does. Text between parameters is copied a run at
+    // a time, so that evaluating a large parameter is not slowed down by the stub.
+    while (*string != '\0') {
+        const char* text = string;
+        size_t text_length;
+
+        if ( (*string == '{') && ( (close = strchr(string + 1, '}')) != NULL ) &&
+             ( (param = lr_stub_find_param(string + 1, close - string - 1)) != NULL ) ) {
+            text = param->value;
+            text_length = param->length;
+            string = close + 1;
+        } else {
+            close = strchr(string + 1, '{');
+            if (close == NULL) {
+                close = string + strlen(string);
+            }
+            text_length = close - string;
+            string = close;
+        }
+
+        if (length + text_length + 1 > capacity) {
+            capacity = (length + text_length + 1) * 2;
+            buffer = (char*)realloc(buffer, capacity);
+        }
+        memcpy(buffer + length, text, text_length);
+        length += text_length;
+    }
+
+    result = lr_stub_arena_copy(buffer, length);
+    free(buffer);
+    return result;
+}
+
+char* lr_paramarr_idx(const char* paramarr_name, unsigned int index) {
+    char name[LR_STUB_MAX_PARAM_NAME_LENGTH + 16];
+    lr_stub_param* param;
+
+    snprintf(name, sizeof(name), "%s_%u", paramarr_name, index);
+    param = lr_stub_find_param(name, strlen(name));
+    if (param == NULL) {
+        return lr_stub_arena_copy("", 0);
+    }
+    return lr_stub_arena_copy(param->value, param->length);
+}
+
+int lr_paramarr_len(const char* paramarr_name) {
+    char name[LR_STUB_MAX_PARAM_NAME_LENGTH + 16];
+    lr_stub_param* param;
+
+    snprintf(name, sizeof(name), "%s_count", paramarr_name);
+    param = lr_stub_find_param(name, strlen(name));
+    if (param == NULL) {
+        return 0;
+    }
+    return atoi(param->value);
+}
+
+char* lr_paramarr_random(const char* paramarr_name) {
+    const int count = lr_paramarr_len(paramarr_name);
+
+    if (count == 0) {
+        return lr_stub_arena_copy("", 0);
+    }
+    return lr_paramarr_idx(paramarr_name, 1 + rand() % count);
+}
+
+/* Messages */
+
+static void lr_stub_print(const char* prefix, const char* format, va_list arguments) {
+    if (lr_stub_verbose == -1) {
+        lr_stub_verbose = (getenv("LR_STUB_VERBOSE") != NULL);
+    }
+    if (lr_stub_verbose) {
+        fprintf(stderr, "%s", prefix);
+        vfprintf(stderr, format, arguments);
+        fprintf(stderr, "\n");
+    }
+}
+
+int lr_output_message(const char* format, ...) {
+    va_list arguments;
+
+    va_start(arguments, format);
+    lr_stub_print("", format, arguments);
+    va_end(arguments);
+    return 0;
+}
+
+int lr_log_message(const char* format, ...) {
+    va_list arguments;
+
+    va_start(arguments, format);
+    lr_stub_print("", format, arguments);
+    va_end(arguments);
+    return 0;
+}
+
+int lr_debug_message(unsigned int message_level, const char* format, ...) {
+    va_list arguments;
+
+    if ( (lr_stub_debug_message & message_level) == 0 ) {
+        return 0;
+    }
+    va_start(arguments, format);
+    lr_stub_print("", format, arguments);
+    va_end(arguments);
+    return 0;
+}
+
+int lr_error_message(const char* format, ...) {
+    va_list arguments;
+
+    lr_stub_errors++;
+    va_start(arguments, format);
+    fprintf(stderr, "Error: ");
+    vfprintf(stderr, format, arguments);
+    fprintf(stderr, "\n");
+    va_end(arguments);
+    return 0;
+}
+
+unsigned int lr_get_debug_message(void) {
+    return lr_stub_debug_message;
+}
+
+int lr_set_debug_message(unsigned int message_level, unsigned int on_off) {
+    if (on_off) {
+        lr_stub_debug_message |= message_level;
+    } else {
+        lr_stub_debug_message &= ~message_level;
+    }
+    return 0;
+}
+
+void lr_abort(void) {
+    fprintf(stderr, "Error: lr_abort() was called.\n");
+    exit(3);
+}
+
+/* Other LoadRunner functions */
+
+int lr_load_dll(const char* library_name) {
+    return 0;
+}
+
+int lr_start_transaction(const char* transaction_name) {
+    return 0;
+}
+
+int lr_end_transaction(const char* transaction_name, int status) {
+    return 0;
+}
+
+double lr_get_transaction_wasted_time(const char* transaction_name) {
+    return 0;
+}
+
+int lr_user_data_point(const char* name, double value) {
+    return 0;
+}
+
+int lr_think_time(double seconds) {
+    return 0;
+}
+
+void lr_whoami(int* vuser_id, char** vuser_group, int* scenario_id) {
+    if (vuser_id != NULL) {
+        *vuser_id = 1;
+    }
+    if (vuser_group != NULL) {
+        *vuser_group = "benchmarks";
+    }
+    if (scenario_id != NULL) {
+        *scenario_id = 1;
+    }
+}
+
+char* lr_get_host_name(void) {
+    return "localhost";
+}
+
+char* lr_get_vuser_ip(void) {
+    return "127.0.0.1";
+}
+
+/* C library functions that VuGen has, but glibc does not */
+
+char* itoa(int value, char* buffer, int radix) {
+    char digits[40];
+    unsigned int remaining = (unsigned int)value;
+    int count = 0;
+    int i = 0;
+
+    if ( (value < 0) && (radix == 10) ) {
+        buffer[i++] = '-';
+        remaining = -(unsigned int)value;
+    }
+    do {
+        digits[count++] = "0123456789abcdefghijklmnopqrstuvwxyz"[remaining % radix];
+        remaining /= radix;
+    } while (remaining != 0);
+    while (count > 0) {
+        buffer[i++] = digits[--count];
+    }
+    buffer[i] = '\0';
+    return buffer;
+}
+
+int stricmp(const char* a, const char* b) {
+    return strcasecmp(a, b);
+}
+
+/* Windows API functions */
+
+// A few lr-libc functions are Windows-only and are not compiled out on Linux (e.g. the mmdrv.exe
+// process functions). These stand-ins let the headers link; they all fail, and are not benchmarked.
+
+int OpenProcess() {
+    return 0;
+}
+
+int CloseHandle() {
+    return 0;
+}
+
+int GetModuleFileNameExA() {
+    return 0;
+}
+
+int CreateMutexA() {
+    return 0;
+}
+
+int WaitForSingleObject() {
+    return -1; // WAIT_FAILED
+}
+
+int ReleaseMutex() {
+    return 0;
+}
+
+int _getpid() {
+    return getpid();
+}
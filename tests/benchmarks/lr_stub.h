@@ -0,0 +1,166 @@
+/**
+ * @file
+ *
+ * @section DESCRIPTION
+ *
+ * A stand-in for the parts of the LoadRunner runtime that lr-libc uses, so that the library
+ * headers can be compiled and benchmarked with gcc on Linux, without VuGen.
+ *
+ * VuGen scripts are compiled without any system headers, so the lr-libc headers declare the
+ * functions they need themselves. This file recreates that environment: it declares the C library
+ * functions that VuGen makes available to scripts, and the lr_* functions. It must be included
+ * before any of the lr-libc headers, and nothing else should be included.
+ *
+ * The stub also counts the memory that the library allocates. malloc, calloc, realloc and free
+ * are redefined here, so every allocation made by code compiled after this header (the library
+ * and the benchmarks) goes through lr_stub_malloc etc. Allocations made by the stub itself are
+ * not counted.
+ */
+
+#ifndef LR_STUB_H
+#define LR_STUB_H
+
+/* C library functions that VuGen makes available to scripts */
+
+typedef unsigned long size_t;
+#define NULL ((void*)0)
+
+// paramarr.h has its own va_* macros for 32-bit VuGen, which only work where the arguments are
+// passed on the stack. These are used instead (they are macros, so that paramarr.h sees them).
+#define va_list __builtin_va_list
+#define va_start(ap, v) __builtin_va_start(ap, v)
+#define va_arg(ap, t) __builtin_va_arg(ap, t)
+#define va_end(ap) __builtin_va_end(ap)
+
+void* malloc(size_t size);
+void* calloc(size_t count, size_t size);
+void* realloc(void* pointer, size_t size);
+void free(void* pointer);
+
+size_t strlen(const char* string);
+char* strcpy(char* destination, const char* source);
+char* strncpy(char* destination, const char* source, size_t length);
+char* strcat(char* destination, const char* source);
+int strcmp(const char* a, const char* b);
+int strncmp(const char* a, const char* b, size_t length);
+int stricmp(const char* a, const char* b);
+char* strchr(const char* string, int c);
+char* strstr(const char* haystack, const char* needle);
+char* strtok(char* string, const char* delimiters);
+void* memcpy(void* destination, const void* source, size_t length);
+void* memmove(void* destination, const void* source, size_t length);
+void* memset(void* destination, int c, size_t length);
+int memcmp(const void* a, const void* b, size_t length);
+void* memchr(const void* buffer, int c, size_t length);
+
+int printf(const char* format, ...);
+int sprintf(char* buffer, const char* format, ...);
+int snprintf(char* buffer, size_t length, const char* format, ...);
+int sscanf(const char* string, const char* format, ...);
+void* fopen(const char* file_name, const char* mode);
+int fclose(void* file);
+size_t fread(void* buffer, size_t size, size_t count, void* file);
+size_t fwrite(const void* buffer, size_t size, size_t count, void* file);
+int fseek(void* file, long offset, int origin);
+long ftell(void* file);
+int fprintf(void* file, const char* format, ...);
+int fflush(void* file);
+int remove(const char* file_name);
+
+int atoi(const char* string);
+long atol(const char* string);
+double atof(const char* string);
+char* itoa(int value, char* buffer, int radix);
+int toupper(int c);
+int tolower(int c);
+int isalpha(int c);
+int isdigit(int c);
+int isspace(int c);
+long time(long* t);
+int rand(void);
+void srand(unsigned int seed);
+void exit(int status);
+char* getenv(const char* name);
+
+/* LoadRunner constants */
+
+#define TRUE 1
+#define FALSE 0
+#define LAST ((char*)0)
+#define far
+
+#define LR_PASS 0
+#define LR_FAIL 1
+#define LR_AUTO 2
+
+#define LR_SWITCH_OFF 0
+#define LR_SWITCH_ON 1
+
+#define LR_MSG_CLASS_DISABLE_LOG 0
+#define LR_MSG_CLASS_BRIEF_LOG 1
+#define LR_MSG_CLASS_RESULT_DATA 2
+#define LR_MSG_CLASS_PARAMETERS 4
+#define LR_MSG_CLASS_FULL_TRACE 8
+#define LR_MSG_CLASS_EXTENDED_LOG 16
+#define LR_MSG_CLASS_JIT_LOG_ON_ERROR 512
+
+/* LoadRunner functions */
+
+int lr_save_string(const char* value, const char* param_name);
+int lr_save_var(const char* value, unsigned long length, unsigned long options, const char* param_name);
+int lr_save_int(int value, const char* param_name);
+int lr_free_parameter(const char* param_name);
+char* lr_eval_string(const char* string);
+char* lr_paramarr_idx(const char* paramarr_name, unsigned int index);
+char* lr_paramarr_random(const char* paramarr_name);
+int lr_paramarr_len(const char* paramarr_name);
+
+int lr_output_message(const char* format, ...);
+int lr_log_message(const char* format, ...);
+int lr_error_message(const char* format, ...);
+int lr_debug_message(unsigned int message_level, const char* format, ...);
+unsigned int lr_get_debug_message(void);
+int lr_set_debug_message(unsigned int message_level, unsigned int on_off);
+void lr_abort(void);
+
+int lr_load_dll(const char* library_name);
+int lr_start_transaction(const char* transaction_name);
+int lr_end_transaction(const char* transaction_name, int status);
+double lr_get_transaction_wasted_time(const char* transaction_name);
+int lr_user_data_point(const char* name, double value);
+int lr_think_time(double seconds);
+void lr_whoami(int* vuser_id, char** vuser_group, int* scenario_id);
+char* lr_get_host_name(void);
+char* lr_get_vuser_ip(void);
+
+/* Controls for the benchmarks */
+
+typedef struct {
+    double mallocs; // calls to malloc, calloc and realloc
+    double frees; // calls to free (with a non-NULL pointer)
+    double bytes; // bytes requested from malloc, calloc and realloc
+} lr_stub_allocation_counts;
+
+void* lr_stub_malloc(size_t size);
+void* lr_stub_calloc(size_t count, size_t size);
+void* lr_stub_realloc(void* pointer, size_t size);
+void lr_stub_free(void* pointer);
+void lr_stub_get_allocation_counts(lr_stub_allocation_counts* counts);
+
+// Frees the strings returned by lr_eval_string and lr_paramarr_idx, like LoadRunner does at the
+// end of each iteration.
+void lr_stub_end_iteration(void);
+
+// Returns the number of lr_error_message calls so far. A benchmark that causes errors is not
+// measuring what it claims to.
+int lr_stub_error_count(void);
+
+// Returns a monotonic time in microseconds.
+double lr_stub_now_usec(void);
+
+#define malloc(size) lr_stub_malloc(size)
+#define calloc(count, size) lr_stub_calloc(count, size)
+#define realloc(pointer, size) lr_stub_realloc(pointer, size)
+#define free(pointer) lr_stub_free(pointer)
+
+#endif // LR_STUB_H
@@ -0,0 +1,112 @@
+#!/bin/sh
+
+# == About this program ==
+# This shell script builds and runs the lr-libc benchmarks on Linux. Each benchmark measures the
+# time and memory allocations of one lr-libc function on a realistic input, so that the speed of
+# the library can be compared before and after a change.
+
+# == Requirements ==
+# gcc (or another compiler that accepts the same options, set with CC) and awk. LoadRunner is not
+# needed: the library is compiled against lr_stub.c, which stands in for the LoadRunner runtime.
+
+# == Running the benchmarks ==
+# Run the script from any directory:
+#   tests/benchmarks/run_benchmarks.sh [-t milliseconds] [-o results_file] [-c baseline_file] [filter]
+# * filter: only run the benchmarks whose names contain this text, e.g. "paramarr.h/" or "sha256".
+# * -t: the time spent measuring each benchmark (default 500 ms). Longer times give steadier results.
+# * -o: also save the results to this file.
+# * -c: compare the results with an earlier results file, and show which benchmarks got faster or
+#   slower.
+# The results are printed as JSON, one benchmark per line (see benchmarks.c for the fields).
+#
+# To check the effect of a change:
+#   tests/benchmarks/run_benchmarks.sh -o before.jsonl
+#   (make the change)
+#   tests/benchmarks/run_benchmarks.sh -c before.jsonl
+
+set -e
+
+script_dir=$(cd "$(dirname "$0")" && pwd)
+min_time_ms=500
+output_file=""
+baseline_file=""
+
+while getopts "t:o:c:" option; do
+    case $option in
+        t) min_time_ms=$OPTARG ;;
+        o) output_file=$OPTARG ;;
+        c) baseline_file=$OPTARG ;;
+        *) echo "Usage: $0 [-t milliseconds] [-o results_file] [-c baseline_file] [filter]" >&2; exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+filter=${1:-}
+
+if [ -n "$baseline_file" ] && [ ! -f "$baseline_file" ]; then
+    echo "Error: baseline file '$baseline_file' not found." >&2
+    exit 2
+fi
+
+# Build the benchmarks. The library is compiled the way VuGen compiles scripts: as C89 with GNU
+# extensions, and without warnings (the headers rely on implicit declarations).
+build_dir=$(mktemp -d)
+trap 'rm -rf "$build_dir"' EXIT
+${CC:-gcc} -std=gnu89 -O2 -w -c "$script_dir/benchmarks.c" -o "$build_dir/benchmarks.o"
+${CC:-gcc} -O2 -c "$script_dir/lr_stub.c" -o "$build_dir/lr_stub.o"
+${CC:-gcc} "$build_dir/benchmarks.o" "$build_dir/lr_stub.o" -lm -ldl -lpthread -o "$build_dir/benchmarks"
+
+# Run the benchmarks. Temporary files are written to the build directory.
+BENCH_MIN_TIME_MS=$min_time_ms BENCH_TMPDIR=$build_dir "$build_dir/benchmarks" "$filter" > "$build_dir/results.jsonl"
+cat "$build_dir/results.jsonl"
+if [ -n "$output_file" ]; then
+    cp "$build_dir/results.jsonl" "$output_file"
+fi
+
+if grep -q '"errors": [1-9]' "$build_dir/results.jsonl"; then
+    echo "Error: some benchmarks called lr_error_message, so their results are not valid." >&2
+    exit 1
+fi
+
+# Compare with the baseline. Benchmarks are matched by name and input, and the fastest times
+# (ns_per_op) are compared. Changes of less than 5% are usually noise.
+if [ -n "$baseline_file" ]; then
+    echo
+    awk '
+        function field(line, name,    start, rest) {
+            start = index(line, "\"" name "\": ")
+            if (start == 0) {
+                return ""
+            }
+            rest = substr(line, start + length(name) + 4)
+            if (substr(rest, 1, 1) == "\"") {
+                rest = substr(rest, 2)
+                return substr(rest, 1, index(rest, "\"") - 1)
+            }
+            match(rest, /^[0-9.]+/)
+            return substr(rest, 1, RLENGTH)
+        }
+        {
+            key = field($0, "benchmark") " [" field($0, "input") "]"
+        }
+        FNR == NR {
+            baseline_ns[key] = field($0, "ns_per_op")
+            baseline_allocs[key] = field($0, "allocs_per_op")
+            next
+        }
+        key in baseline_ns {
+            ns = field($0, "ns_per_op")
+            change = (ns - baseline_ns[key]) / baseline_ns[key] * 100
+            verdict = ""
+            if (change <= -5) {
+                verdict = "faster"
+            } else if (change >= 5) {
+                verdict = "SLOWER"
+            }
+            allocs = field($0, "allocs_per_op")
+            if (allocs != baseline_allocs[key]) {
+                verdict = verdict " (allocs/op " baseline_allocs[key] " -> " allocs ")"
+            }
+            printf "%-75s %12.1f -> %12.1f ns/op %+7.1f%% %s\n", key, baseline_ns[key], ns, change, verdict
+        }
+    ' "$baseline_file" "$build_dir/results.jsonl"
+fi